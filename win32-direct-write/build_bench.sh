@@ -0,0 +1,28 @@
+#!/bin/sh
+
+mkdir -p build
+
+opts="-O2 -g -march=native -Wno-write-strings"
+
+cd build
+c++ $opts ../example_text_bench.cpp -o text_bench -lpthread
+c++ $opts ../example_headless.cpp -o headless -lpthread
+c++ $opts ../example_hot_path_bench.cpp -o hot_path_bench -lpthread
+c++ $opts -DTRACE_ENABLED=1 ../example_headless.cpp -o headless_trace -lpthread
+c++ $opts ../example_atlas_packer_test.cpp -o atlas_packer_test
+c++ $opts ../example_text_instance_test.cpp -o text_instance_test
+c++ $opts ../example_utf8_test.cpp -o utf8_test
+c++ $opts ../example_glyph_cache_test.cpp -o glyph_cache_test
+c++ $opts ../example_vertex_ring_test.cpp -o vertex_ring_test
+c++ $opts ../example_m_values_test.cpp -o m_values_test
+c++ $opts ../example_frame_arena_test.cpp -o frame_arena_test -lpthread
+c++ $opts ../example_glyph_table_test.cpp -o glyph_table_test
+c++ $opts ../example_render_commands_test.cpp -o render_commands_test
+c++ $opts ../example_atlas_levels_test.cpp -o atlas_levels_test
+c++ $opts ../example_layout_cache_test.cpp -o layout_cache_test
+c++ $opts ../example_subpixel_test.cpp -o subpixel_test
+c++ $opts ../example_atlas_dirty_test.cpp -o atlas_dirty_test
+c++ $opts ../example_bmp_file_test.cpp -o bmp_file_test
+c++ $opts ../example_cpu_compositor_test.cpp -o cpu_compositor_test
+c++ $opts ../example_truetype_test.cpp -o truetype_test
+c++ $opts ../example_parallel_bake_test.cpp -o parallel_bake_test -lpthread
@@ -7,4 +7,24 @@ set opts=-nologo -FC -Zi
 pushd build
 cl %opts% ..\example_texture_extraction.cpp dwrite.lib gdi32.lib /Feextract
 cl %opts% ..\example_rasterizer.cpp dwrite.lib gdi32.lib user32.lib opengl32.lib /Ferasterize
+cl %opts% -O2 ..\example_text_bench.cpp /Fetext_bench
+cl %opts% -O2 ..\example_headless.cpp /Feheadless
+cl %opts% -O2 ..\example_hot_path_bench.cpp /Fehot_path_bench
+cl %opts% -O2 ..\example_atlas_packer_test.cpp /Featlas_packer_test
+cl %opts% -O2 ..\example_text_instance_test.cpp /Fetext_instance_test
+cl %opts% -O2 ..\example_utf8_test.cpp /Feutf8_test
+cl %opts% -O2 ..\example_glyph_cache_test.cpp /Feglyph_cache_test
+cl %opts% -O2 ..\example_vertex_ring_test.cpp /Fevertex_ring_test
+cl %opts% -O2 ..\example_m_values_test.cpp /Fem_values_test
+cl %opts% -O2 ..\example_frame_arena_test.cpp /Feframe_arena_test
+cl %opts% -O2 ..\example_glyph_table_test.cpp /Feglyph_table_test
+cl %opts% -O2 ..\example_render_commands_test.cpp /Ferender_commands_test
+cl %opts% -O2 ..\example_atlas_levels_test.cpp /Featlas_levels_test
+cl %opts% -O2 ..\example_layout_cache_test.cpp /Felayout_cache_test
+cl %opts% -O2 ..\example_subpixel_test.cpp /Fesubpixel_test
+cl %opts% -O2 ..\example_atlas_dirty_test.cpp /Featlas_dirty_test
+cl %opts% -O2 ..\example_bmp_file_test.cpp /Febmp_file_test
+cl %opts% -O2 ..\example_cpu_compositor_test.cpp /Fecpu_compositor_test
+cl %opts% -O2 ..\example_truetype_test.cpp /Fetruetype_test
+cl %opts% -O2 ..\example_parallel_bake_test.cpp /Feparallel_bake_test
 popd
\ No newline at end of file
@@ -0,0 +1,159 @@
+// DirectWrite rasterization example: linear scratch arena and heap allocation counter
+// An arena is one block reserved up front and handed out front to back. Memory comes back all at
+// once, either to a mark taken earlier or by resetting the whole arena at the start of a frame, so
+// nothing that lives for a frame or less needs the general purpose heap.
+// Everything that may allocate while a frame is drawn goes through heap_alloc and friends. With
+// HEAP_ALLOC_CHECKS on, which is the default outside of NDEBUG builds, they count what happens
+// between heap_frame_begin and heap_frame_end so a stray allocation shows up as a number. The count
+// is per thread: a frame only counts what the thread that opened it allocates, bake workers running
+// alongside the frame are not part of it.
+
+#if !defined(EXAMPLE_ARENA_H)
+#define EXAMPLE_ARENA_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#if !defined(HEAP_ALLOC_CHECKS)
+#if defined(NDEBUG)
+#define HEAP_ALLOC_CHECKS 0
+#else
+#define HEAP_ALLOC_CHECKS 1
+#endif
+#endif
+
+////////////////////////////////
+
+// Heap Allocation Counter
+
+// One per thread
+struct Heap_Alloc_Counter{
+    uint64_t total;
+    // Allocations since heap_frame_begin
+    uint64_t in_frame;
+    bool32 frame_open;
+};
+
+static thread_local Heap_Alloc_Counter heap_counter = {0};
+
+void
+heap__count(void){
+#if HEAP_ALLOC_CHECKS
+    heap_counter.total += 1;
+    if (heap_counter.frame_open){
+        heap_counter.in_frame += 1;
+    }
+#endif
+}
+
+void*
+heap_alloc(size_t size){
+    heap__count();
+    return(malloc(size));
+}
+
+void*
+heap_realloc(void *ptr, size_t size){
+    heap__count();
+    return(realloc(ptr, size));
+}
+
+void
+heap_free(void *ptr){
+    free(ptr);
+}
+
+void
+heap_frame_begin(void){
+    heap_counter.in_frame = 0;
+    heap_counter.frame_open = true;
+}
+
+// Returns how many allocations the frame made, always zero without HEAP_ALLOC_CHECKS.
+uint64_t
+heap_frame_end(void){
+    heap_counter.frame_open = false;
+    return(heap_counter.in_frame);
+}
+
+////////////////////////////////
+
+// Arena
+
+#define ARENA_DEFAULT_ALIGN 16
+
+struct Arena{
+    uint8_t *base;
+    uint64_t size;
+    uint64_t used;
+    // Most ever used at once, for sizing the arena
+    uint64_t high_water;
+    // Pushes that did not fit
+    uint64_t failures;
+};
+
+struct Arena_Mark{
+    uint64_t used;
+};
+
+Arena
+arena_alloc(uint64_t size){
+    Arena arena = {0};
+    arena.base = (uint8_t*)heap_alloc((size_t)size);
+    assert(arena.base != 0);
+    arena.size = size;
+    return(arena);
+}
+
+void
+arena_free(Arena *arena){
+    heap_free(arena->base);
+    memset(arena, 0, sizeof(*arena));
+}
+
+// Returns zero when the arena is out of room, the arena never grows.
+void*
+arena_push_align(Arena *arena, uint64_t size, uint64_t align){
+    assert(align > 0 && (align & (align - 1)) == 0);
+    uint64_t address = (uint64_t)(uintptr_t)arena->base + arena->used;
+    uint64_t padding = (align - (address & (align - 1))) & (align - 1);
+    if (arena->used + padding + size > arena->size){
+        arena->failures += 1;
+        return(0);
+    }
+    void *result = arena->base + arena->used + padding;
+    arena->used += padding + size;
+    if (arena->high_water < arena->used){
+        arena->high_water = arena->used;
+    }
+    return(result);
+}
+
+void*
+arena_push(Arena *arena, uint64_t size){
+    return(arena_push_align(arena, size, ARENA_DEFAULT_ALIGN));
+}
+
+#define arena_push_array(arena, T, count) (T*)arena_push((arena), sizeof(T)*(uint64_t)(count))
+
+Arena_Mark
+arena_mark(Arena *arena){
+    Arena_Mark mark = {arena->used};
+    return(mark);
+}
+
+void
+arena_pop_to(Arena *arena, Arena_Mark mark){
+    assert(mark.used <= arena->used);
+    arena->used = mark.used;
+}
+
+void
+arena_reset(Arena *arena){
+    arena->used = 0;
+}
+
+#endif
@@ -0,0 +1,191 @@
+// DirectWrite rasterization example: atlas uploads of just the texels that changed
+// The atlas texture is allocated once. A glyph baked into it later is written to a CPU copy of the
+// atlas and the rectangle it covers is remembered for its slice. Once a frame, before anything
+// draws, each slice's dirty rectangles are uploaded with one sub-image call apiece and forgotten.
+// A call has a cost of its own, so a new rectangle is merged with one already marked whenever the
+// union adds no more than merge_slack texels nobody asked for. Cells handed out side by side grow
+// into strips and the strips into blocks. When a slice has ATLAS_DIRTY_MAX_RECTS rectangles the
+// new one merges with whichever rectangle wastes the least.
+// The upload sits behind a function pointer so the coalescing can be checked without a GPU.
+
+#if !defined(EXAMPLE_ATLAS_DIRTY_H)
+#define EXAMPLE_ATLAS_DIRTY_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+
+#define ATLAS_DIRTY_MAX_RECTS 16
+
+// x1 and y1 are one past the last texel
+struct Atlas_Dirty_Rect{
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+};
+
+// Uploads a rectangle of a slice. texels is the rectangle's first texel, rows are pitch texels apart.
+typedef void Atlas_Upload_Function(void *backend, int32_t slice, Atlas_Dirty_Rect rect, uint16_t *texels, int32_t pitch);
+
+struct Atlas_Dirty_Stats{
+    uint64_t glyphs;
+    // Texels the glyphs wrote
+    uint64_t written;
+    uint64_t merges;
+    uint64_t flushes;
+    uint64_t uploads;
+    // Texels the uploads sent
+    uint64_t uploaded;
+};
+
+struct Atlas_Dirty{
+    int32_t atlas_w;
+    int32_t atlas_h;
+    int32_t slice_count;
+    int32_t merge_slack;
+    // CPU copy of the whole atlas, slice after slice
+    uint16_t *texels;
+    // ATLAS_DIRTY_MAX_RECTS per slice
+    Atlas_Dirty_Rect *rects;
+    int32_t *rect_counts;
+    
+    Atlas_Dirty_Stats stats;
+};
+
+Atlas_Dirty
+atlas_dirty_init(int32_t atlas_w, int32_t atlas_h, int32_t slice_count, int32_t merge_slack){
+    Atlas_Dirty dirty = {0};
+    dirty.atlas_w = atlas_w;
+    dirty.atlas_h = atlas_h;
+    dirty.slice_count = slice_count;
+    dirty.merge_slack = merge_slack;
+    size_t texel_count = (size_t)atlas_w*atlas_h*slice_count;
+    dirty.texels = (uint16_t*)heap_alloc(sizeof(uint16_t)*texel_count);
+    memset(dirty.texels, 0, sizeof(uint16_t)*texel_count);
+    dirty.rects = (Atlas_Dirty_Rect*)heap_alloc(sizeof(Atlas_Dirty_Rect)*ATLAS_DIRTY_MAX_RECTS*slice_count);
+    dirty.rect_counts = (int32_t*)heap_alloc(sizeof(int32_t)*slice_count);
+    memset(dirty.rect_counts, 0, sizeof(int32_t)*slice_count);
+    return(dirty);
+}
+
+void
+atlas_dirty_free(Atlas_Dirty *dirty){
+    heap_free(dirty->texels);
+    heap_free(dirty->rects);
+    heap_free(dirty->rect_counts);
+    memset(dirty, 0, sizeof(*dirty));
+}
+
+uint64_t
+atlas_dirty_memory(Atlas_Dirty *dirty){
+    return((uint64_t)dirty->atlas_w*dirty->atlas_h*dirty->slice_count*sizeof(uint16_t) +
+           (uint64_t)dirty->slice_count*(ATLAS_DIRTY_MAX_RECTS*sizeof(Atlas_Dirty_Rect) + sizeof(int32_t)));
+}
+
+int64_t
+atlas_dirty__area(Atlas_Dirty_Rect r){
+    return((int64_t)(r.x1 - r.x0)*(r.y1 - r.y0));
+}
+
+Atlas_Dirty_Rect
+atlas_dirty__union(Atlas_Dirty_Rect a, Atlas_Dirty_Rect b){
+    Atlas_Dirty_Rect r = a;
+    r.x0 = (b.x0 < r.x0)?b.x0:r.x0;
+    r.y0 = (b.y0 < r.y0)?b.y0:r.y0;
+    r.x1 = (b.x1 > r.x1)?b.x1:r.x1;
+    r.y1 = (b.y1 > r.y1)?b.y1:r.y1;
+    return(r);
+}
+
+// Texels the union of two rectangles covers that neither of them does.
+int64_t
+atlas_dirty__waste(Atlas_Dirty_Rect a, Atlas_Dirty_Rect b){
+    Atlas_Dirty_Rect overlap = {0};
+    overlap.x0 = (a.x0 > b.x0)?a.x0:b.x0;
+    overlap.y0 = (a.y0 > b.y0)?a.y0:b.y0;
+    overlap.x1 = (a.x1 < b.x1)?a.x1:b.x1;
+    overlap.y1 = (a.y1 < b.y1)?a.y1:b.y1;
+    int64_t shared = 0;
+    if (overlap.x0 < overlap.x1 && overlap.y0 < overlap.y1){
+        shared = atlas_dirty__area(overlap);
+    }
+    return(atlas_dirty__area(atlas_dirty__union(a, b)) - (atlas_dirty__area(a) + atlas_dirty__area(b) - shared));
+}
+
+// Index of the marked rectangle that merges with rect for the least waste.
+int32_t
+atlas_dirty__closest(Atlas_Dirty_Rect *rects, int32_t count, Atlas_Dirty_Rect rect, int64_t *waste_out){
+    int32_t result = -1;
+    int64_t best = 0;
+    for (int32_t i = 0; i < count; i += 1){
+        int64_t waste = atlas_dirty__waste(rects[i], rect);
+        if (result < 0 || waste < best){
+            result = i;
+            best = waste;
+        }
+    }
+    *waste_out = best;
+    return(result);
+}
+
+void
+atlas_dirty_mark(Atlas_Dirty *dirty, int32_t slice, Atlas_Dirty_Rect rect){
+    assert(0 <= slice && slice < dirty->slice_count);
+    assert(0 <= rect.x0 && rect.x0 < rect.x1 && rect.x1 <= dirty->atlas_w);
+    assert(0 <= rect.y0 && rect.y0 < rect.y1 && rect.y1 <= dirty->atlas_h);
+    Atlas_Dirty_Rect *rects = dirty->rects + slice*ATLAS_DIRTY_MAX_RECTS;
+    int32_t *count = &dirty->rect_counts[slice];
+    
+    // A merge makes the rectangle bigger, which may bring it within reach of another one.
+    for (;;){
+        int64_t waste = 0;
+        int32_t closest = atlas_dirty__closest(rects, *count, rect, &waste);
+        if (closest < 0 || (waste > dirty->merge_slack && *count < ATLAS_DIRTY_MAX_RECTS)){
+            break;
+        }
+        rect = atlas_dirty__union(rect, rects[closest]);
+        *count -= 1;
+        rects[closest] = rects[*count];
+        dirty->stats.merges += 1;
+    }
+    rects[*count] = rect;
+    *count += 1;
+}
+
+// Copies w*h texels, rows pitch apart, into the CPU copy at (x, y) and marks them for upload.
+void
+atlas_dirty_write(Atlas_Dirty *dirty, int32_t slice, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *texels, int32_t pitch){
+    uint16_t *dst = dirty->texels + ((size_t)slice*dirty->atlas_h + y)*dirty->atlas_w + x;
+    for (int32_t row = 0; row < h; row += 1){
+        memcpy(dst, texels, sizeof(uint16_t)*w);
+        dst += dirty->atlas_w;
+        texels += pitch;
+    }
+    Atlas_Dirty_Rect rect = {x, y, x + w, y + h};
+    atlas_dirty_mark(dirty, slice, rect);
+    dirty->stats.glyphs += 1;
+    dirty->stats.written += (uint64_t)w*h;
+}
+
+// Uploads every dirty rectangle and forgets them. Call before the frame's first draw.
+void
+atlas_dirty_flush(Atlas_Dirty *dirty, Atlas_Upload_Function *upload, void *backend){
+    for (int32_t slice = 0; slice < dirty->slice_count; slice += 1){
+        Atlas_Dirty_Rect *rects = dirty->rects + slice*ATLAS_DIRTY_MAX_RECTS;
+        for (int32_t i = 0; i < dirty->rect_counts[slice]; i += 1){
+            Atlas_Dirty_Rect rect = rects[i];
+            uint16_t *texels = dirty->texels + ((size_t)slice*dirty->atlas_h + rect.y0)*dirty->atlas_w + rect.x0;
+            upload(backend, slice, rect, texels, dirty->atlas_w);
+            dirty->stats.uploads += 1;
+            dirty->stats.uploaded += (uint64_t)atlas_dirty__area(rect);
+        }
+        dirty->rect_counts[slice] = 0;
+    }
+    dirty->stats.flushes += 1;
+}
+
+#endif
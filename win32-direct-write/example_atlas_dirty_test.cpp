@@ -0,0 +1,222 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the dirty rectangle atlas uploads
+// usage: atlas_dirty_test [seed]
+// Random glyph writes go into the atlas a frame at a time and the flush uploads into a mock texture.
+// After every flush the texture must hold exactly the CPU copy, every upload must lie in the atlas
+// and no slice may hold more than ATLAS_DIRTY_MAX_RECTS rectangles. Writes carry values no other
+// write has, so an upload that is lost or lands in the wrong place shows. A few fixed layouts must
+// coalesce the way they are built to: cells side by side into one strip, a block of cells into one
+// rectangle, cells far apart kept apart until the slice runs out of rectangles.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_atlas_dirty.h"
+#include "example_test.h"
+
+static int32_t test_scenario_count = 100;
+static int32_t test_frame_count = 60;
+
+// Stands in for the atlas texture. Checks what every upload is handed.
+struct Test_Mock_Texture{
+    int32_t atlas_w;
+    int32_t atlas_h;
+    int32_t slice_count;
+    uint16_t *texels;
+    int32_t uploads;
+    int64_t uploaded;
+    int32_t bad_uploads;
+};
+
+void
+test_upload(void *backend, int32_t slice, Atlas_Dirty_Rect rect, uint16_t *texels, int32_t pitch){
+    Test_Mock_Texture *texture = (Test_Mock_Texture*)backend;
+    texture->uploads += 1;
+    if (slice < 0 || slice >= texture->slice_count || pitch != texture->atlas_w ||
+        rect.x0 < 0 || rect.x0 >= rect.x1 || rect.x1 > texture->atlas_w ||
+        rect.y0 < 0 || rect.y0 >= rect.y1 || rect.y1 > texture->atlas_h){
+        texture->bad_uploads += 1;
+        return;
+    }
+    texture->uploaded += (int64_t)(rect.x1 - rect.x0)*(rect.y1 - rect.y0);
+    uint16_t *dst = texture->texels + ((size_t)slice*texture->atlas_h + rect.y0)*texture->atlas_w + rect.x0;
+    for (int32_t y = rect.y0; y < rect.y1; y += 1){
+        memcpy(dst, texels, sizeof(uint16_t)*(rect.x1 - rect.x0));
+        dst += texture->atlas_w;
+        texels += pitch;
+    }
+}
+
+Test_Mock_Texture
+test_texture_init(int32_t atlas_w, int32_t atlas_h, int32_t slice_count){
+    Test_Mock_Texture texture = {0};
+    texture.atlas_w = atlas_w;
+    texture.atlas_h = atlas_h;
+    texture.slice_count = slice_count;
+    texture.texels = (uint16_t*)calloc((size_t)atlas_w*atlas_h*slice_count, sizeof(uint16_t));
+    return(texture);
+}
+
+// Writes a w by h cell of values no earlier write used.
+void
+test_write_cell(Atlas_Dirty *dirty, int32_t slice, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *stamp){
+    uint16_t cell[64*64];
+    for (int32_t t = 0; t < w*h; t += 1){
+        cell[t] = *stamp;
+        *stamp = (uint16_t)(*stamp + 1);
+        *stamp = (*stamp == 0)?1:*stamp;
+    }
+    atlas_dirty_write(dirty, slice, x, y, w, h, cell, w);
+}
+
+// Uploads of one flush of a fresh atlas with the given cells written to slice 0
+void
+test_layout(char *name, int32_t merge_slack, int32_t *cells, int32_t cell_count, int32_t expected_uploads){
+    Atlas_Dirty dirty = atlas_dirty_init(256, 256, 1, merge_slack);
+    Test_Mock_Texture texture = test_texture_init(256, 256, 1);
+    uint16_t stamp = 1;
+    int64_t written = 0;
+    for (int32_t i = 0; i < cell_count; i += 1){
+        int32_t *cell = cells + 4*i;
+        test_write_cell(&dirty, 0, cell[0], cell[1], cell[2], cell[3], &stamp);
+        written += cell[2]*cell[3];
+    }
+    atlas_dirty_flush(&dirty, test_upload, &texture);
+    int64_t failures_before = test_state.failures;
+    TEST_CHECK(texture.uploads == expected_uploads);
+    TEST_CHECK(texture.bad_uploads == 0);
+    TEST_CHECK(memcmp(texture.texels, dirty.texels, sizeof(uint16_t)*256*256) == 0);
+    // With no slack only a full slice uploads texels nobody wrote.
+    if (merge_slack == 0 && cell_count <= ATLAS_DIRTY_MAX_RECTS){
+        TEST_CHECK(texture.uploaded == written);
+    }
+    if (test_state.failures != failures_before){
+        printf("    %s: %d uploads of %lld texels for %lld written\n", name, texture.uploads,
+               (long long)texture.uploaded, (long long)written);
+    }
+    free(texture.texels);
+    atlas_dirty_free(&dirty);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0xD1A7Eu);
+    uint32_t state = seed;
+    
+    // Fixed Layouts
+    {
+        int32_t strip[4*6];
+        for (int32_t i = 0; i < 6; i += 1){
+            int32_t cell[4] = {16*i, 32, 16, 16};
+            memcpy(strip + 4*i, cell, sizeof(cell));
+        }
+        test_layout("strip", 0, strip, 6, 1);
+        
+        int32_t block[4*9];
+        for (int32_t i = 0; i < 9; i += 1){
+            int32_t cell[4] = {100 + 12*(i%3), 50 + 12*(i/3), 12, 12};
+            memcpy(block + 4*i, cell, sizeof(cell));
+        }
+        test_layout("block", 0, block, 9, 1);
+        
+        // Cells a few texels apart join at a slack that covers the gaps and not below it.
+        int32_t gapped[4*4];
+        for (int32_t i = 0; i < 4; i += 1){
+            int32_t cell[4] = {20*i, 0, 16, 16};
+            memcpy(gapped + 4*i, cell, sizeof(cell));
+        }
+        test_layout("gapped tight", 63, gapped, 4, 4);
+        test_layout("gapped", 64, gapped, 4, 1);
+        
+        // Cells on a diagonal, one more than a slice can hold apart
+        int32_t far[4*(ATLAS_DIRTY_MAX_RECTS + 1)];
+        for (int32_t i = 0; i < ATLAS_DIRTY_MAX_RECTS + 1; i += 1){
+            int32_t cell[4] = {14*i, 14*i, 8, 8};
+            memcpy(far + 4*i, cell, sizeof(cell));
+        }
+        test_layout("far", 0, far, ATLAS_DIRTY_MAX_RECTS, ATLAS_DIRTY_MAX_RECTS);
+        test_layout("far full", 0, far, ATLAS_DIRTY_MAX_RECTS + 1, ATLAS_DIRTY_MAX_RECTS);
+    }
+    
+    // Random Frames
+    uint64_t total_writes = 0;
+    uint64_t total_uploads = 0;
+    uint64_t total_merges = 0;
+    for (int32_t scenario = 0; scenario < test_scenario_count; scenario += 1){
+        int64_t failures_before = test_state.failures;
+        int32_t atlas_w = test_random_range(&state, 16, 300);
+        int32_t atlas_h = test_random_range(&state, 16, 300);
+        int32_t slice_count = test_random_range(&state, 1, 3);
+        int32_t merge_slack = (test_random_range(&state, 0, 3) == 0)?0:test_random_range(&state, 1, 4096);
+        Atlas_Dirty dirty = atlas_dirty_init(atlas_w, atlas_h, slice_count, merge_slack);
+        Test_Mock_Texture texture = test_texture_init(atlas_w, atlas_h, slice_count);
+        size_t atlas_bytes = sizeof(uint16_t)*atlas_w*atlas_h*slice_count;
+        uint16_t stamp = 1;
+        uint64_t written = 0;
+        int32_t write_count = 0;
+        
+        for (int32_t frame = 0; frame < test_frame_count; frame += 1){
+            // Sometimes nothing, sometimes more writes than there are rectangles
+            int32_t frame_writes = test_random_range(&state, 0, 3*ATLAS_DIRTY_MAX_RECTS);
+            frame_writes = (frame%7 == 0)?0:frame_writes;
+            for (int32_t i = 0; i < frame_writes; i += 1){
+                int32_t slice = test_random_range(&state, 0, slice_count - 1);
+                int32_t w = test_random_range(&state, 1, (atlas_w < 64)?atlas_w:64);
+                int32_t h = test_random_range(&state, 1, (atlas_h < 64)?atlas_h:64);
+                int32_t x = test_random_range(&state, 0, atlas_w - w);
+                int32_t y = test_random_range(&state, 0, atlas_h - h);
+                test_write_cell(&dirty, slice, x, y, w, h, &stamp);
+                written += (uint64_t)w*h;
+                write_count += 1;
+                for (int32_t s = 0; s < slice_count; s += 1){
+                    TEST_CHECK(dirty.rect_counts[s] <= ATLAS_DIRTY_MAX_RECTS);
+                }
+            }
+            
+            int32_t uploads_before = texture.uploads;
+            atlas_dirty_flush(&dirty, test_upload, &texture);
+            TEST_CHECK(texture.uploads - uploads_before <= slice_count*ATLAS_DIRTY_MAX_RECTS);
+            TEST_CHECK(frame_writes > 0 || texture.uploads == uploads_before);
+            TEST_CHECK(memcmp(texture.texels, dirty.texels, atlas_bytes) == 0);
+            for (int32_t s = 0; s < slice_count; s += 1){
+                TEST_CHECK(dirty.rect_counts[s] == 0);
+            }
+        }
+        
+        TEST_CHECK(texture.bad_uploads == 0);
+        TEST_CHECK(dirty.stats.glyphs == (uint64_t)write_count);
+        TEST_CHECK(dirty.stats.written == written);
+        TEST_CHECK(dirty.stats.uploads == (uint64_t)texture.uploads);
+        TEST_CHECK(dirty.stats.uploaded == (uint64_t)texture.uploaded);
+        TEST_CHECK(dirty.stats.flushes == (uint64_t)test_frame_count);
+        if (test_state.failures != failures_before){
+            printf("    scenario %d: %dx%dx%d atlas, slack %d\n", scenario, atlas_w, atlas_h, slice_count, merge_slack);
+        }
+        total_writes += write_count;
+        total_uploads += texture.uploads;
+        total_merges += dirty.stats.merges;
+        
+        free(texture.texels);
+        atlas_dirty_free(&dirty);
+    }
+    
+    printf("atlas_dirty_test: %llu writes reached the texture in %llu uploads after %llu merges\n",
+           (unsigned long long)total_writes, (unsigned long long)total_uploads, (unsigned long long)total_merges);
+    return(test_finish("atlas_dirty_test", seed));
+}
@@ -0,0 +1,153 @@
+// DirectWrite rasterization example: atlas texels packed as coverage levels
+// The blend only ever looks at C = int(S*6 + 0.1) of each subpixel channel, seven levels. Three
+// levels fit in nine bits, so a texel packs into 16 bits instead of 24: bits 0..2 hold the red
+// level, 3..5 green and 6..8 blue. The GPU samples the packed atlas as an integer texture and reads
+// the levels straight out of the bits. On the way back to bytes every level becomes the byte that is
+// closest to level/6, and that byte quantizes back to the same level, so nothing the blend can see
+// is lost.
+
+#if !defined(EXAMPLE_ATLAS_LEVELS_H)
+#define EXAMPLE_ATLAS_LEVELS_H
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define ATLAS_LEVELS_SSSE3 1
+#include <tmmintrin.h>
+#endif
+#include <stdint.h>
+typedef int32_t bool32;
+
+#define ATLAS_LEVEL_COUNT 7
+
+// Byte for each level, the unused eighth bit pattern reads as full coverage.
+static constexpr uint8_t atlas_level_bytes[8] = {0, 43, 85, 128, 170, 213, 255, 255};
+
+// int(s/255.f*6 + 0.1f) for every byte, in integer arithmetic the SIMD path can use too.
+// The levels start at 39, 81, 124, 166, 209 and 251, none of them near a rounding edge.
+uint32_t
+atlas_level(uint8_t s){
+    return((((uint32_t)s + 4)*1543) >> 16);
+}
+
+uint16_t
+atlas_levels_pack_texel(uint8_t *rgb){
+    return((uint16_t)(atlas_level(rgb[0]) | (atlas_level(rgb[1]) << 3) | (atlas_level(rgb[2]) << 6)));
+}
+
+void
+atlas_levels_unpack_texel(uint16_t texel, uint8_t *rgb){
+    rgb[0] = atlas_level_bytes[texel & 7];
+    rgb[1] = atlas_level_bytes[(texel >> 3) & 7];
+    rgb[2] = atlas_level_bytes[(texel >> 6) & 7];
+}
+
+////////////////////////////////
+
+// Pack
+
+void
+atlas_levels_pack_scalar(uint8_t *rgb, uint16_t *out, int64_t texel_count){
+    for (int64_t i = 0; i < texel_count; i += 1){
+        out[i] = atlas_levels_pack_texel(rgb + 3*i);
+    }
+}
+
+#if defined(ATLAS_LEVELS_SSSE3)
+// Levels of eight bytes held in 16 bit lanes
+__m128i
+atlas_levels__level_epi16(__m128i s){
+    return(_mm_mulhi_epu16(_mm_add_epi16(s, _mm_set1_epi16(4)), _mm_set1_epi16(1543)));
+}
+
+__m128i
+atlas_levels__gather_channel(__m128i a, __m128i b, __m128i c, __m128i ma, __m128i mb, __m128i mc){
+    return(_mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, ma), _mm_shuffle_epi8(b, mb)), _mm_shuffle_epi8(c, mc)));
+}
+#endif
+
+// Sixteen texels per step: the 48 bytes are split into red, green and blue vectors, each channel is
+// quantized in 16 bit lanes and the three levels are merged into the packed texels.
+void
+atlas_levels_pack(uint8_t *rgb, uint16_t *out, int64_t texel_count){
+    int64_t i = 0;
+#if defined(ATLAS_LEVELS_SSSE3)
+    __m128i r0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    __m128i b0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= texel_count; i += 16){
+        __m128i a = _mm_loadu_si128((__m128i*)(rgb + 3*i));
+        __m128i b = _mm_loadu_si128((__m128i*)(rgb + 3*i + 16));
+        __m128i c = _mm_loadu_si128((__m128i*)(rgb + 3*i + 32));
+        __m128i red   = atlas_levels__gather_channel(a, b, c, r0, r1, r2);
+        __m128i green = atlas_levels__gather_channel(a, b, c, g0, g1, g2);
+        __m128i blue  = atlas_levels__gather_channel(a, b, c, b0, b1, b2);
+        
+        __m128i lo = atlas_levels__level_epi16(_mm_unpacklo_epi8(red, zero));
+        lo = _mm_or_si128(lo, _mm_slli_epi16(atlas_levels__level_epi16(_mm_unpacklo_epi8(green, zero)), 3));
+        lo = _mm_or_si128(lo, _mm_slli_epi16(atlas_levels__level_epi16(_mm_unpacklo_epi8(blue, zero)), 6));
+        __m128i hi = atlas_levels__level_epi16(_mm_unpackhi_epi8(red, zero));
+        hi = _mm_or_si128(hi, _mm_slli_epi16(atlas_levels__level_epi16(_mm_unpackhi_epi8(green, zero)), 3));
+        hi = _mm_or_si128(hi, _mm_slli_epi16(atlas_levels__level_epi16(_mm_unpackhi_epi8(blue, zero)), 6));
+        _mm_storeu_si128((__m128i*)(out + i), lo);
+        _mm_storeu_si128((__m128i*)(out + i + 8), hi);
+    }
+#endif
+    atlas_levels_pack_scalar(rgb + 3*i, out + i, texel_count - i);
+}
+
+////////////////////////////////
+
+// Unpack
+
+void
+atlas_levels_unpack_scalar(uint16_t *in, uint8_t *rgb, int64_t texel_count){
+    for (int64_t i = 0; i < texel_count; i += 1){
+        atlas_levels_unpack_texel(in[i], rgb + 3*i);
+    }
+}
+
+// Sixteen texels per step: the levels are pulled out into byte vectors, turned into bytes with one
+// table shuffle and interleaved back into 48 bytes of RGB.
+void
+atlas_levels_unpack(uint16_t *in, uint8_t *rgb, int64_t texel_count){
+    int64_t i = 0;
+#if defined(ATLAS_LEVELS_SSSE3)
+    __m128i r0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+    __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+    __m128i b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    __m128i r1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+    __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+    __m128i b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+    __m128i r2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    __m128i b2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+    __m128i bytes = _mm_setr_epi8(0, 43, 85, (char)128, (char)170, (char)213, (char)255, (char)255, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m128i seven = _mm_set1_epi16(7);
+    for (; i + 16 <= texel_count; i += 16){
+        __m128i lo = _mm_loadu_si128((__m128i*)(in + i));
+        __m128i hi = _mm_loadu_si128((__m128i*)(in + i + 8));
+        __m128i red   = _mm_packus_epi16(_mm_and_si128(lo, seven), _mm_and_si128(hi, seven));
+        __m128i green = _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(lo, 3), seven), _mm_and_si128(_mm_srli_epi16(hi, 3), seven));
+        __m128i blue  = _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(lo, 6), seven), _mm_and_si128(_mm_srli_epi16(hi, 6), seven));
+        red   = _mm_shuffle_epi8(bytes, red);
+        green = _mm_shuffle_epi8(bytes, green);
+        blue  = _mm_shuffle_epi8(bytes, blue);
+        
+        __m128i a = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(red, r0), _mm_shuffle_epi8(green, g0)), _mm_shuffle_epi8(blue, b0));
+        __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(red, r1), _mm_shuffle_epi8(green, g1)), _mm_shuffle_epi8(blue, b1));
+        __m128i c = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(red, r2), _mm_shuffle_epi8(green, g2)), _mm_shuffle_epi8(blue, b2));
+        _mm_storeu_si128((__m128i*)(rgb + 3*i), a);
+        _mm_storeu_si128((__m128i*)(rgb + 3*i + 16), b);
+        _mm_storeu_si128((__m128i*)(rgb + 3*i + 32), c);
+    }
+#endif
+    atlas_levels_unpack_scalar(in + i, rgb + 3*i, texel_count - i);
+}
+
+#endif
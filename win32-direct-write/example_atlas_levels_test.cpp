@@ -0,0 +1,168 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the packed coverage level atlas
+// usage: atlas_levels_test [seed]
+// The integer level formula against the shader's float one for every byte, and every packed texel
+// through unpack and pack. Then the SIMD kernels against the scalar ones on every length up to a few
+// steps and on long random runs: the same texels and bytes come out, every byte keeps its level,
+// and nothing is written past the end of the output.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_atlas_levels.h"
+#include "example_test.h"
+
+static int32_t test_short_max = 80;
+static int32_t test_random_run_count = 200;
+static int32_t test_random_run_max = 20000;
+
+// Past the end of every output buffer
+#define TEST_GUARD_BYTES 64
+#define TEST_GUARD 0xA5
+
+bool32
+test_guard_intact(uint8_t *end){
+    for (int32_t i = 0; i < TEST_GUARD_BYTES; i += 1){
+        if (end[i] != TEST_GUARD){
+            return(false);
+        }
+    }
+    return(true);
+}
+
+// Runs both kernels of both directions on texel_count texels of rgb.
+void
+test_kernels(uint8_t *rgb, int64_t texel_count){
+    int64_t failures_before = test_state.failures;
+    size_t packed_size = sizeof(uint16_t)*texel_count;
+    size_t rgb_size = 3*texel_count;
+    uint16_t *packed_scalar = (uint16_t*)malloc(packed_size + TEST_GUARD_BYTES);
+    uint16_t *packed_simd = (uint16_t*)malloc(packed_size + TEST_GUARD_BYTES);
+    uint8_t *rgb_scalar = (uint8_t*)malloc(rgb_size + TEST_GUARD_BYTES);
+    uint8_t *rgb_simd = (uint8_t*)malloc(rgb_size + TEST_GUARD_BYTES);
+    memset(packed_scalar, TEST_GUARD, packed_size + TEST_GUARD_BYTES);
+    memset(packed_simd, TEST_GUARD, packed_size + TEST_GUARD_BYTES);
+    memset(rgb_scalar, TEST_GUARD, rgb_size + TEST_GUARD_BYTES);
+    memset(rgb_simd, TEST_GUARD, rgb_size + TEST_GUARD_BYTES);
+    
+    atlas_levels_pack_scalar(rgb, packed_scalar, texel_count);
+    atlas_levels_pack(rgb, packed_simd, texel_count);
+    TEST_CHECK(memcmp(packed_scalar, packed_simd, packed_size) == 0);
+    TEST_CHECK(test_guard_intact((uint8_t*)packed_simd + packed_size));
+    for (int64_t i = 0; i < texel_count; i += 1){
+        if (!TEST_CHECK(packed_scalar[i] == atlas_levels_pack_texel(rgb + 3*i))){
+            break;
+        }
+    }
+    
+    atlas_levels_unpack_scalar(packed_scalar, rgb_scalar, texel_count);
+    atlas_levels_unpack(packed_simd, rgb_simd, texel_count);
+    TEST_CHECK(memcmp(rgb_scalar, rgb_simd, rgb_size) == 0);
+    TEST_CHECK(test_guard_intact(rgb_simd + rgb_size));
+    for (size_t i = 0; i < rgb_size; i += 1){
+        if (!TEST_CHECK(atlas_level(rgb[i]) == atlas_level(rgb_simd[i]))){
+            break;
+        }
+    }
+    if (test_state.failures != failures_before){
+        printf("    %lld texels\n", (long long)texel_count);
+    }
+    
+    free(rgb_simd);
+    free(rgb_scalar);
+    free(packed_simd);
+    free(packed_scalar);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x1E7E15u);
+    uint32_t state = seed;
+    
+    // Levels
+    for (int32_t s = 0; s < 256; s += 1){
+        TEST_CHECK(atlas_level((uint8_t)s) == (uint32_t)(int32_t)((float)s/255.f*6.f + 0.1f));
+    }
+    for (int32_t level = 0; level < ATLAS_LEVEL_COUNT; level += 1){
+        TEST_CHECK(atlas_level(atlas_level_bytes[level]) == (uint32_t)level);
+    }
+    TEST_CHECK(atlas_level(atlas_level_bytes[7]) == ATLAS_LEVEL_COUNT - 1);
+    for (uint32_t texel = 0; texel < 512; texel += 1){
+        uint8_t rgb[3];
+        atlas_levels_unpack_texel((uint16_t)texel, rgb);
+        uint32_t expected = 0;
+        for (int32_t c = 0; c < 3; c += 1){
+            uint32_t level = (texel >> (3*c)) & 7;
+            level = (level == 7)?(ATLAS_LEVEL_COUNT - 1):level;
+            expected |= level << (3*c);
+        }
+        TEST_CHECK(atlas_levels_pack_texel(rgb) == expected);
+    }
+    
+    // Kernels
+    // Every byte value in every channel, at every length that ends a SIMD step early or late
+    int32_t pattern_count = 4096 + 13;
+    uint8_t *pattern = (uint8_t*)malloc(3*pattern_count);
+    for (int32_t i = 0; i < pattern_count; i += 1){
+        pattern[3*i + 0] = (uint8_t)i;
+        pattern[3*i + 1] = (uint8_t)(7*i + 1);
+        pattern[3*i + 2] = (uint8_t)(13*i + 2);
+    }
+    for (int32_t count = 0; count <= test_short_max; count += 1){
+        test_kernels(pattern, count);
+    }
+    test_kernels(pattern, pattern_count);
+    free(pattern);
+    
+    // Random runs, mostly empty texels and full ones like a real atlas
+    uint8_t *rgb = (uint8_t*)malloc(3*test_random_run_max);
+    for (int32_t run = 0; run < test_random_run_count; run += 1){
+        int32_t count = test_random_range(&state, 1, test_random_run_max);
+        for (int32_t i = 0; i < 3*count; i += 1){
+            int32_t kind = test_random_range(&state, 0, 3);
+            rgb[i] = (kind == 0)?0:(kind == 1)?255:(uint8_t)test_random(&state);
+        }
+        test_kernels(rgb, count);
+    }
+    free(rgb);
+    
+    // Words with the seven bits above the levels set must unpack the same both ways.
+    {
+        int32_t count = 4096 + 7;
+        uint16_t *words = (uint16_t*)malloc(sizeof(uint16_t)*count);
+        uint8_t *rgb_scalar = (uint8_t*)malloc(3*count);
+        uint8_t *rgb_simd = (uint8_t*)malloc(3*count);
+        for (int32_t i = 0; i < count; i += 1){
+            words[i] = (uint16_t)test_random(&state);
+        }
+        atlas_levels_unpack_scalar(words, rgb_scalar, count);
+        atlas_levels_unpack(words, rgb_simd, count);
+        TEST_CHECK(memcmp(rgb_scalar, rgb_simd, 3*count) == 0);
+        free(rgb_simd);
+        free(rgb_scalar);
+        free(words);
+    }
+
+#if ATLAS_LEVELS_SSSE3
+    printf("atlas_levels_test: SSSE3 kernels against the scalar ones\n");
+#else
+    printf("atlas_levels_test: no SSSE3 in this build, the kernels are the scalar ones\n");
+#endif
+    return(test_finish("atlas_levels_test", seed));
+}
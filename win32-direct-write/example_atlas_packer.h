@@ -0,0 +1,218 @@
+// DirectWrite rasterization example: skyline rectangle packer for the glyph atlas
+// This file has no platform dependencies so the packing can be measured anywhere.
+
+#if !defined(EXAMPLE_ATLAS_PACKER_H)
+#define EXAMPLE_ATLAS_PACKER_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+struct Atlas_Skyline_Node{
+    int32_t x;
+    int32_t y;
+    int32_t w;
+};
+
+struct Atlas_Slot{
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+    int32_t slice;
+};
+
+struct Atlas_Packer{
+    int32_t slice_w;
+    int32_t slice_h;
+    int32_t padding;
+    
+    // The skyline of the slice currently being filled. Earlier slices are closed.
+    Atlas_Skyline_Node *nodes;
+    int32_t node_count;
+    int32_t node_max;
+    
+    int32_t slice_count;
+    int64_t used_area;
+    int32_t rect_count;
+};
+
+void
+atlas_packer_reset_skyline(Atlas_Packer *packer){
+    packer->nodes[0].x = 0;
+    packer->nodes[0].y = 0;
+    packer->nodes[0].w = packer->slice_w;
+    packer->node_count = 1;
+}
+
+Atlas_Packer
+atlas_packer_init(int32_t slice_w, int32_t slice_h, int32_t padding){
+    Atlas_Packer packer = {0};
+    packer.slice_w = slice_w;
+    packer.slice_h = slice_h;
+    packer.padding = padding;
+    // Every node covers at least one column, so the skyline can never have more nodes than columns.
+    packer.node_max = slice_w + 1;
+    packer.nodes = (Atlas_Skyline_Node*)malloc(sizeof(Atlas_Skyline_Node)*packer.node_max);
+    atlas_packer_reset_skyline(&packer);
+    packer.slice_count = 1;
+    return(packer);
+}
+
+void
+atlas_packer_free(Atlas_Packer *packer){
+    free(packer->nodes);
+    memset(packer, 0, sizeof(*packer));
+}
+
+// Returns the y at which a w wide rect fits when its left edge is on node i, or -1 if it does not fit.
+int32_t
+atlas_packer__fit(Atlas_Packer *packer, int32_t i, int32_t w, int32_t h){
+    int32_t x = packer->nodes[i].x;
+    if (x + w > packer->slice_w){
+        return(-1);
+    }
+    int32_t y = 0;
+    int32_t remaining = w;
+    for (; remaining > 0; i += 1){
+        assert(i < packer->node_count);
+        if (packer->nodes[i].y > y){
+            y = packer->nodes[i].y;
+        }
+        if (y + h > packer->slice_h){
+            return(-1);
+        }
+        remaining -= packer->nodes[i].w;
+    }
+    return(y);
+}
+
+bool32
+atlas_packer__insert(Atlas_Packer *packer, int32_t w, int32_t h, int32_t *x_out, int32_t *y_out){
+    // Bottom-left rule: lowest resulting top edge wins, ties go to the narrowest node.
+    int32_t best_i = -1;
+    int32_t best_top = packer->slice_h + 1;
+    int32_t best_w = packer->slice_w + 1;
+    int32_t best_y = 0;
+    for (int32_t i = 0; i < packer->node_count; i += 1){
+        int32_t y = atlas_packer__fit(packer, i, w, h);
+        if (y >= 0){
+            int32_t top = y + h;
+            if (top < best_top || (top == best_top && packer->nodes[i].w < best_w)){
+                best_i = i;
+                best_top = top;
+                best_w = packer->nodes[i].w;
+                best_y = y;
+            }
+        }
+    }
+    if (best_i < 0){
+        return(false);
+    }
+    
+    int32_t x = packer->nodes[best_i].x;
+    
+    // Insert the new node, then eat into the nodes it shadows.
+    assert(packer->node_count < packer->node_max);
+    memmove(packer->nodes + best_i + 1, packer->nodes + best_i,
+            sizeof(Atlas_Skyline_Node)*(packer->node_count - best_i));
+    packer->node_count += 1;
+    packer->nodes[best_i].x = x;
+    packer->nodes[best_i].y = best_y + h;
+    packer->nodes[best_i].w = w;
+    
+    int32_t right = x + w;
+    for (int32_t i = best_i + 1; i < packer->node_count;){
+        Atlas_Skyline_Node *node = &packer->nodes[i];
+        if (node->x >= right){
+            break;
+        }
+        int32_t node_right = node->x + node->w;
+        if (node_right <= right){
+            memmove(packer->nodes + i, packer->nodes + i + 1,
+                    sizeof(Atlas_Skyline_Node)*(packer->node_count - i - 1));
+            packer->node_count -= 1;
+        }
+        else{
+            node->w = node_right - right;
+            node->x = right;
+            break;
+        }
+    }
+    
+    // Merge neighbours at the same height.
+    for (int32_t i = 0; i + 1 < packer->node_count;){
+        if (packer->nodes[i].y == packer->nodes[i + 1].y){
+            packer->nodes[i].w += packer->nodes[i + 1].w;
+            memmove(packer->nodes + i + 1, packer->nodes + i + 2,
+                    sizeof(Atlas_Skyline_Node)*(packer->node_count - i - 2));
+            packer->node_count -= 1;
+        }
+        else{
+            i += 1;
+        }
+    }
+    
+    *x_out = x;
+    *y_out = best_y;
+    return(true);
+}
+
+// Places a w by h rect, opening a new slice when the current one is full.
+// Zero area rects get an empty slot and consume no space.
+// Returns false only if the rect can never fit in a slice.
+bool32
+atlas_packer_pack(Atlas_Packer *packer, int32_t w, int32_t h, Atlas_Slot *slot){
+    memset(slot, 0, sizeof(*slot));
+    if (w <= 0 || h <= 0){
+        return(true);
+    }
+    
+    int32_t padded_w = w + packer->padding;
+    int32_t padded_h = h + packer->padding;
+    if (padded_w > packer->slice_w || padded_h > packer->slice_h){
+        return(false);
+    }
+    
+    int32_t x = 0;
+    int32_t y = 0;
+    if (!atlas_packer__insert(packer, padded_w, padded_h, &x, &y)){
+        atlas_packer_reset_skyline(packer);
+        packer->slice_count += 1;
+        bool32 success = atlas_packer__insert(packer, padded_w, padded_h, &x, &y);
+        assert(success);
+    }
+    
+    slot->x = x;
+    slot->y = y;
+    slot->w = w;
+    slot->h = h;
+    slot->slice = packer->slice_count - 1;
+    packer->used_area += (int64_t)w*(int64_t)h;
+    packer->rect_count += 1;
+    return(true);
+}
+
+// Fraction of the allocated slice area covered by glyph texels.
+float
+atlas_packer_efficiency(Atlas_Packer *packer){
+    int64_t total_area = (int64_t)packer->slice_w*(int64_t)packer->slice_h*(int64_t)packer->slice_count;
+    float result = 0.f;
+    if (total_area > 0){
+        result = (float)((double)packer->used_area/(double)total_area);
+    }
+    return(result);
+}
+
+// Slices big enough to hold a few hundred glyphs of the given cap height.
+int32_t
+atlas_packer_choose_slice_side(int32_t cap_height_px){
+    int32_t side = 32*cap_height_px;
+    int32_t result = 256;
+    for (; result < side && result < 2048; result *= 2);
+    return(result);
+}
+
+#endif
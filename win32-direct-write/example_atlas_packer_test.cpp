@@ -0,0 +1,176 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the skyline atlas packer
+// usage: atlas_packer_test [seed]
+// Packs sets of random rects into random slice sizes and paddings. Every placed rect, padding
+// included, must lie inside its slice and cover no texel of another; a rect only opens a new slice
+// when it is placed, and then at the corner of that slice; rects that can never fit are refused
+// without touching the packer; the area and count totals match what was placed.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_atlas_packer.h"
+#include "example_test.h"
+
+static int32_t test_set_count = 1000;
+static int32_t test_set_rect_max = 400;
+
+enum{
+    // Glyph sized
+    TestShape_Small,
+    TestShape_Tall,
+    TestShape_Wide,
+    // From half a slice to a full slice, most sets open several slices
+    TestShape_Big,
+    // Anything from zero area to past the slice, to be refused or skipped
+    TestShape_Edge,
+    TestShape_COUNT,
+};
+
+void
+test_random_rect(uint32_t *state, int32_t shape, int32_t slice_w, int32_t slice_h, int32_t *w, int32_t *h){
+    switch (shape){
+        case TestShape_Small:
+        {
+            *w = test_random_range(state, 1, 32);
+            *h = test_random_range(state, 1, 32);
+        }break;
+        
+        case TestShape_Tall:
+        {
+            *w = test_random_range(state, 1, 4);
+            *h = test_random_range(state, 1, slice_h);
+        }break;
+        
+        case TestShape_Wide:
+        {
+            *w = test_random_range(state, 1, slice_w);
+            *h = test_random_range(state, 1, 4);
+        }break;
+        
+        case TestShape_Big:
+        {
+            *w = test_random_range(state, slice_w/2, slice_w);
+            *h = test_random_range(state, slice_h/2, slice_h);
+        }break;
+        
+        default:
+        {
+            *w = test_random_range(state, -2, slice_w + 4);
+            *h = test_random_range(state, -2, slice_h + 4);
+        }break;
+    }
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x2F6E2B1u);
+    uint32_t state = seed;
+    
+    // One texel per byte of the slice being filled. Earlier slices are closed, nothing lands there.
+    int32_t side_max = 512;
+    uint8_t *used = (uint8_t*)malloc(side_max*side_max);
+    
+    int64_t rect_total = 0;
+    int64_t refused_total = 0;
+    int64_t slice_total = 0;
+    for (int32_t set = 0; set < test_set_count; set += 1){
+        int64_t failures_before = test_state.failures;
+        int32_t slice_w = 32 << test_random_range(&state, 0, 4);
+        int32_t slice_h = 32 << test_random_range(&state, 0, 4);
+        int32_t padding = test_random_range(&state, 0, 2);
+        int32_t shape = test_random_range(&state, 0, TestShape_COUNT);
+        int32_t rect_count = test_random_range(&state, 1, test_set_rect_max);
+        
+        Atlas_Packer packer = atlas_packer_init(slice_w, slice_h, padding);
+        memset(used, 0, side_max*side_max);
+        int64_t area = 0;
+        int32_t placed = 0;
+        for (int32_t i = 0; i < rect_count; i += 1){
+            // Shape COUNT mixes every shape in one set.
+            int32_t rect_shape = (shape == TestShape_COUNT)?test_random_range(&state, 0, TestShape_COUNT - 1):shape;
+            int32_t w = 0;
+            int32_t h = 0;
+            test_random_rect(&state, rect_shape, slice_w, slice_h, &w, &h);
+            
+            int32_t slice_count_before = packer.slice_count;
+            int64_t used_area_before = packer.used_area;
+            Atlas_Slot slot = {0};
+            bool32 packed = atlas_packer_pack(&packer, w, h, &slot);
+            
+            bool32 empty = (w <= 0 || h <= 0);
+            bool32 fits = (w + padding <= slice_w && h + padding <= slice_h);
+            TEST_CHECK(packed == (empty || fits));
+            if (empty || !packed){
+                // Nothing placed, nothing changed.
+                refused_total += !packed;
+                TEST_CHECK(slot.w == 0 && slot.h == 0);
+                TEST_CHECK(packer.slice_count == slice_count_before);
+                TEST_CHECK(packer.used_area == used_area_before);
+                continue;
+            }
+            
+            TEST_CHECK(slot.w == w && slot.h == h);
+            TEST_CHECK(slot.slice == packer.slice_count - 1);
+            TEST_CHECK(packer.slice_count == slice_count_before || packer.slice_count == slice_count_before + 1);
+            if (packer.slice_count != slice_count_before){
+                // A fresh skyline puts the first rect in the corner.
+                TEST_CHECK(slot.x == 0 && slot.y == 0);
+                memset(used, 0, side_max*side_max);
+            }
+            
+            int32_t x1 = slot.x + w + padding;
+            int32_t y1 = slot.y + h + padding;
+            bool32 in_bounds = (slot.x >= 0 && slot.y >= 0 && x1 <= slice_w && y1 <= slice_h);
+            TEST_CHECK(in_bounds);
+            if (in_bounds){
+                int32_t overlap = 0;
+                for (int32_t y = slot.y; y < y1; y += 1){
+                    uint8_t *row = used + y*side_max;
+                    for (int32_t x = slot.x; x < x1; x += 1){
+                        overlap += row[x];
+                        row[x] = 1;
+                    }
+                }
+                TEST_CHECK(overlap == 0);
+            }
+            area += (int64_t)w*h;
+            placed += 1;
+        }
+        
+        TEST_CHECK(packer.used_area == area);
+        TEST_CHECK(packer.rect_count == placed);
+        TEST_CHECK(packer.node_count >= 1 && packer.node_count <= packer.node_max);
+        float efficiency = atlas_packer_efficiency(&packer);
+        TEST_CHECK(efficiency >= 0.f && efficiency <= 1.f);
+        if (test_state.failures != failures_before){
+            printf("    set %d: %dx%d slices, padding %d, shape %d, %d rects\n",
+                   set, slice_w, slice_h, padding, shape, rect_count);
+        }
+        
+        rect_total += placed;
+        slice_total += packer.slice_count;
+        atlas_packer_free(&packer);
+    }
+    free(used);
+    
+    printf("atlas_packer_test: %d sets, %lld rects placed in %lld slices, %lld refused\n",
+           test_set_count, (long long)rect_total, (long long)slice_total, (long long)refused_total);
+    return(test_finish("atlas_packer_test", seed));
+}
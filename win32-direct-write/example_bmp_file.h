@@ -0,0 +1,335 @@
+// DirectWrite rasterization example: 24 bit BMP files
+// Images are passed around as rows of 32 bit pixels with the bytes R, G, B, X in memory, the layout
+// of a Cpu_Framebuffer. The file side is the plain uncompressed 24 bit BMP, rows stored bottom up.
+// Writing streams: the headers go out first and the rows follow, converted into a chunk of at most
+// BMP_WRITE_CHUNK_SIZE bytes (or one row, if a row is bigger) and written with a vectored write,
+// the headers riding along with the first chunk. Memory stays at one chunk whatever the image size.
+// GDI's DIB sections hold B, G, R, X, which BmpPixels_BGRX writes without the swap.
+
+#if !defined(EXAMPLE_BMP_FILE_H)
+#define EXAMPLE_BMP_FILE_H
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+
+#define BMP_WRITE_CHUNK_SIZE (64 << 10)
+
+#pragma pack(push, 1)
+struct Bmp_Header{
+    char sig[2];
+    uint32_t file_size;
+    uint32_t reserved;
+    uint32_t data_offset;
+};
+
+struct Bmp_Info_Header{
+    uint32_t size;
+    int32_t width;
+    int32_t height;
+    uint16_t planes;
+    uint16_t bits_per_pixel;
+    uint32_t compression;
+    uint32_t image_size;
+    uint32_t x_pixels_per_meter;
+    uint32_t y_pixels_per_meter;
+    uint32_t colors_used;
+    uint32_t important_colors;
+};
+#pragma pack(pop)
+
+// Byte order of the 32 bit pixels handed to the writer
+enum{
+    BmpPixels_RGBX,
+    BmpPixels_BGRX,
+};
+
+struct Bmp_Write_Span{
+    void *data;
+    uint64_t size;
+};
+
+struct Bmp_Writer{
+#if defined(_WIN32)
+    HANDLE file;
+#else
+    int fd;
+#endif
+    int32_t width;
+    int32_t height;
+    int32_t pixel_format;
+    int32_t out_pitch;
+    Bmp_Header header;
+    Bmp_Info_Header info_header;
+    bool32 header_written;
+    // chunk_rows converted rows, chunk_used of them waiting to go out
+    uint8_t *chunk;
+    int32_t chunk_rows;
+    int32_t chunk_used;
+    int32_t rows_pushed;
+    bool32 failed;
+    uint64_t bytes_written;
+};
+
+int32_t
+bmp_pitch(int32_t width){
+    return((width*3 + 3) & ~3);
+}
+
+////////////////////////////////
+
+// Streaming Writer
+
+// Writes every span in order, however many tries the system takes.
+bool32
+bmp__write_spans(Bmp_Writer *writer, Bmp_Write_Span *spans, int32_t count){
+#if defined(_WIN32)
+    for (int32_t i = 0; i < count; i += 1){
+        uint8_t *data = (uint8_t*)spans[i].data;
+        uint64_t size = spans[i].size;
+        for (;size > 0;){
+            DWORD part = (size > (1u << 30))?(1u << 30):(DWORD)size;
+            DWORD written = 0;
+            if (!WriteFile(writer->file, data, part, &written, 0) || written == 0){
+                return(false);
+            }
+            data += written;
+            size -= written;
+            writer->bytes_written += written;
+        }
+    }
+    return(true);
+#else
+    struct iovec vectors[4];
+    assert(count <= 4);
+    for (int32_t i = 0; i < count; i += 1){
+        vectors[i].iov_base = spans[i].data;
+        vectors[i].iov_len = (size_t)spans[i].size;
+    }
+    struct iovec *first = vectors;
+    for (;count > 0;){
+        ssize_t written = writev(writer->fd, first, count);
+        if (written <= 0){
+            return(false);
+        }
+        writer->bytes_written += (uint64_t)written;
+        // Step past what went out, a short write can stop in the middle of a span.
+        for (;count > 0 && (size_t)written >= first->iov_len;){
+            written -= (ssize_t)first->iov_len;
+            first += 1;
+            count -= 1;
+        }
+        if (count > 0){
+            first->iov_base = (uint8_t*)first->iov_base + written;
+            first->iov_len -= (size_t)written;
+        }
+    }
+    return(true);
+#endif
+}
+
+void
+bmp__flush_chunk(Bmp_Writer *writer){
+    Bmp_Write_Span spans[3];
+    int32_t span_count = 0;
+    if (!writer->header_written){
+        spans[span_count].data = &writer->header;
+        spans[span_count].size = sizeof(writer->header);
+        span_count += 1;
+        spans[span_count].data = &writer->info_header;
+        spans[span_count].size = sizeof(writer->info_header);
+        span_count += 1;
+        writer->header_written = true;
+    }
+    if (writer->chunk_used > 0){
+        spans[span_count].data = writer->chunk;
+        spans[span_count].size = (uint64_t)writer->out_pitch*writer->chunk_used;
+        span_count += 1;
+    }
+    if (!writer->failed && span_count > 0 && !bmp__write_spans(writer, spans, span_count)){
+        writer->failed = true;
+    }
+    writer->chunk_used = 0;
+}
+
+// Opens the file and sets up the headers. False if the file cannot be made or the image is too big
+// for a BMP's 32 bit sizes.
+bool32
+bmp_writer_begin(Bmp_Writer *writer, char *file_name, int32_t width, int32_t height, int32_t pixel_format){
+    memset(writer, 0, sizeof(*writer));
+    if (width <= 0 || height <= 0 || width > (1 << 28)){
+        return(false);
+    }
+    int32_t out_pitch = bmp_pitch(width);
+    uint64_t file_size = sizeof(Bmp_Header) + sizeof(Bmp_Info_Header) + (uint64_t)out_pitch*height;
+    if (file_size > 0xFFFFFFFFull){
+        return(false);
+    }
+#if defined(_WIN32)
+    writer->file = CreateFileA(file_name, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if (writer->file == INVALID_HANDLE_VALUE){
+        return(false);
+    }
+#else
+    writer->fd = open(file_name, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (writer->fd < 0){
+        return(false);
+    }
+#endif
+    
+    writer->width = width;
+    writer->height = height;
+    writer->pixel_format = pixel_format;
+    writer->out_pitch = out_pitch;
+    writer->header.sig[0] = 'B';
+    writer->header.sig[1] = 'M';
+    writer->header.data_offset = sizeof(Bmp_Header) + sizeof(Bmp_Info_Header);
+    writer->header.file_size = (uint32_t)file_size;
+    writer->info_header.size = sizeof(Bmp_Info_Header);
+    writer->info_header.width = width;
+    writer->info_header.height = height;
+    writer->info_header.planes = 1;
+    writer->info_header.bits_per_pixel = 24;
+    
+    writer->chunk_rows = BMP_WRITE_CHUNK_SIZE/out_pitch;
+    writer->chunk_rows = (writer->chunk_rows < 1)?1:writer->chunk_rows;
+    writer->chunk_rows = (writer->chunk_rows > height)?height:writer->chunk_rows;
+    size_t chunk_size = (size_t)out_pitch*writer->chunk_rows;
+    writer->chunk = (uint8_t*)heap_alloc(chunk_size);
+    // The padding at the end of each row is never written over, so it stays zero.
+    memset(writer->chunk, 0, chunk_size);
+    return(true);
+}
+
+// Converts the next row of the file, which starts with the bottom row of the image.
+void
+bmp_writer_push_row(Bmp_Writer *writer, void *pixels){
+    assert(writer->rows_pushed < writer->height);
+    uint8_t *in_pixel = (uint8_t*)pixels;
+    uint8_t *out_pixel = writer->chunk + (size_t)writer->out_pitch*writer->chunk_used;
+    int32_t width = writer->width;
+    if (writer->pixel_format == BmpPixels_BGRX){
+        for (int32_t x = 0; x < width; x += 1){
+            out_pixel[0] = in_pixel[0];
+            out_pixel[1] = in_pixel[1];
+            out_pixel[2] = in_pixel[2];
+            in_pixel += 4;
+            out_pixel += 3;
+        }
+    }
+    else{
+        for (int32_t x = 0; x < width; x += 1){
+            out_pixel[0] = in_pixel[2];
+            out_pixel[1] = in_pixel[1];
+            out_pixel[2] = in_pixel[0];
+            in_pixel += 4;
+            out_pixel += 3;
+        }
+    }
+    writer->chunk_used += 1;
+    writer->rows_pushed += 1;
+    if (writer->chunk_used == writer->chunk_rows){
+        bmp__flush_chunk(writer);
+    }
+}
+
+// Writes what is left and closes the file. False if any write failed or rows are missing.
+bool32
+bmp_writer_end(Bmp_Writer *writer){
+    bmp__flush_chunk(writer);
+    bool32 result = (!writer->failed && writer->rows_pushed == writer->height);
+#if defined(_WIN32)
+    CloseHandle(writer->file);
+#else
+    if (close(writer->fd) != 0){
+        result = false;
+    }
+#endif
+    heap_free(writer->chunk);
+    memset(writer, 0, sizeof(*writer));
+    return(result);
+}
+
+// Writes an image held top down, rows pitch bytes apart.
+bool32
+bmp_write_pixels(char *file_name, void *pixels, int32_t width, int32_t height, int32_t pitch, int32_t pixel_format){
+    Bmp_Writer writer = {0};
+    if (!bmp_writer_begin(&writer, file_name, width, height, pixel_format)){
+        return(false);
+    }
+    for (int32_t y = height - 1; y >= 0; y -= 1){
+        bmp_writer_push_row(&writer, (uint8_t*)pixels + (size_t)y*pitch);
+    }
+    return(bmp_writer_end(&writer));
+}
+
+// pitch is in pixels, as in a Cpu_Framebuffer.
+bool32
+bmp_write_rgbx(char *file_name, uint32_t *pixels, int32_t width, int32_t height, int32_t pitch){
+    return(bmp_write_pixels(file_name, pixels, width, height, pitch*4, BmpPixels_RGBX));
+}
+
+////////////////////////////////
+
+// Reading
+
+// Reads what bmp_write_rgbx writes: uncompressed 24 bit, bottom up or top down. Returns zero on
+// anything else, the pixels come back with a pitch of width.
+uint32_t*
+bmp_read_rgbx(char *file_name, int32_t *width_out, int32_t *height_out){
+    FILE *in = fopen(file_name, "rb");
+    if (in == 0){
+        return(0);
+    }
+    
+    uint32_t *pixels = 0;
+    Bmp_Header header = {0};
+    Bmp_Info_Header info_header = {0};
+    if (fread(&header, sizeof(header), 1, in) == 1 &&
+        fread(&info_header, sizeof(info_header), 1, in) == 1 &&
+        header.sig[0] == 'B' && header.sig[1] == 'M' &&
+        info_header.bits_per_pixel == 24 && info_header.compression == 0 &&
+        info_header.width > 0 && info_header.height != 0 &&
+        fseek(in, header.data_offset, SEEK_SET) == 0){
+        int32_t width = info_header.width;
+        bool32 bottom_up = (info_header.height > 0);
+        int32_t height = bottom_up?info_header.height:-info_header.height;
+        int32_t in_pitch = bmp_pitch(width);
+        
+        pixels = (uint32_t*)heap_alloc(sizeof(uint32_t)*width*height);
+        uint8_t *row = (uint8_t*)heap_alloc(in_pitch);
+        for (int32_t i = 0; i < height; i += 1){
+            if (fread(row, 1, in_pitch, in) != (size_t)in_pitch){
+                heap_free(pixels);
+                pixels = 0;
+                break;
+            }
+            int32_t y = bottom_up?(height - 1 - i):i;
+            uint8_t *in_pixel = row;
+            uint32_t *out_pixel = pixels + (size_t)y*width;
+            for (int32_t x = 0; x < width; x += 1){
+                out_pixel[x] = (uint32_t)in_pixel[2] | ((uint32_t)in_pixel[1] << 8) | ((uint32_t)in_pixel[0] << 16);
+                in_pixel += 3;
+            }
+        }
+        heap_free(row);
+        *width_out = width;
+        *height_out = height;
+    }
+    
+    fclose(in);
+    return(pixels);
+}
+
+#endif
@@ -0,0 +1,194 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the streaming BMP writer
+// usage: bmp_file_test [seed]
+// Random images of random sizes and pitches in both byte orders are written and the file is compared
+// byte for byte with one built whole in memory: the headers, the rows bottom up with the channels
+// swapped or not, and zero padding at the end of every row. Sizes are picked around the chunk: one
+// row, rows wider than a chunk, heights a few rows past a whole number of chunks. What was written
+// reads back the same. Images a BMP cannot hold, files that cannot be made and missing rows fail.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_bmp_file.h"
+#include "example_test.h"
+
+static int32_t test_image_count = 150;
+static char *test_file_name = "bmp_file_test.bmp";
+
+uint8_t*
+test_read_file(char *file_name, int64_t *size_out){
+    uint8_t *result = 0;
+    *size_out = -1;
+    FILE *file = fopen(file_name, "rb");
+    if (file != 0){
+        fseek(file, 0, SEEK_END);
+        int64_t size = (int64_t)ftell(file);
+        fseek(file, 0, SEEK_SET);
+        result = (uint8_t*)malloc((size_t)size + 1);
+        if (fread(result, 1, (size_t)size, file) == (size_t)size){
+            *size_out = size;
+        }
+        fclose(file);
+    }
+    return(result);
+}
+
+// The whole file as it should come out, built without the writer
+uint8_t*
+test_expected_file(uint8_t *pixels, int32_t width, int32_t height, int32_t pitch, int32_t pixel_format, uint64_t *size_out){
+    int32_t out_pitch = (width*3 + 3)/4*4;
+    uint64_t data_offset = 14 + 40;
+    uint64_t size = data_offset + (uint64_t)out_pitch*height;
+    uint8_t *file = (uint8_t*)calloc((size_t)size, 1);
+    uint32_t fields[] = {
+        (uint32_t)size, 0, (uint32_t)data_offset,
+        40, (uint32_t)width, (uint32_t)height,
+    };
+    file[0] = 'B';
+    file[1] = 'M';
+    memcpy(file + 2, fields, sizeof(fields));
+    file[26] = 1;
+    file[28] = 24;
+    for (int32_t y = 0; y < height; y += 1){
+        uint8_t *in_pixel = pixels + (size_t)y*pitch;
+        uint8_t *out_pixel = file + data_offset + (size_t)out_pitch*(height - 1 - y);
+        for (int32_t x = 0; x < width; x += 1){
+            for (int32_t c = 0; c < 3; c += 1){
+                out_pixel[c] = (pixel_format == BmpPixels_BGRX)?in_pixel[c]:in_pixel[2 - c];
+            }
+            in_pixel += 4;
+            out_pixel += 3;
+        }
+    }
+    *size_out = size;
+    return(file);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0xB3Fu);
+    uint32_t state = seed;
+    TEST_CHECK(sizeof(Bmp_Header) == 14 && sizeof(Bmp_Info_Header) == 40);
+    
+    int32_t wide_width = BMP_WRITE_CHUNK_SIZE/3 + 1;
+    int32_t chunk_rows_200 = BMP_WRITE_CHUNK_SIZE/bmp_pitch(200);
+    int32_t fixed_sizes[][2] = {
+        {1, 1}, {1, 7}, {2, 3}, {3, 2}, {5, 1}, {200, 200},
+        {200, chunk_rows_200}, {200, chunk_rows_200 + 1}, {200, 3*chunk_rows_200 - 1},
+        {wide_width, 1}, {wide_width, 3},
+    };
+    int32_t fixed_count = sizeof(fixed_sizes)/sizeof(fixed_sizes[0]);
+    
+    uint64_t total_bytes = 0;
+    for (int32_t image = 0; image < fixed_count + test_image_count; image += 1){
+        int64_t failures_before = test_state.failures;
+        int32_t width = 0;
+        int32_t height = 0;
+        if (image < fixed_count){
+            width = fixed_sizes[image][0];
+            height = fixed_sizes[image][1];
+        }
+        else{
+            width = test_random_range(&state, 1, 700);
+            height = test_random_range(&state, 1, 300);
+        }
+        int32_t pitch = width*4 + 4*test_random_range(&state, 0, 5);
+        int32_t pixel_format = (image%2 == 0)?BmpPixels_RGBX:BmpPixels_BGRX;
+        uint8_t *pixels = (uint8_t*)malloc((size_t)pitch*height);
+        for (int32_t i = 0; i < pitch*height; i += 1){
+            pixels[i] = (uint8_t)test_random(&state);
+        }
+        
+        uint64_t expected_size = 0;
+        uint8_t *expected = test_expected_file(pixels, width, height, pitch, pixel_format, &expected_size);
+        TEST_CHECK(bmp_write_pixels(test_file_name, pixels, width, height, pitch, pixel_format));
+        int64_t size = 0;
+        uint8_t *file = test_read_file(test_file_name, &size);
+        TEST_CHECK(file != 0 && (uint64_t)size == expected_size);
+        if (file != 0 && (uint64_t)size == expected_size){
+            TEST_CHECK(memcmp(file, expected, (size_t)size) == 0);
+        }
+        total_bytes += (uint64_t)(size > 0?size:0);
+        
+        // RGBX images come back as written, with X cleared.
+        if (pixel_format == BmpPixels_RGBX){
+            int32_t read_width = 0;
+            int32_t read_height = 0;
+            uint32_t *read = bmp_read_rgbx(test_file_name, &read_width, &read_height);
+            TEST_CHECK(read != 0 && read_width == width && read_height == height);
+            if (read != 0 && read_width == width && read_height == height){
+                for (int32_t y = 0; y < height; y += 1){
+                    uint32_t *row = (uint32_t*)(pixels + (size_t)y*pitch);
+                    bool32 same = true;
+                    for (int32_t x = 0; x < width; x += 1){
+                        same = same && (read[(size_t)y*width + x] == (row[x] & 0xFFFFFF));
+                    }
+                    if (!TEST_CHECK(same)){
+                        break;
+                    }
+                }
+            }
+            heap_free(read);
+        }
+        if (test_state.failures != failures_before){
+            printf("    image %d: %dx%d, pitch %d, %s\n", image, width, height, pitch,
+                   (pixel_format == BmpPixels_BGRX)?"BGRX":"RGBX");
+        }
+        
+        free(file);
+        free(expected);
+        free(pixels);
+    }
+    
+    // Failures
+    {
+        uint32_t pixel = 0;
+        Bmp_Writer writer = {0};
+        TEST_CHECK(!bmp_writer_begin(&writer, test_file_name, 0, 1, BmpPixels_RGBX));
+        TEST_CHECK(!bmp_writer_begin(&writer, test_file_name, 1, 0, BmpPixels_RGBX));
+        TEST_CHECK(!bmp_writer_begin(&writer, test_file_name, 1, -1, BmpPixels_RGBX));
+        TEST_CHECK(!bmp_writer_begin(&writer, test_file_name, (1 << 28) + 1, 1, BmpPixels_RGBX));
+        // Past four gigabytes of rows
+        TEST_CHECK(!bmp_writer_begin(&writer, test_file_name, 1 << 16, 1 << 15, BmpPixels_RGBX));
+        TEST_CHECK(!bmp_write_pixels("no_such_directory/bmp_file_test.bmp", &pixel, 1, 1, 4, BmpPixels_RGBX));
+        
+        // Ending early writes what was pushed and still fails.
+        TEST_CHECK(bmp_writer_begin(&writer, test_file_name, 4, 3, BmpPixels_RGBX));
+        uint32_t row[4] = {0};
+        bmp_writer_push_row(&writer, row);
+        bmp_writer_push_row(&writer, row);
+        TEST_CHECK(!bmp_writer_end(&writer));
+        
+        // A file that is not a 24 bit BMP does not read.
+        FILE *out = fopen(test_file_name, "wb");
+        if (TEST_CHECK(out != 0)){
+            fwrite("BM not a bitmap", 1, 15, out);
+            fclose(out);
+        }
+        int32_t read_width = 0;
+        int32_t read_height = 0;
+        TEST_CHECK(bmp_read_rgbx(test_file_name, &read_width, &read_height) == 0);
+    }
+    remove(test_file_name);
+    
+    printf("bmp_file_test: %d images, %.1f MB written\n", fixed_count + test_image_count,
+           (double)total_bytes/(1024.0*1024.0));
+    return(test_finish("bmp_file_test", seed));
+}
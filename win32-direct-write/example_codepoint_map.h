@@ -0,0 +1,109 @@
+// DirectWrite rasterization example: codepoint to glyph index table
+// ASCII and Latin-1 are a direct array filled at init. The rest of Unicode goes through a two level
+// page table whose pages are filled with one bulk font query the first time they are touched, so
+// after warm up a lookup is a couple of loads and never calls into the font API.
+
+#if !defined(EXAMPLE_CODEPOINT_MAP_H)
+#define EXAMPLE_CODEPOINT_MAP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+
+#define CODEPOINT_MAP_PAGE_SIZE 256
+#define CODEPOINT_MAP_PAGE_COUNT (0x110000/CODEPOINT_MAP_PAGE_SIZE)
+
+// Fills glyphs[i] with the glyph of codepoints[i], zero for codepoints the font does not cover.
+typedef void Codepoint_Glyphs_Function(void *backend, uint32_t *codepoints, uint16_t *glyphs, int32_t count);
+
+struct Codepoint_Map{
+    uint16_t latin1[CODEPOINT_MAP_PAGE_SIZE];
+    // Zero until first touched. Pages with no glyphs at all share empty_page.
+    uint16_t *pages[CODEPOINT_MAP_PAGE_COUNT];
+    uint16_t empty_page[CODEPOINT_MAP_PAGE_SIZE];
+    
+    void *backend;
+    Codepoint_Glyphs_Function *codepoint_glyphs;
+    
+    int32_t filled_page_count;
+    int32_t allocated_page_count;
+};
+
+void
+codepoint_map__query_page(Codepoint_Map *map, uint32_t page_index, uint16_t *glyphs){
+    uint32_t codepoints[CODEPOINT_MAP_PAGE_SIZE];
+    for (uint32_t i = 0; i < CODEPOINT_MAP_PAGE_SIZE; i += 1){
+        codepoints[i] = page_index*CODEPOINT_MAP_PAGE_SIZE + i;
+    }
+    map->codepoint_glyphs(map->backend, codepoints, glyphs, CODEPOINT_MAP_PAGE_SIZE);
+}
+
+Codepoint_Map*
+codepoint_map_alloc(void *backend, Codepoint_Glyphs_Function *codepoint_glyphs){
+    Codepoint_Map *map = (Codepoint_Map*)heap_alloc(sizeof(Codepoint_Map));
+    memset(map, 0, sizeof(*map));
+    map->backend = backend;
+    map->codepoint_glyphs = codepoint_glyphs;
+    codepoint_map__query_page(map, 0, map->latin1);
+    map->pages[0] = map->latin1;
+    map->filled_page_count = 1;
+    return(map);
+}
+
+void
+codepoint_map_free(Codepoint_Map *map){
+    for (int32_t i = 1; i < CODEPOINT_MAP_PAGE_COUNT; i += 1){
+        if (map->pages[i] != 0 && map->pages[i] != map->empty_page){
+            heap_free(map->pages[i]);
+        }
+    }
+    heap_free(map);
+}
+
+uint16_t*
+codepoint_map__fill_page(Codepoint_Map *map, uint32_t page_index){
+    uint16_t glyphs[CODEPOINT_MAP_PAGE_SIZE];
+    codepoint_map__query_page(map, page_index, glyphs);
+    
+    bool32 any_glyph = false;
+    for (int32_t i = 0; i < CODEPOINT_MAP_PAGE_SIZE; i += 1){
+        any_glyph = any_glyph || (glyphs[i] != 0);
+    }
+    uint16_t *page = map->empty_page;
+    if (any_glyph){
+        page = (uint16_t*)heap_alloc(sizeof(glyphs));
+        memcpy(page, glyphs, sizeof(glyphs));
+        map->allocated_page_count += 1;
+    }
+    map->pages[page_index] = page;
+    map->filled_page_count += 1;
+    return(page);
+}
+
+uint16_t
+codepoint_map_lookup(Codepoint_Map *map, uint32_t codepoint){
+    uint16_t result = 0;
+    if (codepoint < CODEPOINT_MAP_PAGE_SIZE){
+        result = map->latin1[codepoint];
+    }
+    else if (codepoint < 0x110000){
+        uint32_t page_index = codepoint/CODEPOINT_MAP_PAGE_SIZE;
+        uint16_t *page = map->pages[page_index];
+        if (page == 0){
+            page = codepoint_map__fill_page(map, page_index);
+        }
+        result = page[codepoint%CODEPOINT_MAP_PAGE_SIZE];
+    }
+    return(result);
+}
+
+// Bytes held by the table, counting the page pointers.
+uint64_t
+codepoint_map_memory(Codepoint_Map *map){
+    return(sizeof(Codepoint_Map) + (uint64_t)map->allocated_page_count*sizeof(uint16_t)*CODEPOINT_MAP_PAGE_SIZE);
+}
+
+#endif
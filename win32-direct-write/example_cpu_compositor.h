@@ -0,0 +1,478 @@
+// DirectWrite rasterization example: CPU compositor for the ClearType blend
+// Does what the GPU path does with a draw list, into a block of memory: every covered texel picks
+// M_value_table[int(S*6 + 0.1)] per channel, the framebuffer is decoded from sRGB, blended as
+// fore*M + back*(1 - M) (the dual source glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC1_COLOR)) and encoded
+// back to sRGB the way GL_FRAMEBUFFER_SRGB does.
+// The sRGB encode is exact: a linear value is bucketed by a 8192 entry table, and since no bucket
+// holds more than one rounding threshold a single compare against the next threshold finishes it.
+// With the style fixed a channel's result only depends on the coverage index and the old byte, so
+// each style gets a 3x7x256 table of results, kept in a small cache keyed by the style. The inner
+// loops are then one lookup per channel, and the AVX2 path gives the same bytes as the scalar one.
+// It only pays off on wide glyphs, narrow ones stay scalar.
+
+#if !defined(EXAMPLE_CPU_COMPOSITOR_H)
+#define EXAMPLE_CPU_COMPOSITOR_H
+
+#if defined(__AVX2__)
+#define CPU_COMPOSITOR_AVX2 1
+#include <immintrin.h>
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_m_values.h"
+#include "example_text_batch.h"
+#include "example_render_commands.h"
+
+#define CPU_SRGB_BUCKETS 8192
+
+struct Cpu_Srgb_Tables{
+    bool32 initialized;
+    float decode[256];
+    // Smallest linear value that encodes to k + 1, the last one is past any linear value
+    float threshold[256];
+    int32_t bucket_base[CPU_SRGB_BUCKETS];
+    // int(S*6 + 0.1) for every 8 bit coverage value
+    int32_t coverage_index[256];
+    // Smallest coverage value with an index of at least i + 1
+    int32_t coverage_step[6];
+};
+
+static Cpu_Srgb_Tables cpu_srgb = {0};
+
+// Instances narrower than this take the scalar path even when the AVX2 one is asked for. A row of a
+// narrow glyph is two or three blocks of eight, one partly masked: three gathers and eighteen
+// compares each for a few texels, where the scalar loop skips the empty ones for a single test each.
+// On the text bench's scene AVX2 runs behind scalar at 12pt and only pulls ahead from about 24pt,
+// where the glyphs start to pass 24 texels; 12pt and 16pt glyphs all stay under it.
+static int32_t cpu_simd_min_width = 24;
+
+// Pixels are R, G, B, X bytes in sRGB, X is left alone.
+struct Cpu_Framebuffer{
+    uint32_t *pixels;
+    int32_t w;
+    int32_t h;
+    int32_t pitch;
+};
+
+// Same layout as the texture array: slices of w*h RGB texels.
+struct Cpu_Atlas{
+    uint8_t *texels;
+    int32_t w;
+    int32_t h;
+    int32_t slice_count;
+};
+
+////////////////////////////////
+
+// sRGB
+
+double
+cpu_srgb_decode_exact(double x){
+    return((x <= 0.04045)?(x/12.92):pow((x + 0.055)/1.055, 2.4));
+}
+
+double
+cpu_srgb_encode_exact(double x){
+    return((x <= 0.0031308)?(x*12.92):(1.055*pow(x, 1.0/2.4) - 0.055));
+}
+
+// Reference encode that the tables reproduce bit for bit.
+uint8_t
+cpu_srgb_encode_reference(float x){
+    double e = cpu_srgb_encode_exact((x < 0.f)?0.0:(x > 1.f)?1.0:(double)x)*255.0 + 0.5;
+    return((uint8_t)e);
+}
+
+uint8_t
+cpu_srgb_encode(float x){
+    x = (x < 0.f)?0.f:x;
+    x = (x > 1.f)?1.f:x;
+    int32_t bucket = (int32_t)(x*(float)CPU_SRGB_BUCKETS);
+    bucket = (bucket > CPU_SRGB_BUCKETS - 1)?(CPU_SRGB_BUCKETS - 1):bucket;
+    int32_t base = cpu_srgb.bucket_base[bucket];
+    return((uint8_t)(base + (x >= cpu_srgb.threshold[base])));
+}
+
+void
+cpu_srgb_init(void){
+    if (cpu_srgb.initialized){
+        return;
+    }
+    for (int32_t k = 0; k < 256; k += 1){
+        cpu_srgb.decode[k] = (float)cpu_srgb_decode_exact((double)k/255.0);
+        cpu_srgb.coverage_index[k] = (int32_t)(((float)k/255.f)*6 + 0.1f);
+    }
+    for (int32_t i = 0; i < 6; i += 1){
+        int32_t k = 0;
+        for (; cpu_srgb.coverage_index[k] < i + 1; k += 1);
+        cpu_srgb.coverage_step[i] = k;
+    }
+    
+    // Start from the midpoint between codes and step to the exact float where the reference flips.
+    for (int32_t k = 0; k < 255; k += 1){
+        float t = (float)cpu_srgb_decode_exact(((double)k + 0.5)/255.0);
+        for (; cpu_srgb_encode_reference(t) > k;){
+            t = nextafterf(t, 0.f);
+        }
+        for (; cpu_srgb_encode_reference(t) <= k;){
+            t = nextafterf(t, 2.f);
+        }
+        cpu_srgb.threshold[k] = t;
+    }
+    cpu_srgb.threshold[255] = 2.f;
+    
+    for (int32_t j = 0; j < CPU_SRGB_BUCKETS; j += 1){
+        float start = (float)j/(float)CPU_SRGB_BUCKETS;
+        float end = (float)(j + 1)/(float)CPU_SRGB_BUCKETS;
+        int32_t base = cpu_srgb_encode_reference(start);
+        cpu_srgb.bucket_base[j] = base;
+        // At most one threshold inside the bucket
+        assert(base >= 254 || cpu_srgb.threshold[base + 1] >= end);
+    }
+    cpu_srgb.initialized = true;
+    
+    for (int32_t k = 0; k < 256; k += 1){
+        assert(cpu_srgb_encode(cpu_srgb.decode[k]) == k);
+    }
+}
+
+void
+cpu_framebuffer_clear(Cpu_Framebuffer *framebuffer, float r, float g, float b){
+    uint32_t pixel = ((uint32_t)cpu_srgb_encode(r) |
+                      ((uint32_t)cpu_srgb_encode(g) << 8) |
+                      ((uint32_t)cpu_srgb_encode(b) << 16) |
+                      0xFF000000u);
+    for (int32_t y = 0; y < framebuffer->h; y += 1){
+        uint32_t *row = framebuffer->pixels + (size_t)y*framebuffer->pitch;
+        for (int32_t x = 0; x < framebuffer->w; x += 1){
+            row[x] = pixel;
+        }
+    }
+}
+
+////////////////////////////////
+
+// Blend Tables
+
+#define CPU_BLEND_CACHE_SIZE 64
+
+struct Cpu_Blend_Table{
+    float color[3];
+    float M[6];
+    uint64_t last_used;
+    // out[(7*c + C)*256 + back], with room for the AVX2 path's four byte reads past the end
+    uint8_t out[3*7*256 + 4];
+};
+
+struct Cpu_Compositor{
+    Cpu_Blend_Table *tables;
+    int32_t table_count;
+    uint64_t clock;
+    
+    uint64_t table_hits;
+    uint64_t table_builds;
+};
+
+Cpu_Compositor
+cpu_compositor_init(void){
+    cpu_srgb_init();
+    Cpu_Compositor compositor = {0};
+    compositor.tables = (Cpu_Blend_Table*)heap_alloc(sizeof(Cpu_Blend_Table)*CPU_BLEND_CACHE_SIZE);
+    return(compositor);
+}
+
+void
+cpu_compositor_free(Cpu_Compositor *compositor){
+    heap_free(compositor->tables);
+    memset(compositor, 0, sizeof(*compositor));
+}
+
+void
+cpu_blend_table_build(Cpu_Blend_Table *table, Text_Style *style){
+    memcpy(table->color, style->color, sizeof(table->color));
+    memcpy(table->M, style->M, sizeof(table->M));
+    for (int32_t c = 0; c < 3; c += 1){
+        for (int32_t C = 0; C < 7; C += 1){
+            float M = (C == 0)?0.f:style->M[C - 1];
+            uint8_t *out = table->out + (7*c + C)*256;
+            for (int32_t back = 0; back < 256; back += 1){
+                float blended = style->color[c]*M + cpu_srgb.decode[back]*(1.f - M);
+                out[back] = cpu_srgb_encode(blended);
+            }
+        }
+    }
+    memset(table->out + 3*7*256, 0, 4);
+}
+
+// Table for a style, built on a miss over the least recently used entry. The styles of one command
+// all get a newer stamp than anything they could push out, so a command never evicts its own.
+Cpu_Blend_Table*
+cpu_compositor_table(Cpu_Compositor *compositor, Text_Style *style){
+    Cpu_Blend_Table *oldest = 0;
+    for (int32_t i = 0; i < compositor->table_count; i += 1){
+        Cpu_Blend_Table *table = &compositor->tables[i];
+        if (memcmp(table->color, style->color, sizeof(table->color)) == 0 &&
+            memcmp(table->M, style->M, sizeof(table->M)) == 0){
+            table->last_used = compositor->clock;
+            compositor->table_hits += 1;
+            return(table);
+        }
+        if (oldest == 0 || table->last_used < oldest->last_used){
+            oldest = table;
+        }
+    }
+    Cpu_Blend_Table *table = oldest;
+    if (compositor->table_count < CPU_BLEND_CACHE_SIZE){
+        table = &compositor->tables[compositor->table_count];
+        compositor->table_count += 1;
+    }
+    cpu_blend_table_build(table, style);
+    table->last_used = compositor->clock;
+    compositor->table_builds += 1;
+    return(table);
+}
+
+////////////////////////////////
+
+// Blending
+
+// One row of a glyph, count texels from in to the pixels at out.
+void
+cpu_composite_span_scalar(uint8_t *in, uint32_t *out, int32_t count, uint8_t *table){
+    for (int32_t i = 0; i < count; i += 1, in += 3){
+        if ((in[0] | in[1] | in[2]) == 0){
+            // M is zero, which leaves the pixel as it is.
+            continue;
+        }
+        uint32_t pixel = out[i];
+        uint32_t result = pixel & 0xFF000000u;
+        for (int32_t c = 0; c < 3; c += 1){
+            int32_t C = cpu_srgb.coverage_index[in[c]];
+            result |= (uint32_t)table[(7*c + C)*256 + ((pixel >> (8*c)) & 0xFF)] << (8*c);
+        }
+        out[i] = result;
+    }
+}
+
+#if CPU_COMPOSITOR_AVX2
+// A w by h block of a glyph. Reads may run past a row into the rest of the atlas, up to in_end.
+void
+cpu_composite_block_avx2(uint8_t *in, int32_t in_pitch, uint8_t *in_end, uint32_t *out, int32_t out_pitch,
+                         int32_t w, int32_t h, uint8_t *table){
+    // Texels 0..3 come from the first 16 bytes and texels 4..7 from the 16 bytes at in + 8, each
+    // channel is shuffled into the low byte of its lane.
+    __m256i spread[3];
+    for (int32_t c = 0; c < 3; c += 1){
+        spread[c] = _mm256_setr_epi8(0 + c, -1, -1, -1, 3 + c, -1, -1, -1, 6 + c, -1, -1, -1, 9 + c, -1, -1, -1,
+                                     4 + c, -1, -1, -1, 7 + c, -1, -1, -1, 10 + c, -1, -1, -1, 13 + c, -1, -1, -1);
+    }
+    __m256i steps[6];
+    for (int32_t k = 0; k < 6; k += 1){
+        steps[k] = _mm256_set1_epi32(cpu_srgb.coverage_step[k] - 1);
+    }
+    __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000u);
+    __m256i lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    
+    uint8_t tail[32];
+    for (int32_t y = 0; y < h; y += 1, in += in_pitch, out += out_pitch){
+        uint8_t *row_in = in;
+        for (int32_t x = 0; x < w; x += 8, row_in += 24){
+            int32_t lanes = w - x;
+            __m256i lane_mask = _mm256_set1_epi32(-1);
+            uint8_t *texel_source = row_in;
+            if (lanes < 8){
+                lane_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(lanes), lane_index);
+                // Only the very end of the atlas needs a copy, anywhere else the extra texels are read and masked off.
+                if (row_in + 24 > in_end){
+                    memset(tail, 0, sizeof(tail));
+                    memcpy(tail, row_in, lanes*3);
+                    texel_source = tail;
+                }
+            }
+            
+            __m256i texels = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i*)texel_source)),
+                                                     _mm_loadu_si128((__m128i*)(texel_source + 8)), 1);
+            __m256i S[3];
+            for (int32_t c = 0; c < 3; c += 1){
+                S[c] = _mm256_and_si256(_mm256_shuffle_epi8(texels, spread[c]), lane_mask);
+            }
+            __m256i any = _mm256_or_si256(_mm256_or_si256(S[0], S[1]), S[2]);
+            if (_mm256_testz_si256(any, any)){
+                continue;
+            }
+            __m256i covered = _mm256_cmpgt_epi32(any, _mm256_setzero_si256());
+            
+            __m256i pixels = _mm256_maskload_epi32((int*)(out + x), lane_mask);
+            __m256i result = _mm256_and_si256(pixels, alpha_mask);
+            for (int32_t c = 0; c < 3; c += 1){
+                // Coverage index from six compares, each one that passes subtracts minus one.
+                __m256i C = _mm256_setzero_si256();
+                for (int32_t k = 0; k < 6; k += 1){
+                    C = _mm256_sub_epi32(C, _mm256_cmpgt_epi32(S[c], steps[k]));
+                }
+                __m256i back = _mm256_and_si256(_mm256_srli_epi32(pixels, 8*c), byte_mask);
+                __m256i index = _mm256_add_epi32(_mm256_slli_epi32(_mm256_add_epi32(C, _mm256_set1_epi32(7*c)), 8), back);
+                __m256i blended = _mm256_and_si256(_mm256_i32gather_epi32((int*)table, index, 1), byte_mask);
+                result = _mm256_or_si256(result, _mm256_slli_epi32(blended, 8*c));
+            }
+            result = _mm256_blendv_epi8(pixels, result, covered);
+            _mm256_maskstore_epi32((int*)(out + x), lane_mask, result);
+        }
+    }
+}
+#endif
+
+// Blends a run of glyph instances, clipped to the framebuffer. tables holds one blend table per
+// style index.
+void
+cpu_composite_instances(Cpu_Framebuffer *framebuffer, Cpu_Atlas *atlas, Text_Instance *instances, int32_t count,
+                        Cpu_Blend_Table **tables, bool32 use_simd){
+    for (int32_t k = 0; k < count; k += 1){
+        Text_Instance *instance = &instances[k];
+        uint8_t *table = tables[instance->style]->out;
+        
+        int32_t x0 = instance->x;
+        int32_t y0 = instance->y;
+        int32_t x1 = x0 + instance->w;
+        int32_t y1 = y0 + instance->h;
+        int32_t skip_x = (x0 < 0)?-x0:0;
+        int32_t skip_y = (y0 < 0)?-y0:0;
+        x1 = (x1 > framebuffer->w)?framebuffer->w:x1;
+        y1 = (y1 > framebuffer->h)?framebuffer->h:y1;
+        int32_t w = x1 - (x0 + skip_x);
+        if (w <= 0){
+            continue;
+        }
+        int32_t h = y1 - (y0 + skip_y);
+        if (h <= 0){
+            continue;
+        }
+        assert(instance->slice < atlas->slice_count);
+        uint8_t *slice = atlas->texels + (size_t)instance->slice*atlas->w*atlas->h*3;
+        int32_t in_pitch = atlas->w*3;
+        uint8_t *in = slice + ((size_t)(instance->atlas_y + skip_y)*atlas->w + instance->atlas_x + skip_x)*3;
+        uint32_t *out = framebuffer->pixels + (size_t)(y0 + skip_y)*framebuffer->pitch + x0 + skip_x;
+#if CPU_COMPOSITOR_AVX2
+        if (use_simd && w >= cpu_simd_min_width){
+            uint8_t *in_end = atlas->texels + (size_t)atlas->slice_count*atlas->w*atlas->h*3;
+            cpu_composite_block_avx2(in, in_pitch, in_end, out, framebuffer->pitch, w, h, table);
+            continue;
+        }
+#endif
+        for (int32_t y = 0; y < h; y += 1, in += in_pitch, out += framebuffer->pitch){
+            cpu_composite_span_scalar(in, out, w, table);
+        }
+    }
+}
+
+// One draw: instances whose style indices point into styles.
+void
+cpu_composite_command(Cpu_Compositor *compositor, Cpu_Framebuffer *framebuffer, Cpu_Atlas *atlas,
+                      Text_Style *styles, int32_t style_count, Text_Instance *instances, int32_t instance_count,
+                      bool32 use_simd){
+    Cpu_Blend_Table *tables[TEXT_STYLE_MAX];
+    compositor->clock += 1;
+    for (int32_t j = 0; j < style_count; j += 1){
+        tables[j] = cpu_compositor_table(compositor, &styles[j]);
+    }
+    cpu_composite_instances(framebuffer, atlas, instances, instance_count, tables, use_simd);
+}
+
+// Every command of the list, in order. The list's texture handles are not looked at, the caller
+// passes the atlas the list was built against.
+void
+cpu_composite_draw_list(Cpu_Compositor *compositor, Cpu_Framebuffer *framebuffer, Cpu_Atlas *atlas,
+                        Text_Draw_List *list, bool32 use_simd){
+    for (int32_t i = 0; i < list->command_count; i += 1){
+        Text_Draw_Command *command = &list->commands[i];
+        cpu_composite_command(compositor, framebuffer, atlas, list->styles + command->first_style, command->style_count,
+                              list->instances + command->first_instance, command->instance_count, use_simd);
+    }
+}
+
+////////////////////////////////
+
+// Render Command Executor
+// Runs a render stream into memory. Like the draw list the glyph batches' textures are not looked
+// at, every batch reads the one atlas.
+
+struct Cpu_Render_Target{
+    Cpu_Compositor *compositor;
+    // What clears and glyph batches draw into
+    Cpu_Framebuffer *framebuffer;
+    Cpu_Atlas *atlas;
+    // What blits copy to, blits are skipped without one
+    Cpu_Framebuffer *window;
+    bool32 use_simd;
+};
+
+void
+cpu_render_clear(void *user, Render_Clear *clear){
+    Cpu_Render_Target *target = (Cpu_Render_Target*)user;
+    cpu_framebuffer_clear(target->framebuffer, clear->color[0], clear->color[1], clear->color[2]);
+}
+
+void
+cpu_render_glyphs(void *user, Render_Glyphs *glyphs, Text_Style *styles, Text_Instance *instances){
+    Cpu_Render_Target *target = (Cpu_Render_Target*)user;
+    cpu_composite_command(target->compositor, target->framebuffer, target->atlas, styles, glyphs->style_count,
+                          instances, glyphs->instance_count, target->use_simd);
+}
+
+// Clipped to both framebuffers.
+void
+cpu_render_blit(void *user, Render_Blit *blit){
+    Cpu_Render_Target *target = (Cpu_Render_Target*)user;
+    Cpu_Framebuffer *src = target->framebuffer;
+    Cpu_Framebuffer *dst = target->window;
+    if (dst == 0){
+        return;
+    }
+    int32_t x = blit->x;
+    int32_t y = blit->y;
+    int32_t dst_x = blit->dst_x;
+    int32_t dst_y = blit->dst_y;
+    int32_t w = blit->w;
+    int32_t h = blit->h;
+    int32_t skip_x = 0;
+    skip_x = (-x > skip_x)?-x:skip_x;
+    skip_x = (-dst_x > skip_x)?-dst_x:skip_x;
+    int32_t skip_y = 0;
+    skip_y = (-y > skip_y)?-y:skip_y;
+    skip_y = (-dst_y > skip_y)?-dst_y:skip_y;
+    x += skip_x;
+    dst_x += skip_x;
+    w -= skip_x;
+    y += skip_y;
+    dst_y += skip_y;
+    h -= skip_y;
+    w = (x + w > src->w)?(src->w - x):w;
+    w = (dst_x + w > dst->w)?(dst->w - dst_x):w;
+    h = (y + h > src->h)?(src->h - y):h;
+    h = (dst_y + h > dst->h)?(dst->h - dst_y):h;
+    if (w <= 0 || h <= 0){
+        return;
+    }
+    for (int32_t row = 0; row < h; row += 1){
+        memcpy(dst->pixels + (size_t)(dst_y + row)*dst->pitch + dst_x,
+               src->pixels + (size_t)(y + row)*src->pitch + x, sizeof(uint32_t)*w);
+    }
+}
+
+Render_Executor
+cpu_render_executor(Cpu_Render_Target *target){
+    Render_Executor executor = {0};
+    executor.user = target;
+    executor.clear = cpu_render_clear;
+    executor.glyphs = cpu_render_glyphs;
+    executor.blit = cpu_render_blit;
+    return(executor);
+}
+
+#endif
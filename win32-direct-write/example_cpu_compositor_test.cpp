@@ -0,0 +1,262 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the CPU compositor
+// usage: cpu_compositor_test [seed]
+// The table sRGB encode against the reference on every float around a rounding threshold and on a
+// dense sweep of the rest. Then random draw lists over random atlases into random framebuffers: the
+// scalar path, the AVX2 path for every instance and the AVX2 path from the default width must all
+// give the bytes of a blend done one texel at a time with no tables. Glyphs hang off every edge of
+// the framebuffer, sit at the very end of the atlas, and the styles outnumber the table cache.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_cpu_compositor.h"
+#include "example_test.h"
+
+static int32_t test_encode_sweep_count = 1 << 22;
+static int32_t test_scene_count = 120;
+
+// One texel at a time with no tables, clipped the way the compositor clips
+void
+test_reference_composite(Cpu_Framebuffer *framebuffer, Cpu_Atlas *atlas, Text_Draw_List *list){
+    for (int32_t i = 0; i < list->command_count; i += 1){
+        Text_Draw_Command *command = &list->commands[i];
+        for (int32_t k = 0; k < command->instance_count; k += 1){
+            Text_Instance *instance = &list->instances[command->first_instance + k];
+            Text_Style *style = &list->styles[command->first_style + instance->style];
+            float M_value_table[7] = {0.f, style->M[0], style->M[1], style->M[2], style->M[3], style->M[4], style->M[5]};
+            uint8_t *slice = atlas->texels + (size_t)instance->slice*atlas->w*atlas->h*3;
+            for (int32_t y = 0; y < instance->h; y += 1){
+                for (int32_t x = 0; x < instance->w; x += 1){
+                    int32_t px = instance->x + x;
+                    int32_t py = instance->y + y;
+                    if (px < 0 || py < 0 || px >= framebuffer->w || py >= framebuffer->h){
+                        continue;
+                    }
+                    uint8_t *texel = slice + ((size_t)(instance->atlas_y + y)*atlas->w + instance->atlas_x + x)*3;
+                    uint32_t *pixel = &framebuffer->pixels[(size_t)py*framebuffer->pitch + px];
+                    uint32_t result = *pixel & 0xFF000000u;
+                    for (int32_t c = 0; c < 3; c += 1){
+                        float S = (float)texel[c]/255.f;
+                        float M = M_value_table[(int32_t)(S*6 + 0.1f)];
+                        float back = (float)cpu_srgb_decode_exact((double)((*pixel >> (8*c)) & 0xFF)/255.0);
+                        result |= (uint32_t)cpu_srgb_encode_reference(style->color[c]*M + back*(1.f - M)) << (8*c);
+                    }
+                    *pixel = result;
+                }
+            }
+        }
+    }
+}
+
+uint8_t
+test_random_coverage(uint32_t *state){
+    int32_t kind = test_random_range(state, 0, 3);
+    return((kind == 0)?0:(kind == 1)?255:(uint8_t)test_random(state));
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0xC0417u);
+    uint32_t state = seed;
+    Cpu_Compositor compositor = cpu_compositor_init();
+    
+    // Encode
+    {
+        int64_t failures_before = test_state.failures;
+        for (int32_t k = 0; k < 255; k += 1){
+            float t = cpu_srgb.threshold[k];
+            float below = nextafterf(t, 0.f);
+            TEST_CHECK(cpu_srgb_encode(t) == cpu_srgb_encode_reference(t));
+            TEST_CHECK(cpu_srgb_encode(below) == cpu_srgb_encode_reference(below));
+            TEST_CHECK(cpu_srgb_encode(t) == k + 1 && cpu_srgb_encode(below) == k);
+        }
+        for (int32_t i = 0; i <= test_encode_sweep_count; i += 1){
+            float x = (float)i/(float)test_encode_sweep_count;
+            if (!TEST_CHECK(cpu_srgb_encode(x) == cpu_srgb_encode_reference(x))){
+                printf("    encode %.9g: %d, the reference %d\n", x, cpu_srgb_encode(x), cpu_srgb_encode_reference(x));
+                break;
+            }
+        }
+        float outside[] = {-1.f, -0.f, -1e-30f, 1.0000001f, 2.f, 1e30f};
+        for (int32_t i = 0; i < (int32_t)(sizeof(outside)/sizeof(outside[0])); i += 1){
+            TEST_CHECK(cpu_srgb_encode(outside[i]) == cpu_srgb_encode_reference(outside[i]));
+        }
+        for (int32_t k = 0; k < 256; k += 1){
+            TEST_CHECK(cpu_srgb.coverage_index[k] == (int32_t)(((float)k/255.f)*6 + 0.1f));
+        }
+        if (test_state.failures != failures_before){
+            printf("    sRGB encode\n");
+        }
+    }
+    
+    // Draw Lists
+    int32_t default_min_width = cpu_simd_min_width;
+    uint64_t total_instances = 0;
+    uint64_t total_builds = 0;
+    for (int32_t scene = 0; scene < test_scene_count; scene += 1){
+        int64_t failures_before = test_state.failures;
+        Cpu_Atlas atlas = {0};
+        atlas.w = test_random_range(&state, 64, 300);
+        atlas.h = test_random_range(&state, 40, 200);
+        atlas.slice_count = test_random_range(&state, 1, 3);
+        size_t texel_bytes = (size_t)atlas.w*atlas.h*atlas.slice_count*3;
+        atlas.texels = (uint8_t*)malloc(texel_bytes);
+        for (size_t i = 0; i < texel_bytes; i += 1){
+            atlas.texels[i] = test_random_coverage(&state);
+        }
+        
+        // More styles than the cache holds over the whole list, at most TEXT_STYLE_MAX per command
+        int32_t style_count = test_random_range(&state, 1, 2*CPU_BLEND_CACHE_SIZE);
+        Text_Style *styles = (Text_Style*)calloc(style_count, sizeof(Text_Style));
+        for (int32_t i = 0; i < style_count; i += 1){
+            uint8_t rgba[4];
+            for (int32_t c = 0; c < 4; c += 1){
+                rgba[c] = (uint8_t)test_random(&state);
+            }
+            rgba[3] = (test_random_range(&state, 0, 1) == 0)?255:rgba[3];
+            float M_value_table[7];
+            m_values_rgba8(rgba[0], rgba[1], rgba[2], rgba[3], M_value_table);
+            for (int32_t c = 0; c < 3; c += 1){
+                styles[i].color[c] = cpu_srgb.decode[rgba[c]];
+            }
+            memcpy(styles[i].M, M_value_table + 1, sizeof(styles[i].M));
+        }
+        
+        int32_t instance_count = test_random_range(&state, 1, 300);
+        Text_Instance *instances = (Text_Instance*)calloc(instance_count, sizeof(Text_Instance));
+        Text_Draw_Command commands[8];
+        int32_t command_count = 0;
+        int32_t fb_w = test_random_range(&state, 1, 200);
+        int32_t fb_h = test_random_range(&state, 1, 120);
+        for (int32_t i = 0; i < instance_count; i += 1){
+            Text_Instance *instance = &instances[i];
+            instance->w = (uint8_t)test_random_range(&state, 1, 64);
+            instance->h = (uint8_t)test_random_range(&state, 1, 40);
+            instance->slice = (uint8_t)test_random_range(&state, 0, atlas.slice_count - 1);
+            instance->atlas_x = (uint16_t)test_random_range(&state, 0, atlas.w - instance->w);
+            instance->atlas_y = (uint16_t)test_random_range(&state, 0, atlas.h - instance->h);
+            if (test_random_range(&state, 0, 9) == 0){
+                // Up against the last texel of the atlas
+                instance->slice = (uint8_t)(atlas.slice_count - 1);
+                instance->atlas_x = (uint16_t)(atlas.w - instance->w);
+                instance->atlas_y = (uint16_t)(atlas.h - instance->h);
+            }
+            instance->x = (int16_t)test_random_range(&state, -instance->w - 4, fb_w + 4);
+            instance->y = (int16_t)test_random_range(&state, -instance->h - 4, fb_h + 4);
+        }
+        for (int32_t first = 0; first < instance_count && command_count < 8;){
+            Text_Draw_Command *command = &commands[command_count];
+            command_count += 1;
+            command->first_instance = first;
+            command->instance_count = test_random_range(&state, 1, instance_count - first);
+            command->instance_count = (command_count == 8)?(instance_count - first):command->instance_count;
+            command->style_count = test_random_range(&state, 1, (style_count < TEXT_STYLE_MAX)?style_count:TEXT_STYLE_MAX);
+            command->first_style = test_random_range(&state, 0, style_count - command->style_count);
+            for (int32_t k = first; k < first + command->instance_count; k += 1){
+                instances[k].style = (uint16_t)test_random_range(&state, 0, command->style_count - 1);
+            }
+            first += command->instance_count;
+        }
+        Text_Draw_List list = {instances, instance_count, styles, style_count, commands, command_count};
+        
+        // A pitch wider than the framebuffer, with random pixels and alpha bytes that must survive
+        int32_t pitch = fb_w + test_random_range(&state, 0, 9);
+        size_t pixel_count = (size_t)pitch*fb_h;
+        uint32_t *background = (uint32_t*)malloc(sizeof(uint32_t)*pixel_count);
+        for (size_t i = 0; i < pixel_count; i += 1){
+            background[i] = test_random(&state);
+        }
+        Cpu_Framebuffer reference = {(uint32_t*)malloc(sizeof(uint32_t)*pixel_count), fb_w, fb_h, pitch};
+        memcpy(reference.pixels, background, sizeof(uint32_t)*pixel_count);
+        test_reference_composite(&reference, &atlas, &list);
+        
+        // Scalar, then AVX2 for every instance, then AVX2 from the default width
+        int32_t variant_count = 1;
+#if CPU_COMPOSITOR_AVX2
+        variant_count = 3;
+#endif
+        for (int32_t v = 0; v < variant_count; v += 1){
+            Cpu_Framebuffer framebuffer = {(uint32_t*)malloc(sizeof(uint32_t)*pixel_count), fb_w, fb_h, pitch};
+            memcpy(framebuffer.pixels, background, sizeof(uint32_t)*pixel_count);
+            cpu_simd_min_width = (v == 1)?0:default_min_width;
+            uint64_t builds_before = compositor.table_builds;
+            cpu_composite_draw_list(&compositor, &framebuffer, &atlas, &list, v != 0);
+            total_builds += compositor.table_builds - builds_before;
+            if (!TEST_CHECK(memcmp(framebuffer.pixels, reference.pixels, sizeof(uint32_t)*pixel_count) == 0)){
+                printf("    variant %d differs from the reference\n", v);
+            }
+            free(framebuffer.pixels);
+        }
+        cpu_simd_min_width = default_min_width;
+        if (test_state.failures != failures_before){
+            printf("    scene %d: %d instances, %d styles, %dx%dx%d atlas, %dx%d framebuffer\n", scene, instance_count,
+                   style_count, atlas.w, atlas.h, atlas.slice_count, fb_w, fb_h);
+        }
+        total_instances += instance_count;
+        
+        free(reference.pixels);
+        free(background);
+        free(instances);
+        free(styles);
+        free(atlas.texels);
+    }
+    
+    // The styles of a list that fits in the cache are built once, the next draw finds them all.
+    {
+        Cpu_Compositor fresh = cpu_compositor_init();
+        Text_Style styles[CPU_BLEND_CACHE_SIZE];
+        memset(styles, 0, sizeof(styles));
+        for (int32_t i = 0; i < CPU_BLEND_CACHE_SIZE; i += 1){
+            float M_value_table[7];
+            styles[i].color[0] = (float)i/CPU_BLEND_CACHE_SIZE;
+            text_compute_M_values(styles[i].color[0], 0.5f, 0.25f, 1.f, M_value_table);
+            memcpy(styles[i].M, M_value_table + 1, sizeof(styles[i].M));
+        }
+        Text_Instance instances[CPU_BLEND_CACHE_SIZE];
+        memset(instances, 0, sizeof(instances));
+        for (int32_t i = 0; i < CPU_BLEND_CACHE_SIZE; i += 1){
+            instances[i].w = 1;
+            instances[i].h = 1;
+            instances[i].style = (uint16_t)i;
+        }
+        uint8_t texel[3] = {255, 255, 255};
+        Cpu_Atlas atlas = {texel, 1, 1, 1};
+        uint32_t pixel = 0;
+        Cpu_Framebuffer framebuffer = {&pixel, 1, 1, 1};
+        Text_Draw_Command command = {0, 0, CPU_BLEND_CACHE_SIZE, 0, CPU_BLEND_CACHE_SIZE};
+        Text_Draw_List list = {instances, CPU_BLEND_CACHE_SIZE, styles, CPU_BLEND_CACHE_SIZE, &command, 1};
+        cpu_composite_draw_list(&fresh, &framebuffer, &atlas, &list, false);
+        TEST_CHECK(fresh.table_builds == CPU_BLEND_CACHE_SIZE);
+        cpu_composite_draw_list(&fresh, &framebuffer, &atlas, &list, false);
+        TEST_CHECK(fresh.table_builds == CPU_BLEND_CACHE_SIZE);
+        TEST_CHECK(fresh.table_hits == CPU_BLEND_CACHE_SIZE);
+        cpu_compositor_free(&fresh);
+    }
+    cpu_compositor_free(&compositor);
+
+#if CPU_COMPOSITOR_AVX2
+    printf("cpu_compositor_test: %llu instances through the scalar and AVX2 paths, %llu blend tables built\n",
+           (unsigned long long)total_instances, (unsigned long long)total_builds);
+#else
+    printf("cpu_compositor_test: no AVX2 in this build, %llu instances through the scalar path\n",
+           (unsigned long long)total_instances);
+#endif
+    return(test_finish("cpu_compositor_test", seed));
+}
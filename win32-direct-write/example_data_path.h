@@ -0,0 +1,82 @@
+// DirectWrite rasterization example: finding the data files of the benchmarks
+// Data files are named relative to win32-direct-write. The build scripts put every program in its
+// build directory, so the root is the parent of the directory the executable is in, wherever it is
+// run from. A program can take a -data <dir> argument to point somewhere else. Files a program
+// writes for itself go in the system temp directory instead.
+
+#if !defined(EXAMPLE_DATA_PATH_H)
+#define EXAMPLE_DATA_PATH_H
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#define DATA_PATH_MAX 1024
+
+// Writes the root without a trailing separator. Falls back to the working directory when the
+// executable's path cannot be found.
+void
+data_root_from_executable(char *root, int32_t root_size){
+    char exe[DATA_PATH_MAX] = {0};
+    int32_t length = 0;
+#if defined(_WIN32)
+    length = (int32_t)GetModuleFileNameA(0, exe, sizeof(exe));
+    length = (length >= (int32_t)sizeof(exe))?0:length;
+#else
+    ssize_t read_length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    length = (read_length > 0)?(int32_t)read_length:0;
+#endif
+    exe[length] = 0;
+    
+    // Cut the file name, then the build directory.
+    int32_t cut_count = 0;
+    for (int32_t i = length - 1; i >= 0 && cut_count < 2; i -= 1){
+        if (exe[i] == '/' || exe[i] == '\\'){
+            exe[i] = 0;
+            cut_count += 1;
+        }
+    }
+    if (cut_count == 2 && exe[0] != 0){
+        snprintf(root, root_size, "%s", exe);
+    }
+    else{
+        snprintf(root, root_size, ".");
+    }
+}
+
+// A file under the root, the path is relative to win32-direct-write.
+char*
+data_path(char *root, char *relative, char *out, int32_t out_size){
+    snprintf(out, out_size, "%s/%s", root, relative);
+    return(out);
+}
+
+// A file in the system temp directory, tagged with the process id so runs side by side do not
+// share it.
+char*
+temp_path(char *name, char *out, int32_t out_size){
+#if defined(_WIN32)
+    char dir[DATA_PATH_MAX] = {0};
+    DWORD length = GetTempPathA(sizeof(dir), dir);
+    if (length == 0 || length >= sizeof(dir)){
+        snprintf(dir, sizeof(dir), ".\\");
+    }
+    snprintf(out, out_size, "%s%lu_%s", dir, (unsigned long)GetCurrentProcessId(), name);
+#else
+    char *dir = getenv("TMPDIR");
+    if (dir == 0 || dir[0] == 0){
+        dir = "/tmp";
+    }
+    snprintf(out, out_size, "%s/%lu_%s", dir, (unsigned long)getpid(), name);
+#endif
+    return(out);
+}
+
+#endif
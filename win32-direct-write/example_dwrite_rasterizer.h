@@ -0,0 +1,223 @@
+// DirectWrite rasterization example: DirectWrite rasterizer backend
+// Glyphs are drawn one at a time into a GDI bitmap render target with the ClearType rendering
+// params, and the box they cover is copied out as RGB coverage. Every baker has its own target, so
+// bakers can run on separate threads over the same font face.
+
+#if !defined(EXAMPLE_DWRITE_RASTERIZER_H)
+#define EXAMPLE_DWRITE_RASTERIZER_H
+
+#include <windows.h>
+#include <dwrite.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_glyph_rasterizer.h"
+#include "example_trace.h"
+
+#define DWCheck(error,r)        if ((error) != S_OK){ error = S_OK; r; }
+#define DWCheckPtr(error,ptr,r) if ((ptr) == 0 || (error) != S_OK){ error = S_OK; r; }
+
+// The file stays mapped for the life of the program.
+uint8_t*
+map_font_file(wchar_t *path, int32_t *size_out){
+    uint8_t *result = 0;
+    *size_out = 0;
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file != INVALID_HANDLE_VALUE){
+        LARGE_INTEGER size = {0};
+        GetFileSizeEx(file, &size);
+        HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+        if (mapping != 0){
+            result = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            *size_out = (int32_t)size.QuadPart;
+        }
+    }
+    return(result);
+}
+
+struct DWrite_Glyph_Baker{
+    IDWriteFontFace *face;
+    IDWriteRenderingParams *rendering_params;
+    IDWriteBitmapRenderTarget *render_target;
+    HDC dc;
+    COLORREF back_color;
+    COLORREF fore_color;
+    int32_t target_w;
+    int32_t target_h;
+    float target_x;
+    float target_y;
+    float pixel_per_em;
+    float pixel_per_design_unit;
+    // RGB copy of the last glyph's box
+    uint8_t *rgb;
+};
+
+// Every baker gets its own render target and memory DC, so bakers can run on separate threads.
+bool32
+dwrite_glyph_baker_init(DWrite_Glyph_Baker *baker, IDWriteGdiInterop *dwrite_gdi_interop,
+                        IDWriteFontFace *face, IDWriteRenderingParams *rendering_params,
+                        int32_t target_w, int32_t target_h, float pixel_per_em, float pixel_per_design_unit){
+    memset(baker, 0, sizeof(*baker));
+    COLORREF back_color = RGB(0,0,0);
+    COLORREF fore_color = RGB(255,255,255);
+    
+    // Render Target
+    IDWriteBitmapRenderTarget *render_target = 0;
+    HRESULT error = dwrite_gdi_interop->CreateBitmapRenderTarget(0, target_w, target_h, &render_target);
+    DWCheckPtr(error, render_target, return(false));
+    HDC dc = render_target->GetMemoryDC();
+    
+    // Clear the Render Target
+    {
+        HGDIOBJ original = SelectObject(dc, GetStockObject(DC_PEN));
+        SetDCPenColor(dc, back_color);
+        SelectObject(dc, GetStockObject(DC_BRUSH));
+        SetDCBrushColor(dc, back_color);
+        Rectangle(dc, 0, 0, target_w, target_h);
+        SelectObject(dc, original);
+    }
+    
+    baker->face = face;
+    baker->rendering_params = rendering_params;
+    baker->render_target = render_target;
+    baker->dc = dc;
+    baker->back_color = back_color;
+    baker->fore_color = fore_color;
+    baker->target_w = target_w;
+    baker->target_h = target_h;
+    baker->target_x = (float)(target_w/2);
+    baker->target_y = (float)(target_h/2);
+    baker->pixel_per_em = pixel_per_em;
+    baker->pixel_per_design_unit = pixel_per_design_unit;
+    baker->rgb = (uint8_t*)malloc(target_w*target_h*3);
+    return(true);
+}
+
+void
+dwrite_glyph_baker_free(DWrite_Glyph_Baker *baker){
+    if (baker->render_target != 0){
+        baker->render_target->Release();
+    }
+    free(baker->rgb);
+    memset(baker, 0, sizeof(*baker));
+}
+
+bool32
+dwrite_rasterize_glyph(void *backend, uint16_t glyph_index, float shift_x, Glyph_Bitmap *bitmap){
+    TRACE_SCOPE("rasterize glyph");
+    DWrite_Glyph_Baker *baker = (DWrite_Glyph_Baker*)backend;
+    memset(bitmap, 0, sizeof(*bitmap));
+    
+    // Render the Glyph Into the Target
+    DWRITE_GLYPH_RUN glyph_run = {0};
+    glyph_run.fontFace = baker->face;
+    glyph_run.fontEmSize = baker->pixel_per_em;
+    glyph_run.glyphCount = 1;
+    glyph_run.glyphIndices = &glyph_index;
+    RECT bounding_box = {0};
+    HRESULT error = 0;
+    {
+        TRACE_SCOPE("DrawGlyphRun");
+        error = baker->render_target->DrawGlyphRun(baker->target_x + shift_x, baker->target_y,
+                                                   DWRITE_MEASURING_MODE_NATURAL, &glyph_run, baker->rendering_params,
+                                                   baker->fore_color, &bounding_box);
+    }
+    DWCheck(error, return(false));
+    
+    assert(0 <= bounding_box.left);
+    assert(0 <= bounding_box.top);
+    assert(bounding_box.right <= baker->target_w);
+    assert(bounding_box.bottom <= baker->target_h);
+    
+    // Compute Our Glyph Metrics
+    DWRITE_GLYPH_METRICS glyph_metrics = {0};
+    {
+        TRACE_SCOPE("GetDesignGlyphMetrics");
+        error = baker->face->GetDesignGlyphMetrics(&glyph_index, 1, &glyph_metrics, false);
+    }
+    DWCheck(error, return(false));
+    
+    int32_t tex_w = bounding_box.right - bounding_box.left;
+    int32_t tex_h = bounding_box.bottom - bounding_box.top;
+    bitmap->off_x = bounding_box.left - (int32_t)baker->target_x;
+    bitmap->off_y = bounding_box.top - (int32_t)baker->target_y;
+    bitmap->w = tex_w;
+    bitmap->h = tex_h;
+    bitmap->advance = ((float)glyph_metrics.advanceWidth)*baker->pixel_per_design_unit;
+    bitmap->rgb = baker->rgb;
+    bitmap->pitch = 3*tex_w;
+    
+    // Get the Bitmap
+    HBITMAP dib_bitmap = (HBITMAP)GetCurrentObject(baker->dc, OBJ_BITMAP);
+    DIBSECTION dib = {0};
+    GetObject(dib_bitmap, sizeof(dib), &dib);
+    
+    // Copy the Box Out as RGB
+    {
+        TRACE_SCOPE("DIB blit");
+        assert(dib.dsBm.bmBitsPixel == 32);
+        int32_t in_pitch  = dib.dsBm.bmWidthBytes;
+        int32_t out_pitch = bitmap->pitch;
+        uint8_t *in_line  = (uint8_t*)dib.dsBm.bmBits + bounding_box.left*4 + bounding_box.top*in_pitch;
+        uint8_t *out_line = baker->rgb;
+        for (int32_t y = 0; y < tex_h; y += 1){
+            uint8_t *in_pixel  = in_line;
+            uint8_t *out_pixel = out_line;
+            for (int32_t x = 0; x < tex_w; x += 1){
+                out_pixel[0] = in_pixel[2];
+                out_pixel[1] = in_pixel[1];
+                out_pixel[2] = in_pixel[0];
+                in_pixel += 4;
+                out_pixel += 3;
+            }
+            in_line += in_pitch;
+            out_line += out_pitch;
+        }
+    }
+    
+    // Clear the Render Target
+    {
+        TRACE_SCOPE("clear target");
+        HDC dc = baker->dc;
+        HGDIOBJ original = SelectObject(dc, GetStockObject(DC_PEN));
+        SetDCPenColor(dc, baker->back_color);
+        SelectObject(dc, GetStockObject(DC_BRUSH));
+        SetDCBrushColor(dc, baker->back_color);
+        Rectangle(dc,
+                  bounding_box.left, bounding_box.top,
+                  bounding_box.right, bounding_box.bottom);
+        SelectObject(dc, original);
+    }
+    
+    return(true);
+}
+
+void
+dwrite_glyph_advances(void *backend, float *advances, int32_t glyph_count){
+    DWrite_Glyph_Baker *baker = (DWrite_Glyph_Baker*)backend;
+    uint16_t *all_indices = (uint16_t*)malloc(sizeof(uint16_t)*glyph_count);
+    DWRITE_GLYPH_METRICS *all_glyph_metrics = (DWRITE_GLYPH_METRICS*)malloc(sizeof(DWRITE_GLYPH_METRICS)*glyph_count);
+    memset(all_glyph_metrics, 0, sizeof(DWRITE_GLYPH_METRICS)*glyph_count);
+    for (int32_t i = 0; i < glyph_count; i += 1){
+        all_indices[i] = (uint16_t)i;
+    }
+    HRESULT error = baker->face->GetDesignGlyphMetrics(all_indices, glyph_count, all_glyph_metrics, false);
+    DWCheck(error, assert(!"glyph metrics"));
+    for (int32_t i = 0; i < glyph_count; i += 1){
+        advances[i] = ((float)all_glyph_metrics[i].advanceWidth)*baker->pixel_per_design_unit;
+    }
+    free(all_glyph_metrics);
+    free(all_indices);
+}
+
+void
+dwrite_codepoint_glyphs(void *backend, uint32_t *codepoints, uint16_t *glyphs, int32_t count){
+    IDWriteFontFace *face = (IDWriteFontFace*)backend;
+    HRESULT error = face->GetGlyphIndices(codepoints, count, glyphs);
+    DWCheck(error, memset(glyphs, 0, sizeof(uint16_t)*count));
+}
+
+#endif
@@ -0,0 +1,222 @@
+// DirectWrite rasterization example: versioned baked font cache file
+// Layout: header, glyph metrics array, atlas slices. The atlas starts on a page boundary so a
+// mapped file can be handed straight to the texture upload.
+
+#if !defined(EXAMPLE_FONT_CACHE_FILE_H)
+#define EXAMPLE_FONT_CACHE_FILE_H
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#define FONT_CACHE_MAGIC 0x48434642u // "BFCH"
+#define FONT_CACHE_VERSION 2
+#define FONT_CACHE_ALIGN 4096
+
+// Everything that changes the baked result. A cache file is only used when its key matches exactly.
+struct Font_Cache_Key{
+    uint64_t font_hash;
+    float point_size;
+    float dpi;
+    float gamma;
+    float enhanced_contrast;
+    float clear_type_level;
+    uint32_t pixel_geometry;
+    uint32_t rendering_mode;
+    uint32_t rasterizer;
+};
+
+struct Font_Cache_Header{
+    uint32_t magic;
+    uint32_t version;
+    Font_Cache_Key key;
+    uint32_t glyph_count;
+    uint32_t metrics_stride;
+    uint64_t metrics_offset;
+    uint32_t atlas_w;
+    uint32_t atlas_h;
+    uint32_t atlas_c;
+    uint32_t atlas_bytes_per_texel;
+    uint64_t atlas_offset;
+    uint64_t file_size;
+};
+
+struct Font_Cache_Map{
+    uint8_t *base;
+    uint64_t size;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    
+    // Pointers into the mapping, valid after font_cache_validate
+    Font_Cache_Header *header;
+    void *metrics;
+    uint8_t *atlas;
+};
+
+// FNV-1a over 64 bit words, then the tail bytes.
+uint64_t
+font_cache_hash(uint8_t *data, uint64_t size){
+    uint64_t h = 0xcbf29ce484222325ull;
+    uint64_t word_count = size/8;
+    for (uint64_t i = 0; i < word_count; i += 1){
+        uint64_t word = 0;
+        memcpy(&word, data + 8*i, 8);
+        h ^= word;
+        h *= 0x100000001b3ull;
+    }
+    for (uint64_t i = word_count*8; i < size; i += 1){
+        h ^= data[i];
+        h *= 0x100000001b3ull;
+    }
+    return(h);
+}
+
+uint64_t
+font_cache_align(uint64_t x){
+    return((x + FONT_CACHE_ALIGN - 1) & ~(uint64_t)(FONT_CACHE_ALIGN - 1));
+}
+
+bool32
+font_cache_write(char *file_name, Font_Cache_Key *key,
+                 void *metrics, uint32_t metrics_stride, uint32_t glyph_count,
+                 uint8_t *atlas, uint32_t atlas_w, uint32_t atlas_h, uint32_t atlas_c, uint32_t atlas_bytes_per_texel){
+    Font_Cache_Header header = {0};
+    header.magic = FONT_CACHE_MAGIC;
+    header.version = FONT_CACHE_VERSION;
+    header.key = *key;
+    header.glyph_count = glyph_count;
+    header.metrics_stride = metrics_stride;
+    header.metrics_offset = sizeof(header);
+    header.atlas_w = atlas_w;
+    header.atlas_h = atlas_h;
+    header.atlas_c = atlas_c;
+    header.atlas_bytes_per_texel = atlas_bytes_per_texel;
+    uint64_t metrics_size = (uint64_t)metrics_stride*glyph_count;
+    uint64_t atlas_size = (uint64_t)atlas_w*atlas_h*atlas_c*atlas_bytes_per_texel;
+    header.atlas_offset = font_cache_align(header.metrics_offset + metrics_size);
+    header.file_size = header.atlas_offset + atlas_size;
+    
+    // Written under a temporary name and renamed, so a crash never leaves a torn cache behind.
+    char temp_name[512];
+    snprintf(temp_name, sizeof(temp_name), "%s.tmp", file_name);
+    FILE *out = fopen(temp_name, "wb");
+    if (out == 0){
+        return(false);
+    }
+    static uint8_t zeros[FONT_CACHE_ALIGN] = {0};
+    uint64_t padding = header.atlas_offset - (header.metrics_offset + metrics_size);
+    bool32 success = true;
+    success = success && (fwrite(&header, sizeof(header), 1, out) == 1);
+    success = success && (fwrite(metrics, 1, (size_t)metrics_size, out) == metrics_size);
+    success = success && (fwrite(zeros, 1, (size_t)padding, out) == padding);
+    success = success && (fwrite(atlas, 1, (size_t)atlas_size, out) == atlas_size);
+    fclose(out);
+    
+    if (success){
+        remove(file_name);
+        success = (rename(temp_name, file_name) == 0);
+    }
+    if (!success){
+        remove(temp_name);
+    }
+    return(success);
+}
+
+bool32
+font_cache_map(char *file_name, Font_Cache_Map *map){
+    memset(map, 0, sizeof(*map));
+#if defined(_WIN32)
+    map->file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (map->file == INVALID_HANDLE_VALUE){
+        return(false);
+    }
+    LARGE_INTEGER size = {0};
+    GetFileSizeEx(map->file, &size);
+    map->size = (uint64_t)size.QuadPart;
+    map->mapping = CreateFileMappingA(map->file, 0, PAGE_READONLY, 0, 0, 0);
+    if (map->mapping != 0){
+        map->base = (uint8_t*)MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    map->fd = open(file_name, O_RDONLY);
+    if (map->fd < 0){
+        return(false);
+    }
+    struct stat st = {0};
+    fstat(map->fd, &st);
+    map->size = (uint64_t)st.st_size;
+    if (map->size > 0){
+        void *base = mmap(0, (size_t)map->size, PROT_READ, MAP_PRIVATE, map->fd, 0);
+        if (base != MAP_FAILED){
+            map->base = (uint8_t*)base;
+        }
+    }
+#endif
+    return(map->base != 0);
+}
+
+void
+font_cache_unmap(Font_Cache_Map *map){
+#if defined(_WIN32)
+    if (map->base != 0){
+        UnmapViewOfFile(map->base);
+    }
+    if (map->mapping != 0){
+        CloseHandle(map->mapping);
+    }
+    if (map->file != 0 && map->file != INVALID_HANDLE_VALUE){
+        CloseHandle(map->file);
+    }
+#else
+    if (map->base != 0){
+        munmap(map->base, (size_t)map->size);
+    }
+    if (map->fd > 0){
+        close(map->fd);
+    }
+#endif
+    memset(map, 0, sizeof(*map));
+}
+
+// Checks the mapped file against the key and the caller's metric layout and sets the data pointers.
+bool32
+font_cache_validate(Font_Cache_Map *map, Font_Cache_Key *key, uint32_t metrics_stride){
+    if (map->size < sizeof(Font_Cache_Header)){
+        return(false);
+    }
+    Font_Cache_Header *header = (Font_Cache_Header*)map->base;
+    if (header->magic != FONT_CACHE_MAGIC || header->version != FONT_CACHE_VERSION){
+        return(false);
+    }
+    if (memcmp(&header->key, key, sizeof(*key)) != 0){
+        return(false);
+    }
+    if (header->metrics_stride != metrics_stride || header->file_size != map->size){
+        return(false);
+    }
+    uint64_t metrics_size = (uint64_t)header->metrics_stride*header->glyph_count;
+    uint64_t atlas_size = (uint64_t)header->atlas_w*header->atlas_h*header->atlas_c*header->atlas_bytes_per_texel;
+    if (header->metrics_offset + metrics_size > header->atlas_offset ||
+        header->atlas_offset + atlas_size != header->file_size){
+        return(false);
+    }
+    map->header = header;
+    map->metrics = map->base + header->metrics_offset;
+    map->atlas = map->base + header->atlas_offset;
+    return(true);
+}
+
+#endif
@@ -0,0 +1,272 @@
+// DirectWrite rasterization example: several sizes of one face baked in the background
+// Zooming or moving the window to a monitor with another DPI needs the face at a new pixel size.
+// The registry keeps up to size_max sizes of a face and hands out the one for a point size and dpi.
+// A size it has seen is a lookup. A new one is baked on its own thread while the caller keeps
+// drawing with what it had, and the least recently used size makes room when every slot is taken.
+// Sizes are told apart by pixels per em, so 12pt at 144 dpi and 18pt at 96 dpi are the same bake.
+// What does not depend on the size, the codepoint map and the advances in design units, is one
+// Software_Font_Face shared by every size.
+// The bakes use the software rasterizer unless the registry is given a way to make other ones, the
+// window gives it DirectWrite bakers.
+
+#if !defined(EXAMPLE_FONT_REGISTRY_H)
+#define EXAMPLE_FONT_REGISTRY_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_truetype.h"
+#include "example_glyph_rasterizer.h"
+#include "example_software_rasterizer.h"
+#include "example_parallel_bake.h"
+#include "example_codepoint_map.h"
+#include "example_software_font.h"
+
+enum{
+    FontSize_Empty,
+    FontSize_Baking,
+    FontSize_Ready,
+};
+
+// Fill in worker_count rasterizers for a size, and free what they hold once the bake is done. Both
+// run on the bake thread.
+typedef void Font_Registry_Rasterizers_Init_Function(void *user, float pixel_per_em, Glyph_Rasterizer *rasterizers, int32_t worker_count);
+typedef void Font_Registry_Rasterizers_Free_Function(void *user, Glyph_Rasterizer *rasterizers, int32_t worker_count);
+
+struct Font_Registry_Rasterizers{
+    void *user;
+    Font_Registry_Rasterizers_Init_Function *init;
+    Font_Registry_Rasterizers_Free_Function *free;
+};
+
+struct Font_Registry_Size{
+    struct Font_Registry *registry;
+    float pixel_per_em;
+    int32_t state;
+    // Set by the bake thread once font is filled in
+    volatile int32_t done;
+    Bake_Thread thread;
+    Software_Font font;
+    uint64_t last_used;
+};
+
+struct Font_Registry{
+    Software_Font_Face face;
+    Font_Registry_Rasterizers rasterizers;
+    // Threads each bake splits into
+    int32_t worker_count;
+    Font_Registry_Size *sizes;
+    int32_t size_max;
+    uint64_t tick;
+    
+    uint64_t hits;
+    uint64_t bakes;
+    uint64_t evictions;
+    // Requests that found every slot busy baking
+    uint64_t stalls;
+};
+
+float
+font_registry_pixel_per_em(float point_size, float dpi){
+    return(point_size*(1.f/72.f)*dpi);
+}
+
+// Zero rasterizers bake with the software rasterizer.
+Font_Registry
+font_registry_init(TTF_Font *ttf, int32_t size_max, int32_t worker_count, Font_Registry_Rasterizers *rasterizers){
+    assert(size_max > 0);
+    Font_Registry registry = {0};
+    registry.face = software_font_face_init(ttf);
+    if (rasterizers != 0){
+        registry.rasterizers = *rasterizers;
+    }
+    registry.worker_count = worker_count;
+    registry.size_max = size_max;
+    registry.sizes = (Font_Registry_Size*)heap_alloc(sizeof(Font_Registry_Size)*size_max);
+    memset(registry.sizes, 0, sizeof(Font_Registry_Size)*size_max);
+    return(registry);
+}
+
+void
+font_registry__bake_proc(void *param){
+    Font_Registry_Size *size = (Font_Registry_Size*)param;
+    Font_Registry *registry = size->registry;
+    if (registry->rasterizers.init == 0){
+        size->font = software_font_bake_pixels(registry->face.ttf, size->pixel_per_em, registry->worker_count, &registry->face);
+    }
+    else{
+        int32_t worker_count = registry->worker_count;
+        Glyph_Rasterizer *rasterizers = (Glyph_Rasterizer*)heap_alloc(sizeof(Glyph_Rasterizer)*worker_count);
+        memset(rasterizers, 0, sizeof(Glyph_Rasterizer)*worker_count);
+        registry->rasterizers.init(registry->rasterizers.user, size->pixel_per_em, rasterizers, worker_count);
+        size->font = software_font_bake_rasterizers(&registry->face, size->pixel_per_em, rasterizers, worker_count);
+        registry->rasterizers.free(registry->rasterizers.user, rasterizers, worker_count);
+        heap_free(rasterizers);
+    }
+    bake_atomic_add(&size->done, 1);
+}
+
+// Picks up a finished bake.
+void
+font_registry__poll(Font_Registry_Size *size){
+    if (size->state == FontSize_Baking && bake_atomic_add(&size->done, 0) != 0){
+        bake_thread_join(&size->thread);
+        size->state = FontSize_Ready;
+    }
+}
+
+void
+font_registry__evict(Font_Registry *registry, Font_Registry_Size *size){
+    assert(size->state == FontSize_Ready);
+    software_font_free(&size->font);
+    memset(size, 0, sizeof(*size));
+    registry->evictions += 1;
+}
+
+Font_Registry_Size*
+font_registry__find(Font_Registry *registry, float pixel_per_em){
+    Font_Registry_Size *result = 0;
+    for (int32_t i = 0; i < registry->size_max; i += 1){
+        Font_Registry_Size *size = &registry->sizes[i];
+        if (size->state != FontSize_Empty && size->pixel_per_em == pixel_per_em){
+            result = size;
+            break;
+        }
+    }
+    return(result);
+}
+
+// Which of the size_max slots holds a font the registry handed out. Anything kept per size, like a
+// texture, can be kept per slot and checked against the font's pixel_per_em.
+int32_t
+font_registry_slot(Font_Registry *registry, Software_Font *font){
+    int32_t result = -1;
+    for (int32_t i = 0; i < registry->size_max; i += 1){
+        if (&registry->sizes[i].font == font){
+            result = i;
+            break;
+        }
+    }
+    return(result);
+}
+
+Software_Font*
+font_registry__get(Font_Registry *registry, float pixel_per_em, Font_Registry_Size *keep){
+    registry->tick += 1;
+    
+    Font_Registry_Size *size = font_registry__find(registry, pixel_per_em);
+    if (size != 0){
+        font_registry__poll(size);
+        if (size->state == FontSize_Ready){
+            size->last_used = registry->tick;
+            registry->hits += 1;
+            return(&size->font);
+        }
+        return(0);
+    }
+    
+    // A free slot, otherwise the least recently used size that is done baking and not kept
+    Font_Registry_Size *slot = 0;
+    for (int32_t i = 0; i < registry->size_max; i += 1){
+        Font_Registry_Size *candidate = &registry->sizes[i];
+        font_registry__poll(candidate);
+        if (candidate->state == FontSize_Empty){
+            slot = candidate;
+            break;
+        }
+        if (candidate->state == FontSize_Ready && candidate != keep &&
+            (slot == 0 || candidate->last_used < slot->last_used)){
+            slot = candidate;
+        }
+    }
+    if (slot == 0){
+        registry->stalls += 1;
+        return(0);
+    }
+    if (slot->state == FontSize_Ready){
+        font_registry__evict(registry, slot);
+    }
+    
+    slot->registry = registry;
+    slot->pixel_per_em = pixel_per_em;
+    slot->state = FontSize_Baking;
+    slot->done = 0;
+    slot->last_used = registry->tick;
+    registry->bakes += 1;
+    bake_thread_start(&slot->thread, font_registry__bake_proc, slot);
+    return(0);
+}
+
+// The font for a size once it is baked, zero while it bakes. The first request for a size starts
+// its bake, in place of the least recently used size if there is no free slot. The font stays valid
+// until a later request evicts it.
+Software_Font*
+font_registry_get(Font_Registry *registry, float point_size, float dpi){
+    return(font_registry__get(registry, font_registry_pixel_per_em(point_size, dpi), 0));
+}
+
+// font_registry_get that blocks until the size is baked.
+Software_Font*
+font_registry_get_wait(Font_Registry *registry, float point_size, float dpi){
+    Software_Font *font = font_registry_get(registry, point_size, dpi);
+    if (font == 0){
+        Font_Registry_Size *size = font_registry__find(registry, font_registry_pixel_per_em(point_size, dpi));
+        if (size != 0 && size->state == FontSize_Baking){
+            bake_thread_join(&size->thread);
+            size->state = FontSize_Ready;
+            size->last_used = registry->tick;
+            font = &size->font;
+        }
+    }
+    return(font);
+}
+
+// What a window draws with each frame after a zoom or a DPI change: the wanted size once it is
+// baked, current until then. current is never evicted to make room for the wanted size, so it stays
+// valid for the frame. With one slot that means the wanted size waits until current is let go.
+Software_Font*
+font_registry_get_or_keep(Font_Registry *registry, float point_size, float dpi, Software_Font *current){
+    int32_t current_slot = (current != 0)?font_registry_slot(registry, current):-1;
+    Font_Registry_Size *keep = (current_slot >= 0)?&registry->sizes[current_slot]:0;
+    Software_Font *font = font_registry__get(registry, font_registry_pixel_per_em(point_size, dpi), keep);
+    if (font == 0){
+        font = current;
+    }
+    return(font);
+}
+
+// Bytes of every baked size, and in shared_out the bytes all sizes share.
+uint64_t
+font_registry_memory(Font_Registry *registry, uint64_t *shared_out){
+    uint64_t result = 0;
+    for (int32_t i = 0; i < registry->size_max; i += 1){
+        Font_Registry_Size *size = &registry->sizes[i];
+        if (size->state == FontSize_Ready){
+            result += software_font_memory(&size->font);
+        }
+    }
+    *shared_out = software_font_face_memory(&registry->face);
+    return(result);
+}
+
+void
+font_registry_free(Font_Registry *registry){
+    for (int32_t i = 0; i < registry->size_max; i += 1){
+        Font_Registry_Size *size = &registry->sizes[i];
+        if (size->state == FontSize_Baking){
+            bake_thread_join(&size->thread);
+            size->state = FontSize_Ready;
+        }
+        if (size->state == FontSize_Ready){
+            software_font_free(&size->font);
+        }
+    }
+    heap_free(registry->sizes);
+    software_font_face_free(&registry->face);
+    memset(registry, 0, sizeof(*registry));
+}
+
+#endif
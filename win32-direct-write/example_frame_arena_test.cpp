@@ -0,0 +1,209 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the frame arena and the heap allocation counter
+// usage: frame_arena_test [seed]
+// Random pushes, marks, pops and resets against a model of the arena: every push is aligned, lies
+// inside the arena and after everything still live, a push that does not fit changes nothing, and
+// popping to a mark gives back exactly what came after it. The counter must only count allocations
+// inside a frame and on the thread that opened it. Last, frames of strings through the text batch
+// with arena scratch must stop touching the heap once the first frame has sized the batch.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_parallel_bake.h"
+#include "example_text_batch.h"
+#include "example_test.h"
+
+static int32_t test_arena_count = 500;
+static int32_t test_op_count = 400;
+static int32_t test_frame_count = 100;
+
+#define TEST_MARK_MAX 64
+
+// Allocates while the main thread has a frame open, like a background bake.
+void
+test_other_thread_proc(void *param){
+    void *p = heap_alloc(32);
+    p = heap_realloc(p, 128);
+    heap_free(p);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0xA3E7Au);
+    uint32_t state = seed;
+
+#if HEAP_ALLOC_CHECKS
+    // The counter itself: only allocations inside a frame count against it, frees never do.
+    {
+        void *outside = heap_alloc(16);
+        heap_frame_begin();
+        void *inside = heap_alloc(16);
+        inside = heap_realloc(inside, 64);
+        heap_free(inside);
+        TEST_CHECK(heap_frame_end() == 2);
+        heap_free(outside);
+        TEST_CHECK(heap_frame_end() == 2);
+        heap_frame_begin();
+        TEST_CHECK(heap_frame_end() == 0);
+        
+        // Another thread's allocations are not the frame's.
+        heap_frame_begin();
+        Bake_Thread thread = {0};
+        bake_thread_start(&thread, test_other_thread_proc, 0);
+        bake_thread_join(&thread);
+        void *mine = heap_alloc(8);
+        TEST_CHECK(heap_frame_end() == 1);
+        heap_free(mine);
+    }
+#endif
+    
+    // Arena operations against the model: used only grows by pushes and only shrinks by pops.
+    int64_t push_total = 0;
+    int64_t failure_total = 0;
+    for (int32_t a = 0; a < test_arena_count; a += 1){
+        int64_t failures_before = test_state.failures;
+        uint64_t size = (uint64_t)test_random_range(&state, 1, 1 << 16);
+        Arena arena = arena_alloc(size);
+        uint64_t base = (uint64_t)(uintptr_t)arena.base;
+        Arena_Mark marks[TEST_MARK_MAX];
+        int32_t mark_count = 0;
+        uint64_t high_water = 0;
+        uint64_t failures = 0;
+        for (int32_t op = 0; op < test_op_count; op += 1){
+            int32_t kind = test_random_range(&state, 0, 15);
+            if (kind < 10){
+                uint64_t push_size = (uint64_t)test_random_range(&state, 0, 4096);
+                uint64_t align = (uint64_t)1 << test_random_range(&state, 0, 7);
+                uint64_t used_before = arena.used;
+                uint8_t *p = (uint8_t*)arena_push_align(&arena, push_size, align);
+                if (p == 0){
+                    failures += 1;
+                    TEST_CHECK(arena.used == used_before);
+                    // It really did not fit, with the padding the alignment needs.
+                    uint64_t start = (base + used_before + align - 1) & ~(align - 1);
+                    TEST_CHECK(start - base + push_size > size);
+                }
+                else{
+                    uint64_t address = (uint64_t)(uintptr_t)p;
+                    TEST_CHECK(address%align == 0);
+                    TEST_CHECK(address >= base + used_before && address - (base + used_before) < align);
+                    TEST_CHECK(address + push_size <= base + size);
+                    TEST_CHECK(arena.used == address + push_size - base);
+                    // The memory is there to be written.
+                    memset(p, 0xCD, (size_t)push_size);
+                    push_total += 1;
+                }
+            }
+            else if (kind < 12 && mark_count < TEST_MARK_MAX){
+                marks[mark_count] = arena_mark(&arena);
+                mark_count += 1;
+            }
+            else if (kind < 14 && mark_count > 0){
+                mark_count -= 1;
+                arena_pop_to(&arena, marks[mark_count]);
+                TEST_CHECK(arena.used == marks[mark_count].used);
+            }
+            else if (kind == 15){
+                arena_reset(&arena);
+                TEST_CHECK(arena.used == 0);
+                mark_count = 0;
+            }
+            high_water = (arena.used > high_water)?arena.used:high_water;
+            TEST_CHECK(arena.used <= arena.size);
+        }
+        TEST_CHECK(arena.high_water == high_water);
+        TEST_CHECK(arena.failures == failures);
+        if (test_state.failures != failures_before){
+            printf("    arena %d: %llu bytes\n", a, (unsigned long long)size);
+        }
+        failure_total += failures;
+        arena_free(&arena);
+    }
+    
+    // Steady frames: the batch keeps its arrays from frame to frame, the scratch of every string
+    // comes from the arena, so only the first frame may allocate.
+    {
+        int32_t glyph_count = 128;
+        Glyph_Metrics *metrics = (Glyph_Metrics*)calloc(glyph_count, sizeof(Glyph_Metrics));
+        for (int32_t i = 0; i < glyph_count; i += 1){
+            metrics[i].off_y = -10.f;
+            metrics[i].advance = 7.f;
+            metrics[i].xy_w = 6.f;
+            metrics[i].xy_h = 12.f;
+            metrics[i].uv_x = (float)(i%16)/16.f;
+            metrics[i].uv_y = (float)(i/16)/16.f;
+        }
+        Text_Instance *templates = text_alloc_instance_templates(metrics, glyph_count, 256, 256);
+        int32_t string_count = 40;
+        int32_t string_lengths[40];
+        uint32_t string_seeds[40];
+        for (int32_t s = 0; s < string_count; s += 1){
+            string_lengths[s] = test_random_range(&state, 0, 200);
+            string_seeds[s] = test_random(&state) | 1;
+        }
+        
+        Arena arena = arena_alloc(1 << 16);
+        Text_Batch batch = {0};
+        uint64_t steady_allocations = 0;
+        for (int32_t frame = 0; frame < test_frame_count; frame += 1){
+            arena_reset(&arena);
+            heap_frame_begin();
+            text_batch_begin_frame(&batch);
+            for (int32_t s = 0; s < string_count; s += 1){
+                // Rotating the order and the colors changes how strings share commands and styles.
+                int32_t k = (s + frame)%string_count;
+                Arena_Mark mark = arena_mark(&arena);
+                uint16_t *glyphs = arena_push_array(&arena, uint16_t, string_lengths[k]);
+                int32_t *pen_x = arena_push_array(&arena, int32_t, string_lengths[k]);
+                TEST_CHECK(glyphs != 0 && pen_x != 0);
+                uint32_t string_state = string_seeds[k];
+                for (int32_t i = 0; i < string_lengths[k]; i += 1){
+                    glyphs[i] = (uint16_t)(test_random(&string_state)%glyph_count);
+                    pen_x[i] = 10 + 7*i;
+                }
+                uint8_t shade = (uint8_t)(((s + frame)%8)*32);
+                text_batch_begin_string_rgba8(&batch, 1 + (uint32_t)(k%3), 256, 256, shade, 255 - shade, 128, 255);
+                text_batch_push_run(&batch, templates, glyphs, pen_x, 20 + 16*k, string_lengths[k]);
+                arena_pop_to(&arena, mark);
+            }
+            uint64_t allocations = heap_frame_end();
+            if (frame > 0){
+                steady_allocations += allocations;
+            }
+            TEST_CHECK(arena.used == 0);
+        }
+#if HEAP_ALLOC_CHECKS
+        TEST_CHECK(steady_allocations == 0);
+#endif
+        TEST_CHECK(arena.failures == 0);
+        printf("frame_arena_test: %d steady frames, %llu heap allocations after the first, arena high water %llu bytes\n",
+               test_frame_count - 1, (unsigned long long)steady_allocations, (unsigned long long)arena.high_water);
+        
+        text_batch_free(&batch);
+        arena_free(&arena);
+        heap_free(templates);
+        free(metrics);
+    }
+    
+    printf("frame_arena_test: %d arenas, %lld pushes, %lld that did not fit\n",
+           test_arena_count, (long long)push_total, (long long)failure_total);
+    return(test_finish("frame_arena_test", seed));
+}
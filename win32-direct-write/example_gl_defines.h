@@ -3,6 +3,8 @@
 typedef char GLchar;
 typedef ptrdiff_t GLsizeiptr;
 typedef ptrdiff_t GLintptr;
+typedef uint64_t GLuint64;
+typedef struct __GLsync *GLsync;
 
 typedef void GLDEBUGPROC_Type(GLenum source,GLenum type,GLuint id,GLenum severity,GLsizei length,const GLchar *message,const void *userParam);
 typedef GLDEBUGPROC_Type *GLDEBUGPROC;
@@ -10,11 +12,18 @@ typedef GLDEBUGPROC_Type *GLDEBUGPROC;
 #define GL_FUNC(N,R,P) typedef R N##_Type P; static N##_Type *N = 0;
 #include "example_gl_funcs.h"
 
+#define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
+
+#define GL_MAP_WRITE_BIT                  0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT       0x0004
+#define GL_MAP_UNSYNCHRONIZED_BIT         0x0020
+
 #define GL_CONSTANT_COLOR                 0x8001
 
 #define GL_CLAMP_TO_EDGE                  0x812F
 
 #define GL_FRAMEBUFFER_UNDEFINED          0x8219
+#define GL_R16UI                          0x8234
 
 #define GL_DEBUG_OUTPUT_SYNCHRONOUS       0x8242
 #define GL_DEBUG_SEVERITY_NOTIFICATION    0x826B
@@ -23,8 +32,14 @@ typedef GLDEBUGPROC_Type *GLDEBUGPROC;
 
 #define GL_ARRAY_BUFFER                   0x8892
 
+#define GL_STREAM_DRAW                    0x88E0
 #define GL_DYNAMIC_DRAW                   0x88E8
 
+#define GL_PIXEL_UNPACK_BUFFER            0x88EC
+
+#define GL_SRC1_COLOR                     0x88F9
+#define GL_ONE_MINUS_SRC1_COLOR           0x88FA
+
 #define GL_FRAGMENT_SHADER                0x8B30
 #define GL_VERTEX_SHADER                  0x8B31
 
@@ -46,9 +61,15 @@ typedef GLDEBUGPROC_Type *GLDEBUGPROC;
 #define GL_COLOR_ATTACHMENT0              0x8CE0
 
 #define GL_FRAMEBUFFER                    0x8D40
+#define GL_RED_INTEGER                    0x8D94
 
 #define GL_FRAMEBUFFER_SRGB               0x8DB9
 
+#define GL_SYNC_GPU_COMMANDS_COMPLETE     0x9117
+#define GL_ALREADY_SIGNALED               0x911A
+#define GL_TIMEOUT_EXPIRED                0x911B
+#define GL_CONDITION_SATISFIED            0x911C
+
 #define GL_DEBUG_SEVERITY_HIGH            0x9146
 #define GL_DEBUG_SEVERITY_MEDIUM          0x9147
 #define GL_DEBUG_SEVERITY_LOW             0x9148
@@ -10,6 +10,7 @@ GL_FUNC(glCheckFramebufferStatus, GLenum, (GLenum target))
 GL_FUNC(glBlitFramebuffer, void, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter))
 
 GL_FUNC(glTexImage3D, void, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels));
+GL_FUNC(glTexSubImage3D, void, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels))
 
 GL_FUNC(glCreateProgram, GLuint, (void))
 GL_FUNC(glCreateShader, GLuint, (GLenum type))
@@ -24,19 +25,29 @@ GL_FUNC(glGetAttribLocation, GLint, (GLuint program, const GLchar *name))
 GL_FUNC(glGenBuffers, void, (GLsizei n, GLuint *buffers))
 GL_FUNC(glBindBuffer, void, (GLenum target, GLuint buffer))
 GL_FUNC(glBufferData, void, (GLenum target, GLsizeiptr size, const void *data, GLenum usage))
+GL_FUNC(glMapBufferRange, void*, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access))
+GL_FUNC(glUnmapBuffer, GLboolean, (GLenum target))
+
+GL_FUNC(glFenceSync, GLsync, (GLenum condition, GLbitfield flags))
+GL_FUNC(glClientWaitSync, GLenum, (GLsync sync, GLbitfield flags, GLuint64 timeout))
+GL_FUNC(glDeleteSync, void, (GLsync sync))
 
 GL_FUNC(glEnableVertexAttribArray, void, (GLuint index))
 GL_FUNC(glVertexAttribPointer, void, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer))
+GL_FUNC(glVertexAttribIPointer, void, (GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer))
+GL_FUNC(glVertexAttribDivisor, void, (GLuint index, GLuint divisor))
 
 GL_FUNC(glActiveTexture, void, (GLenum texture))
 
 GL_FUNC(glUniform4f, void, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3))
 GL_FUNC(glUniform1i, void, (GLint location, GLint v0))
 GL_FUNC(glUniform1fv, void, (GLint location, GLsizei count, const GLfloat *value))
+GL_FUNC(glUniform4fv, void, (GLint location, GLsizei count, const GLfloat *value))
 GL_FUNC(glUniformMatrix3fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value))
 
 GL_FUNC(glGenVertexArrays, void, (GLsizei n, GLuint *arrays))
 GL_FUNC(glBindVertexArray, void, (GLuint array))
+GL_FUNC(glDrawArraysInstanced, void, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount))
 
 GL_FUNC(glBlendColor, void, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha))
 
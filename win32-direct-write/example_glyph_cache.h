@@ -0,0 +1,202 @@
+// DirectWrite rasterization example: fixed size glyph atlas with least recently used eviction
+// The cache only decides where glyphs live. Rasterizing and uploading a glyph on a miss is left to
+// the caller, so any rasterizer backend can sit behind it.
+
+#if !defined(EXAMPLE_GLYPH_CACHE_H)
+#define EXAMPLE_GLYPH_CACHE_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_atlas_packer.h"
+
+struct Glyph_Cache_Cell{
+    int32_t glyph;
+    // Links in the LRU list, most recently used at the front
+    int32_t prev;
+    int32_t next;
+    uint64_t last_used_frame;
+};
+
+struct Glyph_Cache{
+    int32_t cell_w;
+    int32_t cell_h;
+    int32_t cells_x;
+    int32_t cells_y;
+    int32_t slice_count;
+    int32_t cell_count;
+    
+    // cells[cell_count] is the sentinel of the LRU list
+    Glyph_Cache_Cell *cells;
+    
+    // Cell of every glyph in the font, -1 when the glyph is not resident
+    int32_t *glyph_cells;
+    int32_t glyph_count;
+    
+    uint64_t frame;
+    // Glyph the last miss evicted, -1 when its cell was free
+    int32_t last_evicted;
+    
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t failures;
+    uint64_t releases;
+};
+
+enum Glyph_Cache_Result{
+    GlyphCache_Hit,
+    // The glyph was given a cell and must be rasterized into it
+    GlyphCache_Miss,
+    // Every cell is in use by the current frame
+    GlyphCache_Full,
+};
+
+void
+glyph_cache__unlink(Glyph_Cache *cache, int32_t cell){
+    Glyph_Cache_Cell *c = &cache->cells[cell];
+    cache->cells[c->prev].next = c->next;
+    cache->cells[c->next].prev = c->prev;
+}
+
+void
+glyph_cache__push_front(Glyph_Cache *cache, int32_t cell){
+    int32_t sentinel = cache->cell_count;
+    Glyph_Cache_Cell *c = &cache->cells[cell];
+    c->prev = sentinel;
+    c->next = cache->cells[sentinel].next;
+    cache->cells[c->next].prev = cell;
+    cache->cells[sentinel].next = cell;
+}
+
+void
+glyph_cache__push_back(Glyph_Cache *cache, int32_t cell){
+    int32_t sentinel = cache->cell_count;
+    Glyph_Cache_Cell *c = &cache->cells[cell];
+    c->next = sentinel;
+    c->prev = cache->cells[sentinel].prev;
+    cache->cells[c->prev].next = cell;
+    cache->cells[sentinel].prev = cell;
+}
+
+Glyph_Cache
+glyph_cache_init(int32_t glyph_count, int32_t cell_w, int32_t cell_h, int32_t atlas_w, int32_t atlas_h, int32_t slice_count){
+    Glyph_Cache cache = {0};
+    cache.cell_w = cell_w;
+    cache.cell_h = cell_h;
+    cache.cells_x = atlas_w/cell_w;
+    cache.cells_y = atlas_h/cell_h;
+    cache.slice_count = slice_count;
+    cache.cell_count = cache.cells_x*cache.cells_y*slice_count;
+    assert(cache.cell_count > 0);
+    
+    cache.cells = (Glyph_Cache_Cell*)malloc(sizeof(Glyph_Cache_Cell)*(cache.cell_count + 1));
+    int32_t sentinel = cache.cell_count;
+    cache.cells[sentinel].glyph = -1;
+    cache.cells[sentinel].prev = sentinel;
+    cache.cells[sentinel].next = sentinel;
+    cache.cells[sentinel].last_used_frame = 0;
+    for (int32_t i = 0; i < cache.cell_count; i += 1){
+        cache.cells[i].glyph = -1;
+        cache.cells[i].last_used_frame = 0;
+        glyph_cache__push_front(&cache, i);
+    }
+    
+    cache.glyph_count = glyph_count;
+    cache.glyph_cells = (int32_t*)malloc(sizeof(int32_t)*glyph_count);
+    for (int32_t i = 0; i < glyph_count; i += 1){
+        cache.glyph_cells[i] = -1;
+    }
+    
+    cache.frame = 1;
+    cache.last_evicted = -1;
+    return(cache);
+}
+
+void
+glyph_cache_free(Glyph_Cache *cache){
+    free(cache->cells);
+    free(cache->glyph_cells);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Glyphs used during the current frame are never evicted, the frame may still be drawing from them.
+void
+glyph_cache_begin_frame(Glyph_Cache *cache){
+    cache->frame += 1;
+}
+
+Atlas_Slot
+glyph_cache_cell_slot(Glyph_Cache *cache, int32_t cell){
+    int32_t cells_per_slice = cache->cells_x*cache->cells_y;
+    int32_t in_slice = cell%cells_per_slice;
+    Atlas_Slot slot = {0};
+    slot.x = cache->cell_w*(in_slice%cache->cells_x);
+    slot.y = cache->cell_h*(in_slice/cache->cells_x);
+    slot.w = cache->cell_w;
+    slot.h = cache->cell_h;
+    slot.slice = cell/cells_per_slice;
+    return(slot);
+}
+
+Glyph_Cache_Result
+glyph_cache_lookup(Glyph_Cache *cache, int32_t glyph, Atlas_Slot *slot){
+    assert(0 <= glyph && glyph < cache->glyph_count);
+    Glyph_Cache_Result result = GlyphCache_Hit;
+    
+    int32_t cell = cache->glyph_cells[glyph];
+    if (cell >= 0){
+        cache->hits += 1;
+    }
+    else{
+        // The back of the list is the least recently used cell.
+        int32_t sentinel = cache->cell_count;
+        cell = cache->cells[sentinel].prev;
+        Glyph_Cache_Cell *victim = &cache->cells[cell];
+        if (victim->glyph >= 0 && victim->last_used_frame == cache->frame){
+            cache->failures += 1;
+            return(GlyphCache_Full);
+        }
+        cache->last_evicted = victim->glyph;
+        if (victim->glyph >= 0){
+            cache->glyph_cells[victim->glyph] = -1;
+            cache->evictions += 1;
+        }
+        victim->glyph = glyph;
+        cache->glyph_cells[glyph] = cell;
+        cache->misses += 1;
+        result = GlyphCache_Miss;
+    }
+    
+    glyph_cache__unlink(cache, cell);
+    glyph_cache__push_front(cache, cell);
+    cache->cells[cell].last_used_frame = cache->frame;
+    
+    *slot = glyph_cache_cell_slot(cache, cell);
+    return(result);
+}
+
+// Gives back the cell of a glyph that turned out to have nothing to draw. The cell goes to the back
+// of the list so it is the next one handed out.
+void
+glyph_cache_release(Glyph_Cache *cache, int32_t glyph){
+    int32_t cell = cache->glyph_cells[glyph];
+    if (cell >= 0){
+        cache->glyph_cells[glyph] = -1;
+        cache->cells[cell].glyph = -1;
+        cache->cells[cell].last_used_frame = 0;
+        cache->releases += 1;
+        glyph_cache__unlink(cache, cell);
+        glyph_cache__push_back(cache, cell);
+    }
+}
+
+bool32
+glyph_cache_is_resident(Glyph_Cache *cache, int32_t glyph){
+    return(cache->glyph_cells[glyph] >= 0);
+}
+
+#endif
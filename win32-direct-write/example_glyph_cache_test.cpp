@@ -0,0 +1,177 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the LRU glyph cache
+// usage: glyph_cache_test [seed]
+// Runs random frames of lookups and releases against caches of random size and keeps its own model
+// of what every cell holds. A hit must find the glyph that was baked into its cell, a miss must take
+// a released cell first and otherwise the least recently used one, never a glyph of the current
+// frame, and the cache is only full when the frame has used every cell.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_glyph_cache.h"
+#include "example_test.h"
+
+static int32_t test_set_count = 200;
+static int32_t test_frame_count = 60;
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x6C1A5Eu);
+    uint32_t state = seed;
+    
+    int64_t lookup_total = 0;
+    int64_t eviction_total = 0;
+    int64_t full_total = 0;
+    for (int32_t set = 0; set < test_set_count; set += 1){
+        int64_t failures_before = test_state.failures;
+        int32_t glyph_count = test_random_range(&state, 1, 2000);
+        int32_t cell_side = test_random_range(&state, 4, 32);
+        int32_t atlas_side = cell_side*test_random_range(&state, 1, 8);
+        int32_t slice_count = test_random_range(&state, 1, 3);
+        Glyph_Cache cache = glyph_cache_init(glyph_count, cell_side, cell_side, atlas_side, atlas_side, slice_count);
+        
+        // The model: the glyph baked into each cell, and when each glyph was last looked up. Ticks
+        // order every lookup, frames only decide what may not be evicted.
+        int32_t *cell_glyphs = (int32_t*)malloc(sizeof(int32_t)*cache.cell_count);
+        int64_t *glyph_ticks = (int64_t*)calloc(glyph_count, sizeof(int64_t));
+        uint64_t *glyph_frames = (uint64_t*)calloc(glyph_count, sizeof(uint64_t));
+        int32_t *released_cells = (int32_t*)malloc(sizeof(int32_t)*cache.cell_count);
+        int32_t released_count = 0;
+        for (int32_t i = 0; i < cache.cell_count; i += 1){
+            cell_glyphs[i] = -1;
+        }
+        int64_t tick = 0;
+        int64_t lookups = 0;
+        int64_t releases = 0;
+        
+        for (int32_t frame = 0; frame < test_frame_count; frame += 1){
+            glyph_cache_begin_frame(&cache);
+            int32_t frame_used = 0;
+            int32_t lookup_count = test_random_range(&state, 0, 2*cache.cell_count);
+            for (int32_t i = 0; i < lookup_count; i += 1){
+                // Now and then a resident glyph turns out to draw nothing.
+                if (test_random_range(&state, 0, 15) == 0){
+                    int32_t glyph = test_random_range(&state, 0, glyph_count - 1);
+                    int32_t cell = cache.glyph_cells[glyph];
+                    if (cell >= 0 && glyph_frames[glyph] != cache.frame){
+                        glyph_cache_release(&cache, glyph);
+                        TEST_CHECK(!glyph_cache_is_resident(&cache, glyph));
+                        cell_glyphs[cell] = -1;
+                        released_cells[released_count] = cell;
+                        released_count += 1;
+                        releases += 1;
+                    }
+                }
+                
+                // Skewed toward the low glyphs, like text is
+                int32_t r = test_random_range(&state, 0, 1023);
+                int32_t glyph = (int32_t)(((int64_t)r*r*glyph_count) >> 20);
+                bool32 was_resident = glyph_cache_is_resident(&cache, glyph);
+                bool32 first_this_frame = (glyph_frames[glyph] != cache.frame);
+                
+                // The cell the model expects a miss to take: the last released one, then the never
+                // used ones in order, then the least recently used glyph's.
+                int32_t expected_cell = -1;
+                if (released_count > 0){
+                    expected_cell = released_cells[released_count - 1];
+                }
+                for (int32_t cell = 0; cell < cache.cell_count && expected_cell < 0; cell += 1){
+                    if (cell_glyphs[cell] < 0){
+                        expected_cell = cell;
+                    }
+                }
+                for (int32_t cell = 0; cell < cache.cell_count && (expected_cell < 0 || cell_glyphs[expected_cell] >= 0); cell += 1){
+                    if (expected_cell < 0 || glyph_ticks[cell_glyphs[cell]] < glyph_ticks[cell_glyphs[expected_cell]]){
+                        expected_cell = cell;
+                    }
+                }
+                
+                Atlas_Slot slot = {0};
+                Glyph_Cache_Result result = glyph_cache_lookup(&cache, glyph, &slot);
+                lookups += 1;
+                tick += 1;
+                int32_t cells_per_slice = cache.cells_x*cache.cells_y;
+                int32_t cell = slot.slice*cells_per_slice + (slot.y/cell_side)*cache.cells_x + slot.x/cell_side;
+                
+                if (result == GlyphCache_Full){
+                    TEST_CHECK(!was_resident);
+                    TEST_CHECK(frame_used == cache.cell_count);
+                    full_total += 1;
+                    continue;
+                }
+                TEST_CHECK(slot.w == cell_side && slot.h == cell_side);
+                TEST_CHECK(slot.x >= 0 && slot.x + slot.w <= atlas_side && slot.y >= 0 && slot.y + slot.h <= atlas_side);
+                TEST_CHECK(0 <= slot.slice && slot.slice < slice_count);
+                if (result == GlyphCache_Hit){
+                    TEST_CHECK(was_resident);
+                    TEST_CHECK(cell_glyphs[cell] == glyph);
+                }
+                else{
+                    TEST_CHECK(!was_resident);
+                    TEST_CHECK(cell == expected_cell);
+                    int32_t evicted = cell_glyphs[cell];
+                    if (evicted >= 0){
+                        TEST_CHECK(glyph_frames[evicted] != cache.frame);
+                        TEST_CHECK(!glyph_cache_is_resident(&cache, evicted));
+                        eviction_total += 1;
+                    }
+                    for (int32_t k = released_count - 1; k >= 0; k -= 1){
+                        if (released_cells[k] == cell){
+                            memmove(released_cells + k, released_cells + k + 1, sizeof(int32_t)*(released_count - k - 1));
+                            released_count -= 1;
+                            break;
+                        }
+                    }
+                    cell_glyphs[cell] = glyph;
+                }
+                frame_used += first_this_frame;
+                glyph_ticks[glyph] = tick;
+                glyph_frames[glyph] = cache.frame;
+            }
+        }
+        
+        TEST_CHECK((int64_t)(cache.hits + cache.misses + cache.failures) == lookups);
+        TEST_CHECK((int64_t)cache.releases == releases);
+        int32_t resident_count = 0;
+        for (int32_t glyph = 0; glyph < glyph_count; glyph += 1){
+            resident_count += glyph_cache_is_resident(&cache, glyph);
+        }
+        int32_t model_count = 0;
+        for (int32_t cell = 0; cell < cache.cell_count; cell += 1){
+            model_count += (cell_glyphs[cell] >= 0);
+        }
+        TEST_CHECK(resident_count == model_count);
+        if (test_state.failures != failures_before){
+            printf("    set %d: %d glyphs, %d cells of %d in %d slices\n",
+                   set, glyph_count, cache.cell_count, cell_side, slice_count);
+        }
+        
+        lookup_total += lookups;
+        free(released_cells);
+        free(glyph_frames);
+        free(glyph_ticks);
+        free(cell_glyphs);
+        glyph_cache_free(&cache);
+    }
+    
+    printf("glyph_cache_test: %d sets, %lld lookups, %lld evictions, %lld full\n",
+           test_set_count, (long long)lookup_total, (long long)eviction_total, (long long)full_total);
+    return(test_finish("glyph_cache_test", seed));
+}
@@ -0,0 +1,49 @@
+// DirectWrite rasterization example: interface between the glyph bake and a rasterizer backend
+// A backend turns a glyph index into an RGB coverage bitmap (one coverage value per subpixel) plus
+// the box placement and advance that the bake stores in Glyph_Metrics.
+
+#if !defined(EXAMPLE_GLYPH_RASTERIZER_H)
+#define EXAMPLE_GLYPH_RASTERIZER_H
+
+#include <stdint.h>
+#include <string.h>
+typedef int32_t bool32;
+
+struct Glyph_Bitmap{
+    // Box of the glyph relative to the pen position on the baseline, y down
+    int32_t off_x;
+    int32_t off_y;
+    int32_t w;
+    int32_t h;
+    // Unrounded advance in pixels
+    float advance;
+    // Owned by the backend, valid until the next call
+    uint8_t *rgb;
+    int32_t pitch;
+};
+
+// shift_x in [0,1) moves the glyph right of the pen by a fraction of a pixel, for subpixel phases.
+typedef bool32 Rasterize_Glyph_Function(void *backend, uint16_t glyph_index, float shift_x, Glyph_Bitmap *bitmap);
+typedef void Glyph_Advances_Function(void *backend, float *advances, int32_t glyph_count);
+
+struct Glyph_Rasterizer{
+    void *backend;
+    Rasterize_Glyph_Function *rasterize_glyph;
+    Glyph_Advances_Function *glyph_advances;
+    int32_t glyph_count;
+    float pixel_per_em;
+};
+
+// Copies the top left w by h texels of a glyph bitmap into an RGB destination.
+void
+glyph_bitmap_copy(Glyph_Bitmap *bitmap, int32_t w, int32_t h, uint8_t *out, int32_t out_pitch){
+    uint8_t *in_line = bitmap->rgb;
+    uint8_t *out_line = out;
+    for (int32_t y = 0; y < h; y += 1){
+        memcpy(out_line, in_line, 3*w);
+        in_line += bitmap->pitch;
+        out_line += out_pitch;
+    }
+}
+
+#endif
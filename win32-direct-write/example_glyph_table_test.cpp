@@ -0,0 +1,215 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the sparse glyph table under a churning glyph cache
+// usage: glyph_table_test [seed]
+// Bakes far more distinct glyph variants than there are dense indices through a small glyph cache,
+// releasing every variant the cache evicts, like draw_string does. Every variant used in a frame
+// must own its dense index and keep the template it was baked with, a released variant that comes
+// back keeps its index until it was handed on, and only released variants give their index away.
+// Last, baked fonts of 65535 glyphs get a dense index for every glyph but one that draws.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_text_batch.h"
+#include "example_glyph_cache.h"
+#include "example_test.h"
+
+static int32_t test_glyph_count = 40000;
+static int32_t test_phase_count = 4;
+static int32_t test_frame_count = 400;
+static int32_t test_lookups_per_frame = 600;
+
+#define TEST_CELL_SIDE 8
+#define TEST_ATLAS_SIDE 240
+
+// Every variant has its own box, some draw nothing.
+Glyph_Metrics
+test_variant_metrics(int32_t variant, Atlas_Slot slot){
+    Glyph_Metrics metrics = {0};
+    uint32_t h = (uint32_t)variant*2654435761u;
+    metrics.advance = 7.f;
+    if ((h >> 7)%9 != 0){
+        metrics.off_x = (float)((h >> 11)%5) - 2.f;
+        metrics.off_y = -(float)((h >> 14)%8);
+        metrics.xy_w = (float)(1 + (h >> 17)%TEST_CELL_SIDE);
+        metrics.xy_h = (float)(1 + (h >> 21)%TEST_CELL_SIDE);
+        metrics.uv_w = metrics.xy_w/TEST_ATLAS_SIDE;
+        metrics.uv_h = metrics.xy_h/TEST_ATLAS_SIDE;
+        metrics.uv_x = (float)slot.x/TEST_ATLAS_SIDE;
+        metrics.uv_y = (float)slot.y/TEST_ATLAS_SIDE;
+        metrics.uv_slice = (float)slot.slice;
+    }
+    return(metrics);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x61AB1Eu);
+    uint32_t state = seed;
+    
+    // Churn
+    {
+        int32_t variant_count = test_glyph_count*test_phase_count;
+        Glyph_Metrics *font_metrics = (Glyph_Metrics*)calloc(test_glyph_count, sizeof(Glyph_Metrics));
+        Text_Glyph_Table table = text_glyph_table_alloc(font_metrics, test_glyph_count, test_phase_count, TEST_ATLAS_SIDE, TEST_ATLAS_SIDE, false);
+        Glyph_Cache cache = glyph_cache_init(variant_count, TEST_CELL_SIDE, TEST_CELL_SIDE, TEST_ATLAS_SIDE, TEST_ATLAS_SIDE, 1);
+        TEST_CHECK(cache.cell_count < TEXT_GLYPH_DENSE_MAX);
+        
+        // The model: the template each variant was baked with and the variant each dense index went to
+        Text_Instance *expected = (Text_Instance*)calloc(variant_count, sizeof(Text_Instance));
+        int32_t *owners = (int32_t*)malloc(sizeof(int32_t)*TEXT_GLYPH_DENSE_MAX);
+        for (int32_t i = 0; i < TEXT_GLYPH_DENSE_MAX; i += 1){
+            owners[i] = -1;
+        }
+        uint8_t *drawn = (uint8_t*)calloc(variant_count, 1);
+        int32_t *frame_variants = (int32_t*)malloc(sizeof(int32_t)*test_lookups_per_frame);
+        int64_t distinct_drawn = 0;
+        int64_t kept_total = 0;
+        
+        for (int32_t frame = 0; frame < test_frame_count; frame += 1){
+            int64_t failures_before = test_state.failures;
+            glyph_cache_begin_frame(&cache);
+            // A window sliding over every variant, a few hot variants and a few anywhere, which are
+            // often ones that were evicted before.
+            int32_t window = (int32_t)(((int64_t)frame*variant_count)/test_frame_count);
+            int32_t frame_count = 0;
+            for (int32_t i = 0; i < test_lookups_per_frame; i += 1){
+                int32_t kind = test_random_range(&state, 0, 9);
+                int32_t variant = (window + test_random_range(&state, 0, 1499))%variant_count;
+                if (kind == 0){
+                    variant = test_random_range(&state, 0, 199);
+                }
+                else if (kind == 1){
+                    variant = test_random_range(&state, 0, variant_count - 1);
+                }
+                if (table.dense[variant] == TEXT_GLYPH_EMPTY){
+                    continue;
+                }
+                
+                Atlas_Slot slot = {0};
+                Glyph_Cache_Result result = glyph_cache_lookup(&cache, variant, &slot);
+                if (!TEST_CHECK(result != GlyphCache_Full)){
+                    continue;
+                }
+                if (result == GlyphCache_Miss){
+                    if (cache.last_evicted >= 0){
+                        text_glyph_table_release(&table, cache.last_evicted);
+                    }
+                    uint16_t before = table.dense[variant];
+                    Glyph_Metrics metrics = test_variant_metrics(variant, slot);
+                    TEST_CHECK(text_glyph_table_set(&table, variant, &metrics, TEST_ATLAS_SIDE, TEST_ATLAS_SIDE));
+                    if (text_glyph_is_empty(&metrics)){
+                        TEST_CHECK(table.dense[variant] == TEXT_GLYPH_EMPTY);
+                        glyph_cache_release(&cache, variant);
+                        continue;
+                    }
+                    uint16_t dense = table.dense[variant];
+                    if (!TEST_CHECK(dense < TEXT_GLYPH_DENSE_MAX)){
+                        continue;
+                    }
+                    if (before < TEXT_GLYPH_DENSE_MAX){
+                        TEST_CHECK(dense == before);
+                        kept_total += 1;
+                    }
+                    int32_t owner = owners[dense];
+                    if (owner >= 0 && owner != variant){
+                        // Only an index whose variant left the cache is handed on.
+                        TEST_CHECK(!glyph_cache_is_resident(&cache, owner));
+                        TEST_CHECK(table.dense[owner] == TEXT_GLYPH_UNKNOWN);
+                    }
+                    owners[dense] = variant;
+                    text_instance_template(&metrics, TEST_ATLAS_SIDE, TEST_ATLAS_SIDE, &expected[variant]);
+                    if (!drawn[variant]){
+                        drawn[variant] = 1;
+                        distinct_drawn += 1;
+                    }
+                }
+                frame_variants[frame_count] = variant;
+                frame_count += 1;
+            }
+            
+            // Every variant of the frame still owns its index and its template.
+            for (int32_t i = 0; i < frame_count; i += 1){
+                int32_t variant = frame_variants[i];
+                uint16_t dense = table.dense[variant];
+                if (TEST_CHECK(dense < TEXT_GLYPH_DENSE_MAX)){
+                    TEST_CHECK(table.drawable_variants[dense] == (uint32_t)variant);
+                    TEST_CHECK(table.drawable_live[dense]);
+                    TEST_CHECK(memcmp(&table.templates[dense], &expected[variant], sizeof(Text_Instance)) == 0);
+                }
+            }
+            TEST_CHECK(table.drawable_count <= TEXT_GLYPH_DENSE_MAX);
+            if (test_state.failures != failures_before){
+                printf("    frame %d: window at variant %d, %d drawable, %llu reassigned\n",
+                       frame, window, table.drawable_count, (unsigned long long)table.reassignments);
+            }
+        }
+        
+        TEST_CHECK(distinct_drawn > TEXT_GLYPH_DENSE_MAX);
+        TEST_CHECK(table.reassignments > 0);
+        printf("glyph_table_test: %lld distinct variants drawn through %d cells, %d dense indices, "
+               "%llu handed on, %lld kept by variants that came back\n",
+               (long long)distinct_drawn, cache.cell_count, table.drawable_count,
+               (unsigned long long)table.reassignments, (long long)kept_total);
+        
+        free(frame_variants);
+        free(drawn);
+        free(owners);
+        free(expected);
+        glyph_cache_free(&cache);
+        text_glyph_table_free(&table);
+        free(font_metrics);
+    }
+    
+    // The Largest Baked Font
+    {
+        int32_t glyph_count = 65535;
+        Glyph_Metrics *metrics = (Glyph_Metrics*)calloc(glyph_count, sizeof(Glyph_Metrics));
+        for (int32_t i = 0; i < glyph_count; i += 1){
+            metrics[i].advance = 5.f;
+            metrics[i].xy_w = 4.f;
+            metrics[i].xy_h = 6.f;
+        }
+        Text_Glyph_Table table = text_glyph_table_alloc(metrics, glyph_count, 1, 256, 256, true);
+        TEST_CHECK(table.drawable_count == TEXT_GLYPH_DENSE_MAX);
+        TEST_CHECK(table.dropped_count == 1);
+        TEST_CHECK(table.dense[glyph_count - 2] == TEXT_GLYPH_DENSE_MAX - 1);
+        TEST_CHECK(table.dense[glyph_count - 1] == TEXT_GLYPH_EMPTY);
+        text_glyph_table_free(&table);
+        
+        // With a space among them every glyph that draws has an index.
+        metrics[32].xy_w = 0.f;
+        metrics[32].xy_h = 0.f;
+        table = text_glyph_table_alloc(metrics, glyph_count, 1, 256, 256, true);
+        TEST_CHECK(table.drawable_count == TEXT_GLYPH_DENSE_MAX);
+        TEST_CHECK(table.dropped_count == 0);
+        TEST_CHECK(table.dense[32] == TEXT_GLYPH_EMPTY);
+        TEST_CHECK(table.dense[glyph_count - 1] == TEXT_GLYPH_DENSE_MAX - 1);
+        for (int32_t i = 0; i < glyph_count; i += 1){
+            uint16_t dense = table.dense[i];
+            if (dense != TEXT_GLYPH_EMPTY && !TEST_CHECK(table.drawable_variants[dense] == (uint32_t)i)){
+                break;
+            }
+        }
+        text_glyph_table_free(&table);
+        free(metrics);
+    }
+    
+    return(test_finish("glyph_table_test", seed));
+}
@@ -0,0 +1,696 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: the test scene without a window or a GPU
+// usage: headless <font.ttf> [-golden <dir>] [-update] [-out <dir>] [-frames <n>] [-scalar] [-layout_cache]
+//                 [-capture <file>] [-replay <file>] [-trace <file>] [-zoom]
+//
+// Every TB_ x TF_ combination of the rasterizer's test scene is drawn into an offscreen CPU
+// framebuffer: the software rasterizer bakes the font, the text batch lays out the strings into a
+// render command stream and the CPU executor runs the stream. Each combination reports its time per
+// frame and glyphs per second.
+//
+// -golden <dir>  compare every frame against <dir>/golden.txt, which lists a hash per combination
+//                for one font file and point size. When <dir> also holds <Back>_<Fore>.bmp, a
+//                mismatch reports how many pixels differ and by how much.
+// -update        write the golden hashes and images into the golden directory instead of comparing
+// -out <dir>     write every frame to <dir>/<Back>_<Fore>.bmp
+// -frames <n>    frames timed per combination, the first one is not counted
+// -scalar        composite without SIMD, by default glyphs 24 or more texels wide use AVX2
+// -layout_cache  keep laid out strings from frame to frame, see example_layout_cache.h
+// -capture <file> write the command stream of every combination to <file>
+// -replay <file>  run the frames of a capture instead of drawing the scene, without any layout. A
+//                 capture of all the combinations is checked against the goldens like a drawn one.
+//                 The atlas is the one this run bakes, so the font and size have to be the same.
+// -trace <file>   write the bake and every frame as Chrome trace events to <file> and print a summary
+//                 per phase, see example_trace.h. Only in a build with TRACE_ENABLED set, which
+//                 build_bench.sh makes as headless_trace.
+// -zoom           once the combinations are done, zoom the first one in and out and move it to a
+//                 144 dpi monitor and back, the way a window does through example_font_registry.h.
+//                 New sizes bake in the background while the frames keep the size they had.
+//
+// The exit code is 1 when any combination does not match its golden hash or any file the run was
+// asked to write could not be written. test_data/headless holds the hashes for DejaVuSans.ttf, from
+// the build directory:
+//   headless /usr/share/fonts/truetype/dejavu/DejaVuSans.ttf -golden ../test_data/headless
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_truetype.h"
+#include "example_font_cache_file.h"
+#include "example_text_batch.h"
+#include "example_render_commands.h"
+#include "example_cpu_compositor.h"
+#include "example_software_font.h"
+#include "example_font_registry.h"
+#include "example_test_scene.h"
+#include "example_bmp_file.h"
+#include "example_trace.h"
+
+static int32_t headless_width = 800;
+static int32_t headless_height = 600;
+static float headless_point_size = 12.f;
+static float headless_dpi = 96.f;
+
+// Sizes the registry keeps baked, enough for the zoom steps to find some of them resident
+static int32_t headless_font_sizes = 4;
+
+struct Headless_Zoom_Step{
+    float point_size;
+    float dpi;
+};
+
+// Each step is held for a few frames once its size is in.
+static Headless_Zoom_Step headless_zoom_steps[] = {
+    {12.f, 96.f}, {14.f, 96.f}, {16.f, 96.f}, {18.f, 96.f}, {16.f, 96.f}, {14.f, 96.f}, {12.f, 96.f},
+    {12.f, 144.f}, {16.f, 144.f}, {12.f, 144.f}, {12.f, 96.f}, {10.f, 96.f}, {12.f, 96.f},
+};
+static int32_t headless_zoom_hold_frames = 4;
+
+////////////////////////////////
+
+uint64_t
+headless_now_ns(void){
+    uint64_t result = 0;
+#if defined(_WIN32)
+    LARGE_INTEGER counter = {0};
+    LARGE_INTEGER frequency = {0};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (uint64_t)((double)counter.QuadPart*1000000000.0/(double)frequency.QuadPart);
+#else
+    struct timespec t = {0};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (uint64_t)t.tv_sec*1000000000ull + (uint64_t)t.tv_nsec;
+#endif
+    return(result);
+}
+
+uint8_t*
+headless_read_file(char *file_name, int32_t *size_out){
+    uint8_t *result = 0;
+    FILE *file = fopen(file_name, "rb");
+    if (file != 0){
+        fseek(file, 0, SEEK_END);
+        int32_t size = (int32_t)ftell(file);
+        fseek(file, 0, SEEK_SET);
+        result = (uint8_t*)malloc(size + 1);
+        fread(result, 1, size, file);
+        result[size] = 0;
+        fclose(file);
+        *size_out = size;
+    }
+    return(result);
+}
+
+// FNV-1a over the color bytes, the X byte of the pixels is not part of the image.
+uint64_t
+headless_image_hash(Cpu_Framebuffer *framebuffer){
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int32_t y = 0; y < framebuffer->h; y += 1){
+        uint32_t *row = framebuffer->pixels + (size_t)y*framebuffer->pitch;
+        for (int32_t x = 0; x < framebuffer->w; x += 1){
+            h ^= (row[x] & 0xFFFFFF);
+            h *= 0x100000001b3ull;
+        }
+    }
+    return(h);
+}
+
+////////////////////////////////
+
+// Test Scene Target
+
+struct Headless_Target{
+    Software_Font *font;
+    Text_Batch *batch;
+    Arena *arena;
+    Render_Stream *stream;
+    Cpu_Render_Target cpu;
+    // Time spent clearing, so it can be told apart from the compositing around it
+    uint64_t clear_ns;
+    int32_t glyph_count;
+};
+
+// Strings drawn before the clear go out first, so they land under it like they would on the GPU.
+void
+headless_scene_clear(void *user, float r, float g, float b){
+    Headless_Target *target = (Headless_Target*)user;
+    render_text_batch(target->stream, target->batch);
+    render_clear(target->stream, r, g, b);
+}
+
+void
+headless_scene_draw_string(void *user, char *text, int32_t x, int32_t y, float r, float g, float b, float a){
+    Headless_Target *target = (Headless_Target*)user;
+    software_font_draw_string(target->font, target->batch, target->arena, text, x, y, r, g, b, a);
+}
+
+////////////////////////////////
+
+// Render Command Executor
+// The CPU executor, with the clears timed and the glyphs counted.
+
+void
+headless_render_clear(void *user, Render_Clear *clear){
+    TRACE_SCOPE("clear");
+    Headless_Target *target = (Headless_Target*)user;
+    uint64_t start = headless_now_ns();
+    cpu_render_clear(&target->cpu, clear);
+    target->clear_ns += headless_now_ns() - start;
+}
+
+void
+headless_render_glyphs(void *user, Render_Glyphs *glyphs, Text_Style *styles, Text_Instance *instances){
+    TRACE_SCOPE("composite");
+    Headless_Target *target = (Headless_Target*)user;
+    cpu_render_glyphs(&target->cpu, glyphs, styles, instances);
+    target->glyph_count += glyphs->instance_count;
+}
+
+void
+headless_render_blit(void *user, Render_Blit *blit){
+    Headless_Target *target = (Headless_Target*)user;
+    cpu_render_blit(&target->cpu, blit);
+}
+
+////////////////////////////////
+
+// Golden Hashes
+
+struct Headless_Golden{
+    bool32 loaded;
+    uint64_t font_hash;
+    float point_size;
+    bool32 has_hash[TB_COUNT][TF_COUNT];
+    uint64_t hash[TB_COUNT][TF_COUNT];
+};
+
+int32_t
+headless_find_name(char **names, int32_t count, char *name){
+    int32_t result = -1;
+    for (int32_t i = 0; i < count; i += 1){
+        if (strcmp(names[i], name) == 0){
+            result = i;
+            break;
+        }
+    }
+    return(result);
+}
+
+// golden.txt is a "font <hash> <point size>" line, then one "<Back> <Fore> <hash>" line per combination.
+Headless_Golden
+headless_golden_load(char *file_name){
+    Headless_Golden golden = {0};
+    FILE *file = fopen(file_name, "rb");
+    if (file != 0){
+        unsigned long long font_hash = 0;
+        if (fscanf(file, " font %llx %f", &font_hash, &golden.point_size) == 2){
+            golden.loaded = true;
+            golden.font_hash = font_hash;
+            char back[32];
+            char fore[32];
+            unsigned long long hash = 0;
+            for (;fscanf(file, " %31s %31s %llx", back, fore, &hash) == 3;){
+                int32_t bmode = headless_find_name(test_scene_back_names, TB_COUNT, back);
+                int32_t fmode = headless_find_name(test_scene_fore_names, TF_COUNT, fore);
+                if (bmode >= 0 && fmode >= 0){
+                    golden.has_hash[bmode][fmode] = true;
+                    golden.hash[bmode][fmode] = hash;
+                }
+            }
+        }
+        fclose(file);
+    }
+    return(golden);
+}
+
+bool32
+headless_golden_save(char *file_name, Headless_Golden *golden){
+    FILE *file = fopen(file_name, "wb");
+    if (file == 0){
+        return(false);
+    }
+    fprintf(file, "font %016llx %g\n", (unsigned long long)golden->font_hash, golden->point_size);
+    for (int32_t bmode = 0; bmode < TB_COUNT; bmode += 1){
+        for (int32_t fmode = 0; fmode < TF_COUNT; fmode += 1){
+            fprintf(file, "%s %s %016llx\n", test_scene_back_names[bmode], test_scene_fore_names[fmode],
+                    (unsigned long long)golden->hash[bmode][fmode]);
+        }
+    }
+    fclose(file);
+    return(true);
+}
+
+// Pixel differences against a golden image, when there is one to compare with.
+void
+headless_report_diff(Cpu_Framebuffer *framebuffer, char *golden_image_name){
+    int32_t w = 0;
+    int32_t h = 0;
+    uint32_t *golden = bmp_read_rgbx(golden_image_name, &w, &h);
+    if (golden == 0){
+        return;
+    }
+    if (w != framebuffer->w || h != framebuffer->h){
+        printf("    golden image is %dx%d, the frame is %dx%d\n", w, h, framebuffer->w, framebuffer->h);
+    }
+    else{
+        int32_t diff_count = 0;
+        int32_t max_delta = 0;
+        int32_t first_x = -1;
+        int32_t first_y = -1;
+        for (int32_t y = 0; y < h; y += 1){
+            uint32_t *row = framebuffer->pixels + (size_t)y*framebuffer->pitch;
+            for (int32_t x = 0; x < w; x += 1){
+                uint32_t a = row[x];
+                uint32_t b = golden[y*w + x];
+                if (((a ^ b) & 0xFFFFFF) == 0){
+                    continue;
+                }
+                if (diff_count == 0){
+                    first_x = x;
+                    first_y = y;
+                }
+                diff_count += 1;
+                for (int32_t c = 0; c < 3; c += 1){
+                    int32_t delta = (int32_t)((a >> (8*c)) & 0xFF) - (int32_t)((b >> (8*c)) & 0xFF);
+                    delta = (delta < 0)?-delta:delta;
+                    max_delta = (max_delta < delta)?delta:max_delta;
+                }
+            }
+        }
+        printf("    %d pixels differ from %s, max channel delta %d, first at (%d,%d)\n",
+               diff_count, golden_image_name, max_delta, first_x, first_y);
+    }
+    heap_free(golden);
+}
+
+////////////////////////////////
+
+int
+main(int argc, char **argv){
+    char *font_name = 0;
+    char *golden_dir = 0;
+    char *out_dir = 0;
+    bool32 update = false;
+    bool32 use_simd = true;
+    bool32 use_layout_cache = false;
+    int32_t frame_count = 20;
+    char *capture_name = 0;
+    char *replay_name = 0;
+    char *trace_name = 0;
+    bool32 zoom = false;
+    for (int32_t i = 1; i < argc; i += 1){
+        if (strcmp(argv[i], "-golden") == 0 && i + 1 < argc){
+            golden_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-out") == 0 && i + 1 < argc){
+            out_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc){
+            frame_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-update") == 0){
+            update = true;
+        }
+        else if (strcmp(argv[i], "-scalar") == 0){
+            use_simd = false;
+        }
+        else if (strcmp(argv[i], "-layout_cache") == 0){
+            use_layout_cache = true;
+        }
+        else if (strcmp(argv[i], "-capture") == 0 && i + 1 < argc){
+            capture_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc){
+            replay_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc){
+            trace_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-zoom") == 0){
+            zoom = true;
+        }
+        else{
+            font_name = argv[i];
+        }
+    }
+    if (font_name == 0 || frame_count < 2 || (update && golden_dir == 0) ||
+        (replay_name != 0 && (update || capture_name != 0 || zoom))){
+        printf("usage: headless <font.ttf> [-golden <dir>] [-update] [-out <dir>] [-frames <n>] [-scalar] [-layout_cache]\n"
+               "                [-capture <file>] [-replay <file>] [-trace <file>] [-zoom]\n");
+        return(1);
+    }
+#if !CPU_COMPOSITOR_AVX2
+    use_simd = false;
+#endif
+#if !TRACE_ENABLED
+    if (trace_name != 0){
+        printf("-trace: built without TRACE_ENABLED, use headless_trace\n");
+        trace_name = 0;
+    }
+#endif
+    TRACE_THREAD_NAME("main");
+    
+    int32_t font_size = 0;
+    uint8_t *font_data = headless_read_file(font_name, &font_size);
+    TTF_Font ttf = {0};
+    if (font_data == 0 || !ttf_init(&ttf, font_data, font_size)){
+        printf("%s: not a TrueType font\n", font_name);
+        return(1);
+    }
+    
+    // Bake
+    // Every size comes from the registry, the first one is waited for.
+    uint64_t bake_start = headless_now_ns();
+    Font_Registry registry = font_registry_init(&ttf, headless_font_sizes, bake_core_count(), 0);
+    Software_Font *font = font_registry_get_wait(&registry, headless_point_size, headless_dpi);
+    uint64_t bake_end = headless_now_ns();
+    printf("%s %.0fpt: %d glyphs baked into %d slice(s) of %dx%d in %.1f ms, %s compositing\n",
+           font_name, headless_point_size, font->glyph_count, font->slice_count, font->atlas_side, font->atlas_side,
+           (double)(bake_end - bake_start)/1000000.0, use_simd?"simd":"scalar");
+    Layout_Cache layout_cache = {0};
+    if (use_layout_cache){
+        layout_cache = layout_cache_init(256, 256, 256);
+        font->layout_cache = &layout_cache;
+        font->layout_id = (uint32_t)font_registry_slot(&registry, font);
+    }
+    
+    // Goldens
+    char golden_file_name[1024] = {0};
+    Headless_Golden golden = {0};
+    uint64_t font_hash = font_cache_hash(font_data, (uint64_t)font_size);
+    if (golden_dir != 0){
+        snprintf(golden_file_name, sizeof(golden_file_name), "%s/golden.txt", golden_dir);
+        if (!update){
+            golden = headless_golden_load(golden_file_name);
+            if (!golden.loaded){
+                printf("%s: no golden hashes, run with -update to make them\n", golden_file_name);
+            }
+            else if (golden.font_hash != font_hash || golden.point_size != headless_point_size){
+                printf("%s: golden hashes are for font %016llx at %gpt, this is %016llx at %gpt\n",
+                       golden_file_name, (unsigned long long)golden.font_hash, golden.point_size,
+                       (unsigned long long)font_hash, headless_point_size);
+            }
+        }
+    }
+    Headless_Golden updated = {0};
+    updated.loaded = true;
+    updated.font_hash = font_hash;
+    updated.point_size = headless_point_size;
+    
+    // Offscreen Target
+    Cpu_Compositor compositor = cpu_compositor_init();
+    Cpu_Atlas atlas = {font->atlas, font->atlas_side, font->atlas_side, font->slice_count};
+    Cpu_Framebuffer framebuffer = {0};
+    framebuffer.w = headless_width;
+    framebuffer.h = headless_height;
+    framebuffer.pitch = headless_width;
+    framebuffer.pixels = (uint32_t*)heap_alloc(sizeof(uint32_t)*headless_width*headless_height);
+    Text_Batch batch = {0};
+    Arena arena = arena_alloc(1 << 20);
+    Render_Stream stream = {0};
+    
+    Headless_Target headless_target = {0};
+    headless_target.font = font;
+    headless_target.batch = &batch;
+    headless_target.arena = &arena;
+    headless_target.stream = &stream;
+    headless_target.cpu.compositor = &compositor;
+    headless_target.cpu.framebuffer = &framebuffer;
+    headless_target.cpu.atlas = &atlas;
+    headless_target.cpu.use_simd = use_simd;
+    Test_Scene_Target scene_target = {0};
+    scene_target.user = &headless_target;
+    scene_target.clear = headless_scene_clear;
+    scene_target.draw_string = headless_scene_draw_string;
+    Render_Executor executor = {0};
+    executor.user = &headless_target;
+    executor.clear = headless_render_clear;
+    executor.glyphs = headless_render_glyphs;
+    executor.blit = headless_render_blit;
+    
+    // Capture Files
+    FILE *capture_file = 0;
+    if (capture_name != 0){
+        capture_file = fopen(capture_name, "wb");
+        if (capture_file == 0 || !render_capture_begin(capture_file)){
+            printf("%s: cannot write a capture\n", capture_name);
+            return(1);
+        }
+    }
+    FILE *replay_file = 0;
+    Render_Atlas_Bounds atlas_bounds = {atlas.w, atlas.h, atlas.slice_count};
+    if (replay_name != 0){
+        replay_file = fopen(replay_name, "rb");
+        if (replay_file == 0 || !render_capture_check(replay_file)){
+            printf("%s: not a render capture\n", replay_name);
+            return(1);
+        }
+    }
+    
+    // Draw Every Combination
+    // A replay takes the frames of the capture in order, one per combination.
+    int32_t mismatch_count = 0;
+    int32_t combination_count = 0;
+    uint64_t total_ns = 0;
+    uint64_t total_glyphs = 0;
+    bool32 replay_ended = false;
+    for (int32_t bmode = 0; bmode < TB_COUNT && !replay_ended; bmode += 1){
+        for (int32_t fmode = 0; fmode < TF_COUNT; fmode += 1){
+            if (replay_file != 0 && !render_capture_read_frame(replay_file, &stream, &atlas_bounds)){
+                // A frame that was read and turned away is a damaged capture, not its end.
+                if (!feof(replay_file)){
+                    printf("%s: frame %d is damaged or reads outside the atlas\n", replay_name, combination_count);
+                    mismatch_count += 1;
+                }
+                printf("%s: %d frames\n", replay_name, combination_count);
+                replay_ended = true;
+                break;
+            }
+            
+            // The first frame builds the blend tables and sizes the batch, the rest are timed.
+            uint64_t clear_ns = 0;
+            uint64_t layout_ns = 0;
+            uint64_t composite_ns = 0;
+            for (int32_t frame = 0; frame < frame_count; frame += 1){
+                TRACE_SCOPE("frame");
+                uint64_t start = headless_now_ns();
+                if (replay_file == 0){
+                    TRACE_SCOPE("test scene");
+                    arena_reset(&arena);
+                    render_stream_begin_frame(&stream);
+                    test_scene_draw(&scene_target, bmode, fmode, false);
+                    render_text_batch(&stream, &batch);
+                }
+                uint64_t mid = headless_now_ns();
+                headless_target.clear_ns = 0;
+                headless_target.glyph_count = 0;
+                {
+                    TRACE_SCOPE("execute");
+                    render_stream_execute(&stream, &executor);
+                }
+                uint64_t end = headless_now_ns();
+                if (frame > 0){
+                    clear_ns += headless_target.clear_ns;
+                    layout_ns += mid - start;
+                    composite_ns += end - mid - headless_target.clear_ns;
+                }
+            }
+            if (capture_file != 0 && !render_capture_write_frame(capture_file, &stream)){
+                printf("%s: could not write a frame\n", capture_name);
+                mismatch_count += 1;
+            }
+            combination_count += 1;
+            int32_t glyph_count = headless_target.glyph_count;
+            int32_t timed_frames = frame_count - 1;
+            uint64_t frame_ns = clear_ns + layout_ns + composite_ns;
+            double ns_per_frame = (double)frame_ns/timed_frames;
+            total_ns += frame_ns;
+            total_glyphs += (uint64_t)glyph_count*timed_frames;
+            
+            char *back = test_scene_back_names[bmode];
+            char *fore = test_scene_fore_names[fmode];
+            uint64_t hash = headless_image_hash(&framebuffer);
+            updated.hash[bmode][fmode] = hash;
+            
+            char *status = "";
+            bool32 mismatch = false;
+            if (update){
+                status = ", golden updated";
+                char image_name[1024];
+                snprintf(image_name, sizeof(image_name), "%s/%s_%s.bmp", golden_dir, back, fore);
+                if (!bmp_write_rgbx(image_name, framebuffer.pixels, framebuffer.w, framebuffer.h, framebuffer.pitch)){
+                    status = ", COULD NOT WRITE THE GOLDEN IMAGE";
+                    mismatch_count += 1;
+                }
+            }
+            else if (golden_dir != 0){
+                if (golden.loaded && golden.has_hash[bmode][fmode] && golden.hash[bmode][fmode] == hash){
+                    status = ", golden ok";
+                }
+                else{
+                    status = ", GOLDEN MISMATCH";
+                    mismatch = true;
+                    mismatch_count += 1;
+                }
+            }
+            
+            printf("%-6s x %-9s: %4d glyphs, clear %.3f ms, layout %.3f ms, composite %.3f ms, %.3f ms/frame, %.2f Mglyphs/sec, hash %016llx%s\n",
+                   back, fore, glyph_count, (double)clear_ns/(1000000.0*timed_frames),
+                   (double)layout_ns/(1000000.0*timed_frames), (double)composite_ns/(1000000.0*timed_frames),
+                   ns_per_frame/1000000.0, (double)glyph_count*1000.0/ns_per_frame,
+                   (unsigned long long)hash, status);
+            
+            if (mismatch){
+                char image_name[1024];
+                snprintf(image_name, sizeof(image_name), "%s/%s_%s.bmp", golden_dir, back, fore);
+                headless_report_diff(&framebuffer, image_name);
+            }
+            if (out_dir != 0){
+                char image_name[1024];
+                snprintf(image_name, sizeof(image_name), "%s/%s_%s.bmp", out_dir, back, fore);
+                if (!bmp_write_rgbx(image_name, framebuffer.pixels, framebuffer.w, framebuffer.h, framebuffer.pitch)){
+                    printf("    could not write %s\n", image_name);
+                    mismatch_count += 1;
+                }
+            }
+        }
+    }
+    
+    if (combination_count == 0){
+        return(1);
+    }
+    printf("all %d combinations: %.3f ms/frame, %.2f Mglyphs/sec",
+           combination_count, (double)total_ns/(1000000.0*combination_count*(frame_count - 1)),
+           (double)total_glyphs*1000.0/(double)total_ns);
+    if (update){
+        if (headless_golden_save(golden_file_name, &updated)){
+            printf(", golden hashes written to %s\n", golden_file_name);
+        }
+        else{
+            printf(", could not write %s\n", golden_file_name);
+            mismatch_count += 1;
+        }
+    }
+    else if (golden_dir != 0){
+        printf(", %d golden mismatches\n", mismatch_count);
+    }
+    else{
+        printf("\n");
+    }
+    
+    // Zoom
+    // Each step asks the registry for its size every frame and draws with whatever it has, the
+    // frames before a new size is in keep the size of the step before.
+    if (zoom){
+        int32_t step_count = (int32_t)(sizeof(headless_zoom_steps)/sizeof(headless_zoom_steps[0]));
+        uint64_t bakes_before = registry.bakes;
+        uint64_t evictions_before = registry.evictions;
+        int32_t stale_frames = 0;
+        int32_t zoom_frames = 0;
+        uint64_t zoom_ns = 0;
+        uint64_t longest_ns = 0;
+        for (int32_t step = 0; step < step_count; step += 1){
+            Headless_Zoom_Step *zoom_step = &headless_zoom_steps[step];
+            float pixel_per_em = font_registry_pixel_per_em(zoom_step->point_size, zoom_step->dpi);
+            int32_t held_frames = 0;
+            for (;held_frames < headless_zoom_hold_frames;){
+                TRACE_SCOPE("zoom frame");
+                uint64_t start = headless_now_ns();
+                font = font_registry_get_or_keep(&registry, zoom_step->point_size, zoom_step->dpi, font);
+                font->layout_cache = use_layout_cache?&layout_cache:0;
+                font->layout_id = (uint32_t)font_registry_slot(&registry, font);
+                headless_target.font = font;
+                atlas.texels = font->atlas;
+                atlas.w = font->atlas_side;
+                atlas.h = font->atlas_side;
+                atlas.slice_count = font->slice_count;
+                
+                arena_reset(&arena);
+                render_stream_begin_frame(&stream);
+                test_scene_draw(&scene_target, 0, 0, false);
+                render_text_batch(&stream, &batch);
+                render_stream_execute(&stream, &executor);
+                uint64_t frame_ns = headless_now_ns() - start;
+                zoom_ns += frame_ns;
+                longest_ns = (frame_ns > longest_ns)?frame_ns:longest_ns;
+                zoom_frames += 1;
+                if (font->pixel_per_em == pixel_per_em){
+                    held_frames += 1;
+                }
+                else{
+                    stale_frames += 1;
+                }
+            }
+        }
+        printf("zoom: %d steps in %d frames, %llu sizes baked in the background over %d frames drawn at the size before, %llu evictions, %.3f ms/frame, longest %.3f ms\n",
+               step_count, zoom_frames, (unsigned long long)(registry.bakes - bakes_before), stale_frames,
+               (unsigned long long)(registry.evictions - evictions_before), (double)zoom_ns/(1000000.0*zoom_frames),
+               (double)longest_ns/1000000.0);
+        int32_t resident_count = 0;
+        for (int32_t i = 0; i < registry.size_max; i += 1){
+            resident_count += (registry.sizes[i].state == FontSize_Ready);
+        }
+        uint64_t shared_bytes = 0;
+        uint64_t size_bytes = font_registry_memory(&registry, &shared_bytes);
+        printf("zoom: %llu KB in %d resident sizes, %llu KB shared by all of them\n",
+               (unsigned long long)(size_bytes/1024), resident_count, (unsigned long long)(shared_bytes/1024));
+    }
+    
+    if (use_layout_cache){
+        printf("layout cache: %llu hits (%llu moved), %llu misses, %llu evictions, %llu KB\n",
+               (unsigned long long)layout_cache.hits, (unsigned long long)layout_cache.moves,
+               (unsigned long long)layout_cache.misses, (unsigned long long)layout_cache.evictions,
+               (unsigned long long)(layout_cache_memory(&layout_cache)/1024));
+        layout_cache_free(&layout_cache);
+    }
+#if TRACE_ENABLED
+    if (trace_name != 0){
+        printf("\n");
+        trace_write_summary(stdout);
+        if (!trace_write_json(trace_name)){
+            printf("%s: cannot write the trace\n", trace_name);
+            mismatch_count += 1;
+        }
+    }
+#endif
+    
+    if (capture_file != 0){
+        fclose(capture_file);
+    }
+    if (replay_file != 0){
+        fclose(replay_file);
+    }
+    render_stream_free(&stream);
+    arena_free(&arena);
+    text_batch_free(&batch);
+    heap_free(framebuffer.pixels);
+    cpu_compositor_free(&compositor);
+    font_registry_free(&registry);
+    free(font_data);
+    
+    return((mismatch_count == 0)?0:1);
+}
@@ -0,0 +1,694 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: a fixed suite of benchmarks for the per glyph path of draw_string
+// usage: hot_path_bench <font.ttf> [-runs <n>] [-csv <file>] [-baseline <file>] [-threshold <percent>]
+//                       [-data <dir>]
+//
+// text_bench measures each piece of the pipeline against its own alternatives and changes whenever a
+// piece does. This one runs the same fixtures over the same inputs every time, so its numbers can be
+// compared from one build to the next. Every fixture goes over every line of an input once per run:
+//
+// lookup          UTF-8 decode and codepoint map lookup
+// vertex          layout through the glyph table and the instances of the run
+// m_tables        a string's style and its blend table, eight colors that stay in the cache
+// m_tables_build  the same with a new color on every line, so every string builds its blend table
+// blit_swizzle    every glyph of the line copied out of the baked atlas, packed to 16 bit levels and
+//                 written to the dirty atlas, as if each one missed the glyph cache; the dirty
+//                 rectangles are copied out once a screenful of lines
+// submit          software_font_draw_string, recorded into a render command stream and executed by the
+//                 CPU compositor, a stream per screenful of lines
+//
+// The inputs are printable ASCII, test_data/source_file.txt as source code, and the 672 line
+// test_data/text_file.txt of win32-file-handles. The source code is a frozen copy of
+// example_rasterizer.cpp, so edits to the example do not move the numbers. Paths are relative to
+// win32-direct-write, found from the executable's build directory, see example_data_path.h.
+//
+// A glyph is a codepoint of the input, whether it draws or not, so every fixture of an input divides
+// by the same count. ns/glyph is the median of the timed runs after one run to warm up. allocs/glyph
+// counts heap_alloc and heap_realloc over all timed runs, which needs HEAP_ALLOC_CHECKS (on outside
+// NDEBUG builds). bytes/glyph is what the fixture writes: codepoints and indices, instances, styles
+// and blend tables, atlas texels, command stream bytes.
+//
+// -runs <n>            timed runs per fixture and input
+// -csv <file>          also write fixture,input,glyphs,ns_per_glyph,allocs_per_glyph,bytes_per_glyph
+// -baseline <file>     compare with a csv of an earlier run. The exit code is 1 when a fixture got
+//                      slower by more than the threshold or allocates where it did not.
+// -threshold <percent> slowdown a baseline comparison lets through, 10 by default
+// -data <dir>          where win32-direct-write is, when the executable is not in its build directory
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_truetype.h"
+#include "example_codepoint_map.h"
+#include "example_data_path.h"
+#include "example_utf8.h"
+#include "example_m_values.h"
+#include "example_text_batch.h"
+#include "example_render_commands.h"
+#include "example_cpu_compositor.h"
+#include "example_software_font.h"
+#include "example_atlas_levels.h"
+#include "example_atlas_dirty.h"
+
+static float hot_point_size = 12.f;
+static int32_t hot_width = 800;
+static int32_t hot_height = 600;
+// Lines of a screenful for the submit fixture
+static int32_t hot_screen_lines = 36;
+static int32_t hot_ascii_lines = 672;
+static int32_t hot_ascii_columns = 80;
+
+////////////////////////////////
+
+uint64_t
+hot_now_ns(void){
+    uint64_t result = 0;
+#if defined(_WIN32)
+    LARGE_INTEGER counter = {0};
+    LARGE_INTEGER frequency = {0};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (uint64_t)((double)counter.QuadPart*1000000000.0/(double)frequency.QuadPart);
+#else
+    struct timespec t = {0};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (uint64_t)t.tv_sec*1000000000ull + (uint64_t)t.tv_nsec;
+#endif
+    return(result);
+}
+
+uint8_t*
+hot_read_file(char *file_name, int32_t *size_out){
+    uint8_t *result = 0;
+    FILE *file = fopen(file_name, "rb");
+    if (file != 0){
+        fseek(file, 0, SEEK_END);
+        int32_t size = (int32_t)ftell(file);
+        fseek(file, 0, SEEK_SET);
+        result = (uint8_t*)malloc(size + 1);
+        fread(result, 1, size, file);
+        result[size] = 0;
+        fclose(file);
+        *size_out = size;
+    }
+    return(result);
+}
+
+////////////////////////////////
+
+// Inputs
+
+// Lines of an input, split in place, with the glyph index of every codepoint worked out up front
+// for the fixtures that start from glyphs.
+struct Hot_Input{
+    char *name;
+    char *text;
+    char **lines;
+    int32_t line_count;
+    uint16_t *glyphs;
+    // line_count + 1 entries, the glyphs of line i are line_first[i] up to line_first[i + 1]
+    int32_t *line_first;
+    int32_t glyph_count;
+    // Longest line in bytes
+    int32_t line_max;
+};
+
+bool32
+hot_input_init(Hot_Input *input, char *name, char *text, int32_t size, Codepoint_Map *map){
+    memset(input, 0, sizeof(*input));
+    if (text == 0){
+        return(false);
+    }
+    input->name = name;
+    input->text = text;
+    input->lines = (char**)malloc(sizeof(char*)*(size + 1));
+    char *line = text;
+    for (int32_t i = 0; i <= size; i += 1){
+        if (i == size || text[i] == '\n'){
+            text[i] = 0;
+            if (i > 0 && text[i - 1] == '\r'){
+                text[i - 1] = 0;
+            }
+            // No line for the end of a file that ends with a newline
+            if (i < size || line < text + size){
+                input->lines[input->line_count] = line;
+                input->line_count += 1;
+            }
+            line = text + i + 1;
+        }
+    }
+    
+    uint32_t *codepoints = (uint32_t*)malloc(sizeof(uint32_t)*(size + 1));
+    input->glyphs = (uint16_t*)malloc(sizeof(uint16_t)*(size + 1));
+    input->line_first = (int32_t*)malloc(sizeof(int32_t)*(input->line_count + 1));
+    for (int32_t i = 0; i < input->line_count; i += 1){
+        int32_t length = (int32_t)strlen(input->lines[i]);
+        input->line_max = (length > input->line_max)?length:input->line_max;
+        input->line_first[i] = input->glyph_count;
+        int32_t count = utf8_decode((uint8_t*)input->lines[i], length, codepoints);
+        for (int32_t j = 0; j < count; j += 1){
+            input->glyphs[input->glyph_count] = codepoint_map_lookup(map, codepoints[j]);
+            input->glyph_count += 1;
+        }
+    }
+    input->line_first[input->line_count] = input->glyph_count;
+    free(codepoints);
+    return(input->glyph_count > 0);
+}
+
+// Every printable ASCII character in turn, each line starting one further along.
+char*
+hot_ascii_text(int32_t *size_out){
+    int32_t size = hot_ascii_lines*(hot_ascii_columns + 1);
+    char *text = (char*)malloc(size + 1);
+    char *at = text;
+    for (int32_t line = 0; line < hot_ascii_lines; line += 1){
+        for (int32_t column = 0; column < hot_ascii_columns; column += 1){
+            *at = (char)(0x20 + (line + column)%(0x7F - 0x20));
+            at += 1;
+        }
+        *at = '\n';
+        at += 1;
+    }
+    *at = 0;
+    *size_out = size;
+    return(text);
+}
+
+void
+hot_input_free(Hot_Input *input){
+    free(input->line_first);
+    free(input->glyphs);
+    free(input->lines);
+    free(input->text);
+    memset(input, 0, sizeof(*input));
+}
+
+////////////////////////////////
+
+// Fixtures
+
+// Everything the fixtures draw with, set up once and kept across runs like a window keeps it across
+// frames.
+struct Hot_Context{
+    Software_Font font;
+    Cpu_Compositor compositor;
+    Cpu_Atlas atlas;
+    Cpu_Framebuffer framebuffer;
+    Cpu_Render_Target target;
+    Render_Executor executor;
+    Text_Batch batch;
+    Render_Stream stream;
+    Atlas_Dirty dirty;
+    Arena arena;
+    
+    // Scratch for one line
+    uint32_t *codepoints;
+    uint16_t *dense;
+    int32_t *pen_x;
+    uint16_t *packed;
+    // Colors handed out by m_tables_build, kept going from run to run so no run finds its tables
+    uint32_t color_counter;
+    // Where the flushes of blit_swizzle copy what they upload, a slice worth of texels
+    uint16_t *staging;
+};
+
+// Returns the bytes the run wrote.
+typedef uint64_t Hot_Fixture_Function(Hot_Context *context, Hot_Input *input);
+
+struct Hot_Fixture{
+    char *name;
+    Hot_Fixture_Function *run;
+};
+
+uint64_t
+hot_lookup(Hot_Context *context, Hot_Input *input){
+    Software_Font *font = &context->font;
+    uint64_t bytes = 0;
+    for (int32_t line = 0; line < input->line_count; line += 1){
+        char *text = input->lines[line];
+        int32_t length = (int32_t)strlen(text);
+        int32_t count = utf8_decode((uint8_t*)text, length, context->codepoints);
+        for (int32_t i = 0; i < count; i += 1){
+            context->dense[i] = codepoint_map_lookup(font->map, context->codepoints[i]);
+        }
+        assert(memcmp(context->dense, input->glyphs + input->line_first[line], sizeof(uint16_t)*count) == 0);
+        bytes += (uint64_t)count*(sizeof(uint32_t) + sizeof(uint16_t));
+    }
+    return(bytes);
+}
+
+uint64_t
+hot_vertex(Hot_Context *context, Hot_Input *input){
+    Software_Font *font = &context->font;
+    Text_Batch *batch = &context->batch;
+    text_batch_begin_frame(batch);
+    for (int32_t line = 0; line < input->line_count; line += 1){
+        int32_t first = input->line_first[line];
+        int32_t count = input->line_first[line + 1] - first;
+        int32_t pen_y = 16 + 16*(line%hot_screen_lines);
+        int32_t visible_count = text_glyph_table_layout(&font->glyphs, input->glyphs + first, count, 10,
+                                                        context->dense, context->pen_x);
+        text_batch_begin_string_rgba8(batch, 1, font->atlas_side, font->atlas_side, 255, 255, 255, 255);
+        text_batch_push_run(batch, font->glyphs.templates, context->dense, context->pen_x, pen_y, visible_count);
+    }
+    return(sizeof(Text_Instance)*(uint64_t)batch->instance_count);
+}
+
+Text_Style
+hot_style(uint32_t color){
+    uint8_t r = (uint8_t)(color >> 16);
+    uint8_t g = (uint8_t)(color >> 8);
+    uint8_t b = (uint8_t)color;
+    Text_Style style = {0};
+    float M_value_table[7];
+    m_values_rgba8(r, g, b, 255, M_value_table);
+    style.color[0] = m_value_alphas.a[r];
+    style.color[1] = m_value_alphas.a[g];
+    style.color[2] = m_value_alphas.a[b];
+    memcpy(style.M, M_value_table + 1, sizeof(style.M));
+    return(style);
+}
+
+uint64_t
+hot_m_tables__run(Hot_Context *context, Hot_Input *input, bool32 new_colors){
+    // What an editor's syntax highlighting might use
+    static uint32_t palette[8] = {
+        0xD4D4D4, 0x569CD6, 0xCE9178, 0x6A9955, 0xB5CEA8, 0xC586C0, 0x4EC9B0, 0xDCDCAA,
+    };
+    Cpu_Compositor *compositor = &context->compositor;
+    uint64_t builds = compositor->table_builds;
+    uint64_t bytes = 0;
+    for (int32_t line = 0; line < input->line_count; line += 1){
+        uint32_t color = palette[line%8];
+        if (new_colors){
+            context->color_counter += 1;
+            color = (context->color_counter*0x9E3779B1u) >> 8;
+        }
+        Text_Style style = hot_style(color);
+        compositor->clock += 1;
+        Cpu_Blend_Table *table = cpu_compositor_table(compositor, &style);
+        assert(memcmp(table->M, style.M, sizeof(style.M)) == 0);
+        bytes += sizeof(Text_Style);
+    }
+    bytes += (compositor->table_builds - builds)*sizeof(((Cpu_Blend_Table*)0)->out);
+    return(bytes);
+}
+
+uint64_t
+hot_m_tables(Hot_Context *context, Hot_Input *input){
+    return(hot_m_tables__run(context, input, false));
+}
+
+uint64_t
+hot_m_tables_build(Hot_Context *context, Hot_Input *input){
+    return(hot_m_tables__run(context, input, true));
+}
+
+// Copies the rectangle out the way the GL example writes it into its unpack ring, rows packed.
+void
+hot_upload(void *backend, int32_t slice, Atlas_Dirty_Rect rect, uint16_t *texels, int32_t pitch){
+    Hot_Context *context = (Hot_Context*)backend;
+    assert(0 <= slice && slice < context->font.slice_count);
+    int32_t w = rect.x1 - rect.x0;
+    uint16_t *out = context->staging;
+    for (int32_t y = rect.y0; y < rect.y1; y += 1, texels += pitch, out += w){
+        memcpy(out, texels, sizeof(uint16_t)*w);
+    }
+}
+
+uint64_t
+hot_blit_swizzle(Hot_Context *context, Hot_Input *input){
+    Software_Font *font = &context->font;
+    int32_t side = font->atlas_side;
+    uint64_t bytes = 0;
+    for (int32_t line = 0; line < input->line_count; line += 1){
+        int32_t first = input->line_first[line];
+        int32_t count = input->line_first[line + 1] - first;
+        int32_t visible_count = text_glyph_table_layout(&font->glyphs, input->glyphs + first, count, 10,
+                                                        context->dense, context->pen_x);
+        for (int32_t i = 0; i < visible_count; i += 1){
+            Text_Instance *glyph = &font->glyphs.templates[context->dense[i]];
+            int32_t w = glyph->w;
+            int32_t h = glyph->h;
+            uint8_t *rgb = font->atlas + (((size_t)glyph->slice*side + glyph->atlas_y)*side + glyph->atlas_x)*3;
+            for (int32_t y = 0; y < h; y += 1){
+                atlas_levels_pack(rgb + (size_t)y*side*3, context->packed + y*w, w);
+            }
+            atlas_dirty_write(&context->dirty, glyph->slice, glyph->atlas_x, glyph->atlas_y, w, h, context->packed, w);
+            bytes += sizeof(uint16_t)*(uint64_t)w*h;
+        }
+        // The window flushes once a frame
+        if ((line + 1)%hot_screen_lines == 0){
+            atlas_dirty_flush(&context->dirty, hot_upload, context);
+        }
+    }
+    atlas_dirty_flush(&context->dirty, hot_upload, context);
+    return(bytes);
+}
+
+uint64_t
+hot_submit(Hot_Context *context, Hot_Input *input){
+    Software_Font *font = &context->font;
+    Text_Batch *batch = &context->batch;
+    Render_Stream *stream = &context->stream;
+    uint64_t bytes = 0;
+    for (int32_t first = 0; first < input->line_count; first += hot_screen_lines){
+        int32_t end = first + hot_screen_lines;
+        end = (end > input->line_count)?input->line_count:end;
+        arena_reset(&context->arena);
+        render_stream_begin_frame(stream);
+        text_batch_begin_frame(batch);
+        render_clear(stream, 0.f, 0.f, 0.f);
+        for (int32_t line = first; line < end; line += 1){
+            software_font_draw_string(font, batch, &context->arena, input->lines[line], 10, 16 + 16*(line - first),
+                                      0.9f, 0.9f, 0.9f, 1.f);
+        }
+        render_text_batch(stream, batch);
+        render_stream_execute(stream, &context->executor);
+        bytes += stream->size;
+    }
+    return(bytes);
+}
+
+static Hot_Fixture hot_fixtures[] = {
+    {"lookup", hot_lookup},
+    {"vertex", hot_vertex},
+    {"m_tables", hot_m_tables},
+    {"m_tables_build", hot_m_tables_build},
+    {"blit_swizzle", hot_blit_swizzle},
+    {"submit", hot_submit},
+};
+
+////////////////////////////////
+
+// Results
+
+struct Hot_Result{
+    char fixture[32];
+    char input[32];
+    uint64_t glyphs;
+    double ns_per_glyph;
+    double allocs_per_glyph;
+    double bytes_per_glyph;
+};
+
+int
+hot_compare_u64(const void *a, const void *b){
+    uint64_t x = *(uint64_t*)a;
+    uint64_t y = *(uint64_t*)b;
+    return((x < y)?-1:(x > y)?1:0);
+}
+
+Hot_Result
+hot_measure(Hot_Context *context, Hot_Fixture *fixture, Hot_Input *input, int32_t run_count){
+    // The warm up grows the batch, the stream and the arena's pages to what the input needs
+    fixture->run(context, input);
+    
+    uint64_t *run_ns = (uint64_t*)malloc(sizeof(uint64_t)*run_count);
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    for (int32_t i = 0; i < run_count; i += 1){
+        heap_frame_begin();
+        uint64_t start = hot_now_ns();
+        bytes = fixture->run(context, input);
+        uint64_t end = hot_now_ns();
+        allocations += heap_frame_end();
+        run_ns[i] = end - start;
+    }
+    qsort(run_ns, run_count, sizeof(uint64_t), hot_compare_u64);
+    
+    Hot_Result result = {0};
+    snprintf(result.fixture, sizeof(result.fixture), "%s", fixture->name);
+    snprintf(result.input, sizeof(result.input), "%s", input->name);
+    result.glyphs = (uint64_t)input->glyph_count;
+    result.ns_per_glyph = (double)run_ns[run_count/2]/(double)input->glyph_count;
+    result.allocs_per_glyph = (double)allocations/((double)run_count*input->glyph_count);
+    result.bytes_per_glyph = (double)bytes/(double)input->glyph_count;
+    free(run_ns);
+    return(result);
+}
+
+void
+hot_write_csv_line(FILE *file, Hot_Result *result){
+    fprintf(file, "%s,%s,%llu,%.3f,%.6f,%.2f\n", result->fixture, result->input, (unsigned long long)result->glyphs,
+            result->ns_per_glyph, result->allocs_per_glyph, result->bytes_per_glyph);
+}
+
+// Reads a csv written by -csv. Returns how many results it holds.
+int32_t
+hot_read_csv(char *file_name, Hot_Result *results, int32_t result_max){
+    int32_t count = 0;
+    FILE *file = fopen(file_name, "rb");
+    if (file == 0){
+        return(0);
+    }
+    char line[256];
+    for (;count < result_max && fgets(line, sizeof(line), file) != 0;){
+        Hot_Result *result = &results[count];
+        memset(result, 0, sizeof(*result));
+        unsigned long long glyphs = 0;
+        if (sscanf(line, "%31[^,],%31[^,],%llu,%lf,%lf,%lf", result->fixture, result->input, &glyphs,
+                   &result->ns_per_glyph, &result->allocs_per_glyph, &result->bytes_per_glyph) == 6){
+            result->glyphs = glyphs;
+            count += 1;
+        }
+    }
+    fclose(file);
+    return(count);
+}
+
+// Prints the change from the baseline of every result it has. Returns how many got worse.
+int32_t
+hot_compare_baseline(Hot_Result *results, int32_t count, Hot_Result *baseline, int32_t baseline_count, double threshold){
+    int32_t regressions = 0;
+    printf("\n%-16s %-8s %12s %12s %8s\n", "vs baseline", "", "ns/glyph", "was", "change");
+    for (int32_t i = 0; i < count; i += 1){
+        Hot_Result *result = &results[i];
+        Hot_Result *old = 0;
+        for (int32_t j = 0; j < baseline_count; j += 1){
+            if (strcmp(baseline[j].fixture, result->fixture) == 0 && strcmp(baseline[j].input, result->input) == 0){
+                old = &baseline[j];
+                break;
+            }
+        }
+        if (old == 0 || old->ns_per_glyph <= 0.0){
+            continue;
+        }
+        double change = 100.0*(result->ns_per_glyph/old->ns_per_glyph - 1.0);
+        bool32 slower = (change > threshold);
+        bool32 allocates = (result->allocs_per_glyph > old->allocs_per_glyph);
+        char *verdict = "";
+        if (allocates){
+            verdict = "  ALLOCATES";
+            regressions += 1;
+        }
+        else if (slower){
+            verdict = "  SLOWER";
+            regressions += 1;
+        }
+        printf("%-16s %-8s %12.2f %12.2f %+7.1f%%%s\n", result->fixture, result->input,
+               result->ns_per_glyph, old->ns_per_glyph, change, verdict);
+    }
+    return(regressions);
+}
+
+////////////////////////////////
+
+int
+main(int argc, char **argv){
+    char *font_name = 0;
+    char *csv_name = 0;
+    char *baseline_name = 0;
+    int32_t run_count = 15;
+    double threshold = 10.0;
+    char *data_root_name = 0;
+    for (int32_t i = 1; i < argc; i += 1){
+        if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc){
+            run_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-csv") == 0 && i + 1 < argc){
+            csv_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-baseline") == 0 && i + 1 < argc){
+            baseline_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-threshold") == 0 && i + 1 < argc){
+            threshold = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-data") == 0 && i + 1 < argc){
+            data_root_name = argv[++i];
+        }
+        else{
+            font_name = argv[i];
+        }
+    }
+    if (font_name == 0 || run_count < 1){
+        printf("usage: hot_path_bench <font.ttf> [-runs <n>] [-csv <file>] [-baseline <file>] [-threshold <percent>]\n"
+               "                      [-data <dir>]\n");
+        return(1);
+    }
+    
+    int32_t font_size = 0;
+    uint8_t *font_data = hot_read_file(font_name, &font_size);
+    TTF_Font ttf = {0};
+    if (font_data == 0 || !ttf_init(&ttf, font_data, font_size)){
+        printf("%s: not a TrueType font\n", font_name);
+        return(1);
+    }
+    
+    Hot_Context context = {0};
+    context.font = software_font_bake(&ttf, hot_point_size, bake_core_count());
+    Software_Font *font = &context.font;
+    context.compositor = cpu_compositor_init();
+    context.atlas.texels = font->atlas;
+    context.atlas.w = font->atlas_side;
+    context.atlas.h = font->atlas_side;
+    context.atlas.slice_count = font->slice_count;
+    context.framebuffer.w = hot_width;
+    context.framebuffer.h = hot_height;
+    context.framebuffer.pitch = hot_width;
+    context.framebuffer.pixels = (uint32_t*)malloc(sizeof(uint32_t)*hot_width*hot_height);
+    context.target.compositor = &context.compositor;
+    context.target.framebuffer = &context.framebuffer;
+    context.target.atlas = &context.atlas;
+    context.target.use_simd = true;
+    context.executor = cpu_render_executor(&context.target);
+    context.dirty = atlas_dirty_init(font->atlas_side, font->atlas_side, font->slice_count, 1024);
+    context.arena = arena_alloc(1 << 20);
+    context.packed = (uint16_t*)malloc(sizeof(uint16_t)*256*256);
+    context.staging = (uint16_t*)malloc(sizeof(uint16_t)*font->atlas_side*font->atlas_side);
+    
+    Hot_Input inputs[3];
+    int32_t input_count = 0;
+    {
+        int32_t size = 0;
+        char *text = hot_ascii_text(&size);
+        if (hot_input_init(&inputs[input_count], "ascii", text, size, font->map)){
+            input_count += 1;
+        }
+        char data_root[DATA_PATH_MAX];
+        if (data_root_name != 0){
+            snprintf(data_root, sizeof(data_root), "%s", data_root_name);
+        }
+        else{
+            data_root_from_executable(data_root, sizeof(data_root));
+        }
+        char *file_names[2] = {"test_data/source_file.txt", "../win32-file-handles/test_data/text_file.txt"};
+        char *names[2] = {"source", "text"};
+        for (int32_t i = 0; i < 2; i += 1){
+            char file_path[DATA_PATH_MAX];
+            text = (char*)hot_read_file(data_path(data_root, file_names[i], file_path, sizeof(file_path)), &size);
+            if (hot_input_init(&inputs[input_count], names[i], text, size, font->map)){
+                input_count += 1;
+            }
+            else{
+                printf("%s: cannot read %s, pass -data <win32-direct-write>\n", names[i], file_path);
+                free(text);
+            }
+        }
+    }
+    int32_t line_max = 0;
+    for (int32_t i = 0; i < input_count; i += 1){
+        line_max = (inputs[i].line_max > line_max)?inputs[i].line_max:line_max;
+    }
+    context.codepoints = (uint32_t*)malloc(sizeof(uint32_t)*(line_max + 1));
+    context.dense = (uint16_t*)malloc(sizeof(uint16_t)*(line_max + 1));
+    context.pen_x = (int32_t*)malloc(sizeof(int32_t)*(line_max + 1));
+    
+    printf("hot_path_bench %s at %.0fpt, %d runs", font_name, hot_point_size, run_count);
+#if !HEAP_ALLOC_CHECKS
+    printf(", allocations are not counted in this build");
+#endif
+    printf("\n");
+    for (int32_t i = 0; i < input_count; i += 1){
+        printf("  %-8s %5d lines %7d glyphs\n", inputs[i].name, inputs[i].line_count, inputs[i].glyph_count);
+    }
+    printf("\n%-16s %-8s %12s %14s %14s\n", "fixture", "input", "ns/glyph", "allocs/glyph", "bytes/glyph");
+    
+    int32_t fixture_count = (int32_t)(sizeof(hot_fixtures)/sizeof(hot_fixtures[0]));
+    int32_t result_count = 0;
+    Hot_Result *results = (Hot_Result*)malloc(sizeof(Hot_Result)*fixture_count*3);
+    for (int32_t i = 0; i < fixture_count; i += 1){
+        for (int32_t j = 0; j < input_count; j += 1){
+            Hot_Result *result = &results[result_count];
+            *result = hot_measure(&context, &hot_fixtures[i], &inputs[j], run_count);
+            result_count += 1;
+            printf("%-16s %-8s %12.2f %14.4f %14.1f\n", result->fixture, result->input,
+                   result->ns_per_glyph, result->allocs_per_glyph, result->bytes_per_glyph);
+        }
+    }
+    
+    int32_t exit_code = 0;
+    if (csv_name != 0){
+        FILE *file = fopen(csv_name, "wb");
+        if (file == 0){
+            printf("cannot write %s\n", csv_name);
+            exit_code = 1;
+        }
+        else{
+            fprintf(file, "fixture,input,glyphs,ns_per_glyph,allocs_per_glyph,bytes_per_glyph\n");
+            for (int32_t i = 0; i < result_count; i += 1){
+                hot_write_csv_line(file, &results[i]);
+            }
+            fclose(file);
+        }
+    }
+    if (baseline_name != 0){
+        Hot_Result baseline[64];
+        int32_t baseline_count = hot_read_csv(baseline_name, baseline, 64);
+        if (baseline_count == 0){
+            printf("%s: no results to compare with\n", baseline_name);
+            exit_code = 1;
+        }
+        else{
+            int32_t regressions = hot_compare_baseline(results, result_count, baseline, baseline_count, threshold);
+            printf("%d regressions past %.0f%%\n", regressions, threshold);
+            if (regressions > 0){
+                exit_code = 1;
+            }
+        }
+    }
+    
+    free(results);
+    for (int32_t i = 0; i < input_count; i += 1){
+        hot_input_free(&inputs[i]);
+    }
+    free(context.pen_x);
+    free(context.dense);
+    free(context.codepoints);
+    free(context.packed);
+    free(context.staging);
+    arena_free(&context.arena);
+    atlas_dirty_free(&context.dirty);
+    render_stream_free(&context.stream);
+    text_batch_free(&context.batch);
+    free(context.framebuffer.pixels);
+    cpu_compositor_free(&context.compositor);
+    software_font_free(font);
+    free(font_data);
+    return(exit_code);
+}
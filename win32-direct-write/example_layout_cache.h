@@ -0,0 +1,249 @@
+// DirectWrite rasterization example: cache of laid out strings
+// Most strings on screen are the same strings as last frame. The cache keeps the laid out run of a
+// string, the dense template index and pen position of each glyph that draws, keyed by the font,
+// the size and the text itself. A string drawn again at the same x costs a hash and a compare, one
+// that moved sideways adds the difference to its pen positions, and a vertical move is free because
+// y is applied when the instances are made.
+// Memory is fixed at init: entry_count entries of at most text_max bytes and glyph_max glyphs, with
+// the least recently used entry replaced. Longer strings are laid out every time.
+
+#if !defined(EXAMPLE_LAYOUT_CACHE_H)
+#define EXAMPLE_LAYOUT_CACHE_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+
+struct Layout_Cache_Entry{
+    uint64_t hash;
+    uint32_t font_id;
+    float size;
+    // -1 while the entry is unused
+    int32_t text_length;
+    int32_t glyph_count;
+    // The pen positions are for a string starting at x
+    int32_t x;
+    // Links in the LRU list, most recently used at the front
+    int32_t prev;
+    int32_t next;
+    // Next entry in the same bucket, -1 at the end
+    int32_t bucket_next;
+};
+
+struct Layout_Cache{
+    int32_t entry_count;
+    int32_t text_max;
+    int32_t glyph_max;
+    // entries[entry_count] is the sentinel of the LRU list
+    Layout_Cache_Entry *entries;
+    int32_t *buckets;
+    uint32_t bucket_mask;
+    
+    // Per entry, text_max bytes and glyph_max glyphs
+    char *text_memory;
+    uint16_t *glyph_memory;
+    int32_t *pen_memory;
+    
+    uint64_t hits;
+    // Hits at a different x
+    uint64_t moves;
+    uint64_t misses;
+    uint64_t evictions;
+    // Strings too long to keep
+    uint64_t bypasses;
+};
+
+// What text_batch_push_run needs. Points into the cache, valid until the next store.
+struct Layout_Run{
+    uint16_t *glyphs;
+    int32_t *pen_x;
+    int32_t count;
+};
+
+void
+layout_cache__unlink(Layout_Cache *cache, int32_t entry){
+    Layout_Cache_Entry *e = &cache->entries[entry];
+    cache->entries[e->prev].next = e->next;
+    cache->entries[e->next].prev = e->prev;
+}
+
+void
+layout_cache__push_front(Layout_Cache *cache, int32_t entry){
+    int32_t sentinel = cache->entry_count;
+    Layout_Cache_Entry *e = &cache->entries[entry];
+    e->prev = sentinel;
+    e->next = cache->entries[sentinel].next;
+    cache->entries[e->next].prev = entry;
+    cache->entries[sentinel].next = entry;
+}
+
+Layout_Cache
+layout_cache_init(int32_t entry_count, int32_t text_max, int32_t glyph_max){
+    assert(entry_count > 0);
+    Layout_Cache cache = {0};
+    cache.entry_count = entry_count;
+    cache.text_max = text_max;
+    cache.glyph_max = glyph_max;
+    
+    cache.entries = (Layout_Cache_Entry*)heap_alloc(sizeof(Layout_Cache_Entry)*(entry_count + 1));
+    memset(cache.entries, 0, sizeof(Layout_Cache_Entry)*(entry_count + 1));
+    int32_t sentinel = entry_count;
+    cache.entries[sentinel].prev = sentinel;
+    cache.entries[sentinel].next = sentinel;
+    for (int32_t i = 0; i < entry_count; i += 1){
+        cache.entries[i].text_length = -1;
+        cache.entries[i].bucket_next = -1;
+        layout_cache__push_front(&cache, i);
+    }
+    
+    // Twice as many buckets as entries, rounded up to a power of two
+    uint32_t bucket_count = 1;
+    while (bucket_count < 2*(uint32_t)entry_count){
+        bucket_count *= 2;
+    }
+    cache.bucket_mask = bucket_count - 1;
+    cache.buckets = (int32_t*)heap_alloc(sizeof(int32_t)*bucket_count);
+    for (uint32_t i = 0; i < bucket_count; i += 1){
+        cache.buckets[i] = -1;
+    }
+    
+    cache.text_memory = (char*)heap_alloc((size_t)entry_count*text_max);
+    cache.glyph_memory = (uint16_t*)heap_alloc(sizeof(uint16_t)*entry_count*glyph_max);
+    cache.pen_memory = (int32_t*)heap_alloc(sizeof(int32_t)*entry_count*glyph_max);
+    return(cache);
+}
+
+void
+layout_cache_free(Layout_Cache *cache){
+    heap_free(cache->entries);
+    heap_free(cache->buckets);
+    heap_free(cache->text_memory);
+    heap_free(cache->glyph_memory);
+    heap_free(cache->pen_memory);
+    memset(cache, 0, sizeof(*cache));
+}
+
+uint64_t
+layout_cache_memory(Layout_Cache *cache){
+    return((uint64_t)(cache->entry_count + 1)*sizeof(Layout_Cache_Entry) +
+           (uint64_t)(cache->bucket_mask + 1)*sizeof(int32_t) +
+           (uint64_t)cache->entry_count*cache->text_max +
+           (uint64_t)cache->entry_count*cache->glyph_max*(sizeof(uint16_t) + sizeof(int32_t)));
+}
+
+// FNV-1a over the text, seeded with the font and the size.
+uint64_t
+layout_cache_hash(uint32_t font_id, float size, char *text, int32_t text_length){
+    uint32_t size_bits = 0;
+    memcpy(&size_bits, &size, sizeof(size_bits));
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = (h ^ font_id)*0x100000001b3ull;
+    h = (h ^ size_bits)*0x100000001b3ull;
+    for (int32_t i = 0; i < text_length; i += 1){
+        h ^= (uint8_t)text[i];
+        h *= 0x100000001b3ull;
+    }
+    return(h);
+}
+
+Layout_Run
+layout_cache__run(Layout_Cache *cache, int32_t entry){
+    Layout_Run run = {0};
+    run.glyphs = cache->glyph_memory + (size_t)entry*cache->glyph_max;
+    run.pen_x = cache->pen_memory + (size_t)entry*cache->glyph_max;
+    run.count = cache->entries[entry].glyph_count;
+    return(run);
+}
+
+// Finds the run of a string and moves it to x.
+bool32
+layout_cache_lookup(Layout_Cache *cache, uint32_t font_id, float size, char *text, int32_t text_length, int32_t x,
+                    Layout_Run *run_out){
+    uint64_t hash = layout_cache_hash(font_id, size, text, text_length);
+    int32_t entry = cache->buckets[hash & cache->bucket_mask];
+    for (; entry >= 0; entry = cache->entries[entry].bucket_next){
+        Layout_Cache_Entry *e = &cache->entries[entry];
+        if (e->hash == hash && e->font_id == font_id && e->size == size && e->text_length == text_length &&
+            memcmp(cache->text_memory + (size_t)entry*cache->text_max, text, text_length) == 0){
+            break;
+        }
+    }
+    if (entry < 0){
+        cache->misses += 1;
+        return(false);
+    }
+    
+    cache->hits += 1;
+    layout_cache__unlink(cache, entry);
+    layout_cache__push_front(cache, entry);
+    Layout_Cache_Entry *e = &cache->entries[entry];
+    Layout_Run run = layout_cache__run(cache, entry);
+    if (e->x != x){
+        int32_t delta = x - e->x;
+        for (int32_t i = 0; i < run.count; i += 1){
+            run.pen_x[i] += delta;
+        }
+        e->x = x;
+        cache->moves += 1;
+    }
+    *run_out = run;
+    return(true);
+}
+
+// Keeps the run of a string laid out at x in place of the least recently used entry. Returns false
+// when the string is too long to keep.
+bool32
+layout_cache_store(Layout_Cache *cache, uint32_t font_id, float size, char *text, int32_t text_length, int32_t x,
+                   uint16_t *glyphs, int32_t *pen_x, int32_t count){
+    if (text_length > cache->text_max || count > cache->glyph_max){
+        cache->bypasses += 1;
+        return(false);
+    }
+    
+    int32_t sentinel = cache->entry_count;
+    int32_t entry = cache->entries[sentinel].prev;
+    Layout_Cache_Entry *e = &cache->entries[entry];
+    if (e->text_length >= 0){
+        int32_t *link = &cache->buckets[e->hash & cache->bucket_mask];
+        while (*link != entry){
+            link = &cache->entries[*link].bucket_next;
+        }
+        *link = e->bucket_next;
+        cache->evictions += 1;
+    }
+    
+    e->hash = layout_cache_hash(font_id, size, text, text_length);
+    e->font_id = font_id;
+    e->size = size;
+    e->text_length = text_length;
+    e->glyph_count = count;
+    e->x = x;
+    int32_t *bucket = &cache->buckets[e->hash & cache->bucket_mask];
+    e->bucket_next = *bucket;
+    *bucket = entry;
+    memcpy(cache->text_memory + (size_t)entry*cache->text_max, text, text_length);
+    Layout_Run run = layout_cache__run(cache, entry);
+    memcpy(run.glyphs, glyphs, sizeof(uint16_t)*count);
+    memcpy(run.pen_x, pen_x, sizeof(int32_t)*count);
+    
+    layout_cache__unlink(cache, entry);
+    layout_cache__push_front(cache, entry);
+    return(true);
+}
+
+// Forgets every string, for when a font's glyphs or metrics change.
+void
+layout_cache_clear(Layout_Cache *cache){
+    for (int32_t i = 0; i < cache->entry_count; i += 1){
+        cache->entries[i].text_length = -1;
+        cache->entries[i].bucket_next = -1;
+    }
+    for (uint32_t i = 0; i <= cache->bucket_mask; i += 1){
+        cache->buckets[i] = -1;
+    }
+}
+
+#endif
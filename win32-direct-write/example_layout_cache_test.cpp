@@ -0,0 +1,253 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the layout cache against a model
+// usage: layout_cache_test [seed]
+// Random strings are looked up and stored at random x the way draw_string does, and a plain list
+// with use stamps says what should be there. A hit must be the string that was stored, for the same
+// font and size, with its pen positions moved to the new x; a miss must be a string the model does
+// not hold; the least recently used string is the one replaced; strings past the limits are never
+// kept. Strings that only differ in font, size or their last byte share buckets in a small cache.
+// After a clear every lookup misses, and nothing is allocated after init.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_layout_cache.h"
+#include "example_test.h"
+
+static int32_t test_scenario_count = 60;
+static int32_t test_operation_count = 4000;
+
+#define TEST_POOL_SIZE 96
+#define TEST_TEXT_MAX 40
+
+// A string the cache can be asked about: the text, the font and the size it is laid out with
+struct Test_String{
+    char text[TEST_TEXT_MAX + 8];
+    int32_t text_length;
+    uint32_t font_id;
+    float size;
+};
+
+// What the model holds for one kept string
+struct Test_Model_Entry{
+    int32_t string;
+    int32_t x;
+    uint64_t stamp;
+    int32_t glyph_count;
+    uint16_t glyphs[TEST_TEXT_MAX + 8];
+    int32_t pen_x[TEST_TEXT_MAX + 8];
+};
+
+struct Test_Model{
+    Test_Model_Entry *entries;
+    int32_t count;
+    int32_t max;
+    uint64_t clock;
+};
+
+bool32
+test_string_equal(Test_String *a, Test_String *b){
+    return(a->text_length == b->text_length && a->font_id == b->font_id && a->size == b->size &&
+           memcmp(a->text, b->text, a->text_length) == 0);
+}
+
+// Two strings of the pool can be the same string, the model goes by what they hold.
+int32_t
+test_model_find(Test_Model *model, Test_String *pool, int32_t string){
+    for (int32_t i = 0; i < model->count; i += 1){
+        if (test_string_equal(&pool[model->entries[i].string], &pool[string])){
+            return(i);
+        }
+    }
+    return(-1);
+}
+
+// Glyphs and pen positions a layout of the string at x would give, one glyph per byte
+int32_t
+test_layout(Test_String *string, int32_t x, uint16_t *glyphs, int32_t *pen_x){
+    int32_t pen = x;
+    for (int32_t i = 0; i < string->text_length; i += 1){
+        glyphs[i] = (uint16_t)((uint8_t)string->text[i]*7 + string->font_id);
+        pen_x[i] = pen;
+        pen += 3 + (uint8_t)string->text[i]%9 + (int32_t)string->size;
+    }
+    return(string->text_length);
+}
+
+// Strings in groups of four that collide on everything but one thing
+void
+test_make_pool(Test_String *pool, uint32_t *state){
+    for (int32_t i = 0; i < TEST_POOL_SIZE; i += 4){
+        Test_String base = {0};
+        base.text_length = test_random_range(state, 0, TEST_TEXT_MAX + 6);
+        for (int32_t j = 0; j < base.text_length; j += 1){
+            base.text[j] = (char)test_random_range(state, 32, 126);
+        }
+        base.font_id = (uint32_t)test_random_range(state, 0, 2);
+        base.size = (float)test_random_range(state, 10, 14);
+        for (int32_t k = 0; k < 4; k += 1){
+            pool[i + k] = base;
+        }
+        pool[i + 1].font_id += 1;
+        pool[i + 2].size += 0.5f;
+        if (base.text_length > 0){
+            pool[i + 3].text[base.text_length - 1] ^= 1;
+        }
+        else{
+            pool[i + 3].text[0] = 'x';
+            pool[i + 3].text_length = 1;
+        }
+    }
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x1A7C4Eu);
+    uint32_t state = seed;
+    uint64_t total_hits = 0;
+    uint64_t total_moves = 0;
+    uint64_t total_evictions = 0;
+    uint64_t total_bypasses = 0;
+    
+    Test_String *pool = (Test_String*)malloc(sizeof(Test_String)*TEST_POOL_SIZE);
+    uint16_t glyphs[TEST_TEXT_MAX + 8];
+    int32_t pen_x[TEST_TEXT_MAX + 8];
+    for (int32_t scenario = 0; scenario < test_scenario_count; scenario += 1){
+        int64_t failures_before = test_state.failures;
+        test_make_pool(pool, &state);
+        int32_t entry_count = test_random_range(&state, 1, 48);
+        int32_t text_max = test_random_range(&state, 8, TEST_TEXT_MAX);
+        int32_t glyph_max = test_random_range(&state, 8, TEST_TEXT_MAX);
+        Layout_Cache cache = layout_cache_init(entry_count, text_max, glyph_max);
+        Test_Model model = {0};
+        model.max = entry_count;
+        model.entries = (Test_Model_Entry*)malloc(sizeof(Test_Model_Entry)*entry_count);
+        uint64_t evictions = 0;
+        uint64_t bypasses = 0;
+
+#if HEAP_ALLOC_CHECKS
+        heap_frame_begin();
+#endif
+        for (int32_t op = 0; op < test_operation_count; op += 1){
+            // Mostly strings already seen, so hits, moves and evictions all happen
+            int32_t index = test_random_range(&state, 0, TEST_POOL_SIZE - 1);
+            if (test_random_range(&state, 0, 3) != 0){
+                index = test_random_range(&state, 0, entry_count + entry_count/2);
+                index = index%TEST_POOL_SIZE;
+            }
+            Test_String *string = &pool[index];
+            int32_t x = (test_random_range(&state, 0, 2) == 0)?test_random_range(&state, -200, 800):40;
+            
+            if (op%500 == 499){
+                layout_cache_clear(&cache);
+                model.count = 0;
+            }
+            
+            model.clock += 1;
+            int32_t found = test_model_find(&model, pool, index);
+            Layout_Run run = {0};
+            bool32 hit = layout_cache_lookup(&cache, string->font_id, string->size, string->text, string->text_length, x, &run);
+            if (!TEST_CHECK(hit == (found >= 0))){
+                printf("    op %d: string %d %s, the model %s it\n", op, index, hit?"hit":"missed", (found >= 0)?"holds":"does not hold");
+                break;
+            }
+            if (hit){
+                Test_Model_Entry *entry = &model.entries[found];
+                entry->stamp = model.clock;
+                int32_t count = test_layout(string, x, glyphs, pen_x);
+                TEST_CHECK(run.count == count && run.count == entry->glyph_count);
+                TEST_CHECK(memcmp(run.glyphs, glyphs, sizeof(uint16_t)*count) == 0);
+                TEST_CHECK(memcmp(run.pen_x, pen_x, sizeof(int32_t)*count) == 0);
+                entry->x = x;
+            }
+            else{
+                int32_t count = test_layout(string, x, glyphs, pen_x);
+                bool32 kept = layout_cache_store(&cache, string->font_id, string->size, string->text, string->text_length, x,
+                                                 glyphs, pen_x, count);
+                bool32 fits = (string->text_length <= text_max && count <= glyph_max);
+                TEST_CHECK(kept == fits);
+                if (!fits){
+                    bypasses += 1;
+                }
+                else{
+                    int32_t slot = model.count;
+                    if (model.count == model.max){
+                        slot = 0;
+                        for (int32_t i = 1; i < model.count; i += 1){
+                            if (model.entries[i].stamp < model.entries[slot].stamp){
+                                slot = i;
+                            }
+                        }
+                        evictions += 1;
+                    }
+                    else{
+                        model.count += 1;
+                    }
+                    Test_Model_Entry *entry = &model.entries[slot];
+                    entry->string = index;
+                    entry->x = x;
+                    entry->stamp = model.clock;
+                    entry->glyph_count = count;
+                    memcpy(entry->glyphs, glyphs, sizeof(uint16_t)*count);
+                    memcpy(entry->pen_x, pen_x, sizeof(int32_t)*count);
+                }
+            }
+        }
+#if HEAP_ALLOC_CHECKS
+        TEST_CHECK(heap_frame_end() == 0);
+#endif
+        
+        // Every string the model holds is found, and nothing else.
+        for (int32_t i = 0; i < TEST_POOL_SIZE; i += 1){
+            Layout_Run run = {0};
+            Test_String *string = &pool[i];
+            int32_t found = test_model_find(&model, pool, i);
+            uint64_t hits_before = cache.hits;
+            bool32 hit = layout_cache_lookup(&cache, string->font_id, string->size, string->text, string->text_length, 40, &run);
+            TEST_CHECK(hit == (found >= 0));
+            if (hit){
+                model.entries[found].stamp = ++model.clock;
+                TEST_CHECK(cache.hits == hits_before + 1);
+            }
+        }
+        TEST_CHECK(cache.bypasses == bypasses);
+        // Clears drop strings without counting evictions.
+        TEST_CHECK(cache.evictions == evictions);
+        if (test_state.failures != failures_before){
+            printf("    scenario %d: %d entries of %d bytes and %d glyphs\n", scenario, entry_count, text_max, glyph_max);
+        }
+        
+        total_hits += cache.hits;
+        total_moves += cache.moves;
+        total_evictions += cache.evictions;
+        total_bypasses += cache.bypasses;
+        free(model.entries);
+        layout_cache_free(&cache);
+    }
+    free(pool);
+    
+    TEST_CHECK(total_hits > 0 && total_moves > 0 && total_evictions > 0 && total_bypasses > 0);
+    printf("layout_cache_test: %llu hits, %llu moved, %llu evictions, %llu too long\n",
+           (unsigned long long)total_hits, (unsigned long long)total_moves,
+           (unsigned long long)total_evictions, (unsigned long long)total_bypasses);
+#if !HEAP_ALLOC_CHECKS
+    printf("layout_cache_test: allocations are not counted in this build\n");
+#endif
+    return(test_finish("layout_cache_test", seed));
+}
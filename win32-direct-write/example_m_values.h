@@ -0,0 +1,151 @@
+// DirectWrite rasterization example: M value tables for the ClearType blend
+// M values depend on the text color only through V = 0.5*r + g + 0.1875*b. For 8 bit colors
+// 16*255*V = 8*r + 16*g + 3*b is an integer, and outside of [214*16, 323*16] the result is clamped
+// to Cmax or Cmin, so every 8 bit color lands on one of 1745 rows computed at compile time. Alpha
+// only scales a row. The GPU styles and the CPU compositor both read their M values from here.
+
+#if !defined(EXAMPLE_M_VALUES_H)
+#define EXAMPLE_M_VALUES_H
+
+#include <stdint.h>
+#include <string.h>
+typedef int32_t bool32;
+
+static constexpr float m_value_cmax[7] = {
+    0.f,
+    0.380392157f,
+    0.600000000f,
+    0.749019608f,
+    0.854901961f,
+    0.937254902f,
+    1.f,
+};
+static constexpr float m_value_cmin[7] = {
+    0.f,
+    0.166666667f,
+    0.333333333f,
+    0.500000000f,
+    0.666666667f,
+    0.833333333f,
+    1.f,
+};
+
+static constexpr float m_value_A = 0.839215686374509f; // 214/255
+static constexpr float m_value_B = 1.266666666666667f; // 323/255
+
+// Reference computation for any color, the tables are built from the same arithmetic.
+void
+text_compute_M_values(float r, float g, float b, float a, float *M_value_table){
+    float V = r*0.5f + g + b*0.1875f;
+    float L = (V - m_value_A)/(m_value_B - m_value_A);
+    
+    M_value_table[0] = 0.f;
+    for (int32_t i = 1; i <= 5; i += 1){
+        float Cmax = m_value_cmax[i];
+        float Cmin = m_value_cmin[i];
+        float M = Cmax + (Cmin - Cmax)*L;
+        if (M > Cmax){
+            M = Cmax;
+        }
+        if (M < Cmin){
+            M = Cmin;
+        }
+        M_value_table[i] = M*a;
+    }
+    M_value_table[6] = a;
+}
+
+////////////////////////////////
+
+// Compile Time Tables
+
+#define M_VALUE_KEY_MIN (214*16)
+#define M_VALUE_KEY_MAX (323*16)
+#define M_VALUE_KEY_COUNT (M_VALUE_KEY_MAX - M_VALUE_KEY_MIN + 1)
+
+constexpr float
+m_value__unscaled(int32_t i, int32_t v_key){
+    float V = (float)v_key/(16.f*255.f);
+    float L = (V - m_value_A)/(m_value_B - m_value_A);
+    float M = m_value_cmax[i] + (m_value_cmin[i] - m_value_cmax[i])*L;
+    if (M > m_value_cmax[i]){
+        M = m_value_cmax[i];
+    }
+    if (M < m_value_cmin[i]){
+        M = m_value_cmin[i];
+    }
+    return(M);
+}
+
+// M[1..5] for every V key at full alpha
+struct M_Value_Rows{
+    float M[M_VALUE_KEY_COUNT][5];
+    
+    constexpr M_Value_Rows() : M(){
+        for (int32_t key = 0; key < M_VALUE_KEY_COUNT; key += 1){
+            for (int32_t i = 0; i < 5; i += 1){
+                M[key][i] = m_value__unscaled(i + 1, key + M_VALUE_KEY_MIN);
+            }
+        }
+    }
+};
+
+struct M_Value_Alphas{
+    float a[256];
+    
+    constexpr M_Value_Alphas() : a(){
+        for (int32_t i = 0; i < 256; i += 1){
+            a[i] = (float)i/255.f;
+        }
+    }
+};
+
+static constexpr M_Value_Rows m_value_rows;
+static constexpr M_Value_Alphas m_value_alphas;
+
+uint8_t
+m_value_quantize(float x){
+    x = x*255.f + 0.5f;
+    if (x < 0.f){
+        x = 0.f;
+    }
+    if (x > 255.f){
+        x = 255.f;
+    }
+    return((uint8_t)x);
+}
+
+constexpr int32_t
+m_value_v_key(uint8_t r, uint8_t g, uint8_t b){
+    return(8*r + 16*g + 3*b);
+}
+
+// Row of the table for an 8 bit color, colors past either end of the ramp share the end rows.
+const float*
+m_value_row(uint8_t r, uint8_t g, uint8_t b){
+    int32_t key = m_value_v_key(r, g, b);
+    key = (key < M_VALUE_KEY_MIN)?M_VALUE_KEY_MIN:key;
+    key = (key > M_VALUE_KEY_MAX)?M_VALUE_KEY_MAX:key;
+    return(m_value_rows.M[key - M_VALUE_KEY_MIN]);
+}
+
+// The seven M values for an 8 bit color, laid out like text_compute_M_values.
+void
+m_values_rgba8(uint8_t r, uint8_t g, uint8_t b, uint8_t a, float *M_value_table){
+    const float *row = m_value_row(r, g, b);
+    M_value_table[0] = 0.f;
+    if (a == 255){
+        // Opaque text, the row is already the answer.
+        memcpy(M_value_table + 1, row, sizeof(float)*5);
+        M_value_table[6] = 1.f;
+    }
+    else{
+        float alpha = m_value_alphas.a[a];
+        for (int32_t i = 0; i < 5; i += 1){
+            M_value_table[i + 1] = row[i]*alpha;
+        }
+        M_value_table[6] = alpha;
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the M value tables
+// usage: m_values_test
+// The compile time tables against text_compute_M_values, over every opaque 8 bit color and every
+// alpha of a spread of colors. Each of the seven values must be far below the 1/255 step of the
+// output away from what the shader's formula gives.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_m_values.h"
+#include "example_test.h"
+
+static float test_max_error = 1e-6f;
+
+float
+test_m_values_error(uint8_t r, uint8_t g, uint8_t b, uint8_t a){
+    float expected[7];
+    float got[7];
+    text_compute_M_values(r/255.f, g/255.f, b/255.f, a/255.f, expected);
+    m_values_rgba8(r, g, b, a, got);
+    float max_error = 0.f;
+    for (int32_t i = 0; i < 7; i += 1){
+        float error = fabsf(got[i] - expected[i]);
+        max_error = (error > max_error)?error:max_error;
+    }
+    return(max_error);
+}
+
+// Exhaustive, there is no seed.
+int
+main(void){
+    float max_error = 0.f;
+    for (int32_t r = 0; r < 256; r += 1){
+        for (int32_t g = 0; g < 256; g += 1){
+            for (int32_t b = 0; b < 256; b += 1){
+                float error = test_m_values_error((uint8_t)r, (uint8_t)g, (uint8_t)b, 255);
+                if (!TEST_CHECK(error <= test_max_error) && test_state.failures <= TEST_FAILURE_PRINT_MAX){
+                    printf("    rgba %d %d %d 255: error %g\n", r, g, b, error);
+                }
+                max_error = (error > max_error)?error:max_error;
+            }
+        }
+    }
+    for (int32_t r = 0; r < 256; r += 15){
+        for (int32_t g = 0; g < 256; g += 15){
+            for (int32_t b = 0; b < 256; b += 15){
+                for (int32_t a = 0; a < 256; a += 1){
+                    float error = test_m_values_error((uint8_t)r, (uint8_t)g, (uint8_t)b, (uint8_t)a);
+                    if (!TEST_CHECK(error <= test_max_error) && test_state.failures <= TEST_FAILURE_PRINT_MAX){
+                        printf("    rgba %d %d %d %d: error %g\n", r, g, b, a, error);
+                    }
+                    max_error = (error > max_error)?error:max_error;
+                }
+            }
+        }
+    }
+    
+    printf("m_values_test: %d rows (%d bytes), max error %.2g\n",
+           M_VALUE_KEY_COUNT, (int32_t)sizeof(m_value_rows), max_error);
+    return(test_finish("m_values_test", 0));
+}
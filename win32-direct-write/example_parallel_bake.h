@@ -0,0 +1,291 @@
+// DirectWrite rasterization example: multi-threaded atlas bake
+// Three phases so the result is identical to a serial bake:
+//  1. workers rasterize chunks of the glyph range, each with its own rasterizer and scratch storage
+//  2. the calling thread packs every box in glyph order
+//  3. workers copy their glyphs into the now disjoint atlas regions and report the placement
+
+#if !defined(EXAMPLE_PARALLEL_BAKE_H)
+#define EXAMPLE_PARALLEL_BAKE_H
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_atlas_packer.h"
+#include "example_glyph_rasterizer.h"
+#include "example_trace.h"
+
+////////////////////////////////
+
+// Threads
+
+typedef void Bake_Thread_Proc(void *param);
+
+struct Bake_Thread{
+    Bake_Thread_Proc *proc;
+    void *param;
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+};
+
+#if defined(_WIN32)
+DWORD WINAPI
+bake_thread__entry(void *param){
+    Bake_Thread *thread = (Bake_Thread*)param;
+    thread->proc(thread->param);
+    return(0);
+}
+#else
+void*
+bake_thread__entry(void *param){
+    Bake_Thread *thread = (Bake_Thread*)param;
+    thread->proc(thread->param);
+    return(0);
+}
+#endif
+
+void
+bake_thread_start(Bake_Thread *thread, Bake_Thread_Proc *proc, void *param){
+    thread->proc = proc;
+    thread->param = param;
+#if defined(_WIN32)
+    thread->handle = CreateThread(0, 0, bake_thread__entry, thread, 0, 0);
+#else
+    pthread_create(&thread->handle, 0, bake_thread__entry, thread);
+#endif
+}
+
+void
+bake_thread_join(Bake_Thread *thread){
+#if defined(_WIN32)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, 0);
+#endif
+}
+
+int32_t
+bake_atomic_add(volatile int32_t *x, int32_t v){
+#if defined(_WIN32)
+    return((int32_t)InterlockedExchangeAdd((volatile LONG*)x, v));
+#else
+    return(__atomic_fetch_add(x, v, __ATOMIC_SEQ_CST));
+#endif
+}
+
+int32_t
+bake_core_count(void){
+    int32_t result = 1;
+#if defined(_WIN32)
+    SYSTEM_INFO info = {0};
+    GetSystemInfo(&info);
+    result = (int32_t)info.dwNumberOfProcessors;
+#else
+    result = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (result < 1){
+        result = 1;
+    }
+    return(result);
+}
+
+////////////////////////////////
+
+// Parallel Bake
+
+typedef void Bake_Glyph_Placed_Function(void *user, int32_t glyph_index, Glyph_Bitmap *bitmap, Atlas_Slot slot);
+
+struct Parallel_Bake_Glyph{
+    Glyph_Bitmap bitmap;
+    bool32 rasterized;
+    int32_t worker;
+    uint64_t offset;
+    Atlas_Slot slot;
+};
+
+struct Parallel_Bake_Worker{
+    struct Parallel_Bake *bake;
+    int32_t index;
+    Glyph_Rasterizer *rasterizer;
+    // Texels of every glyph this worker rasterized, tightly packed
+    uint8_t *storage;
+    uint64_t storage_size;
+    uint64_t storage_max;
+};
+
+struct Parallel_Bake{
+    int32_t glyph_count;
+    int32_t chunk_size;
+    volatile int32_t next_chunk;
+    Parallel_Bake_Glyph *glyphs;
+    Parallel_Bake_Worker *workers;
+    int32_t worker_count;
+    
+    uint8_t *atlas;
+    int32_t atlas_w;
+    int32_t atlas_h;
+    
+    Bake_Glyph_Placed_Function *placed;
+    void *placed_user;
+};
+
+void
+parallel_bake__rasterize_proc(void *param){
+    TRACE_SCOPE("bake rasterize");
+    Parallel_Bake_Worker *worker = (Parallel_Bake_Worker*)param;
+    Parallel_Bake *bake = worker->bake;
+    Glyph_Rasterizer *rasterizer = worker->rasterizer;
+    for (;;){
+        int32_t first = bake_atomic_add(&bake->next_chunk, 1)*bake->chunk_size;
+        if (first >= bake->glyph_count){
+            break;
+        }
+        int32_t one_past_last = first + bake->chunk_size;
+        if (one_past_last > bake->glyph_count){
+            one_past_last = bake->glyph_count;
+        }
+        for (int32_t i = first; i < one_past_last; i += 1){
+            Parallel_Bake_Glyph *glyph = &bake->glyphs[i];
+            Glyph_Bitmap bitmap = {0};
+            glyph->rasterized = rasterizer->rasterize_glyph(rasterizer->backend, (uint16_t)i, 0.f, &bitmap);
+            if (bitmap.w <= 0 || bitmap.h <= 0){
+                // Whitespace and control glyphs keep only their advance: nothing is stored, packed or placed.
+                glyph->rasterized = false;
+            }
+            if (glyph->rasterized){
+                uint64_t size = 3*(uint64_t)bitmap.w*(uint64_t)bitmap.h;
+                if (worker->storage_size + size > worker->storage_max){
+                    worker->storage_max = 2*(worker->storage_size + size) + 4096;
+                    worker->storage = (uint8_t*)realloc(worker->storage, (size_t)worker->storage_max);
+                }
+                glyph->worker = worker->index;
+                glyph->offset = worker->storage_size;
+                glyph_bitmap_copy(&bitmap, bitmap.w, bitmap.h, worker->storage + worker->storage_size, 3*bitmap.w);
+                worker->storage_size += size;
+                glyph->bitmap = bitmap;
+                glyph->bitmap.rgb = 0;
+                glyph->bitmap.pitch = 3*bitmap.w;
+            }
+        }
+    }
+}
+
+void
+parallel_bake__place_proc(void *param){
+    TRACE_SCOPE("bake place");
+    Parallel_Bake_Worker *worker = (Parallel_Bake_Worker*)param;
+    Parallel_Bake *bake = worker->bake;
+    int32_t atlas_slice_size = bake->atlas_w*bake->atlas_h*3;
+    for (;;){
+        int32_t first = bake_atomic_add(&bake->next_chunk, 1)*bake->chunk_size;
+        if (first >= bake->glyph_count){
+            break;
+        }
+        int32_t one_past_last = first + bake->chunk_size;
+        if (one_past_last > bake->glyph_count){
+            one_past_last = bake->glyph_count;
+        }
+        for (int32_t i = first; i < one_past_last; i += 1){
+            Parallel_Bake_Glyph *glyph = &bake->glyphs[i];
+            if (glyph->rasterized){
+                Glyph_Bitmap bitmap = glyph->bitmap;
+                bitmap.rgb = bake->workers[glyph->worker].storage + glyph->offset;
+                Atlas_Slot slot = glyph->slot;
+                uint8_t *out = bake->atlas + atlas_slice_size*slot.slice + 3*slot.x + 3*bake->atlas_w*slot.y;
+                glyph_bitmap_copy(&bitmap, bitmap.w, bitmap.h, out, 3*bake->atlas_w);
+                if (bake->placed != 0){
+                    bake->placed(bake->placed_user, i, &bitmap, slot);
+                }
+            }
+        }
+    }
+}
+
+void
+parallel_bake__run(Parallel_Bake *bake, Bake_Thread_Proc *proc){
+    bake->next_chunk = 0;
+    Bake_Thread *threads = (Bake_Thread*)malloc(sizeof(Bake_Thread)*bake->worker_count);
+    for (int32_t i = 1; i < bake->worker_count; i += 1){
+        bake_thread_start(&threads[i], proc, &bake->workers[i]);
+    }
+    // The calling thread is worker zero.
+    proc(&bake->workers[0]);
+    for (int32_t i = 1; i < bake->worker_count; i += 1){
+        bake_thread_join(&threads[i]);
+    }
+    free(threads);
+}
+
+// Bakes every glyph with one worker per rasterizer. Returns the atlas as atlas_c slices of the packer's
+// slice size, which the caller frees. placed is called from the workers once for every glyph that
+// rasterized and fit in a slice, with its final slot.
+uint8_t*
+parallel_bake_atlas(Glyph_Rasterizer *rasterizers, int32_t worker_count, Atlas_Packer *packer,
+                    Bake_Glyph_Placed_Function *placed, void *placed_user, int32_t *atlas_c_out){
+    assert(worker_count >= 1);
+    Parallel_Bake bake = {0};
+    bake.glyph_count = rasterizers[0].glyph_count;
+    bake.chunk_size = 32;
+    bake.glyphs = (Parallel_Bake_Glyph*)malloc(sizeof(Parallel_Bake_Glyph)*bake.glyph_count);
+    memset(bake.glyphs, 0, sizeof(Parallel_Bake_Glyph)*bake.glyph_count);
+    bake.worker_count = worker_count;
+    bake.workers = (Parallel_Bake_Worker*)malloc(sizeof(Parallel_Bake_Worker)*worker_count);
+    memset(bake.workers, 0, sizeof(Parallel_Bake_Worker)*worker_count);
+    for (int32_t i = 0; i < worker_count; i += 1){
+        bake.workers[i].bake = &bake;
+        bake.workers[i].index = i;
+        bake.workers[i].rasterizer = &rasterizers[i];
+    }
+    bake.placed = placed;
+    bake.placed_user = placed_user;
+    
+    // Rasterize
+    parallel_bake__run(&bake, parallel_bake__rasterize_proc);
+    
+    // Pack
+    {
+        TRACE_SCOPE("bake pack");
+        for (int32_t i = 0; i < bake.glyph_count; i += 1){
+            Parallel_Bake_Glyph *glyph = &bake.glyphs[i];
+            if (glyph->rasterized){
+                // A box bigger than a slice can never be packed. The glyph is left empty, like
+                // whitespace, rather than placed over another glyph at the corner of a slice.
+                if (!atlas_packer_pack(packer, glyph->bitmap.w, glyph->bitmap.h, &glyph->slot)){
+                    glyph->rasterized = false;
+                }
+            }
+        }
+    }
+    
+    // Place
+    bake.atlas_w = packer->slice_w;
+    bake.atlas_h = packer->slice_h;
+    int32_t atlas_c = packer->slice_count;
+    uint64_t atlas_size = (uint64_t)bake.atlas_w*bake.atlas_h*3*atlas_c;
+    bake.atlas = (uint8_t*)malloc((size_t)atlas_size);
+    memset(bake.atlas, 0, (size_t)atlas_size);
+    parallel_bake__run(&bake, parallel_bake__place_proc);
+    
+    for (int32_t i = 0; i < worker_count; i += 1){
+        free(bake.workers[i].storage);
+    }
+    free(bake.workers);
+    free(bake.glyphs);
+    
+    *atlas_c_out = atlas_c;
+    return(bake.atlas);
+}
+
+#endif
@@ -0,0 +1,238 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the multi-threaded atlas bake
+// usage: parallel_bake_test [seed]
+// Random fonts from a stub rasterizer whose glyphs have random boxes: some empty, some that fail to
+// rasterize, some too big for a slice. Every glyph that rasterized and fits is placed exactly once,
+// inside a slice and apart from every other glyph, and its texels are in the atlas where its slot
+// says. Glyphs too big for a slice are never placed and write nothing. Every worker count gives the
+// same atlas and slots as one worker.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_parallel_bake.h"
+#include "example_test.h"
+
+static int32_t test_font_count = 60;
+static int32_t test_worker_max = 4;
+
+struct Test_Glyph_Box{
+    int32_t w;
+    int32_t h;
+    bool32 fails;
+};
+
+// One per worker, the scratch is only valid until the next call like a real backend's.
+struct Test_Stub_Backend{
+    Test_Glyph_Box *boxes;
+    uint8_t *scratch;
+};
+
+uint8_t
+test_texel(int32_t glyph, int32_t x, int32_t y, int32_t c){
+    // Never zero, so the empty atlas shows every texel that was written
+    return((uint8_t)((glyph*31 + x*7 + y*13 + c*101)%255 + 1));
+}
+
+bool32
+test_rasterize_glyph(void *backend, uint16_t glyph_index, float shift_x, Glyph_Bitmap *bitmap){
+    Test_Stub_Backend *stub = (Test_Stub_Backend*)backend;
+    Test_Glyph_Box box = stub->boxes[glyph_index];
+    memset(bitmap, 0, sizeof(*bitmap));
+    if (box.fails){
+        return(false);
+    }
+    bitmap->w = box.w;
+    bitmap->h = box.h;
+    bitmap->pitch = 3*box.w + 5;
+    bitmap->rgb = stub->scratch;
+    for (int32_t y = 0; y < box.h; y += 1){
+        for (int32_t x = 0; x < box.w; x += 1){
+            for (int32_t c = 0; c < 3; c += 1){
+                stub->scratch[y*bitmap->pitch + 3*x + c] = test_texel(glyph_index, x, y, c);
+            }
+        }
+    }
+    return(true);
+}
+
+struct Test_Placements{
+    Atlas_Slot *slots;
+    int32_t *counts;
+};
+
+// Each glyph is placed by one worker, so the counts need no atomics.
+void
+test_placed(void *user, int32_t glyph_index, Glyph_Bitmap *bitmap, Atlas_Slot slot){
+    Test_Placements *placements = (Test_Placements*)user;
+    placements->slots[glyph_index] = slot;
+    placements->counts[glyph_index] += 1;
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0xBA4Eu);
+    uint32_t state = seed;
+    
+    int32_t total_glyphs = 0;
+    int32_t total_oversized = 0;
+    for (int32_t font = 0; font < test_font_count; font += 1){
+        int64_t failures_before = test_state.failures;
+        int32_t slice_side = test_random_range(&state, 16, 128);
+        int32_t padding = test_random_range(&state, 0, 2);
+        int32_t glyph_count = test_random_range(&state, 1, 400);
+        int32_t box_max = slice_side + 8;
+        Test_Glyph_Box *boxes = (Test_Glyph_Box*)malloc(sizeof(Test_Glyph_Box)*glyph_count);
+        int32_t expected_placed = 0;
+        for (int32_t i = 0; i < glyph_count; i += 1){
+            Test_Glyph_Box *box = &boxes[i];
+            int32_t kind = test_random_range(&state, 0, 19);
+            box->fails = (kind == 0);
+            if (kind == 1){
+                box->w = test_random_range(&state, 0, 1);
+                box->h = 1 - box->w;
+            }
+            else if (kind == 2){
+                // Past the slice in one direction or both, or only once padded
+                box->w = test_random_range(&state, slice_side - padding, box_max);
+                box->h = test_random_range(&state, 1, box_max);
+            }
+            else{
+                box->w = test_random_range(&state, 1, slice_side/3);
+                box->h = test_random_range(&state, 1, slice_side/3);
+            }
+            bool32 fits = (box->w + padding <= slice_side && box->h + padding <= slice_side);
+            if (!box->fails && box->w > 0 && box->h > 0){
+                if (fits){
+                    expected_placed += 1;
+                }
+                else{
+                    total_oversized += 1;
+                }
+            }
+        }
+        
+        Test_Stub_Backend stubs[8];
+        Glyph_Rasterizer rasterizers[8];
+        for (int32_t i = 0; i < test_worker_max; i += 1){
+            stubs[i].boxes = boxes;
+            stubs[i].scratch = (uint8_t*)malloc((size_t)(3*box_max + 5)*box_max);
+            memset(&rasterizers[i], 0, sizeof(rasterizers[i]));
+            rasterizers[i].backend = &stubs[i];
+            rasterizers[i].rasterize_glyph = test_rasterize_glyph;
+            rasterizers[i].glyph_count = glyph_count;
+        }
+        
+        uint8_t *reference_atlas = 0;
+        Atlas_Slot *reference_slots = (Atlas_Slot*)malloc(sizeof(Atlas_Slot)*glyph_count);
+        int32_t reference_atlas_c = 0;
+        Test_Placements placements = {0};
+        placements.slots = (Atlas_Slot*)malloc(sizeof(Atlas_Slot)*glyph_count);
+        placements.counts = (int32_t*)malloc(sizeof(int32_t)*glyph_count);
+        for (int32_t worker_count = 1; worker_count <= test_worker_max; worker_count += 1){
+            memset(placements.slots, 0, sizeof(Atlas_Slot)*glyph_count);
+            memset(placements.counts, 0, sizeof(int32_t)*glyph_count);
+            Atlas_Packer packer = atlas_packer_init(slice_side, slice_side, padding);
+            int32_t atlas_c = 0;
+            uint8_t *atlas = parallel_bake_atlas(rasterizers, worker_count, &packer, test_placed, &placements, &atlas_c);
+            atlas_packer_free(&packer);
+            uint64_t slice_size = 3*(uint64_t)slice_side*slice_side;
+            
+            int32_t placed = 0;
+            uint64_t written = 0;
+            for (int32_t i = 0; i < glyph_count; i += 1){
+                Test_Glyph_Box box = boxes[i];
+                bool32 fits = (box.w + padding <= slice_side && box.h + padding <= slice_side);
+                bool32 expected = (!box.fails && box.w > 0 && box.h > 0 && fits);
+                if (!TEST_CHECK(placements.counts[i] == (expected?1:0))){
+                    printf("    glyph %d: %dx%d placed %d times\n", i, box.w, box.h, placements.counts[i]);
+                    continue;
+                }
+                if (!expected){
+                    continue;
+                }
+                placed += 1;
+                written += 3*(uint64_t)box.w*box.h;
+                Atlas_Slot slot = placements.slots[i];
+                if (!TEST_CHECK(slot.w == box.w && slot.h == box.h && 0 <= slot.slice && slot.slice < atlas_c &&
+                                0 <= slot.x && slot.x + slot.w <= slice_side &&
+                                0 <= slot.y && slot.y + slot.h <= slice_side)){
+                    continue;
+                }
+                bool32 same = true;
+                for (int32_t y = 0; y < box.h; y += 1){
+                    uint8_t *row = atlas + slice_size*slot.slice + 3*((uint64_t)(slot.y + y)*slice_side + slot.x);
+                    for (int32_t x = 0; x < box.w; x += 1){
+                        for (int32_t c = 0; c < 3; c += 1){
+                            same = same && (row[3*x + c] == test_texel(i, x, y, c));
+                        }
+                    }
+                }
+                TEST_CHECK(same);
+                for (int32_t j = 0; j < i; j += 1){
+                    Atlas_Slot other = placements.slots[j];
+                    if (placements.counts[j] == 1 && other.w > 0 && other.slice == slot.slice){
+                        bool32 apart = (other.x + other.w <= slot.x || slot.x + slot.w <= other.x ||
+                                        other.y + other.h <= slot.y || slot.y + slot.h <= other.y);
+                        TEST_CHECK(apart);
+                    }
+                }
+            }
+            TEST_CHECK(placed == expected_placed);
+            
+            // Texels nobody placed stay zero, so nothing else was written.
+            uint64_t nonzero = 0;
+            for (uint64_t t = 0; t < slice_size*atlas_c; t += 1){
+                nonzero += (atlas[t] != 0);
+            }
+            TEST_CHECK(nonzero == written);
+            
+            if (reference_atlas == 0){
+                reference_atlas = atlas;
+                reference_atlas_c = atlas_c;
+                memcpy(reference_slots, placements.slots, sizeof(Atlas_Slot)*glyph_count);
+            }
+            else{
+                TEST_CHECK(atlas_c == reference_atlas_c);
+                if (atlas_c == reference_atlas_c){
+                    TEST_CHECK(memcmp(atlas, reference_atlas, (size_t)(slice_size*atlas_c)) == 0);
+                }
+                TEST_CHECK(memcmp(placements.slots, reference_slots, sizeof(Atlas_Slot)*glyph_count) == 0);
+                free(atlas);
+            }
+        }
+        if (test_state.failures != failures_before){
+            printf("    font %d: %d glyphs, %dx%d slices, padding %d\n", font, glyph_count, slice_side, slice_side, padding);
+        }
+        total_glyphs += glyph_count;
+        
+        free(placements.counts);
+        free(placements.slots);
+        free(reference_slots);
+        free(reference_atlas);
+        for (int32_t i = 0; i < test_worker_max; i += 1){
+            free(stubs[i].scratch);
+        }
+        free(boxes);
+    }
+    
+    printf("parallel_bake_test: %d glyphs baked with up to %d workers, %d too big for a slice left empty\n",
+           total_glyphs, test_worker_max, total_oversized);
+    return(test_finish("parallel_bake_test", seed));
+}
@@ -21,14 +21,40 @@
 #include <dwrite_1.h>
 #include <assert.h>
 #include <malloc.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 typedef int32_t bool32;
 
 #include "example_gl_defines.h"
+#include "example_arena.h"
+#include "example_atlas_packer.h"
+#include "example_glyph_cache.h"
+#include "example_font_cache_file.h"
+#include "example_glyph_rasterizer.h"
+#include "example_software_rasterizer.h"
+#include "example_dwrite_rasterizer.h"
+#include "example_parallel_bake.h"
+#include "example_codepoint_map.h"
+#include "example_utf8.h"
+#include "example_text_batch.h"
+#include "example_atlas_levels.h"
+#include "example_vertex_ring.h"
+#include "example_atlas_dirty.h"
+#include "example_render_commands.h"
+#include "example_layout_cache.h"
+#include "example_test_scene.h"
+#include "example_software_font.h"
+#include "example_font_registry.h"
+#include "example_trace.h"
 
 HWND
 window_setup(HINSTANCE hInstance);
 
+float
+window_initial_dpi(HWND wnd);
+
 ////////////////////////////////
 
 static int32_t window_width = 800;
@@ -40,6 +66,73 @@ static float point_size = 12.f;
 // until you're ready for a whole separate nightmare.
 static float dpi = 96.f;
 
+// + and - zoom by zoom_step points, 0 goes back to point_size. Sizes other than the one the font was
+// set up at come from a registry of zoom_font_sizes bakes made in the background with the same
+// rasterizer backend, see example_font_registry.h. Until a new size is in the frames keep the size
+// they had. The process makes itself per monitor DPI aware at startup, so the window starts out at
+// its monitor's DPI and gets WM_DPICHANGED when it moves to another one, both go through the
+// registry the same way.
+static float zoom_step = 2.f;
+static float zoom_min_point_size = 6.f;
+static float zoom_max_point_size = 72.f;
+static int32_t zoom_font_sizes = 4;
+
+// When set glyphs are rasterized the first time they are drawn into a fixed size atlas that evicts
+// the least recently used glyphs. Otherwise every glyph in the font is baked before the first frame.
+// The texture has one more slice than the cache, for glyphs that do not fit a cell.
+static bool32 bake_on_demand = true;
+static int32_t glyph_cache_atlas_side = 512;
+static int32_t glyph_cache_atlas_slices = 2;
+// Glyphs baked on demand get this many variants, one per fraction of a pixel the pen can land on,
+// from 1 to SUBPIXEL_PHASE_MAX. The bake everything path draws every glyph at phase zero.
+static int32_t subpixel_phase_count = 3;
+// Glyphs baked on demand reach the texture once a frame as dirty rectangles. Two rectangles are
+// uploaded as one if that sends at most this many texels extra.
+static int32_t atlas_merge_slack = 1024;
+// Stage the uploads through a pixel unpack ring so the copy never waits on a draw still reading the
+// atlas. Otherwise they go straight from the CPU copy of the atlas.
+static bool32 atlas_upload_through_ring = true;
+static uint64_t atlas_ring_size = 256 << 10;
+// Writes the glyphs, rectangles and texels uploaded to the debugger output every frame they change.
+static bool32 report_atlas_upload_stats = false;
+
+// The bake everything path saves its result here and maps it back in on the next launch.
+static char baked_font_cache_path[] = "baked_font.cache";
+
+// Rasterize with the portable glyf outline rasterizer instead of DirectWrite.
+static bool32 use_software_rasterizer = false;
+
+// Worker threads for the bake everything path, zero for one per core.
+static int32_t bake_thread_count = 0;
+
+// Glyph instances stream through a ring of this size, it only grows if one frame needs more.
+static uint64_t text_ring_size = 1 << 20;
+// Writes the ring's bytes, wraps and stalls avoided to the debugger output every frame.
+static bool32 report_text_ring_stats = false;
+
+// Scratch for everything that lives no longer than a frame, reset at the top of each frame.
+static uint64_t frame_arena_size = 4 << 20;
+
+// Appends every frame's render commands to this file, see example_render_commands.h. headless
+// -replay runs them against its own software bake of the font, so the glyphs only land where they
+// should in captures made with use_software_rasterizer set and bake_on_demand off.
+static bool32 capture_render_commands = false;
+static char render_capture_path[] = "frames.rcmd";
+
+// Laid out strings kept from frame to frame, strings longer than the limits are laid out every time.
+static int32_t layout_cache_entry_count = 256;
+static int32_t layout_cache_text_max = 256;
+static int32_t layout_cache_glyph_max = 256;
+
+#if TRACE_ENABLED
+// Built with TRACE_ENABLED, the trace of startup and the first trace_dump_frame frames is written
+// once that frame is done: Chrome trace events to trace_json_path and the per phase summary to
+// trace_summary_path. See example_trace.h.
+static uint64_t trace_dump_frame = 60;
+static char trace_json_path[] = "trace.json";
+static char trace_summary_path[] = "trace_summary.txt";
+#endif
+
 ////////////////////////////////
 
 struct AutoReleaserClass{
@@ -54,67 +147,118 @@ struct AutoReleaserClass{
     }
 };
 #define DeferRelease(ptr) AutoReleaserClass ptr##_releaser(ptr)
-#define DWCheck(error,r)        if ((error) != S_OK){ error = S_OK; r; }
-#define DWCheckPtr(error,ptr,r) if ((ptr) == 0 || (error) != S_OK){ error = S_OK; r; }
 
 // Font Data Structure
 
-struct Glyph_Metrics{
-    float off_x;
-    float off_y;
-    float advance;
-    float xy_w;
-    float xy_h;
-    float uv_w;
-    float uv_h;
-};
-
 struct Baked_Font{
     IDWriteFontFace *face;
     GLuint texture;
+    float pixel_per_em;
     Glyph_Metrics *metrics;
     int32_t glyph_count;
+    Codepoint_Map *codepoints;
+    // Advance of every glyph, instance templates of the ones that draw
+    Text_Glyph_Table *glyphs;
+    
+    // Only set when glyphs are baked on demand
+    Glyph_Cache *cache;
+    Glyph_Rasterizer rasterizer;
+    int32_t atlas_w;
+    int32_t atlas_h;
+    // Room for a cell, grown for oversize glyphs
+    uint8_t *cell_memory;
+    uint16_t *cell_levels;
+    int32_t cell_memory_texels;
+    Atlas_Dirty *dirty;
+    // Glyphs bigger than a cell go into one extra slice after the cache's, packed as they come.
+    // Each variant's place there is kept for good, a variant with one never takes room again.
+    Atlas_Packer *oversize;
+    Atlas_Slot *oversize_slots;
+    int32_t oversize_slice;
+    // Glyphs that found the extra slice full and were clipped to their cell
+    int32_t oversize_clipped;
 };
 
 ////////////////////////////////
 
+// The quad of each glyph instance is expanded from gl_VertexID, six vertices per instance:
+// top left, bottom left, top right, bottom left, top right, bottom right. uv is in atlas texels.
 static char vert_source[] =
 "#version 330\n"
 "uniform mat3 pixel_to_normal;\n"
-"in vec2 position;\n"
-"in vec3 tex_position;\n"
+"uniform vec4 styles[3*64];\n"
+"in ivec2 box_position;\n"
+"in uvec2 atlas_position;\n"
+"in uvec4 box_size_slice;\n"
+"in uint style;\n"
 "smooth out vec3 uv;\n"
+"flat out vec3 fore_color;\n"
+"flat out vec4 fore_M_lo;\n"
+"flat out vec2 fore_M_hi;\n"
 "void main(){\n"
+"    vec2 corner = vec2((gl_VertexID == 2 || gl_VertexID >= 4)?1.f:0.f,\n"
+"                       (gl_VertexID == 1 || gl_VertexID == 3 || gl_VertexID == 5)?1.f:0.f);\n"
+"    vec2 size = vec2(box_size_slice.xy);\n"
+"    vec2 position = vec2(box_position) + corner*size;\n"
 "    gl_Position.xy = (pixel_to_normal*vec3(position, 1.f)).xy;\n"
 "    gl_Position.z = 0.f;\n"
 "    gl_Position.w = 1.f;\n"
-"    uv = tex_position;\n"
+"    uv = vec3(vec2(atlas_position) + corner*size, float(box_size_slice.z));\n"
+"    vec4 s0 = styles[3*int(style) + 0];\n"
+"    vec4 s1 = styles[3*int(style) + 1];\n"
+"    vec4 s2 = styles[3*int(style) + 2];\n"
+"    fore_color = s0.rgb;\n"
+"    fore_M_lo = vec4(s0.a, s1.xyz);\n"
+"    fore_M_hi = vec2(s1.w, s2.x);\n"
 "}\n";
 
+// Dual source blend: the first output is the premultiplied foreground, the second is the per
+// channel coverage the blend uses to weight the background. The atlas holds packed coverage levels,
+// see example_atlas_levels.h.
 static char frag_source[] = 
 "#version 330\n"
 "smooth in vec3 uv;\n"
-"uniform sampler2DArray tex;\n"
-"uniform float M_value_table[7];\n"
-"layout(location = 0) out vec4 mask;\n"
+"flat in vec3 fore_color;\n"
+"flat in vec4 fore_M_lo;\n"
+"flat in vec2 fore_M_hi;\n"
+"uniform usampler2DArray tex;\n"
+"layout(location = 0, index = 0) out vec4 color;\n"
+"layout(location = 0, index = 1) out vec4 mask;\n"
 "\n"
 "void main(){\n"
-"vec3 S = texture(tex, uv).rgb;\n"
-"int C0 = int(S.r*6 + 0.1); // + 0.1 just incase we have some small rounding taking us below the integer we should be hitting.\n"
-"int C1 = int(S.g*6 + 0.1);\n"
-"int C2 = int(S.b*6 + 0.1);\n"
+"float M_value_table[7] = float[7](0.f, fore_M_lo.x, fore_M_lo.y, fore_M_lo.z, fore_M_lo.w, fore_M_hi.x, fore_M_hi.y);\n"
+"uint S = texelFetch(tex, ivec3(uv), 0).r;\n"
+"int C0 = int(S & 7u);\n"
+"int C1 = int((S >> 3) & 7u);\n"
+"int C2 = int((S >> 6) & 7u);\n"
 "mask.rgb = vec3(M_value_table[C0],\n"
 "M_value_table[C1],\n"
 "M_value_table[C2]);\n"
 "mask.a = 1;\n"
+"color.rgb = fore_color*mask.rgb;\n"
+"color.a = 1;\n"
 "}\n";
 
 static GLuint uniform_pixel_to_normal;
 static GLuint uniform_tex;
-static GLuint uniform_M_value_table;
+static GLuint uniform_styles;
+
+static GLuint attrib_box_position;
+static GLuint attrib_atlas_position;
+static GLuint attrib_box_size_slice;
+static GLuint attrib_style;
 
-static GLuint attrib_position;
-static GLuint attrib_tex_position;
+// Set by window_proc, read once a frame.
+static float window_dpi = 0.f;
+
+// Collects every string of the frame, flushed once before the frame is presented.
+static Text_Batch text_batch;
+static Render_Stream frame_stream;
+static Vertex_Ring text_ring;
+static Vertex_Ring atlas_ring;
+static GLuint atlas_ring_buffer;
+static Arena frame_arena;
+static Layout_Cache layout_cache;
 
 ////////////////////////////////
 
@@ -144,138 +288,545 @@ round_up(float x){
     return(r);
 }
 
+// Glyph Baking
+// The DirectWrite backend is in example_dwrite_rasterizer.h.
+
+// Zoomed Sizes
+// The registry's bakes run on their own threads, every worker gets a baker with its own target.
+
+struct DWrite_Zoom_Source{
+    IDWriteGdiInterop *interop;
+    IDWriteFontFace *face;
+    IDWriteRenderingParams *rendering_params;
+    int32_t glyph_count;
+    float design_units_per_em;
+    float cap_height;
+};
+
 void
-draw_string(Baked_Font font, char *text, int32_t x, int32_t y, float r, float g, float b, float a){
-    // Get Index Array
-    int32_t length = 0;
-    for (; text[length] != 0; length += 1);
-    uint16_t *indices = (uint16_t*)malloc(sizeof(uint16_t)*length);
+dwrite_zoom_rasterizers_init(void *user, float pixel_per_em, Glyph_Rasterizer *rasterizers, int32_t worker_count){
+    DWrite_Zoom_Source *source = (DWrite_Zoom_Source*)user;
+    float pixel_per_design_unit = pixel_per_em/source->design_units_per_em;
+    int32_t target_side = (int32_t)(8.f*source->cap_height*pixel_per_design_unit);
+    DWrite_Glyph_Baker *bakers = (DWrite_Glyph_Baker*)malloc(sizeof(DWrite_Glyph_Baker)*worker_count);
+    for (int32_t i = 0; i < worker_count; i += 1){
+        bool32 created = dwrite_glyph_baker_init(&bakers[i], source->interop, source->face, source->rendering_params,
+                                                 target_side, target_side, pixel_per_em, pixel_per_design_unit);
+        assert(created);
+        rasterizers[i].backend = &bakers[i];
+        rasterizers[i].rasterize_glyph = dwrite_rasterize_glyph;
+        rasterizers[i].glyph_advances = dwrite_glyph_advances;
+        rasterizers[i].glyph_count = source->glyph_count;
+        rasterizers[i].pixel_per_em = pixel_per_em;
+    }
+}
+
+void
+dwrite_zoom_rasterizers_free(void *user, Glyph_Rasterizer *rasterizers, int32_t worker_count){
+    for (int32_t i = 0; i < worker_count; i += 1){
+        dwrite_glyph_baker_free((DWrite_Glyph_Baker*)rasterizers[i].backend);
+    }
+    free(rasterizers[0].backend);
+}
+
+// The texture of each registry slot, uploaded again when the slot holds a new size. The storage is
+// only made again when the atlas of the new size has another shape.
+struct Zoom_Texture{
+    GLuint texture;
+    float pixel_per_em;
+    int32_t atlas_side;
+    int32_t slice_count;
+};
+
+// The packed levels of a size on their way to its texture. Kept from upload to upload and only
+// grown, through heap_realloc so the frame's allocation count shows it.
+struct Zoom_Staging{
+    uint16_t *levels;
+    int64_t texel_max;
+};
+
+GLuint
+zoom_font_texture(Zoom_Texture *textures, Zoom_Staging *staging, Font_Registry *registry, Software_Font *font){
+    Zoom_Texture *zoom_texture = &textures[font_registry_slot(registry, font)];
+    if (zoom_texture->texture == 0 || zoom_texture->pixel_per_em != font->pixel_per_em){
+        TRACE_SCOPE("zoom upload");
+        if (zoom_texture->texture == 0){
+            glGenTextures(1, &zoom_texture->texture);
+        }
+        int64_t texel_count = (int64_t)font->atlas_side*font->atlas_side*font->slice_count;
+        if (texel_count > staging->texel_max){
+            uint16_t *levels = (uint16_t*)heap_realloc(staging->levels, sizeof(uint16_t)*texel_count);
+            if (levels == 0){
+                // Keeps drawing with the base size.
+                return(0);
+            }
+            staging->levels = levels;
+            staging->texel_max = texel_count;
+        }
+        atlas_levels_pack(font->atlas, staging->levels, texel_count);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, zoom_texture->texture);
+        if (zoom_texture->atlas_side == font->atlas_side && zoom_texture->slice_count == font->slice_count){
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, font->atlas_side, font->atlas_side, font->slice_count, GL_RED_INTEGER, GL_UNSIGNED_SHORT, staging->levels);
+        }
+        else{
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16UI, font->atlas_side, font->atlas_side, font->slice_count, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, staging->levels);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            zoom_texture->atlas_side = font->atlas_side;
+            zoom_texture->slice_count = font->slice_count;
+        }
+        zoom_texture->pixel_per_em = font->pixel_per_em;
+    }
+    return(zoom_texture->texture);
+}
+
+// A registry bake drawn like a font baked at startup, every glyph is in its atlas.
+Baked_Font
+zoom_baked_font(Baked_Font *base, Software_Font *font, GLuint texture){
+    Baked_Font result = {0};
+    result.face = base->face;
+    result.texture = texture;
+    result.pixel_per_em = font->pixel_per_em;
+    result.metrics = font->metrics;
+    result.glyph_count = font->glyph_count;
+    result.codepoints = font->map;
+    result.glyphs = &font->glyphs;
+    result.atlas_w = font->atlas_side;
+    result.atlas_h = font->atlas_side;
+    return(result);
+}
+
+// Allocates the metric data for every glyph with the advances filled in. The boxes come from
+// rasterizing each glyph.
+Glyph_Metrics*
+alloc_glyph_metrics(Glyph_Rasterizer *rasterizer){
+    int32_t glyph_count = rasterizer->glyph_count;
+    Glyph_Metrics *metrics = (Glyph_Metrics*)malloc(sizeof(Glyph_Metrics)*glyph_count);
+    memset(metrics, 0, sizeof(Glyph_Metrics)*glyph_count);
+    float *advances = (float*)malloc(sizeof(float)*glyph_count);
+    rasterizer->glyph_advances(rasterizer->backend, advances, glyph_count);
+    for (int32_t i = 0; i < glyph_count; i += 1){
+        metrics[i].advance = advances[i];
+    }
+    free(advances);
+    return(metrics);
+}
+
+void
+fill_glyph_metrics(Glyph_Bitmap *bitmap, int32_t tex_w, int32_t tex_h, Atlas_Slot slot, int32_t atlas_w, int32_t atlas_h, Glyph_Metrics *metrics){
+    metrics->off_x    = (float)bitmap->off_x;
+    metrics->off_y    = (float)bitmap->off_y;
+    metrics->advance  = bitmap->advance;
+    metrics->xy_w     = (float)tex_w;
+    metrics->xy_h     = (float)tex_h;
+    metrics->uv_w     = (float)tex_w/(float)atlas_w;
+    metrics->uv_h     = (float)tex_h/(float)atlas_h;
+    metrics->uv_x     = (float)slot.x/(float)atlas_w;
+    metrics->uv_y     = (float)slot.y/(float)atlas_h;
+    metrics->uv_slice = (float)slot.slice;
+}
+
+// Called from the bake workers once a glyph has its final place in the atlas.
+void
+bake_glyph_placed(void *user, int32_t glyph_index, Glyph_Bitmap *bitmap, Atlas_Slot slot){
+    Baked_Font *font = (Baked_Font*)user;
+    fill_glyph_metrics(bitmap, bitmap->w, bitmap->h, slot, font->atlas_w, font->atlas_h, &font->metrics[glyph_index]);
+}
+
+// The scratch a glyph's texels are packed in on their way to the atlas only grows. Both buffers
+// keep what they had when growing one of them fails.
+bool32
+bake_glyph__reserve_cell_memory(Baked_Font *font, int32_t texel_count){
+    if (texel_count <= font->cell_memory_texels){
+        return(true);
+    }
+    uint8_t *memory = (uint8_t*)heap_realloc(font->cell_memory, (size_t)texel_count*3);
+    if (memory != 0){
+        font->cell_memory = memory;
+    }
+    uint16_t *levels = (uint16_t*)heap_realloc(font->cell_levels, (size_t)texel_count*sizeof(uint16_t));
+    if (levels != 0){
+        font->cell_levels = levels;
+    }
+    if (memory == 0 || levels == 0){
+        return(false);
+    }
+    font->cell_memory_texels = texel_count;
+    return(true);
+}
+
+// Rasterizes a glyph variant into the cell the glyph cache gave it and marks what it wrote for the
+// next upload. A variant with nothing to draw gives its cell back and is never looked up in the
+// cache again, nor is one whose texels find no scratch memory. A variant too big for the cell is
+// packed into the oversize slice instead, its cell only keeps it in the cache's LRU order.
+void
+bake_glyph_on_demand__place(Baked_Font *font, int32_t variant, Atlas_Slot slot){
+    if (font->oversize_slots[variant].w > 0){
+        // Evicted from its cell and back, what it drew in the oversize slice is still there.
+        return;
+    }
+    Glyph_Rasterizer *rasterizer = &font->rasterizer;
+    int32_t phase_count = font->glyphs->phase_count;
+    uint16_t glyph_index = (uint16_t)(variant/phase_count);
+    float shift_x = subpixel_phase_shift(variant%phase_count, phase_count);
+    // The box differs from phase to phase, only the advance is shared.
+    Glyph_Metrics metrics = font->metrics[glyph_index];
     
-    for (int32_t i = 0; i < length; i += 1){
-        uint32_t codepoint = (uint32_t)text[i];
-        font.face->GetGlyphIndices(&codepoint, 1, &indices[i]);
+    Glyph_Bitmap bitmap = {0};
+    bool32 drawn = (rasterizer->rasterize_glyph(rasterizer->backend, glyph_index, shift_x, &bitmap) && bitmap.w > 0 && bitmap.h > 0);
+    if (drawn && (bitmap.w > slot.w || bitmap.h > slot.h)){
+        // The packer opens a second slice when the first is full, which the texture does not have.
+        Atlas_Slot packed = {0};
+        if (font->oversize->slice_count == 1 && atlas_packer_pack(font->oversize, bitmap.w, bitmap.h, &packed) && packed.slice == 0){
+            packed.slice = font->oversize_slice;
+            font->oversize_slots[variant] = packed;
+            slot = packed;
+        }
+        else{
+            font->oversize_clipped += 1;
+        }
     }
     
-    // Fill Vertices
-    int32_t float_per_vertex = 5;
-    int32_t byte_per_vertex = float_per_vertex*sizeof(float);
-    int32_t vertex_per_character = 6;
-    int32_t total_float_count = length*vertex_per_character*float_per_vertex;
-    float *vertices = (float*)malloc(sizeof(float)*total_float_count);
+    // Anything that still spills past the slot is clipped away.
+    int32_t tex_w = (bitmap.w < slot.w)?bitmap.w:slot.w;
+    int32_t tex_h = (bitmap.h < slot.h)?bitmap.h:slot.h;
+    if (drawn && !bake_glyph__reserve_cell_memory(font, tex_w*tex_h)){
+        drawn = false;
+    }
+    if (!drawn){
+        metrics.xy_w = 0.f;
+        metrics.xy_h = 0.f;
+        text_glyph_table_set(font->glyphs, variant, &metrics, font->atlas_w, font->atlas_h);
+        glyph_cache_release(font->cache, variant);
+        return;
+    }
     
-    {
-        float layout_x = (float)x;
-        float layout_y = (float)y;
-        
-        float *vertex = vertices;
+    fill_glyph_metrics(&bitmap, tex_w, tex_h, slot, font->atlas_w, font->atlas_h, &metrics);
+    if (!text_glyph_table_set(font->glyphs, variant, &metrics, font->atlas_w, font->atlas_h)){
+        // Every dense index belongs to a live variant, this one draws nothing until one frees up.
+        glyph_cache_release(font->cache, variant);
+        return;
+    }
+    if (tex_w > 0 && tex_h > 0){
+        glyph_bitmap_copy(&bitmap, tex_w, tex_h, font->cell_memory, tex_w*3);
+        atlas_levels_pack(font->cell_memory, font->cell_levels, tex_w*tex_h);
+        atlas_dirty_write(font->dirty, slot.slice, slot.x, slot.y, tex_w, tex_h, font->cell_levels, tex_w);
+    }
+}
+
+// Handles a miss of the glyph cache. The variant the miss evicted is released from the glyph table,
+// unless it lives on in the oversize slice. When baking hands a released dense index to the new
+// variant, cached runs may still hold the index for the old one and are dropped.
+void
+bake_glyph_on_demand(Baked_Font *font, int32_t variant, Atlas_Slot slot){
+    TRACE_SCOPE("bake glyph on demand");
+    int32_t evicted = font->cache->last_evicted;
+    if (evicted >= 0 && font->oversize_slots[evicted].w == 0){
+        text_glyph_table_release(font->glyphs, evicted);
+    }
+    uint64_t reassignments = font->glyphs->reassignments;
+    bake_glyph_on_demand__place(font, variant, slot);
+    if (font->glyphs->reassignments != reassignments){
+        layout_cache_clear(&layout_cache);
+    }
+}
+
+// With glyphs baked on demand a cached run is only good if every glyph variant in it still has a
+// cell this frame. A variant that was evicted is baked again and keeps its dense index, so the run
+// stays valid unless the cache is full or a bake hands a dense index of the run to another variant.
+bool32
+touch_layout_run(Baked_Font *font, Layout_Run *run){
+    uint64_t reassignments = font->glyphs->reassignments;
+    for (int32_t i = 0; i < run->count && font->glyphs->reassignments == reassignments; i += 1){
+        int32_t variant = (int32_t)font->glyphs->drawable_variants[run->glyphs[i]];
+        Atlas_Slot slot = {0};
+        Glyph_Cache_Result cache_result = glyph_cache_lookup(font->cache, variant, &slot);
+        if (cache_result == GlyphCache_Miss){
+            bake_glyph_on_demand(font, variant, slot);
+        }
+        else if (cache_result == GlyphCache_Full){
+            return(false);
+        }
+    }
+    return(font->glyphs->reassignments == reassignments);
+}
+
+void
+draw_string_length(Baked_Font font, char *text, int32_t text_length, int32_t x, int32_t y, float r, float g, float b, float a){
+    TRACE_SCOPE("draw_string");
+    // Reuse the Layout
+    // The font is told apart by its texture and size, a zoomed size can reuse a texture.
+    Layout_Run run = {0};
+    if (layout_cache_lookup(&layout_cache, font.texture, font.pixel_per_em, text, text_length, x, &run) &&
+        (font.cache == 0 || touch_layout_run(&font, &run))){
+        text_batch_begin_string(&text_batch, font.texture, font.atlas_w, font.atlas_h, r, g, b, a);
+        text_batch_push_run(&text_batch, font.glyphs->templates, run.glyphs, run.pen_x, y, run.count);
+        return;
+    }
+    
+    Arena_Mark mark = arena_mark(&frame_arena);
+    
+    // Decode the UTF-8
+    // Never more codepoints than bytes
+    uint32_t *codepoints = arena_push_array(&frame_arena, uint32_t, text_length);
+    uint16_t *indices = arena_push_array(&frame_arena, uint16_t, text_length);
+    int32_t *pen_x = arena_push_array(&frame_arena, int32_t, text_length);
+    if (codepoints == 0 || indices == 0 || pen_x == 0){
+        // Out of frame scratch, frame_arena_size is too small for this frame.
+        arena_pop_to(&frame_arena, mark);
+        return;
+    }
+    int32_t length = utf8_decode((uint8_t*)text, text_length, codepoints);
+    
+    // Get Index Array
+    for (int32_t i = 0; i < length; i += 1){
+        indices[i] = codepoint_map_lookup(font.codepoints, codepoints[i]);
+    }
+    
+    // Lay Out the Visible Glyphs
+    // Glyphs that draw nothing only move the pen. The rest are compacted in place into dense
+    // template indices of the variant for the pen's subpixel phase. The pen moves in 26.6, pen_x is
+    // the whole pixel part of it.
+    Text_Glyph_Table *glyphs = font.glyphs;
+    int32_t visible_count = 0;
+    bool32 complete = true;
+    if (font.cache == 0){
+        visible_count = text_glyph_table_layout(glyphs, indices, length, x, indices, pen_x);
+    }
+    else{
+        int32_t phase_count = glyphs->phase_count;
+        int32_t pen = subpixel_from_whole_pixels(x);
         for (int32_t i = 0; i < length; i += 1){
             uint16_t index = indices[i];
             assert(index < font.glyph_count);
+            int32_t phase = 0;
+            int32_t pixel_x = subpixel_snap(pen, phase_count, &phase);
+            int32_t variant = index*phase_count + phase;
+            pen += glyphs->advances[index];
+            if (glyphs->dense[variant] == TEXT_GLYPH_EMPTY){
+                continue;
+            }
             
-            float index_f = (float)(index/4);
-            float uv_x = 0.5f*(float)((index&1));
-            float uv_y = 0.5f*(float)(((index&2) >> 1));
-            Glyph_Metrics metrics = font.metrics[index];
-            
-            for (int32_t j = 0; j < vertex_per_character; j += 1){
-                float g_x = layout_x + metrics.off_x;
-                float g_y = layout_y + metrics.off_y;
-                
-                switch (j){
-                    case 0:
-                    {
-                        vertex[0] = g_x;
-                        vertex[1] = g_y;
-                        vertex[2] = uv_x;
-                        vertex[3] = uv_y;
-                    }break;
-                    case 1:
-                    case 3:
-                    {
-                        vertex[0] = g_x;
-                        vertex[1] = g_y + metrics.xy_h;
-                        vertex[2] = uv_x;
-                        vertex[3] = uv_y + metrics.uv_h;
-                    }break;
-                    case 2:
-                    case 4:
-                    {
-                        vertex[0] = g_x + metrics.xy_w;
-                        vertex[1] = g_y;
-                        vertex[2] = uv_x + metrics.uv_w;
-                        vertex[3] = uv_y;
-                    }break;
-                    case 5:
-                    {
-                        vertex[0] = g_x + metrics.xy_w;
-                        vertex[1] = g_y + metrics.xy_h;
-                        vertex[2] = uv_x + metrics.uv_w;
-                        vertex[3] = uv_y + metrics.uv_h;
-                    }break;
-                }
-                vertex[4] = index_f;
-                vertex += float_per_vertex;
+            Atlas_Slot slot = {0};
+            Glyph_Cache_Result cache_result = glyph_cache_lookup(font.cache, variant, &slot);
+            if (cache_result == GlyphCache_Miss){
+                bake_glyph_on_demand(&font, variant, slot);
+            }
+            else if (cache_result == GlyphCache_Full){
+                // No room this frame, leave a gap and move on.
+                complete = false;
+                continue;
             }
             
-            layout_x += metrics.advance;
+            uint16_t dense = glyphs->dense[variant];
+            if (dense < TEXT_GLYPH_DENSE_MAX){
+                indices[visible_count] = dense;
+                pen_x[visible_count] = pixel_x;
+                visible_count += 1;
+            }
         }
     }
     
-    // Compute M Values
-    float V = r*0.5f + g + b*0.1875f;
-    float M_value_table[7];
-    
-    static float Cmax_table[] = {
-        0.f,
-        0.380392157f,
-        0.600000000f,
-        0.749019608f,
-        0.854901961f,
-        0.937254902f,
-        1.f,
-    };
-    static float Cmin_table[] = {
-        0.f,
-        0.166666667f,
-        0.333333333f,
-        0.500000000f,
-        0.666666667f,
-        0.833333333f,
-        1.f,
-    };
-    
-    static float A = 0.839215686374509f; // 214/255
-    static float B = 1.266666666666667f; // 323/255
-    float L = (V - A)/(B - A);
+    // Push the Glyph Instances
+    text_batch_begin_string(&text_batch, font.texture, font.atlas_w, font.atlas_h, r, g, b, a);
+    text_batch_push_run(&text_batch, glyphs->templates, indices, pen_x, y, visible_count);
+    if (complete){
+        layout_cache_store(&layout_cache, font.texture, font.pixel_per_em, text, text_length, x, indices, pen_x, visible_count);
+    }
     
-    M_value_table[0] = 0.f;
-    for (int32_t i = 1; i <= 5; i += 1){
-        float Cmax = Cmax_table[i];
-        float Cmin = Cmin_table[i];
-        float M = Cmax + (Cmin - Cmax)*L;
-        if (M > Cmax){
-            M = Cmax;
-        }
-        if (M < Cmin){
-            M = Cmin;
+    arena_pop_to(&frame_arena, mark);
+}
+
+void
+draw_string(Baked_Font font, char *text, int32_t x, int32_t y, float r, float g, float b, float a){
+    draw_string_length(font, text, (int32_t)strlen(text), x, y, r, g, b, a);
+}
+
+// Test Scene Target
+
+// Strings drawn before the clear go out first, so the clear lands on top of them.
+void
+gl_scene_clear(void *user, float r, float g, float b){
+    render_text_batch(&frame_stream, &text_batch);
+    render_clear(&frame_stream, r, g, b);
+}
+
+void
+gl_scene_draw_string(void *user, char *text, int32_t x, int32_t y, float r, float g, float b, float a){
+    Baked_Font *font = (Baked_Font*)user;
+    draw_string(*font, text, x, y, r, g, b, a);
+}
+
+// Vertex Ring Backend
+// The ring's buffer stays bound to GL_ARRAY_BUFFER.
+
+void
+gl_ring_write(void *backend, uint64_t offset, void *data, uint64_t size){
+    GLbitfield access = GL_MAP_WRITE_BIT|GL_MAP_UNSYNCHRONIZED_BIT|GL_MAP_INVALIDATE_RANGE_BIT;
+    void *dst = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)size, access);
+    memcpy(dst, data, (size_t)size);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+uint64_t
+gl_ring_fence(void *backend){
+    GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    return((uint64_t)(uintptr_t)sync);
+}
+
+bool32
+gl_ring_wait(void *backend, uint64_t fence, bool32 block){
+    GLsync sync = (GLsync)(uintptr_t)fence;
+    GLenum result = 0;
+    if (block){
+        result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    }
+    else{
+        result = glClientWaitSync(sync, 0, 0);
+    }
+    return(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED);
+}
+
+void
+gl_ring_release(void *backend, uint64_t fence){
+    glDeleteSync((GLsync)(uintptr_t)fence);
+}
+
+void
+gl_ring_orphan(void *backend, uint64_t size){
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)size, 0, GL_STREAM_DRAW);
+}
+
+// Atlas Upload Ring Backend
+// The same ring on GL_PIXEL_UNPACK_BUFFER, which is only bound while the atlas uploads are flushed.
+
+void
+gl_unpack_ring_write(void *backend, uint64_t offset, void *data, uint64_t size){
+    GLbitfield access = GL_MAP_WRITE_BIT|GL_MAP_UNSYNCHRONIZED_BIT|GL_MAP_INVALIDATE_RANGE_BIT;
+    void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, (GLintptr)offset, (GLsizeiptr)size, access);
+    memcpy(dst, data, (size_t)size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+}
+
+void
+gl_unpack_ring_orphan(void *backend, uint64_t size){
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, 0, GL_STREAM_DRAW);
+}
+
+// Uploads one dirty rectangle of the bound atlas texture.
+void
+gl_atlas_upload(void *backend, int32_t slice, Atlas_Dirty_Rect rect, uint16_t *texels, int32_t pitch){
+    int32_t w = rect.x1 - rect.x0;
+    int32_t h = rect.y1 - rect.y0;
+    if (atlas_upload_through_ring){
+        // Rows are packed tight in the ring, the texture copies out of it whenever the GPU gets there.
+        uint64_t size = (uint64_t)w*h*sizeof(uint16_t);
+        uint64_t offset = vertex_ring_alloc(&atlas_ring, size);
+        GLbitfield access = GL_MAP_WRITE_BIT|GL_MAP_UNSYNCHRONIZED_BIT|GL_MAP_INVALIDATE_RANGE_BIT;
+        uint16_t *dst = (uint16_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, (GLintptr)offset, (GLsizeiptr)size, access);
+        for (int32_t row = 0; row < h; row += 1){
+            memcpy(dst + row*w, texels + row*pitch, sizeof(uint16_t)*w);
         }
-        M_value_table[i] = M*a;
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, rect.x0, rect.y0, slice, w, h, 1, GL_RED_INTEGER, GL_UNSIGNED_SHORT, (void*)(uintptr_t)offset);
+    }
+    else{
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, rect.x0, rect.y0, slice, w, h, 1, GL_RED_INTEGER, GL_UNSIGNED_SHORT, texels);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+}
+
+// Sends the glyphs baked this frame to the atlas texture, before anything draws from it.
+void
+flush_atlas_uploads(Baked_Font *font){
+    if (font->dirty == 0){
+        return;
+    }
+    TRACE_SCOPE("flush_atlas_uploads");
+    Atlas_Dirty_Stats before = font->dirty->stats;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, font->texture);
+    if (atlas_upload_through_ring){
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, atlas_ring_buffer);
+    }
+    atlas_dirty_flush(font->dirty, gl_atlas_upload, font);
+    if (atlas_upload_through_ring){
+        vertex_ring_end_frame(&atlas_ring);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     }
-    M_value_table[6] = a;
     
-    // Draw
-    glBlendColor(r, g, b, a);
-    glBufferData(GL_ARRAY_BUFFER, total_float_count*sizeof(float), vertices, GL_DYNAMIC_DRAW);
+    Atlas_Dirty_Stats *stats = &font->dirty->stats;
+    if (report_atlas_upload_stats && stats->glyphs != before.glyphs){
+        char line[256];
+        snprintf(line, sizeof(line), "atlas uploads: %llu glyphs, %llu rectangles, %llu bytes, %d oversize glyphs, %d clipped\n",
+                 (unsigned long long)(stats->glyphs - before.glyphs), (unsigned long long)(stats->uploads - before.uploads),
+                 (unsigned long long)((stats->uploaded - before.uploaded)*sizeof(uint16_t)),
+                 font->oversize->rect_count - (font->oversize->slice_count - 1), font->oversize_clipped);
+        OutputDebugStringA(line);
+    }
+}
+
+// Render Command Executor
+// Each glyph batch is one write into the text ring and one instanced draw.
+
+void
+gl_render_clear(void *user, Render_Clear *clear){
+    glClearColor(clear->color[0], clear->color[1], clear->color[2], 1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void
+gl_render_glyphs(void *user, Render_Glyphs *glyphs, Text_Style *styles, Text_Instance *instances){
+    uint64_t ring_offset = vertex_ring_push(&text_ring, instances, glyphs->instance_count*sizeof(Text_Instance));
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, font.texture);
     glUniform1i(uniform_tex, 0);
-    glUniform1fv(uniform_M_value_table, 7, M_value_table);
-    glVertexAttribPointer(attrib_position, 2, GL_FLOAT, GL_FALSE, byte_per_vertex, 0);
-    glVertexAttribPointer(attrib_tex_position, 3, GL_FLOAT, GL_FALSE, byte_per_vertex, (void*)(sizeof(float)*2));
-    glDrawArrays(GL_TRIANGLES, 0, vertex_per_character*length);
     
-    free(vertices);
-    free(indices);
+    // The instance attributes are pointed at the batch's first instance.
+    GLsizei stride = sizeof(Text_Instance);
+    size_t base = (size_t)ring_offset;
+    glVertexAttribIPointer(attrib_box_position,   2, GL_SHORT,          stride, (void*)(base + offsetof(Text_Instance, x)));
+    glVertexAttribIPointer(attrib_atlas_position, 2, GL_UNSIGNED_SHORT, stride, (void*)(base + offsetof(Text_Instance, atlas_x)));
+    glVertexAttribIPointer(attrib_box_size_slice, 4, GL_UNSIGNED_BYTE,  stride, (void*)(base + offsetof(Text_Instance, w)));
+    glVertexAttribIPointer(attrib_style,          1, GL_UNSIGNED_SHORT, stride, (void*)(base + offsetof(Text_Instance, style)));
+    
+    glUniform4fv(uniform_styles, 3*glyphs->style_count, (float*)styles);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, glyphs->texture);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, glyphs->instance_count);
+}
+
+// The render target is bound again at the top of the next frame.
+void
+gl_render_blit(void *user, Render_Blit *blit){
+    GLuint framebuffer = *(GLuint*)user;
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBlitFramebuffer(blit->x, blit->y, blit->x + blit->w, blit->y + blit->h,
+                      blit->dst_x, blit->dst_y, blit->dst_x + blit->w, blit->dst_y + blit->h,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+// Runs the frame's command stream, then fences everything the frame wrote to the ring.
+void
+execute_render_stream(Render_Stream *stream, GLuint framebuffer){
+    TRACE_SCOPE("execute_render_stream");
+    Render_Executor executor = {0};
+    executor.user = &framebuffer;
+    executor.clear = gl_render_clear;
+    executor.glyphs = gl_render_glyphs;
+    executor.blit = gl_render_blit;
+    render_stream_execute(stream, &executor);
+    vertex_ring_end_frame(&text_ring);
+    
+    if (report_text_ring_stats){
+        Vertex_Ring_Stats *stats = &text_ring.last_frame;
+        char line[256];
+        snprintf(line, sizeof(line), "text ring: %llu bytes, %llu wraps, %llu reused, %llu stalls avoided, %llu waits\n",
+                 (unsigned long long)stats->bytes, (unsigned long long)stats->wraps, (unsigned long long)stats->reuses,
+                 (unsigned long long)stats->orphans, (unsigned long long)stats->waits);
+        OutputDebugStringA(line);
+    }
 }
 
 void
@@ -285,6 +836,7 @@ gl_debug(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
 
 int
 WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow){
+    TRACE_THREAD_NAME("main");
     HWND wnd = window_setup(hInstance);
     
     // OpenGL Setup
@@ -302,7 +854,8 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdS
         // Settings
         glEnable(GL_FRAMEBUFFER_SRGB);
         glEnable(GL_BLEND);
-        glBlendFunc(GL_CONSTANT_COLOR, GL_ONE_MINUS_SRC_COLOR);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC1_COLOR);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         
         // sRGB Framebuffer
         GLuint frame_texture = 0;
@@ -349,10 +902,12 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdS
         // Uniforms and Attributes
         uniform_pixel_to_normal = glGetUniformLocation(program, "pixel_to_normal");
         uniform_tex             = glGetUniformLocation(program, "tex");
-        uniform_M_value_table   = glGetUniformLocation(program, "M_value_table");
+        uniform_styles          = glGetUniformLocation(program, "styles");
         
-        attrib_position     = glGetAttribLocation(program, "position");
-        attrib_tex_position = glGetAttribLocation(program, "tex_position");
+        attrib_box_position   = glGetAttribLocation(program, "box_position");
+        attrib_atlas_position = glGetAttribLocation(program, "atlas_position");
+        attrib_box_size_slice = glGetAttribLocation(program, "box_size_slice");
+        attrib_style          = glGetAttribLocation(program, "style");
         
         float mat[9];
         mat[0] = 2.f/(float)window_width; mat[3] = 0.f;                        mat[6] = -1.f;
@@ -373,17 +928,38 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdS
         glGenBuffers(1, &buffer);
         glBindBuffer(GL_ARRAY_BUFFER, buffer);
         
-        glEnableVertexAttribArray(attrib_position);
-        glEnableVertexAttribArray(attrib_tex_position);
+        Vertex_Ring_Backend ring_backend = {0};
+        ring_backend.write = gl_ring_write;
+        ring_backend.fence = gl_ring_fence;
+        ring_backend.wait = gl_ring_wait;
+        ring_backend.release = gl_ring_release;
+        ring_backend.orphan = gl_ring_orphan;
+        text_ring = vertex_ring_init(ring_backend, text_ring_size);
+        frame_arena = arena_alloc(frame_arena_size);
+        layout_cache = layout_cache_init(layout_cache_entry_count, layout_cache_text_max, layout_cache_glyph_max);
+        
+        // Every attribute advances once per instance, the pointers are set by gl_render_glyphs.
+        GLuint instance_attribs[] = {attrib_box_position, attrib_atlas_position, attrib_box_size_slice, attrib_style};
+        for (int32_t i = 0; i < 4; i += 1){
+            glEnableVertexAttribArray(instance_attribs[i]);
+            glVertexAttribDivisor(instance_attribs[i], 1);
+        }
     }
     
     // Font Setup
     Baked_Font font = {0};
+    DWrite_Glyph_Baker baker = {0};
+    TTF_Font ttf_font = {0};
+    Software_Rasterizer software_rasterizer = {0};
+    // Only set up when the font file parses, the registry reads the codepoint map and advances out of it.
+    bool32 zoom_enabled = false;
+    Font_Registry zoom_registry = {0};
+    DWrite_Zoom_Source zoom_source = {0};
+    // Stays mapped for the life of the program when the metrics are used in place.
+    Font_Cache_Map baked_font_file = {0};
     
     {
-        COLORREF back_color = RGB(0,0,0);
-        COLORREF fore_color = RGB(255,255,255);
-        
+        TRACE_SCOPE("font setup");
         HRESULT error = 0;
         
         // Factory
@@ -418,13 +994,13 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdS
                                                      default_rendering_params->GetPixelGeometry(),
                                                      DWRITE_RENDERING_MODE_NATURAL,
                                                      &rendering_params);
-        DeferRelease(rendering_params);
+        // Kept around with the render target so glyphs can be baked on demand.
         DWCheckPtr(error, rendering_params, assert(!"rendering params"));
         
         // Interop
+        // Kept around for the bakes of zoomed sizes.
         IDWriteGdiInterop *dwrite_gdi_interop = 0;
         error = factory->GetGdiInterop(&dwrite_gdi_interop);
-        DeferRelease(dwrite_gdi_interop);
         DWCheckPtr(error, dwrite_gdi_interop, assert(!"gdi interop"));
         
         // Metrics
@@ -433,157 +1009,254 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdS
         
         float pixel_per_em = point_size*(1.f/72.f)*dpi;
         float pixel_per_design_unit = pixel_per_em/((float)font_metrics.designUnitsPerEm);
+        font.pixel_per_em = pixel_per_em;
         
         int32_t raster_target_w = (int32_t)(8.f*((float)font_metrics.capHeight)*pixel_per_design_unit);
         int32_t raster_target_h = (int32_t)(8.f*((float)font_metrics.capHeight)*pixel_per_design_unit);
-        float raster_target_x = (float)(raster_target_w/2);
-        float raster_target_y = (float)(raster_target_h/2);
-        
-        assert((float) ((int)(raster_target_x)) == raster_target_x);
-        assert((float) ((int)(raster_target_y)) == raster_target_y);
-        
         // Glyph Count
         font.glyph_count = font.face->GetGlyphCount();
         
-        // Render Target
-        IDWriteBitmapRenderTarget *render_target = 0;
-        error = dwrite_gdi_interop->CreateBitmapRenderTarget(0, raster_target_w, raster_target_h, &render_target);
-        HDC dc = render_target->GetMemoryDC();
+        // Codepoint to Glyph Table
+        font.codepoints = codepoint_map_alloc(font.face, dwrite_codepoint_glyphs);
         
-        // Clear the Render Target
+        // Render Target
         {
-            HGDIOBJ original = SelectObject(dc, GetStockObject(DC_PEN));
-            SetDCPenColor(dc, back_color);
-            SelectObject(dc, GetStockObject(DC_BRUSH));
-            SetDCBrushColor(dc, back_color);
-            Rectangle(dc, 0, 0, raster_target_w, raster_target_h);
-            SelectObject(dc, original);
+            bool32 created = dwrite_glyph_baker_init(&baker, dwrite_gdi_interop, font.face, rendering_params,
+                                                     raster_target_w, raster_target_h, pixel_per_em, pixel_per_design_unit);
+            assert(created);
         }
         
-        // Allocate CPU Side Atlas
-        int32_t atlas_w = 4*(int32_t)(((float)font_metrics.capHeight)*pixel_per_design_unit);
-        int32_t atlas_h = 4*(int32_t)(((float)font_metrics.capHeight)*pixel_per_design_unit);
-        if (atlas_w < 16){
-            atlas_w = 16;
+        // Pick the Rasterizer Backend
+        int32_t font_file_size = 0;
+        uint8_t *font_file_data = map_font_file(font_path, &font_file_size);
+        bool32 ttf_loaded = (font_file_data != 0 && ttf_init(&ttf_font, font_file_data, font_file_size));
+        if (use_software_rasterizer){
+            assert(ttf_loaded);
+            font.rasterizer = software_rasterizer_init(&software_rasterizer, &ttf_font, pixel_per_em);
         }
         else{
-            atlas_w = next_power_of_two(atlas_w);
+            font.rasterizer.backend = &baker;
+            font.rasterizer.rasterize_glyph = dwrite_rasterize_glyph;
+            font.rasterizer.glyph_advances = dwrite_glyph_advances;
+            font.rasterizer.glyph_count = font.glyph_count;
+            font.rasterizer.pixel_per_em = pixel_per_em;
         }
-        if (atlas_h < 256){
-            atlas_h = 256;
-        }
-        else{
-            atlas_h = next_power_of_two(atlas_h);
-        }
-        int32_t atlas_c = (font.glyph_count + 3)/4;
-        int32_t atlas_slice_size = atlas_w*atlas_h*3;
-        int32_t atlas_memory_size = atlas_slice_size*atlas_c;
-        uint8_t *atlas_memory = (uint8_t*)malloc(atlas_memory_size);
-        memset(atlas_memory, 0, atlas_memory_size);
         
-        // Allocate the Metric Data
-        font.metrics = (Glyph_Metrics*)malloc(sizeof(Glyph_Metrics)*font.glyph_count);
-        memset(font.metrics, 0, sizeof(Glyph_Metrics)*font.glyph_count);
-        
-        // Fill the CPU Side Atlas and Metric Data
-        for (uint16_t glyph_index = 0; glyph_index < font.glyph_count; glyph_index += 1){
-            // Render the Glyph Into the Target
-            DWRITE_GLYPH_RUN glyph_run = {0};
-            glyph_run.fontFace = font.face;
-            glyph_run.fontEmSize = pixel_per_em;
-            glyph_run.glyphCount = 1;
-            glyph_run.glyphIndices = &glyph_index;
-            RECT bounding_box = {0};
-            error = render_target->DrawGlyphRun(raster_target_x, raster_target_y,
-                                                DWRITE_MEASURING_MODE_NATURAL, &glyph_run, rendering_params, RGB(255, 255, 255), &bounding_box);
-            DWCheck(error, continue);
-            
-            assert(0 <= bounding_box.left);
-            assert(0 <= bounding_box.top);
-            assert(bounding_box.right <= raster_target_w);
-            assert(bounding_box.bottom <= raster_target_h);
+        if (bake_on_demand){
+            // Allocate the GPU Side Atlas
+            // Glyphs are rasterized into cells of a fixed size atlas the first time draw_string needs them.
+            // Cells fit a line, the few glyphs that reach past it go to the oversize slice at the end.
+            int32_t cell_side = round_up(((float)(font_metrics.ascent + font_metrics.descent))*pixel_per_design_unit) + 4;
+            int32_t atlas_w = glyph_cache_atlas_side;
+            int32_t atlas_h = glyph_cache_atlas_side;
+            int32_t atlas_c = glyph_cache_atlas_slices + 1;
             
-            // Compute Our Glyph Metrics
-            DWRITE_GLYPH_METRICS glyph_metrics = {0};
-            error = font.face->GetDesignGlyphMetrics(&glyph_index, 1, &glyph_metrics, false);
-            DWCheck(error, continue);
+            font.metrics = alloc_glyph_metrics(&font.rasterizer);
+            font.cache = (Glyph_Cache*)malloc(sizeof(Glyph_Cache));
+            // Keyed by glyph variant, see text_glyph_table_layout
+            int32_t variant_count = font.glyph_count*subpixel_phase_count;
+            *font.cache = glyph_cache_init(variant_count, cell_side, cell_side, atlas_w, atlas_h, glyph_cache_atlas_slices);
+            // Fewer cells than dense indices, only variants kept in the oversize slice can use them all up.
+            assert(font.cache->cell_count < TEXT_GLYPH_DENSE_MAX);
+            font.atlas_w = atlas_w;
+            font.atlas_h = atlas_h;
+            font.cell_memory = (uint8_t*)heap_alloc(cell_side*cell_side*3);
+            font.cell_levels = (uint16_t*)heap_alloc(cell_side*cell_side*sizeof(uint16_t));
+            font.cell_memory_texels = cell_side*cell_side;
+            font.oversize = (Atlas_Packer*)malloc(sizeof(Atlas_Packer));
+            *font.oversize = atlas_packer_init(atlas_w, atlas_h, 1);
+            font.oversize_slots = (Atlas_Slot*)malloc(sizeof(Atlas_Slot)*variant_count);
+            memset(font.oversize_slots, 0, sizeof(Atlas_Slot)*variant_count);
+            font.oversize_slice = glyph_cache_atlas_slices;
+            font.dirty = (Atlas_Dirty*)malloc(sizeof(Atlas_Dirty));
+            *font.dirty = atlas_dirty_init(atlas_w, atlas_h, atlas_c, atlas_merge_slack);
             
-            float off_x = (float)bounding_box.left - raster_target_x;
-            float off_y = (float)bounding_box.top - raster_target_y;
-            float advance = ((float)glyph_metrics.advanceWidth)*pixel_per_design_unit;
-            int32_t tex_w = bounding_box.right - bounding_box.left;
-            int32_t tex_h = bounding_box.bottom - bounding_box.top;
-            
-            font.metrics[glyph_index].off_x   = off_x;
-            font.metrics[glyph_index].off_y   = off_y;
-            font.metrics[glyph_index].advance = (float)round_up(advance);
-            font.metrics[glyph_index].xy_w    = (float)tex_w;
-            font.metrics[glyph_index].xy_h    = (float)tex_h;
-            font.metrics[glyph_index].uv_w    = (float)tex_w/(float)atlas_w;
-            font.metrics[glyph_index].uv_h    = (float)tex_h/(float)atlas_h;
+            glGenTextures(1, &font.texture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, font.texture);
+            {
+                TRACE_SCOPE("glTexImage3D");
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16UI, atlas_w, atlas_h, atlas_c, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, 0);
+            }
             
-            // Get the Bitmap
-            HBITMAP bitmap = (HBITMAP)GetCurrentObject(dc, OBJ_BITMAP);
-            DIBSECTION dib = {0};
-            GetObject(bitmap, sizeof(dib), &dib);
+            if (atlas_upload_through_ring){
+                glGenBuffers(1, &atlas_ring_buffer);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, atlas_ring_buffer);
+                Vertex_Ring_Backend unpack_backend = {0};
+                unpack_backend.write = gl_unpack_ring_write;
+                unpack_backend.fence = gl_ring_fence;
+                unpack_backend.wait = gl_ring_wait;
+                unpack_backend.release = gl_ring_release;
+                unpack_backend.orphan = gl_unpack_ring_orphan;
+                atlas_ring = vertex_ring_init(unpack_backend, atlas_ring_size);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            }
+        }
+        else{
+            // Look for a Baked Font Cache File
+            Font_Cache_Key cache_key = {0};
+            cache_key.font_hash         = (font_file_data != 0)?font_cache_hash(font_file_data, font_file_size):0;
+            cache_key.point_size        = point_size;
+            cache_key.dpi               = dpi;
+            cache_key.gamma             = rendering_params->GetGamma();
+            cache_key.enhanced_contrast = rendering_params->GetEnhancedContrast();
+            cache_key.clear_type_level  = rendering_params->GetClearTypeLevel();
+            cache_key.pixel_geometry    = (uint32_t)rendering_params->GetPixelGeometry();
+            cache_key.rendering_mode    = (uint32_t)rendering_params->GetRenderingMode();
+            cache_key.rasterizer        = use_software_rasterizer?1:0;
             
-            // Blit the Bitmap Into Our CPU Side Atlas
-            int32_t x_slice_offset = (3*atlas_w/2)*(glyph_index&1);
-            int32_t y_slice_offset = (3*atlas_w*atlas_h/2)*((glyph_index&2) >> 1);
-            uint8_t *atlas_slice = atlas_memory + atlas_slice_size*(glyph_index/4) + x_slice_offset + y_slice_offset;
+            bool32 warm_start = (cache_key.font_hash != 0 &&
+                                 font_cache_map(baked_font_cache_path, &baked_font_file) &&
+                                 font_cache_validate(&baked_font_file, &cache_key, sizeof(Glyph_Metrics)) &&
+                                 baked_font_file.header->glyph_count == (uint32_t)font.glyph_count &&
+                                 baked_font_file.header->atlas_bytes_per_texel == sizeof(uint16_t));
             
-            {
-                assert(dib.dsBm.bmBitsPixel == 32);
-                int32_t in_pitch  = dib.dsBm.bmWidthBytes;
-                int32_t out_pitch = atlas_w*3;
-                uint8_t *in_line  = (uint8_t*)dib.dsBm.bmBits + bounding_box.left*4 + bounding_box.top*in_pitch;
-                uint8_t *out_line = atlas_slice;
-                for (int32_t y = 0; y < tex_h; y += 1){
-                    uint8_t *in_pixel  = in_line;
-                    uint8_t *out_pixel = out_line;
-                    for (int32_t x = 0; x < tex_w; x += 1){
-                        out_pixel[0] = in_pixel[2];
-                        out_pixel[1] = in_pixel[1];
-                        out_pixel[2] = in_pixel[0];
-                        in_pixel += 4;
-                        out_pixel += 3;
-                    }
-                    in_line += in_pitch;
-                    out_line += out_pitch;
+            if (warm_start){
+                // The metrics are used in place and the atlas is uploaded straight out of the mapping.
+                Font_Cache_Header *header = baked_font_file.header;
+                font.metrics = (Glyph_Metrics*)baked_font_file.metrics;
+                font.atlas_w = header->atlas_w;
+                font.atlas_h = header->atlas_h;
+                glGenTextures(1, &font.texture);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, font.texture);
+                {
+                    TRACE_SCOPE("glTexImage3D");
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16UI, header->atlas_w, header->atlas_h, header->atlas_c, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, baked_font_file.atlas);
                 }
             }
-            
-            // Clear the Render Target
-            {
-                HGDIOBJ original = SelectObject(dc, GetStockObject(DC_PEN));
-                SetDCPenColor(dc, back_color);
-                SelectObject(dc, GetStockObject(DC_BRUSH));
-                SetDCBrushColor(dc, back_color);
-                Rectangle(dc,
-                          bounding_box.left, bounding_box.top,
-                          bounding_box.right, bounding_box.bottom);
-                SelectObject(dc, original);
+            else{
+                font_cache_unmap(&baked_font_file);
+                
+                font.metrics = alloc_glyph_metrics(&font.rasterizer);
+                
+                // Rasterizer Backend per Worker
+                // Worker zero uses the main backend, the others get their own scratch targets.
+                int32_t worker_count = bake_thread_count;
+                if (worker_count <= 0){
+                    worker_count = bake_core_count();
+                }
+                Glyph_Rasterizer *worker_rasterizers = (Glyph_Rasterizer*)malloc(sizeof(Glyph_Rasterizer)*worker_count);
+                DWrite_Glyph_Baker *worker_bakers = (DWrite_Glyph_Baker*)malloc(sizeof(DWrite_Glyph_Baker)*worker_count);
+                Software_Rasterizer *worker_software = (Software_Rasterizer*)malloc(sizeof(Software_Rasterizer)*worker_count);
+                memset(worker_bakers, 0, sizeof(DWrite_Glyph_Baker)*worker_count);
+                memset(worker_software, 0, sizeof(Software_Rasterizer)*worker_count);
+                worker_rasterizers[0] = font.rasterizer;
+                for (int32_t i = 1; i < worker_count; i += 1){
+                    if (use_software_rasterizer){
+                        worker_rasterizers[i] = software_rasterizer_init(&worker_software[i], &ttf_font, pixel_per_em);
+                    }
+                    else{
+                        bool32 created = dwrite_glyph_baker_init(&worker_bakers[i], dwrite_gdi_interop, font.face, rendering_params,
+                                                                 raster_target_w, raster_target_h, pixel_per_em, pixel_per_design_unit);
+                        assert(created);
+                        worker_rasterizers[i] = font.rasterizer;
+                        worker_rasterizers[i].backend = &worker_bakers[i];
+                    }
+                }
+                
+                // Rasterize, Pack and Fill the CPU Side Atlas and Metric Data
+                int32_t atlas_side = atlas_packer_choose_slice_side((int32_t)(((float)font_metrics.capHeight)*pixel_per_design_unit));
+                int32_t atlas_w = atlas_side;
+                int32_t atlas_h = atlas_side;
+                int32_t atlas_c = 0;
+                font.atlas_w = atlas_w;
+                font.atlas_h = atlas_h;
+                Atlas_Packer packer = atlas_packer_init(atlas_w, atlas_h, 1);
+                uint8_t *atlas_memory = parallel_bake_atlas(worker_rasterizers, worker_count, &packer,
+                                                            bake_glyph_placed, &font, &atlas_c);
+                
+                for (int32_t i = 1; i < worker_count; i += 1){
+                    if (use_software_rasterizer){
+                        software_rasterizer_free(&worker_software[i]);
+                    }
+                    else{
+                        dwrite_glyph_baker_free(&worker_bakers[i]);
+                    }
+                }
+                free(worker_software);
+                free(worker_bakers);
+                free(worker_rasterizers);
+                
+                // Pack the Coverage Levels
+                int64_t texel_count = (int64_t)atlas_w*atlas_h*atlas_c;
+                uint16_t *atlas_levels = (uint16_t*)malloc(sizeof(uint16_t)*texel_count);
+                atlas_levels_pack(atlas_memory, atlas_levels, texel_count);
+                free(atlas_memory);
+                atlas_memory = 0;
+                
+                // Allocate and Fill the GPU Side Atlas
+                glGenTextures(1, &font.texture);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, font.texture);
+                {
+                    TRACE_SCOPE("glTexImage3D");
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16UI, atlas_w, atlas_h, atlas_c, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, atlas_levels);
+                }
+                
+                // Save the Bake for the Next Launch
+                font_cache_write(baked_font_cache_path, &cache_key,
+                                 font.metrics, sizeof(Glyph_Metrics), font.glyph_count,
+                                 (uint8_t*)atlas_levels, atlas_w, atlas_h, atlas_c, sizeof(uint16_t));
+                
+                // Free CPU Side Atlas
+                free(atlas_levels);
+                atlas_levels = 0;
+                atlas_packer_free(&packer);
             }
         }
         
-        // Allocate and Fill the GPU Side Atlas
-        glGenTextures(1, &font.texture);
-        glBindTexture(GL_TEXTURE_2D_ARRAY, font.texture);
-        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB, atlas_w, atlas_h, atlas_c, 0, GL_RGB, GL_UNSIGNED_BYTE, atlas_memory);
+        // Every glyph's metrics are final unless glyphs are baked on demand.
+        int32_t phase_count = (font.cache != 0)?subpixel_phase_count:1;
+        font.glyphs = (Text_Glyph_Table*)malloc(sizeof(Text_Glyph_Table));
+        *font.glyphs = text_glyph_table_alloc(font.metrics, font.glyph_count, phase_count, font.atlas_w, font.atlas_h, font.cache == 0);
         
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
-        // Free CPU Side Atlas
-        free(atlas_memory);
-        atlas_memory = 0;
+        // Zoomed Sizes
+        // Baked by the same backend as the font, one thread short of the cores so the frames go on.
+        if (ttf_loaded && ttf_font.glyph_count == font.glyph_count){
+            Font_Registry_Rasterizers zoom_rasterizers = {0};
+            if (!use_software_rasterizer){
+                zoom_source.interop = dwrite_gdi_interop;
+                zoom_source.face = font.face;
+                zoom_source.rendering_params = rendering_params;
+                zoom_source.glyph_count = font.glyph_count;
+                zoom_source.design_units_per_em = (float)font_metrics.designUnitsPerEm;
+                zoom_source.cap_height = (float)font_metrics.capHeight;
+                zoom_rasterizers.user = &zoom_source;
+                zoom_rasterizers.init = dwrite_zoom_rasterizers_init;
+                zoom_rasterizers.free = dwrite_zoom_rasterizers_free;
+            }
+            int32_t zoom_worker_count = bake_core_count() - 1;
+            zoom_worker_count = (zoom_worker_count < 1)?1:zoom_worker_count;
+            zoom_registry = font_registry_init(&ttf_font, zoom_font_sizes, zoom_worker_count, &zoom_rasterizers);
+            zoom_enabled = true;
+        }
+    }
+    Zoom_Texture *zoom_textures = (Zoom_Texture*)malloc(sizeof(Zoom_Texture)*zoom_font_sizes);
+    memset(zoom_textures, 0, sizeof(Zoom_Texture)*zoom_font_sizes);
+    Zoom_Staging zoom_staging = {0};
+    Software_Font *zoom_font = 0;
+    float view_point_size = point_size;
+    window_dpi = window_initial_dpi(wnd);
+    
+    FILE *render_capture_file = 0;
+    if (capture_render_commands){
+        render_capture_file = fopen(render_capture_path, "wb");
+        if (render_capture_file != 0 && !render_capture_begin(render_capture_file)){
+            fclose(render_capture_file);
+            render_capture_file = 0;
+        }
     }
     
     int32_t mode = 0;
     bool32 paused = false;
+    uint64_t frame_index = 0;
     for (;;){
+        arena_reset(&frame_arena);
+        heap_frame_begin();
+        
         MSG msg = {0};
         for (;PeekMessage(&msg, NULL, 0, 0, PM_REMOVE);){
             TranslateMessage(&msg);
@@ -595,6 +1268,17 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdS
                         paused = !paused;
                     }
                 }
+                else if (msg.wParam == VK_OEM_PLUS || msg.wParam == VK_ADD){
+                    view_point_size += zoom_step;
+                }
+                else if (msg.wParam == VK_OEM_MINUS || msg.wParam == VK_SUBTRACT){
+                    view_point_size -= zoom_step;
+                }
+                else if (msg.wParam == '0'){
+                    view_point_size = point_size;
+                }
+                view_point_size = (view_point_size < zoom_min_point_size)?zoom_min_point_size:view_point_size;
+                view_point_size = (view_point_size > zoom_max_point_size)?zoom_max_point_size:view_point_size;
             }
         }
         
@@ -602,181 +1286,77 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdS
         
         glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
         
-        enum{
-            TB_Black,
-            TB_White,
-            TB_Red,
-            TB_Green,
-            TB_Blue,
-            TB_Yellow,
-            TB_Cyan,
-            TB_Purple,
-            TB_COUNT,
-        };
+        if (font.cache != 0){
+            glyph_cache_begin_frame(font.cache);
+        }
         
-        enum{
-            TF_Gray,
-            TF_RGB,
-            TF_YCP,
-            TF_AlphaGray,
-            TF_AlphaRGB,
-            TF_AlphaYCP,
-            TF_COUNT,
-        };
+        // Zoom
+        // The size the font was set up at draws with it, any other with the registry's bake of it.
+        Baked_Font frame_font = font;
+        if (zoom_enabled){
+            if (view_point_size == point_size && window_dpi == dpi){
+                zoom_font = 0;
+            }
+            else{
+                zoom_font = font_registry_get_or_keep(&zoom_registry, view_point_size, window_dpi, zoom_font);
+            }
+            GLuint zoom_texture = 0;
+            if (zoom_font != 0){
+                zoom_texture = zoom_font_texture(zoom_textures, &zoom_staging, &zoom_registry, zoom_font);
+            }
+            if (zoom_texture != 0){
+                frame_font = zoom_baked_font(&font, zoom_font, zoom_texture);
+            }
+        }
         
         int32_t mode_index = mode/16;
         int32_t bmode = (mode_index/TF_COUNT)%TB_COUNT;
         int32_t fmode = mode_index%TF_COUNT;
         
-        float pop_r = 0.f;
-        float pop_g = 0.f;
-        float pop_b = 0.f;
-#define SetPopColor(r,g,b) pop_r = (r), pop_g = (g), pop_b = (b)
-        switch (bmode){
-            case TB_Black:
-            {
-                glClearColor(0.f, 0.f, 0.f, 1.f);
-                SetPopColor(1.f, 1.f, 1.f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                draw_string(font, "Back = Black", 300, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TB_White:
-            {
-                glClearColor(1.f, 1.f, 1.f, 1.f);
-                SetPopColor(0.f, 0.f, 0.f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                draw_string(font, "Back = White", 300, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TB_Red:
-            {
-                glClearColor(0.5f, 0.f, 0.f, 1.f);
-                SetPopColor(0.f, 0.5f, 0.5f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                draw_string(font, "Back = (.5,0,0)", 300, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TB_Green:
-            {
-                glClearColor(0.f, 0.5f, 0.f, 1.f);
-                SetPopColor(0.5f, 0.f, 0.5f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                draw_string(font, "Back = (0,.5,0)", 300, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TB_Blue:
-            {
-                glClearColor(0.f, 0.f, 0.5f, 1.f);
-                SetPopColor(0.5f, 0.5f, 0.f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                draw_string(font, "Back = (0,0,.5)", 300, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TB_Yellow:
-            {
-                glClearColor(0.5f, 0.5f, 0.f, 1.f);
-                SetPopColor(0.f, 0.f, 0.5f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                draw_string(font, "Back = (.5,.5,0)", 300, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TB_Cyan:
-            {
-                glClearColor(0.f, 0.5f, 0.5f, 1.f);
-                SetPopColor(0.5f, 0.f, 0.f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                draw_string(font, "Back = (0,.5,.5)", 300, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TB_Purple:
-            {
-                glClearColor(0.5f, 0.f, 0.5f, 1.f);
-                SetPopColor(0.f, 0.5f, 0.f);
-                glClear(GL_COLOR_BUFFER_BIT);
-                draw_string(font, "Back = (.5,0,.5)", 300, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
+        Test_Scene_Target scene_target = {0};
+        scene_target.user = &frame_font;
+        scene_target.clear = gl_scene_clear;
+        scene_target.draw_string = gl_scene_draw_string;
+        {
+            TRACE_SCOPE("test scene");
+            render_stream_begin_frame(&frame_stream);
+            test_scene_draw(&scene_target, bmode, fmode, paused);
+            render_text_batch(&frame_stream, &text_batch);
+            render_blit(&frame_stream, 0, 0, window_width, window_height, 0, 0);
         }
         
-        switch (fmode){
-            case TF_Gray:
-            {
-                for (int32_t i = 1; i <= 6; i += 1){
-                    float v = (i - 1)/5.f;
-                    draw_string(font, "DirectWrite rasterizer testing", 50, i*80 + 40, v, v, v, 1.f);
-                }
-                draw_string(font, "Fore = Grays", 550, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TF_RGB:
-            {
-                for (int32_t i = 0; i < 3; i += 1){
-                    float v[3] = {0.f, 0.f, 0.f};
-                    v[i] = 0.5f;
-                    draw_string(font, "DirectWrite rasterizer testing", 50 + 250*i, 120, v[0], v[1], v[2], 1.f);
-                }
-                draw_string(font, "Fore = Red Green Blue", 550, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TF_YCP:
-            {
-                for (int32_t i = 0; i < 3; i += 1){
-                    float v[3] = {0.5f, 0.5f, 0.5f};
-                    v[(i + 2)%3] = 0.f;
-                    draw_string(font, "DirectWrite rasterizer testing", 50 + 250*i, 120, v[0], v[1], v[2], 1.f);
-                }
-                draw_string(font, "Fore = Yellow Cyan Purple", 550, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TF_AlphaGray:
-            {
-                for (int32_t j = 1; j <= 6; j += 1){
-                    float a = (j - 1)/5.f;
-                    draw_string(font, "DirectWrite rasterizer testing",  50, j*80 + 40, 1.f, 1.f, 1.f, a);
-                    draw_string(font, "DirectWrite rasterizer testing", 300, j*80 + 40, 0.f, 0.f, 0.f, a);
-                }
-                draw_string(font, "Fore = Alpha Black and White", 550, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TF_AlphaRGB:
-            {
-                for (int32_t j = 1; j <= 6; j += 1){
-                    float a = (j - 1)/5.f;
-                    for (int32_t i = 0; i < 3; i += 1){
-                        float v[3] = {0.f, 0.f, 0.f};
-                        v[i] = 0.5f;
-                        draw_string(font, "DirectWrite rasterizer testing", 50 + 250*i, j*80 + 40, v[0], v[1], v[2], a);
-                    }
-                }
-                draw_string(font, "Fore = Alpha Red Green Blue", 550, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
-            
-            case TF_AlphaYCP:
-            {
-                for (int32_t j = 1; j <= 6; j += 1){
-                    float a = (j - 1)/5.f;
-                    for (int32_t i = 0; i < 3; i += 1){
-                        float v[3] = {0.5f, 0.5f, 0.5f};
-                        v[(i + 2)%3] = 0.f;
-                        draw_string(font, "DirectWrite rasterizer testing", 50 + 250*i, j*80 + 40, v[0], v[1], v[2], a);
-                    }
-                }
-                draw_string(font, "Fore = Alpha Yellow Cyan Purple", 550, 60, pop_r, pop_g, pop_b, 1.f);
-            }break;
+        flush_atlas_uploads(&font);
+        execute_render_stream(&frame_stream, framebuffer);
+        if (render_capture_file != 0){
+            // The window closes with ExitProcess, which leaves the file's buffer unwritten.
+            render_capture_write_frame(render_capture_file, &frame_stream);
+            fflush(render_capture_file);
         }
         
-        if (!paused){
-            draw_string(font, "Press space to pause cycle",  50, 60, pop_r, pop_g, pop_b, 1.f);
-        }
-        else{
-            draw_string(font, "Press space to resume cycle", 50, 60, pop_r, pop_g, pop_b, 1.f);
+        {
+            TRACE_SCOPE("SwapBuffers");
+            SwapBuffers(dc);
         }
         
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
-        glBlitFramebuffer(0, 0, window_width, window_height, 0, 0, window_width, window_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-        
-        SwapBuffers(dc);
+        // The first frame fills the glyph cache and sizes the batch, after that nothing should allocate.
+        uint64_t frame_allocations = heap_frame_end();
+        if (frame_index > 0 && frame_allocations > 0){
+            char line[128];
+            snprintf(line, sizeof(line), "frame %llu: %llu heap allocations\n",
+                     (unsigned long long)frame_index, (unsigned long long)frame_allocations);
+            OutputDebugStringA(line);
+        }
+#if TRACE_ENABLED
+        if (frame_index == trace_dump_frame){
+            trace_write_json(trace_json_path);
+            FILE *summary_file = fopen(trace_summary_path, "wb");
+            if (summary_file != 0){
+                trace_write_summary(summary_file);
+                fclose(summary_file);
+            }
+        }
+#endif
+        frame_index += 1;
         
         Sleep(100);
         if (!paused){
@@ -875,6 +1455,53 @@ typedef BOOL wglChoosePixelFormatARB_Function(HDC hdc,
                                               int *piFormats,
                                               UINT *nNumFormats);
 
+// Per Monitor DPI
+// Windows only sends WM_DPICHANGED to a process that says it is per monitor DPI aware. The calls
+// for that are newer than the rest of the program, so they are looked up by name.
+
+#define DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2_VALUE ((HANDLE)(intptr_t)-4)
+#define PROCESS_PER_MONITOR_DPI_AWARE_VALUE 2
+
+typedef BOOL WINAPI SetProcessDpiAwarenessContext_Function(HANDLE value);
+typedef HRESULT WINAPI SetProcessDpiAwareness_Function(int value);
+typedef UINT WINAPI GetDpiForWindow_Function(HWND hwnd);
+
+// Windows 10 1703 has the per monitor V2 context, Windows 8.1 the first per monitor awareness.
+// Before that the process stays at 96 DPI and the system stretches the window.
+void
+dpi_awareness_setup(void){
+    HMODULE user32 = LoadLibraryA("user32.dll");
+    SetProcessDpiAwarenessContext_Function *set_context = 0;
+    if (user32 != 0){
+        set_context = (SetProcessDpiAwarenessContext_Function*)GetProcAddress(user32, "SetProcessDpiAwarenessContext");
+    }
+    if (set_context != 0 && set_context(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2_VALUE)){
+        return;
+    }
+    HMODULE shcore = LoadLibraryA("shcore.dll");
+    if (shcore != 0){
+        SetProcessDpiAwareness_Function *set_awareness = (SetProcessDpiAwareness_Function*)GetProcAddress(shcore, "SetProcessDpiAwareness");
+        if (set_awareness != 0){
+            set_awareness(PROCESS_PER_MONITOR_DPI_AWARE_VALUE);
+        }
+    }
+}
+
+// The DPI of the monitor the window is on, dpi where Windows cannot say.
+float
+window_initial_dpi(HWND wnd){
+    float result = dpi;
+    HMODULE user32 = LoadLibraryA("user32.dll");
+    if (user32 != 0){
+        GetDpiForWindow_Function *get_dpi = (GetDpiForWindow_Function*)GetProcAddress(user32, "GetDpiForWindow");
+        UINT window_dpi_value = (get_dpi != 0)?get_dpi(wnd):0;
+        if (window_dpi_value != 0){
+            result = (float)window_dpi_value;
+        }
+    }
+    return(result);
+}
+
 LRESULT
 window_proc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam){
     LRESULT result = 0;
@@ -882,6 +1509,12 @@ window_proc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam){
         case WM_CREATE:
         {}break;
         
+        // The window keeps its size in pixels, only the text is drawn at the new DPI.
+        case WM_DPICHANGED:
+        {
+            window_dpi = (float)HIWORD(wParam);
+        }break;
+        
         case WM_CLOSE:
         case WM_DESTROY:
         {
@@ -902,6 +1535,8 @@ window_setup(HINSTANCE hInstance){
 #define L_REAL_WINDOW_CLASS_NAME L"window"
     wchar_t title[] = L"Example DirectWrite Based Rasterizer";
     
+    dpi_awareness_setup();
+    
     // NOTE(allen): Setup a starter window
     WNDCLASSEX starter_window_class = {0};
     starter_window_class.cbSize = sizeof(starter_window_class);
@@ -1006,7 +1641,7 @@ window_setup(HINSTANCE hInstance){
     
     int32_t context_attributes[] = {
         WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
-        WGL_CONTEXT_MINOR_VERSION_ARB, 0,
+        WGL_CONTEXT_MINOR_VERSION_ARB, 3,
         WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_DEBUG_BIT_ARB,
         WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
         0,
@@ -1,21 +1,29 @@
 #version 330
 // DirectWrite rasterization example: fragment shader
 // This file is only included for reference, GLSL code is stuffed into the rasterizer inline.
+// Dual source blend: the first output is the premultiplied foreground, the second is the per
+// channel coverage the blend uses to weight the background, with
+// glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC1_COLOR). The atlas holds a 3 bit coverage level per channel
+// packed into each texel, see example_atlas_levels.h.
 
 smooth in vec3 uv;
-uniform sampler2DArray tex;
-uniform float M_value_table[7];
-layout(location = 0) out vec4 mask;
+flat in vec3 fore_color;
+flat in vec4 fore_M_lo;
+flat in vec2 fore_M_hi;
+uniform usampler2DArray tex;
+layout(location = 0, index = 0) out vec4 color;
+layout(location = 0, index = 1) out vec4 mask;
 
 void main(){
-    vec3 S = texture(tex, uv).rgb;
-    int C0 = int(S.r*6 + 0.1); // + 0.1 just incase we have some small rounding taking us below the integer we should be hitting.
-    int C1 = int(S.g*6 + 0.1);
-    int C2 = int(S.b*6 + 0.1);
+    float M_value_table[7] = float[7](0.f, fore_M_lo.x, fore_M_lo.y, fore_M_lo.z, fore_M_lo.w, fore_M_hi.x, fore_M_hi.y);
+    uint S = texelFetch(tex, ivec3(uv), 0).r;
+    int C0 = int(S & 7u);
+    int C1 = int((S >> 3) & 7u);
+    int C2 = int((S >> 6) & 7u);
     mask.rgb = vec3(M_value_table[C0],
                     M_value_table[C1],
                     M_value_table[C2]);
     mask.a = 1;
+    color.rgb = fore_color*mask.rgb;
+    color.a = 1;
 }
-
-
@@ -1,15 +1,33 @@
 #version 330
 // DirectWrite rasterization example: vertex shader
 // This file is only included for reference, GLSL code is stuffed into the rasterizer inline.
+// The quad of each glyph instance is expanded from gl_VertexID, six vertices per instance:
+// top left, bottom left, top right, bottom left, top right, bottom right. uv is in atlas texels.
+// Each style is three vec4: the color and M_value_table[1..6].
 
 uniform mat3 pixel_to_normal;
-in vec2 position;
-in vec3 tex_position;
+uniform vec4 styles[3*64];
+in ivec2 box_position;
+in uvec2 atlas_position;
+in uvec4 box_size_slice;
+in uint style;
 smooth out vec3 uv;
+flat out vec3 fore_color;
+flat out vec4 fore_M_lo;
+flat out vec2 fore_M_hi;
 void main(){
+    vec2 corner = vec2((gl_VertexID == 2 || gl_VertexID >= 4)?1.f:0.f,
+                       (gl_VertexID == 1 || gl_VertexID == 3 || gl_VertexID == 5)?1.f:0.f);
+    vec2 size = vec2(box_size_slice.xy);
+    vec2 position = vec2(box_position) + corner*size;
     gl_Position.xy = (pixel_to_normal*vec3(position, 1.f)).xy;
     gl_Position.z = 0.f;
     gl_Position.w = 1.f;
-    uv = tex_position;
+    uv = vec3(vec2(atlas_position) + corner*size, float(box_size_slice.z));
+    vec4 s0 = styles[3*int(style) + 0];
+    vec4 s1 = styles[3*int(style) + 1];
+    vec4 s2 = styles[3*int(style) + 2];
+    fore_color = s0.rgb;
+    fore_M_lo = vec4(s0.a, s1.xyz);
+    fore_M_hi = vec2(s1.w, s2.x);
 }
-
@@ -0,0 +1,358 @@
+// DirectWrite rasterization example: a frame recorded as a stream of render commands
+// Everything a frame does to the screen goes into one stream of bytes: clears, glyph batches and
+// blits of the render target to the window. A glyph batch carries its styles and instances inline,
+// so a stream holds no pointers and means the same thing after it is written to a file and read
+// back. Atlases are resources that live outside the stream, a batch only names its texture.
+// Executors replay a stream through a small set of callbacks: the GL one in example_rasterizer.cpp
+// and the CPU one in example_cpu_compositor.h, which runs without a window or a GPU.
+// A capture file is a header and then one record per frame, the byte count and command count
+// followed by the frame's stream. Reading a frame checks every command against the record, and every
+// instance against its batch's styles and the atlas it will read, before anything executes it.
+
+#if !defined(EXAMPLE_RENDER_COMMANDS_H)
+#define EXAMPLE_RENDER_COMMANDS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_text_batch.h"
+
+#define RENDER_CAPTURE_MAGIC 0x444D4352u // "RCMD"
+#define RENDER_CAPTURE_VERSION 1
+// A frame record bigger than this is taken as a damaged file rather than allocated
+#define RENDER_CAPTURE_FRAME_MAX (1ull << 30)
+
+enum{
+    RenderCommand_Clear = 1,
+    RenderCommand_Glyphs,
+    RenderCommand_Blit,
+};
+
+// Every command starts with this. size covers the header and anything inline, a multiple of 8.
+struct Render_Command_Header{
+    uint32_t type;
+    uint32_t size;
+};
+
+// Colors are linear, as glClearColor sees them with GL_FRAMEBUFFER_SRGB.
+struct Render_Clear{
+    Render_Command_Header header;
+    float color[3];
+    uint32_t reserved;
+};
+
+// One draw of a Text_Draw_List, followed by style_count Text_Style and instance_count Text_Instance.
+struct Render_Glyphs{
+    Render_Command_Header header;
+    uint32_t texture;
+    int32_t style_count;
+    int32_t instance_count;
+    uint32_t reserved;
+};
+
+// Copies w by h pixels at (x, y) of the render target to (dst_x, dst_y) of the window.
+struct Render_Blit{
+    Render_Command_Header header;
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+    int32_t dst_x;
+    int32_t dst_y;
+};
+
+struct Render_Stream{
+    uint8_t *memory;
+    uint64_t size;
+    uint64_t max;
+    int32_t command_count;
+};
+
+// The atlas a stream is executed against. Instances are checked against it because the executors
+// index the atlas with their boxes as they come.
+struct Render_Atlas_Bounds{
+    int32_t w;
+    int32_t h;
+    int32_t slice_count;
+};
+
+struct Render_Capture_Header{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t instance_size;
+    uint32_t style_size;
+};
+
+struct Render_Capture_Frame{
+    uint64_t size;
+    int32_t command_count;
+    uint32_t reserved;
+};
+
+typedef void Render_Clear_Function(void *user, Render_Clear *clear);
+typedef void Render_Glyphs_Function(void *user, Render_Glyphs *glyphs, Text_Style *styles, Text_Instance *instances);
+typedef void Render_Blit_Function(void *user, Render_Blit *blit);
+
+struct Render_Executor{
+    void *user;
+    Render_Clear_Function *clear;
+    Render_Glyphs_Function *glyphs;
+    Render_Blit_Function *blit;
+};
+
+////////////////////////////////
+
+// Recording
+
+void
+render_stream_free(Render_Stream *stream){
+    heap_free(stream->memory);
+    memset(stream, 0, sizeof(*stream));
+}
+
+// The memory keeps its size from frame to frame, so a steady frame never allocates.
+void
+render_stream_begin_frame(Render_Stream *stream){
+    stream->size = 0;
+    stream->command_count = 0;
+}
+
+void
+render_stream__reserve(Render_Stream *stream, uint64_t size){
+    if (size > stream->max){
+        stream->max = (2*size + 4095) & ~(uint64_t)4095;
+        stream->memory = (uint8_t*)heap_realloc(stream->memory, (size_t)stream->max);
+    }
+}
+
+uint64_t
+render_command_size(uint64_t size){
+    return((size + 7) & ~(uint64_t)7);
+}
+
+void*
+render_stream__push(Render_Stream *stream, uint32_t type, uint64_t size){
+    size = render_command_size(size);
+    render_stream__reserve(stream, stream->size + size);
+    Render_Command_Header *header = (Render_Command_Header*)(stream->memory + stream->size);
+    memset(header, 0, (size_t)size);
+    header->type = type;
+    header->size = (uint32_t)size;
+    stream->size += size;
+    stream->command_count += 1;
+    return(header);
+}
+
+void
+render_clear(Render_Stream *stream, float r, float g, float b){
+    Render_Clear *clear = (Render_Clear*)render_stream__push(stream, RenderCommand_Clear, sizeof(Render_Clear));
+    clear->color[0] = r;
+    clear->color[1] = g;
+    clear->color[2] = b;
+}
+
+// Records every draw the batch has so far and starts it over. Call before anything that has to land
+// on top of the strings already drawn.
+void
+render_text_batch(Render_Stream *stream, Text_Batch *batch){
+    Text_Draw_List list = text_batch_draw_list(batch);
+    for (int32_t i = 0; i < list.command_count; i += 1){
+        Text_Draw_Command *command = &list.commands[i];
+        if (command->instance_count == 0){
+            continue;
+        }
+        uint64_t styles_size = sizeof(Text_Style)*(uint64_t)command->style_count;
+        uint64_t instances_size = sizeof(Text_Instance)*(uint64_t)command->instance_count;
+        Render_Glyphs *glyphs = (Render_Glyphs*)render_stream__push(stream, RenderCommand_Glyphs,
+                                                                    sizeof(Render_Glyphs) + styles_size + instances_size);
+        glyphs->texture = command->texture;
+        glyphs->style_count = command->style_count;
+        glyphs->instance_count = command->instance_count;
+        uint8_t *inline_data = (uint8_t*)(glyphs + 1);
+        memcpy(inline_data, list.styles + command->first_style, (size_t)styles_size);
+        memcpy(inline_data + styles_size, list.instances + command->first_instance, (size_t)instances_size);
+    }
+    text_batch_begin_frame(batch);
+}
+
+void
+render_blit(Render_Stream *stream, int32_t x, int32_t y, int32_t w, int32_t h, int32_t dst_x, int32_t dst_y){
+    Render_Blit *blit = (Render_Blit*)render_stream__push(stream, RenderCommand_Blit, sizeof(Render_Blit));
+    blit->x = x;
+    blit->y = y;
+    blit->w = w;
+    blit->h = h;
+    blit->dst_x = dst_x;
+    blit->dst_y = dst_y;
+}
+
+////////////////////////////////
+
+// Execution
+
+Text_Style*
+render_glyphs_styles(Render_Glyphs *glyphs){
+    return((Text_Style*)(glyphs + 1));
+}
+
+Text_Instance*
+render_glyphs_instances(Render_Glyphs *glyphs){
+    return((Text_Instance*)(render_glyphs_styles(glyphs) + glyphs->style_count));
+}
+
+void
+render_stream_execute(Render_Stream *stream, Render_Executor *executor){
+    uint64_t at = 0;
+    for (int32_t i = 0; i < stream->command_count; i += 1){
+        Render_Command_Header *header = (Render_Command_Header*)(stream->memory + at);
+        switch (header->type){
+            case RenderCommand_Clear:
+            {
+                executor->clear(executor->user, (Render_Clear*)header);
+            }break;
+            
+            case RenderCommand_Glyphs:
+            {
+                Render_Glyphs *glyphs = (Render_Glyphs*)header;
+                executor->glyphs(executor->user, glyphs, render_glyphs_styles(glyphs), render_glyphs_instances(glyphs));
+            }break;
+            
+            case RenderCommand_Blit:
+            {
+                executor->blit(executor->user, (Render_Blit*)header);
+            }break;
+        }
+        at += header->size;
+    }
+}
+
+////////////////////////////////
+
+// Capture Files
+
+bool32
+render_capture_begin(FILE *file){
+    Render_Capture_Header header = {0};
+    header.magic = RENDER_CAPTURE_MAGIC;
+    header.version = RENDER_CAPTURE_VERSION;
+    header.instance_size = sizeof(Text_Instance);
+    header.style_size = sizeof(Text_Style);
+    return(fwrite(&header, sizeof(header), 1, file) == 1);
+}
+
+bool32
+render_capture_check(FILE *file){
+    Render_Capture_Header header = {0};
+    return(fread(&header, sizeof(header), 1, file) == 1 &&
+           header.magic == RENDER_CAPTURE_MAGIC &&
+           header.version == RENDER_CAPTURE_VERSION &&
+           header.instance_size == sizeof(Text_Instance) &&
+           header.style_size == sizeof(Text_Style));
+}
+
+bool32
+render_capture_write_frame(FILE *file, Render_Stream *stream){
+    Render_Capture_Frame frame = {0};
+    frame.size = stream->size;
+    frame.command_count = stream->command_count;
+    return(fwrite(&frame, sizeof(frame), 1, file) == 1 &&
+           fwrite(stream->memory, 1, (size_t)stream->size, file) == stream->size);
+}
+
+// True if every instance names one of its batch's styles and its box lies in the atlas.
+bool32
+render_glyphs__validate_instances(Render_Glyphs *glyphs, Render_Atlas_Bounds *bounds){
+    Text_Instance *instances = render_glyphs_instances(glyphs);
+    for (int32_t i = 0; i < glyphs->instance_count; i += 1){
+        Text_Instance *instance = &instances[i];
+        if (instance->style >= glyphs->style_count ||
+            instance->slice >= bounds->slice_count ||
+            instance->atlas_x + instance->w > bounds->w ||
+            instance->atlas_y + instance->h > bounds->h){
+            return(false);
+        }
+    }
+    return(true);
+}
+
+// True if the commands fill exactly size bytes, each one is as big as its type says and the glyph
+// batches only read inside the atlas.
+bool32
+render_stream_validate(Render_Stream *stream, Render_Atlas_Bounds *bounds){
+    uint64_t at = 0;
+    for (int32_t i = 0; i < stream->command_count; i += 1){
+        if (stream->size - at < sizeof(Render_Command_Header)){
+            return(false);
+        }
+        Render_Command_Header *header = (Render_Command_Header*)(stream->memory + at);
+        if (header->size % 8 != 0 || header->size > stream->size - at){
+            return(false);
+        }
+        uint64_t expected = 0;
+        switch (header->type){
+            case RenderCommand_Clear:
+            {
+                expected = sizeof(Render_Clear);
+            }break;
+            
+            case RenderCommand_Glyphs:
+            {
+                if (header->size < sizeof(Render_Glyphs)){
+                    return(false);
+                }
+                Render_Glyphs *glyphs = (Render_Glyphs*)header;
+                if (glyphs->style_count < 0 || glyphs->style_count > TEXT_STYLE_MAX || glyphs->instance_count < 0){
+                    return(false);
+                }
+                expected = sizeof(Render_Glyphs) + sizeof(Text_Style)*(uint64_t)glyphs->style_count +
+                    sizeof(Text_Instance)*(uint64_t)glyphs->instance_count;
+                // The instances are only looked at once they are known to be inside the command.
+                if (render_command_size(expected) == header->size && !render_glyphs__validate_instances(glyphs, bounds)){
+                    return(false);
+                }
+            }break;
+            
+            case RenderCommand_Blit:
+            {
+                expected = sizeof(Render_Blit);
+            }break;
+            
+            default:
+            {
+                return(false);
+            }break;
+        }
+        if (render_command_size(expected) != header->size){
+            return(false);
+        }
+        at += header->size;
+    }
+    return(at == stream->size);
+}
+
+// Reads the next frame into the stream. False at the end of the file or on a frame that does not
+// hold together or reads outside the atlas.
+bool32
+render_capture_read_frame(FILE *file, Render_Stream *stream, Render_Atlas_Bounds *bounds){
+    render_stream_begin_frame(stream);
+    Render_Capture_Frame frame = {0};
+    if (fread(&frame, sizeof(frame), 1, file) != 1 || frame.command_count < 0 || frame.size > RENDER_CAPTURE_FRAME_MAX){
+        return(false);
+    }
+    render_stream__reserve(stream, frame.size);
+    if (fread(stream->memory, 1, (size_t)frame.size, file) != frame.size){
+        return(false);
+    }
+    stream->size = frame.size;
+    stream->command_count = frame.command_count;
+    if (!render_stream_validate(stream, bounds)){
+        render_stream_begin_frame(stream);
+        return(false);
+    }
+    return(true);
+}
+
+#endif
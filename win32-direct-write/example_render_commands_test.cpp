@@ -0,0 +1,317 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of render streams and capture files
+// usage: render_commands_test [seed]
+// Records frames of random strings over a random atlas and runs them through the CPU executor, which
+// must draw what compositing the draw list straight does. The frames go through a capture file and
+// must come back byte for byte. Then damaged captures: an instance with a style its batch does not
+// have, a slice past the atlas or a box hanging off the atlas, and commands of the wrong size or
+// type, must all be turned away when they are read. Last, random bytes of a capture are flipped, and
+// any frame that is still read must only name styles it has and read inside the atlas.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_cpu_compositor.h"
+#include "example_test.h"
+
+static int32_t test_frame_count = 40;
+static int32_t test_string_count = 24;
+static int32_t test_flip_count = 2000;
+
+#define TEST_ATLAS_SIDE 64
+#define TEST_SLICE_COUNT 2
+#define TEST_FRAME_W 240
+#define TEST_FRAME_H 160
+#define TEST_GLYPHS_MAX 64
+
+// A frame of strings in a few colors, on two textures so the batch is cut into several draws.
+// Boxes are anywhere in the atlas up to its edges, and strings run off every side of the frame.
+void
+test_push_frame(Text_Batch *batch, uint32_t *state){
+    uint8_t palette[4][4] = {
+        {0, 0, 0, 255}, {255, 255, 255, 255}, {200, 40, 10, 255}, {30, 120, 250, 160},
+    };
+    for (int32_t i = 0; i < test_string_count; i += 1){
+        uint8_t *color = palette[test_random_range(state, 0, 3)];
+        uint32_t texture = 1 + (i/8)%2;
+        text_batch_begin_string_rgba8(batch, texture, TEST_ATLAS_SIDE, TEST_ATLAS_SIDE, color[0], color[1], color[2], color[3]);
+        int32_t x = test_random_range(state, -40, TEST_FRAME_W);
+        int32_t y = test_random_range(state, -10, TEST_FRAME_H + 10);
+        int32_t glyph_count = test_random_range(state, 1, 20);
+        for (int32_t j = 0; j < glyph_count; j += 1){
+            Glyph_Metrics metrics = {0};
+            int32_t w = test_random_range(state, 0, 16);
+            int32_t h = test_random_range(state, 0, 16);
+            metrics.off_y = -(float)h;
+            metrics.advance = (float)(w + 1);
+            metrics.xy_w = (float)w;
+            metrics.xy_h = (float)h;
+            metrics.uv_x = (float)test_random_range(state, 0, TEST_ATLAS_SIDE - w)/TEST_ATLAS_SIDE;
+            metrics.uv_y = (float)test_random_range(state, 0, TEST_ATLAS_SIDE - h)/TEST_ATLAS_SIDE;
+            metrics.uv_slice = (float)test_random_range(state, 0, TEST_SLICE_COUNT - 1);
+            text_batch_push_glyph(batch, &metrics, (float)x, (float)y);
+            x += w + 1;
+        }
+    }
+}
+
+void
+test_stream_copy(Render_Stream *dst, Render_Stream *src){
+    render_stream_begin_frame(dst);
+    render_stream__reserve(dst, src->size);
+    memcpy(dst->memory, src->memory, (size_t)src->size);
+    dst->size = src->size;
+    dst->command_count = src->command_count;
+}
+
+// The glyph batches of a stream that is known to hold together
+int32_t
+test_glyph_commands(Render_Stream *stream, Render_Glyphs **out, int32_t max){
+    int32_t count = 0;
+    uint64_t at = 0;
+    for (int32_t i = 0; i < stream->command_count; i += 1){
+        Render_Command_Header *header = (Render_Command_Header*)(stream->memory + at);
+        if (header->type == RenderCommand_Glyphs && count < max){
+            out[count] = (Render_Glyphs*)header;
+            count += 1;
+        }
+        at += header->size;
+    }
+    return(count);
+}
+
+// Writes the stream as the only frame of a capture and reads it back.
+bool32
+test_capture_round_trip(Render_Stream *stream, Render_Stream *read, Render_Atlas_Bounds *bounds){
+    FILE *file = tmpfile();
+    if (!TEST_CHECK(file != 0)){
+        return(false);
+    }
+    bool32 written = render_capture_begin(file) && render_capture_write_frame(file, stream);
+    TEST_CHECK(written);
+    rewind(file);
+    bool32 result = render_capture_check(file) && render_capture_read_frame(file, read, bounds);
+    fclose(file);
+    return(result);
+}
+
+// Checked apart from render_stream_validate: everything the CPU executor would index.
+bool32
+test_stream_reads_inside(Render_Stream *stream, Render_Atlas_Bounds *bounds){
+    Render_Glyphs *commands[TEST_GLYPHS_MAX];
+    int32_t command_count = test_glyph_commands(stream, commands, TEST_GLYPHS_MAX);
+    for (int32_t i = 0; i < command_count; i += 1){
+        Render_Glyphs *glyphs = commands[i];
+        Text_Instance *instances = render_glyphs_instances(glyphs);
+        for (int32_t j = 0; j < glyphs->instance_count; j += 1){
+            Text_Instance *instance = &instances[j];
+            if ((int32_t)instance->style >= glyphs->style_count || (int32_t)instance->slice >= bounds->slice_count ||
+                (int32_t)instance->atlas_x + instance->w > bounds->w || (int32_t)instance->atlas_y + instance->h > bounds->h){
+                return(false);
+            }
+        }
+    }
+    return(true);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x5C0DEu);
+    uint32_t state = seed;
+    
+    Cpu_Atlas atlas = {0};
+    atlas.w = TEST_ATLAS_SIDE;
+    atlas.h = TEST_ATLAS_SIDE;
+    atlas.slice_count = TEST_SLICE_COUNT;
+    size_t atlas_size = (size_t)TEST_SLICE_COUNT*TEST_ATLAS_SIDE*TEST_ATLAS_SIDE*3;
+    atlas.texels = (uint8_t*)malloc(atlas_size);
+    for (size_t i = 0; i < atlas_size; i += 1){
+        atlas.texels[i] = (test_random(&state)%3 == 0)?0:(uint8_t)test_random(&state);
+    }
+    Render_Atlas_Bounds bounds = {atlas.w, atlas.h, atlas.slice_count};
+    
+    Cpu_Framebuffer framebuffers[3];
+    for (int32_t i = 0; i < 3; i += 1){
+        framebuffers[i].w = TEST_FRAME_W;
+        framebuffers[i].h = TEST_FRAME_H;
+        framebuffers[i].pitch = TEST_FRAME_W;
+        framebuffers[i].pixels = (uint32_t*)calloc(TEST_FRAME_W*TEST_FRAME_H, sizeof(uint32_t));
+    }
+    size_t frame_bytes = sizeof(uint32_t)*TEST_FRAME_W*TEST_FRAME_H;
+    Cpu_Framebuffer *direct = &framebuffers[0];
+    Cpu_Compositor compositor = cpu_compositor_init();
+    Cpu_Render_Target target = {0};
+    target.compositor = &compositor;
+    target.framebuffer = &framebuffers[1];
+    target.atlas = &atlas;
+    target.window = &framebuffers[2];
+    Render_Executor executor = cpu_render_executor(&target);
+    
+    Text_Batch batch = {0};
+    Render_Stream stream = {0};
+    Render_Stream read = {0};
+    Render_Stream damaged = {0};
+    
+    // Recorded, executed and captured
+    for (int32_t frame = 0; frame < test_frame_count; frame += 1){
+        int64_t failures_before = test_state.failures;
+        text_batch_begin_frame(&batch);
+        test_push_frame(&batch, &state);
+        Text_Draw_List list = text_batch_draw_list(&batch);
+        cpu_framebuffer_clear(direct, 0.1f, 0.5f, 0.5f);
+        cpu_composite_draw_list(&compositor, direct, &atlas, &list, frame%2 == 1);
+        
+        render_stream_begin_frame(&stream);
+        render_clear(&stream, 0.1f, 0.5f, 0.5f);
+        render_text_batch(&stream, &batch);
+        render_blit(&stream, 0, 0, TEST_FRAME_W, TEST_FRAME_H, 0, 0);
+        TEST_CHECK(batch.instance_count == 0);
+        TEST_CHECK(render_stream_validate(&stream, &bounds));
+        
+        target.use_simd = (frame%2 == 1);
+        render_stream_execute(&stream, &executor);
+        TEST_CHECK(memcmp(direct->pixels, framebuffers[1].pixels, frame_bytes) == 0);
+        TEST_CHECK(memcmp(direct->pixels, framebuffers[2].pixels, frame_bytes) == 0);
+        
+        if (TEST_CHECK(test_capture_round_trip(&stream, &read, &bounds))){
+            TEST_CHECK(read.size == stream.size && read.command_count == stream.command_count);
+            TEST_CHECK(memcmp(read.memory, stream.memory, (size_t)stream.size) == 0);
+            memset(framebuffers[1].pixels, 0, frame_bytes);
+            render_stream_execute(&read, &executor);
+            TEST_CHECK(memcmp(direct->pixels, framebuffers[1].pixels, frame_bytes) == 0);
+        }
+        if (test_state.failures != failures_before){
+            printf("    frame %d: %d draws, %d instances, %llu bytes\n",
+                   frame, list.command_count, list.instance_count, (unsigned long long)stream.size);
+        }
+    }
+    
+    // Damaged Captures
+    // The last frame, with one thing wrong at a time. Every instance of every batch is tried.
+    int64_t rejected = 0;
+    Render_Glyphs *commands[TEST_GLYPHS_MAX];
+    int32_t command_count = test_glyph_commands(&stream, commands, TEST_GLYPHS_MAX);
+    TEST_CHECK(command_count > 1);
+    for (int32_t i = 0; i < command_count; i += 1){
+        int32_t instance_count = commands[i]->instance_count;
+        uint64_t offset = (uint8_t*)render_glyphs_instances(commands[i]) - stream.memory;
+        for (int32_t j = 0; j < instance_count; j += 1){
+            int64_t failures_before = test_state.failures;
+            test_stream_copy(&damaged, &stream);
+            Text_Instance *instance = (Text_Instance*)(damaged.memory + offset) + j;
+            Text_Instance original = *instance;
+            
+            instance->style = (uint16_t)commands[i]->style_count;
+            TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+            instance->style = 0xFFFF;
+            TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+            *instance = original;
+            instance->slice = TEST_SLICE_COUNT;
+            TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+            *instance = original;
+            instance->atlas_x = (uint16_t)(TEST_ATLAS_SIDE - instance->w + 1);
+            TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+            *instance = original;
+            instance->atlas_y = (uint16_t)(TEST_ATLAS_SIDE - instance->h + 1);
+            TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+            *instance = original;
+            instance->atlas_x = 0xFFFF;
+            instance->w = 255;
+            TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+            rejected += 6;
+            
+            // Right up against the edges still reads inside.
+            *instance = original;
+            instance->atlas_x = (uint16_t)(TEST_ATLAS_SIDE - instance->w);
+            instance->atlas_y = (uint16_t)(TEST_ATLAS_SIDE - instance->h);
+            instance->slice = TEST_SLICE_COUNT - 1;
+            instance->style = (uint16_t)(commands[i]->style_count - 1);
+            TEST_CHECK(test_capture_round_trip(&damaged, &read, &bounds));
+            if (test_state.failures != failures_before){
+                printf("    draw %d instance %d: style %d of %d, slice %d, box %dx%d at %d,%d\n", i, j,
+                       original.style, commands[i]->style_count, original.slice, original.w, original.h,
+                       original.atlas_x, original.atlas_y);
+            }
+        }
+    }
+    
+    // Commands that do not fit the record
+    {
+        test_stream_copy(&damaged, &stream);
+        Render_Glyphs *glyphs = (Render_Glyphs*)(damaged.memory + (uint64_t)((uint8_t*)commands[0] - stream.memory));
+        TEST_CHECK(test_capture_round_trip(&damaged, &read, &bounds));
+        glyphs->instance_count += 1;
+        TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+        glyphs->instance_count -= 1;
+        glyphs->style_count = TEXT_STYLE_MAX + 1;
+        TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+        glyphs->style_count = commands[0]->style_count;
+        glyphs->header.type = 77;
+        TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+        glyphs->header.type = RenderCommand_Glyphs;
+        glyphs->header.size += 8;
+        TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+        glyphs->header.size -= 8;
+        damaged.command_count += 1;
+        TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+        damaged.command_count -= 1;
+        damaged.size -= 8;
+        TEST_CHECK(!test_capture_round_trip(&damaged, &read, &bounds));
+        rejected += 6;
+        
+        // A failed read leaves nothing to execute.
+        TEST_CHECK(read.size == 0 && read.command_count == 0);
+    }
+    
+    // Random Damage
+    int64_t flips_read = 0;
+    for (int32_t i = 0; i < test_flip_count; i += 1){
+        test_stream_copy(&damaged, &stream);
+        int32_t byte_count = test_random_range(&state, 1, 4);
+        for (int32_t j = 0; j < byte_count; j += 1){
+            uint64_t at = (uint64_t)test_random_range(&state, 0, (int32_t)damaged.size - 1);
+            damaged.memory[at] ^= (uint8_t)test_random_range(&state, 1, 255);
+        }
+        if (test_capture_round_trip(&damaged, &read, &bounds)){
+            flips_read += 1;
+            if (TEST_CHECK(test_stream_reads_inside(&read, &bounds))){
+                render_stream_execute(&read, &executor);
+            }
+        }
+        else{
+            rejected += 1;
+        }
+    }
+    
+    printf("render_commands_test: %d frames round tripped, %lld damaged captures turned away, "
+           "%lld of %d randomly damaged ones still read inside the atlas\n",
+           test_frame_count, (long long)rejected, (long long)flips_read, test_flip_count);
+    
+    render_stream_free(&damaged);
+    render_stream_free(&read);
+    render_stream_free(&stream);
+    text_batch_free(&batch);
+    cpu_compositor_free(&compositor);
+    for (int32_t i = 0; i < 3; i += 1){
+        free(framebuffers[i].pixels);
+    }
+    free(atlas.texels);
+    
+    return(test_finish("render_commands_test", seed));
+}
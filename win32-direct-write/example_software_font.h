@@ -0,0 +1,230 @@
+// DirectWrite rasterization example: a whole font baked on the CPU
+// Every glyph is baked into an atlas that stays in memory, and strings are laid out into a text
+// batch the same way draw_string does it. The software rasterizer does the bake unless the caller
+// brings other rasterizers. Nothing here needs a window or a GPU, so the headless runner and the
+// benchmarks draw text through it.
+
+#if !defined(EXAMPLE_SOFTWARE_FONT_H)
+#define EXAMPLE_SOFTWARE_FONT_H
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_truetype.h"
+#include "example_atlas_packer.h"
+#include "example_glyph_rasterizer.h"
+#include "example_software_rasterizer.h"
+#include "example_parallel_bake.h"
+#include "example_codepoint_map.h"
+#include "example_utf8.h"
+#include "example_text_batch.h"
+#include "example_layout_cache.h"
+#include "example_trace.h"
+
+// What every size of a face has in common: the codepoint map and the advances in design units, which
+// each size scales by its own pixels per design unit.
+struct Software_Font_Face{
+    TTF_Font *ttf;
+    Codepoint_Map *map;
+    uint16_t *design_advances;
+    int32_t glyph_count;
+    int32_t units_per_em;
+    int32_t cap_height;
+};
+
+struct Software_Font{
+    Glyph_Metrics *metrics;
+    Text_Glyph_Table glyphs;
+    int32_t glyph_count;
+    // slice_count slices of atlas_side*atlas_side RGB texels
+    uint8_t *atlas;
+    int32_t atlas_side;
+    int32_t slice_count;
+    Software_Font_Face *face;
+    // The face's map
+    Codepoint_Map *map;
+    // Set when the face belongs to someone else, see software_font_bake_rasterizers
+    bool32 shared_face;
+    float pixel_per_em;
+    
+    // Optional, set by the caller to keep laid out strings across frames. Fonts that share a cache
+    // need different layout ids.
+    Layout_Cache *layout_cache;
+    uint32_t layout_id;
+};
+
+Software_Font_Face
+software_font_face_init(TTF_Font *ttf){
+    Software_Font_Face face = {0};
+    face.ttf = ttf;
+    face.map = codepoint_map_alloc(ttf, ttf_codepoint_glyphs);
+    face.glyph_count = ttf->glyph_count;
+    face.units_per_em = ttf->units_per_em;
+    face.cap_height = ttf->cap_height;
+    face.design_advances = (uint16_t*)heap_alloc(sizeof(uint16_t)*ttf->glyph_count);
+    for (int32_t glyph = 0; glyph < ttf->glyph_count; glyph += 1){
+        face.design_advances[glyph] = (uint16_t)ttf_glyph_advance(ttf, glyph);
+    }
+    return(face);
+}
+
+uint64_t
+software_font_face_memory(Software_Font_Face *face){
+    return(codepoint_map_memory(face->map) + sizeof(uint16_t)*(uint64_t)face->glyph_count);
+}
+
+void
+software_font_face_free(Software_Font_Face *face){
+    codepoint_map_free(face->map);
+    heap_free(face->design_advances);
+    memset(face, 0, sizeof(*face));
+}
+
+void
+software_font__placed(void *user, int32_t glyph_index, Glyph_Bitmap *bitmap, Atlas_Slot slot){
+    Software_Font *font = (Software_Font*)user;
+    Glyph_Metrics *m = &font->metrics[glyph_index];
+    float side = (float)font->atlas_side;
+    m->off_x    = (float)bitmap->off_x;
+    m->off_y    = (float)bitmap->off_y;
+    m->xy_w     = (float)bitmap->w;
+    m->xy_h     = (float)bitmap->h;
+    m->uv_w     = (float)bitmap->w/side;
+    m->uv_h     = (float)bitmap->h/side;
+    m->uv_x     = (float)slot.x/side;
+    m->uv_y     = (float)slot.y/side;
+    m->uv_slice = (float)slot.slice;
+}
+
+// Bakes one size of a face through any rasterizer backend, worker_count rasterizers made for
+// pixel_per_em share the work. The font keeps a pointer to the face, which has to outlive it.
+Software_Font
+software_font_bake_rasterizers(Software_Font_Face *face, float pixel_per_em, Glyph_Rasterizer *rasterizers, int32_t worker_count){
+    TRACE_SCOPE("font bake");
+    assert(rasterizers[0].glyph_count == face->glyph_count);
+    float pixel_per_design_unit = pixel_per_em/(float)face->units_per_em;
+    Software_Font font = {0};
+    font.glyph_count = face->glyph_count;
+    font.pixel_per_em = pixel_per_em;
+    font.face = face;
+    font.map = face->map;
+    font.shared_face = true;
+    font.atlas_side = atlas_packer_choose_slice_side((int32_t)((float)face->cap_height*pixel_per_design_unit));
+    font.metrics = (Glyph_Metrics*)heap_alloc(sizeof(Glyph_Metrics)*face->glyph_count);
+    memset(font.metrics, 0, sizeof(Glyph_Metrics)*face->glyph_count);
+    for (int32_t glyph = 0; glyph < face->glyph_count; glyph += 1){
+        font.metrics[glyph].advance = (float)face->design_advances[glyph]*pixel_per_design_unit;
+    }
+    
+    Atlas_Packer packer = atlas_packer_init(font.atlas_side, font.atlas_side, 1);
+    font.atlas = parallel_bake_atlas(rasterizers, worker_count, &packer, software_font__placed, &font, &font.slice_count);
+    atlas_packer_free(&packer);
+    
+    font.glyphs = text_glyph_table_alloc(font.metrics, font.glyph_count, 1, font.atlas_side, font.atlas_side, true);
+    return(font);
+}
+
+// Bakes one size with the software rasterizer. Sizes of one face can share what does not depend on
+// the size through shared_face, zero gives the font a face of its own.
+Software_Font
+software_font_bake_pixels(TTF_Font *ttf, float pixel_per_em, int32_t worker_count, Software_Font_Face *shared_face){
+    Software_Font_Face *face = shared_face;
+    if (face == 0){
+        face = (Software_Font_Face*)heap_alloc(sizeof(Software_Font_Face));
+        *face = software_font_face_init(ttf);
+    }
+    
+    Software_Rasterizer *software = (Software_Rasterizer*)heap_alloc(sizeof(Software_Rasterizer)*worker_count);
+    Glyph_Rasterizer *rasterizers = (Glyph_Rasterizer*)heap_alloc(sizeof(Glyph_Rasterizer)*worker_count);
+    for (int32_t i = 0; i < worker_count; i += 1){
+        memset(&software[i], 0, sizeof(software[i]));
+        rasterizers[i] = software_rasterizer_init(&software[i], ttf, pixel_per_em);
+    }
+    Software_Font font = software_font_bake_rasterizers(face, pixel_per_em, rasterizers, worker_count);
+    for (int32_t i = 0; i < worker_count; i += 1){
+        software_rasterizer_free(&software[i]);
+    }
+    heap_free(rasterizers);
+    heap_free(software);
+    
+    font.shared_face = (shared_face != 0);
+    return(font);
+}
+
+// Bakes at 96 dpi like the window does.
+Software_Font
+software_font_bake(TTF_Font *ttf, float point_size, int32_t worker_count){
+    return(software_font_bake_pixels(ttf, point_size*(1.f/72.f)*96.f, worker_count, 0));
+}
+
+// Bytes held by one size, not counting a shared face.
+uint64_t
+software_font_memory(Software_Font *font){
+    uint64_t result = (uint64_t)font->glyph_count*sizeof(Glyph_Metrics);
+    result += text_glyph_table_memory(&font->glyphs);
+    result += (uint64_t)font->atlas_side*font->atlas_side*font->slice_count*3;
+    if (!font->shared_face){
+        result += software_font_face_memory(font->face);
+    }
+    return(result);
+}
+
+void
+software_font_free(Software_Font *font){
+    heap_free(font->metrics);
+    text_glyph_table_free(&font->glyphs);
+    // The atlas comes from parallel_bake_atlas
+    free(font->atlas);
+    if (!font->shared_face){
+        software_font_face_free(font->face);
+        heap_free(font->face);
+    }
+    memset(font, 0, sizeof(*font));
+}
+
+// draw_string for a baked font: every glyph is already in the atlas, so there is nothing to upload.
+// The scratch comes from the arena and is returned before this returns.
+void
+software_font_draw_string(Software_Font *font, Text_Batch *batch, Arena *arena, char *text, int32_t x, int32_t y,
+                          float r, float g, float b, float a){
+    TRACE_SCOPE("draw_string");
+    int32_t text_length = (int32_t)strlen(text);
+    Layout_Run run = {0};
+    if (font->layout_cache != 0 &&
+        layout_cache_lookup(font->layout_cache, font->layout_id, font->pixel_per_em, text, text_length, x, &run)){
+        text_batch_begin_string(batch, 1, font->atlas_side, font->atlas_side, r, g, b, a);
+        text_batch_push_run(batch, font->glyphs.templates, run.glyphs, run.pen_x, y, run.count);
+        return;
+    }
+    
+    Arena_Mark mark = arena_mark(arena);
+    uint32_t *codepoints = arena_push_array(arena, uint32_t, text_length);
+    uint16_t *indices = arena_push_array(arena, uint16_t, text_length);
+    int32_t *pen_x = arena_push_array(arena, int32_t, text_length);
+    if (codepoints == 0 || indices == 0 || pen_x == 0){
+        arena_pop_to(arena, mark);
+        return;
+    }
+    
+    int32_t length = utf8_decode((uint8_t*)text, text_length, codepoints);
+    for (int32_t i = 0; i < length; i += 1){
+        indices[i] = codepoint_map_lookup(font->map, codepoints[i]);
+        assert(indices[i] < font->glyph_count);
+    }
+    int32_t visible_count = text_glyph_table_layout(&font->glyphs, indices, length, x, indices, pen_x);
+    
+    text_batch_begin_string(batch, 1, font->atlas_side, font->atlas_side, r, g, b, a);
+    text_batch_push_run(batch, font->glyphs.templates, indices, pen_x, y, visible_count);
+    if (font->layout_cache != 0){
+        layout_cache_store(font->layout_cache, font->layout_id, font->pixel_per_em, text, text_length, x, indices, pen_x, visible_count);
+    }
+    
+    arena_pop_to(arena, mark);
+}
+
+#endif
@@ -0,0 +1,316 @@
+// DirectWrite rasterization example: software TrueType rasterizer backend
+// Outlines come from the glyf table and are rendered unhinted at three times the horizontal
+// resolution. A five tap filter across the subpixels then gives ClearType style RGB coverage
+// in the same layout the DirectWrite backend produces.
+
+#if !defined(EXAMPLE_SOFTWARE_RASTERIZER_H)
+#define EXAMPLE_SOFTWARE_RASTERIZER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_truetype.h"
+#include "example_glyph_rasterizer.h"
+#include "example_trace.h"
+
+struct Software_Rasterizer{
+    TTF_Font *font;
+    float pixel_per_em;
+    float pixel_per_design_unit;
+    
+    // Scratch, grown as needed and reused for every glyph
+    TTF_Outline outline;
+    float *accumulation;
+    int32_t accumulation_max;
+    uint8_t *rgb;
+    int32_t rgb_max;
+};
+
+// Signed area accumulation: each edge deposits the area it covers to its right into the cells it
+// crosses, and a running sum over the buffer turns that into coverage.
+void
+software_rasterizer__line(float *acc, int32_t w, int32_t h, float x0, float y0, float x1, float y1){
+    if (y0 == y1){
+        return;
+    }
+    float dir = 1.f;
+    if (y0 > y1){
+        dir = -1.f;
+        float t = 0.f;
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    float dxdy = (x1 - x0)/(y1 - y0);
+    float x = x0;
+    if (y0 < 0.f){
+        x -= y0*dxdy;
+    }
+    int32_t y_first = (y0 < 0.f)?0:(int32_t)y0;
+    int32_t y_end = (int32_t)ceilf(y1);
+    if (y_end > h){
+        y_end = h;
+    }
+    for (int32_t y = y_first; y < y_end; y += 1){
+        float *line = acc + y*w;
+        float top = (y0 > (float)y)?y0:(float)y;
+        float bottom = (y1 < (float)(y + 1))?y1:(float)(y + 1);
+        float dy = bottom - top;
+        float x_next = x + dxdy*dy;
+        float d = dy*dir;
+        float xa = (x < x_next)?x:x_next;
+        float xb = (x < x_next)?x_next:x;
+        float xa_floor = floorf(xa);
+        int32_t xa_i = (int32_t)xa_floor;
+        float xb_ceil = ceilf(xb);
+        int32_t xb_i = (int32_t)xb_ceil;
+        if (xb_i <= xa_i + 1){
+            float xm = 0.5f*(x + x_next) - xa_floor;
+            line[xa_i] += d - d*xm;
+            line[xa_i + 1] += d*xm;
+        }
+        else{
+            float s = 1.f/(xb - xa);
+            float xa_f = xa - xa_floor;
+            float a0 = 0.5f*s*(1.f - xa_f)*(1.f - xa_f);
+            float xb_f = xb - xb_ceil + 1.f;
+            float am = 0.5f*s*xb_f*xb_f;
+            line[xa_i] += d*a0;
+            if (xb_i == xa_i + 2){
+                line[xa_i + 1] += d*(1.f - a0 - am);
+            }
+            else{
+                float a1 = s*(1.5f - xa_f);
+                line[xa_i + 1] += d*(a1 - a0);
+                for (int32_t xi = xa_i + 2; xi < xb_i - 1; xi += 1){
+                    line[xi] += d*s;
+                }
+                float a2 = a1 + (float)(xb_i - xa_i - 3)*s;
+                line[xb_i - 1] += d*(1.f - a2 - am);
+            }
+            line[xb_i] += d*am;
+        }
+        x = x_next;
+    }
+}
+
+void
+software_rasterizer__quad(float *acc, int32_t w, int32_t h, float x0, float y0, float x1, float y1, float x2, float y2){
+    float ddx = x0 - 2.f*x1 + x2;
+    float ddy = y0 - 2.f*y1 + y2;
+    float dev_squared = ddx*ddx + ddy*ddy;
+    if (dev_squared < 0.333f){
+        software_rasterizer__line(acc, w, h, x0, y0, x2, y2);
+        return;
+    }
+    int32_t n = 1 + (int32_t)sqrtf(sqrtf(3.f*dev_squared));
+    float step = 1.f/(float)n;
+    float px = x0;
+    float py = y0;
+    for (int32_t i = 1; i <= n; i += 1){
+        float t = step*(float)i;
+        float u = 1.f - t;
+        float qx = u*u*x0 + 2.f*u*t*x1 + t*t*x2;
+        float qy = u*u*y0 + 2.f*u*t*y1 + t*t*y2;
+        software_rasterizer__line(acc, w, h, px, py, qx, qy);
+        px = qx;
+        py = qy;
+    }
+}
+
+bool32
+software_rasterize_glyph(void *backend, uint16_t glyph_index, float shift_x, Glyph_Bitmap *bitmap){
+    TRACE_SCOPE("rasterize glyph");
+    Software_Rasterizer *raster = (Software_Rasterizer*)backend;
+    TTF_Font *font = raster->font;
+    float scale = raster->pixel_per_design_unit;
+    memset(bitmap, 0, sizeof(*bitmap));
+    bitmap->advance = (float)ttf_glyph_advance(font, glyph_index)*scale;
+    
+    TTF_Outline *outline = &raster->outline;
+    if (!ttf_glyph_outline(font, glyph_index, outline)){
+        return(false);
+    }
+    if (outline->point_count == 0){
+        return(true);
+    }
+    
+    // Pixel box from the transformed points, so composites are covered, plus a pixel for the filter.
+    float min_x = outline->points[0].x;
+    float max_x = min_x;
+    float min_y = outline->points[0].y;
+    float max_y = min_y;
+    for (int32_t i = 1; i < outline->point_count; i += 1){
+        TTF_Point p = outline->points[i];
+        min_x = (p.x < min_x)?p.x:min_x;
+        max_x = (p.x > max_x)?p.x:max_x;
+        min_y = (p.y < min_y)?p.y:min_y;
+        max_y = (p.y > max_y)?p.y:max_y;
+    }
+    int32_t left = (int32_t)floorf(min_x*scale + shift_x) - 1;
+    int32_t right = (int32_t)ceilf(max_x*scale + shift_x) + 1;
+    int32_t top = (int32_t)floorf(-max_y*scale);
+    int32_t bottom = (int32_t)ceilf(-min_y*scale);
+    int32_t w = right - left;
+    int32_t h = bottom - top;
+    if (w <= 0 || h <= 0){
+        return(true);
+    }
+    
+    // Three subpixels per pixel, two extra columns so edges on the right border have somewhere to go.
+    int32_t sub_w = 3*w + 2;
+    int32_t acc_count = sub_w*h + 1;
+    if (acc_count > raster->accumulation_max){
+        raster->accumulation_max = 2*acc_count;
+        raster->accumulation = (float*)heap_realloc(raster->accumulation, sizeof(float)*raster->accumulation_max);
+    }
+    float *acc = raster->accumulation;
+    memset(acc, 0, sizeof(float)*acc_count);
+    
+    float sx = 3.f*scale;
+    float ox = 3.f*(shift_x - (float)left);
+    float sy = -scale;
+    float oy = -(float)top;
+    
+    int32_t start = 0;
+    for (int32_t c = 0; c < outline->contour_count; c += 1){
+        int32_t end = outline->contour_ends[c];
+        int32_t count = end - start;
+        if (count >= 2){
+            TTF_Point *points = outline->points + start;
+            
+            // Start from an on curve point, or the midpoint of two off curve points.
+            int32_t first_on = -1;
+            for (int32_t i = 0; i < count; i += 1){
+                if (points[i].on_curve){
+                    first_on = i;
+                    break;
+                }
+            }
+            float start_x = 0.f;
+            float start_y = 0.f;
+            if (first_on >= 0){
+                start_x = points[first_on].x;
+                start_y = points[first_on].y;
+            }
+            else{
+                first_on = 0;
+                start_x = 0.5f*(points[0].x + points[count - 1].x);
+                start_y = 0.5f*(points[0].y + points[count - 1].y);
+            }
+            
+            float px = start_x*sx + ox;
+            float py = start_y*sy + oy;
+            float cx = 0.f;
+            float cy = 0.f;
+            bool32 has_control = false;
+            for (int32_t k = 1; k <= count; k += 1){
+                TTF_Point p = points[(first_on + k)%count];
+                bool32 closing = (k == count);
+                float qx = p.x*sx + ox;
+                float qy = p.y*sy + oy;
+                if (closing){
+                    qx = start_x*sx + ox;
+                    qy = start_y*sy + oy;
+                }
+                if (p.on_curve || closing){
+                    if (has_control){
+                        software_rasterizer__quad(acc, sub_w, h, px, py, cx, cy, qx, qy);
+                    }
+                    else{
+                        software_rasterizer__line(acc, sub_w, h, px, py, qx, qy);
+                    }
+                    px = qx;
+                    py = qy;
+                    has_control = false;
+                }
+                else{
+                    if (has_control){
+                        float mx = 0.5f*(cx + qx);
+                        float my = 0.5f*(cy + qy);
+                        software_rasterizer__quad(acc, sub_w, h, px, py, cx, cy, mx, my);
+                        px = mx;
+                        py = my;
+                    }
+                    cx = qx;
+                    cy = qy;
+                    has_control = true;
+                }
+            }
+        }
+        start = end;
+    }
+    
+    // Running sum to coverage, then the subpixel filter into RGB.
+    int32_t rgb_size = 3*w*h;
+    if (rgb_size > raster->rgb_max){
+        raster->rgb_max = 2*rgb_size;
+        raster->rgb = (uint8_t*)heap_realloc(raster->rgb, raster->rgb_max);
+    }
+    float sum = 0.f;
+    for (int32_t i = 0; i < sub_w*h; i += 1){
+        sum += acc[i];
+        float coverage = fabsf(sum);
+        acc[i] = (coverage > 1.f)?1.f:coverage;
+    }
+    static float filter[5] = {1.f/9.f, 2.f/9.f, 3.f/9.f, 2.f/9.f, 1.f/9.f};
+    for (int32_t y = 0; y < h; y += 1){
+        float *line = acc + y*sub_w;
+        uint8_t *out = raster->rgb + y*3*w;
+        for (int32_t s = 0; s < 3*w; s += 1){
+            float v = 0.f;
+            for (int32_t t = -2; t <= 2; t += 1){
+                int32_t k = s + t;
+                if (k >= 0 && k < sub_w){
+                    v += filter[t + 2]*line[k];
+                }
+            }
+            out[s] = (uint8_t)(v*255.f + 0.5f);
+        }
+    }
+    
+    bitmap->off_x = left;
+    bitmap->off_y = top;
+    bitmap->w = w;
+    bitmap->h = h;
+    bitmap->rgb = raster->rgb;
+    bitmap->pitch = 3*w;
+    return(true);
+}
+
+void
+software_glyph_advances(void *backend, float *advances, int32_t glyph_count){
+    Software_Rasterizer *raster = (Software_Rasterizer*)backend;
+    for (int32_t i = 0; i < glyph_count; i += 1){
+        advances[i] = (float)ttf_glyph_advance(raster->font, i)*raster->pixel_per_design_unit;
+    }
+}
+
+Glyph_Rasterizer
+software_rasterizer_init(Software_Rasterizer *raster, TTF_Font *font, float pixel_per_em){
+    memset(raster, 0, sizeof(*raster));
+    raster->font = font;
+    raster->pixel_per_em = pixel_per_em;
+    raster->pixel_per_design_unit = pixel_per_em/(float)font->units_per_em;
+    
+    Glyph_Rasterizer result = {0};
+    result.backend = raster;
+    result.rasterize_glyph = software_rasterize_glyph;
+    result.glyph_advances = software_glyph_advances;
+    result.glyph_count = font->glyph_count;
+    result.pixel_per_em = pixel_per_em;
+    return(result);
+}
+
+void
+software_rasterizer_free(Software_Rasterizer *raster){
+    ttf_outline_free(&raster->outline);
+    heap_free(raster->accumulation);
+    heap_free(raster->rgb);
+    memset(raster, 0, sizeof(*raster));
+}
+
+#endif
@@ -0,0 +1,55 @@
+// DirectWrite rasterization example: 26.6 fixed point pen positions and subpixel phases
+// Advances are kept in 64ths of a pixel, so a line of text adds up to the font's own width instead
+// of gaining the rounding of every glyph. Where a glyph lands is the pen rounded to the nearest
+// 1/phase_count of a pixel: a whole pixel for the quad and a phase that picks one of phase_count
+// variants of the glyph, each rasterized shifted right by phase/phase_count of a pixel.
+// Only integer math decides where glyphs go, so every platform lays text out the same way.
+
+#if !defined(EXAMPLE_SUBPIXEL_H)
+#define EXAMPLE_SUBPIXEL_H
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+typedef int32_t bool32;
+
+#define SUBPIXEL_ONE 64
+#define SUBPIXEL_PHASE_MAX 4
+
+int32_t
+subpixel_from_pixels(float pixels){
+    return((int32_t)floorf(pixels*(float)SUBPIXEL_ONE + 0.5f));
+}
+
+int32_t
+subpixel_from_whole_pixels(int32_t pixels){
+    return(pixels*SUBPIXEL_ONE);
+}
+
+// Rounds toward negative infinity, pens left of the origin snap the same way as the rest.
+int32_t
+subpixel__floor_div(int32_t a, int32_t b){
+    int32_t q = a/b;
+    if ((a%b != 0) && ((a < 0) != (b < 0))){
+        q -= 1;
+    }
+    return(q);
+}
+
+// The pixel a glyph drawn at pen goes to, and in phase_out which of its variants.
+int32_t
+subpixel_snap(int32_t pen, int32_t phase_count, int32_t *phase_out){
+    assert(1 <= phase_count && phase_count <= SUBPIXEL_PHASE_MAX);
+    int32_t steps = subpixel__floor_div(pen*phase_count + SUBPIXEL_ONE/2, SUBPIXEL_ONE);
+    int32_t pixel = subpixel__floor_div(steps, phase_count);
+    *phase_out = steps - pixel*phase_count;
+    return(pixel);
+}
+
+// How far right the variant of a phase is rasterized, in pixels.
+float
+subpixel_phase_shift(int32_t phase, int32_t phase_count){
+    return((float)phase/(float)phase_count);
+}
+
+#endif
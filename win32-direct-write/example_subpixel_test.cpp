@@ -0,0 +1,124 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the 26.6 pen and subpixel phase math
+// usage: subpixel_test [seed]
+// The integer snap against rounding in double precision for every pen near the origin and random
+// pens far from it, on both sides, for every phase count; the floor division against floor; pens
+// that move right never snap left. Then lines of random advances: each advance converts to within
+// half a 64th of a pixel, so a line's 26.6 pen drifts from the exact sum by at most half a 64th per
+// glyph, and snapping the pen adds at most half a phase.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_subpixel.h"
+#include "example_test.h"
+
+static int32_t test_near_pen_max = 4096;
+static int32_t test_far_pen_count = 200000;
+static int32_t test_line_count = 20000;
+static int32_t test_line_glyph_max = 400;
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x26Au);
+    uint32_t state = seed;
+    
+    // Snap
+    for (int32_t phase_count = 1; phase_count <= SUBPIXEL_PHASE_MAX; phase_count += 1){
+        int64_t failures_before = test_state.failures;
+        int32_t last_steps = 0;
+        for (int32_t i = -test_near_pen_max - test_far_pen_count; i <= test_near_pen_max + test_far_pen_count; i += 1){
+            // Every pen near the origin, then random ones up to a few million pixels away
+            int32_t pen = i;
+            bool32 near = (-test_near_pen_max <= i && i <= test_near_pen_max);
+            if (!near){
+                pen = test_random_range(&state, -(1 << 26), 1 << 26);
+            }
+            int32_t phase = -1;
+            int32_t pixel = subpixel_snap(pen, phase_count, &phase);
+            int32_t steps = (int32_t)floor((double)pen*phase_count/SUBPIXEL_ONE + 0.5);
+            TEST_CHECK(0 <= phase && phase < phase_count);
+            if (!TEST_CHECK(pixel*phase_count + phase == steps)){
+                printf("    pen %d at %d phases: pixel %d phase %d\n", pen, phase_count, pixel, phase);
+            }
+            if (near){
+                if (i > -test_near_pen_max){
+                    TEST_CHECK(steps >= last_steps && steps <= last_steps + 1);
+                }
+                last_steps = steps;
+            }
+            // The snapped position is within half a phase of the pen, give or take the float shift.
+            double snapped = (double)pixel + subpixel_phase_shift(phase, phase_count);
+            TEST_CHECK(fabs(snapped - (double)pen/SUBPIXEL_ONE) <= 0.5/phase_count + 1e-6);
+        }
+        if (test_state.failures != failures_before){
+            printf("    %d phases\n", phase_count);
+        }
+    }
+    for (int32_t i = 0; i < 100000; i += 1){
+        int32_t a = (int32_t)test_random(&state)/2;
+        int32_t b = test_random_range(&state, 1, 4096);
+        b = (test_random(&state)%2 == 0)?b:-b;
+        TEST_CHECK(subpixel__floor_div(a, b) == (int32_t)floor((double)a/(double)b));
+    }
+    for (int32_t phase_count = 1; phase_count <= SUBPIXEL_PHASE_MAX; phase_count += 1){
+        for (int32_t phase = 0; phase < phase_count; phase += 1){
+            float shift = subpixel_phase_shift(phase, phase_count);
+            TEST_CHECK(0.f <= shift && shift < 1.f);
+        }
+    }
+    
+    // Advances
+    for (int32_t pixels = -2048; pixels <= 2048; pixels += 1){
+        TEST_CHECK(subpixel_from_whole_pixels(pixels) == subpixel_from_pixels((float)pixels));
+    }
+    double worst_line = 0.0;
+    float *advances = (float*)malloc(sizeof(float)*test_line_glyph_max);
+    for (int32_t line = 0; line < test_line_count; line += 1){
+        int32_t count = test_random_range(&state, 1, test_line_glyph_max);
+        double max_advance = (test_random(&state)%2 == 0)?12.0:200.0;
+        double exact = 0.0;
+        int32_t pen = 0;
+        for (int32_t i = 0; i < count; i += 1){
+            advances[i] = (float)(max_advance*(double)test_random(&state)/4294967296.0);
+            int32_t advance = subpixel_from_pixels(advances[i]);
+            TEST_CHECK(fabs((double)advance/SUBPIXEL_ONE - advances[i]) <= 0.5/SUBPIXEL_ONE);
+            exact += advances[i];
+            pen += advance;
+        }
+        double drift = fabs((double)pen/SUBPIXEL_ONE - exact);
+        double bound = (double)count*0.5/SUBPIXEL_ONE;
+        if (!TEST_CHECK(drift <= bound)){
+            printf("    line %d: %d glyphs drift %.5f px past the bound %.5f px\n", line, count, drift, bound);
+        }
+        worst_line = (drift/bound > worst_line)?drift/bound:worst_line;
+        for (int32_t phase_count = 1; phase_count <= SUBPIXEL_PHASE_MAX; phase_count += 1){
+            int32_t phase = 0;
+            int32_t pixel = subpixel_snap(pen, phase_count, &phase);
+            double snapped = (double)pixel + subpixel_phase_shift(phase, phase_count);
+            TEST_CHECK(fabs(snapped - exact) <= bound + 0.5/phase_count + 1e-6);
+        }
+    }
+    free(advances);
+    
+    printf("subpixel_test: %d random lines, the worst drifts %.0f%% of the rounding bound\n",
+           test_line_count, 100.0*worst_line);
+    return(test_finish("subpixel_test", seed));
+}
@@ -0,0 +1,73 @@
+// DirectWrite rasterization example: helpers for the small standalone tests
+// Each example_*_test.cpp is its own program with no platform dependencies. A failed check prints
+// where it is and the test keeps going, so one run shows every failure; the exit code is nonzero if
+// any check failed. Random inputs come from a seed on the command line, a failure can be replayed.
+
+#if !defined(EXAMPLE_TEST_H)
+#define EXAMPLE_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+typedef int32_t bool32;
+
+// Past this many failures only the count goes up.
+#define TEST_FAILURE_PRINT_MAX 20
+
+struct Test_State{
+    int64_t checks;
+    int64_t failures;
+};
+
+static Test_State test_state = {0};
+
+bool32
+test_check(bool32 condition, char *expression, char *file, int32_t line){
+    test_state.checks += 1;
+    if (!condition){
+        test_state.failures += 1;
+        if (test_state.failures <= TEST_FAILURE_PRINT_MAX){
+            printf("%s:%d: check failed: %s\n", file, line, expression);
+        }
+    }
+    return(condition);
+}
+
+#define TEST_CHECK(c) test_check((c) != 0, #c, __FILE__, __LINE__)
+
+uint32_t
+test_random(uint32_t *state){
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return(x);
+}
+
+// Uniform in [min, max]
+int32_t
+test_random_range(uint32_t *state, int32_t min, int32_t max){
+    return(min + (int32_t)(test_random(state)%(uint32_t)(max - min + 1)));
+}
+
+// The seed is the first argument when there is one. Zero would stick, it becomes one.
+uint32_t
+test_seed(int argc, char **argv, uint32_t default_seed){
+    uint32_t seed = default_seed;
+    if (argc > 1){
+        seed = (uint32_t)strtoul(argv[1], 0, 0);
+    }
+    seed = (seed == 0)?1:seed;
+    return(seed);
+}
+
+// Prints the summary line and gives the exit code.
+int
+test_finish(char *name, uint32_t seed){
+    printf("%s: seed %u, %lld checks, %lld failed\n", name, seed,
+           (long long)test_state.checks, (long long)test_state.failures);
+    return((test_state.failures == 0)?0:1);
+}
+
+#endif
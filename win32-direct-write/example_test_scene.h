@@ -0,0 +1,193 @@
+// DirectWrite rasterization example: the background/foreground test matrix
+// Every background in TB_ is drawn with every foreground set in TF_. The scene only clears and
+// draws strings through a small target, so the window and the headless runner draw the same frames.
+
+#if !defined(EXAMPLE_TEST_SCENE_H)
+#define EXAMPLE_TEST_SCENE_H
+
+#include <stdint.h>
+typedef int32_t bool32;
+
+enum{
+    TB_Black,
+    TB_White,
+    TB_Red,
+    TB_Green,
+    TB_Blue,
+    TB_Yellow,
+    TB_Cyan,
+    TB_Purple,
+    TB_COUNT,
+};
+
+enum{
+    TF_Gray,
+    TF_RGB,
+    TF_YCP,
+    TF_AlphaGray,
+    TF_AlphaRGB,
+    TF_AlphaYCP,
+    TF_COUNT,
+};
+
+static char *test_scene_back_names[TB_COUNT] = {
+    "Black", "White", "Red", "Green", "Blue", "Yellow", "Cyan", "Purple",
+};
+
+static char *test_scene_fore_names[TF_COUNT] = {
+    "Gray", "RGB", "YCP", "AlphaGray", "AlphaRGB", "AlphaYCP",
+};
+
+// Colors are linear, as glClearColor sees them with GL_FRAMEBUFFER_SRGB.
+typedef void Test_Scene_Clear_Function(void *user, float r, float g, float b);
+typedef void Test_Scene_Draw_String_Function(void *user, char *text, int32_t x, int32_t y, float r, float g, float b, float a);
+
+struct Test_Scene_Target{
+    void *user;
+    Test_Scene_Clear_Function *clear;
+    Test_Scene_Draw_String_Function *draw_string;
+};
+
+void
+test_scene_draw(Test_Scene_Target *target, int32_t bmode, int32_t fmode, bool32 paused){
+    void *user = target->user;
+    
+    float pop_r = 0.f;
+    float pop_g = 0.f;
+    float pop_b = 0.f;
+#define SetPopColor(r,g,b) pop_r = (r), pop_g = (g), pop_b = (b)
+    switch (bmode){
+        case TB_Black:
+        {
+            SetPopColor(1.f, 1.f, 1.f);
+            target->clear(user, 0.f, 0.f, 0.f);
+            target->draw_string(user, "Back = Black", 300, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TB_White:
+        {
+            SetPopColor(0.f, 0.f, 0.f);
+            target->clear(user, 1.f, 1.f, 1.f);
+            target->draw_string(user, "Back = White", 300, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TB_Red:
+        {
+            SetPopColor(0.f, 0.5f, 0.5f);
+            target->clear(user, 0.5f, 0.f, 0.f);
+            target->draw_string(user, "Back = (.5,0,0)", 300, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TB_Green:
+        {
+            SetPopColor(0.5f, 0.f, 0.5f);
+            target->clear(user, 0.f, 0.5f, 0.f);
+            target->draw_string(user, "Back = (0,.5,0)", 300, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TB_Blue:
+        {
+            SetPopColor(0.5f, 0.5f, 0.f);
+            target->clear(user, 0.f, 0.f, 0.5f);
+            target->draw_string(user, "Back = (0,0,.5)", 300, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TB_Yellow:
+        {
+            SetPopColor(0.f, 0.f, 0.5f);
+            target->clear(user, 0.5f, 0.5f, 0.f);
+            target->draw_string(user, "Back = (.5,.5,0)", 300, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TB_Cyan:
+        {
+            SetPopColor(0.5f, 0.f, 0.f);
+            target->clear(user, 0.f, 0.5f, 0.5f);
+            target->draw_string(user, "Back = (0,.5,.5)", 300, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TB_Purple:
+        {
+            SetPopColor(0.f, 0.5f, 0.f);
+            target->clear(user, 0.5f, 0.f, 0.5f);
+            target->draw_string(user, "Back = (.5,0,.5)", 300, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+    }
+#undef SetPopColor
+    
+    switch (fmode){
+        case TF_Gray:
+        {
+            for (int32_t i = 1; i <= 6; i += 1){
+                float v = (i - 1)/5.f;
+                target->draw_string(user, "DirectWrite rasterizer testing", 50, i*80 + 40, v, v, v, 1.f);
+            }
+            target->draw_string(user, "Fore = Grays", 550, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TF_RGB:
+        {
+            for (int32_t i = 0; i < 3; i += 1){
+                float v[3] = {0.f, 0.f, 0.f};
+                v[i] = 0.5f;
+                target->draw_string(user, "DirectWrite rasterizer testing", 50 + 250*i, 120, v[0], v[1], v[2], 1.f);
+            }
+            target->draw_string(user, "Fore = Red Green Blue", 550, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TF_YCP:
+        {
+            for (int32_t i = 0; i < 3; i += 1){
+                float v[3] = {0.5f, 0.5f, 0.5f};
+                v[(i + 2)%3] = 0.f;
+                target->draw_string(user, "DirectWrite rasterizer testing", 50 + 250*i, 120, v[0], v[1], v[2], 1.f);
+            }
+            target->draw_string(user, "Fore = Yellow Cyan Purple", 550, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TF_AlphaGray:
+        {
+            for (int32_t j = 1; j <= 6; j += 1){
+                float a = (j - 1)/5.f;
+                target->draw_string(user, "DirectWrite rasterizer testing",  50, j*80 + 40, 1.f, 1.f, 1.f, a);
+                target->draw_string(user, "DirectWrite rasterizer testing", 300, j*80 + 40, 0.f, 0.f, 0.f, a);
+            }
+            target->draw_string(user, "Fore = Alpha Black and White", 550, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TF_AlphaRGB:
+        {
+            for (int32_t j = 1; j <= 6; j += 1){
+                float a = (j - 1)/5.f;
+                for (int32_t i = 0; i < 3; i += 1){
+                    float v[3] = {0.f, 0.f, 0.f};
+                    v[i] = 0.5f;
+                    target->draw_string(user, "DirectWrite rasterizer testing", 50 + 250*i, j*80 + 40, v[0], v[1], v[2], a);
+                }
+            }
+            target->draw_string(user, "Fore = Alpha Red Green Blue", 550, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+        
+        case TF_AlphaYCP:
+        {
+            for (int32_t j = 1; j <= 6; j += 1){
+                float a = (j - 1)/5.f;
+                for (int32_t i = 0; i < 3; i += 1){
+                    float v[3] = {0.5f, 0.5f, 0.5f};
+                    v[(i + 2)%3] = 0.f;
+                    target->draw_string(user, "DirectWrite rasterizer testing", 50 + 250*i, j*80 + 40, v[0], v[1], v[2], a);
+                }
+            }
+            target->draw_string(user, "Fore = Alpha Yellow Cyan Purple", 550, 60, pop_r, pop_g, pop_b, 1.f);
+        }break;
+    }
+    
+    if (!paused){
+        target->draw_string(user, "Press space to pause cycle",  50, 60, pop_r, pop_g, pop_b, 1.f);
+    }
+    else{
+        target->draw_string(user, "Press space to resume cycle", 50, 60, pop_r, pop_g, pop_b, 1.f);
+    }
+}
+
+#endif
@@ -0,0 +1,593 @@
+// DirectWrite rasterization example: frame level text batch
+// Every string drawn during a frame appends one 16 byte instance per glyph to one stream. Strings
+// refer to a table of colors and M values by index, so strings of different colors still go out in
+// one upload and one draw per atlas texture. The batch produces a backend neutral draw list;
+// executing it is up to the renderer.
+
+#if !defined(EXAMPLE_TEXT_BATCH_H)
+#define EXAMPLE_TEXT_BATCH_H
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXT_BATCH_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define TEXT_BATCH_AVX2 1
+#include <immintrin.h>
+#endif
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_m_values.h"
+#include "example_subpixel.h"
+
+// Placement of a baked glyph, both on screen relative to the pen and in the atlas
+struct Glyph_Metrics{
+    float off_x;
+    float off_y;
+    // Unrounded, layout keeps it in 26.6
+    float advance;
+    float xy_w;
+    float xy_h;
+    float uv_w;
+    float uv_h;
+    // Packed position of the glyph's box in the atlas
+    float uv_x;
+    float uv_y;
+    float uv_slice;
+};
+
+// One glyph of the frame. The quad is expanded from this on the GPU.
+struct Text_Instance{
+    // Top left of the glyph's box in pixels
+    int16_t x;
+    int16_t y;
+    // Top left of the box in atlas texels
+    uint16_t atlas_x;
+    uint16_t atlas_y;
+    uint8_t w;
+    uint8_t h;
+    uint8_t slice;
+    uint8_t flags;
+    // Index into the styles of the instance's draw command
+    uint16_t style;
+    uint16_t reserved;
+};
+// The shader reads the stream with this stride, and the emitters add the pen to one 128 bit lane.
+static_assert(sizeof(Text_Instance) == 16, "Text_Instance must stay 16 bytes");
+
+// Color and M_value_table[1..6] of a string, laid out as three vec4 for the shader. Colors are
+// quantized to 8 bits so the M values come straight out of the tables in example_m_values.h.
+struct Text_Style{
+    float color[3];
+    float M[6];
+    float unused[3];
+};
+
+// The most styles a single draw can see. A command is split when a frame uses more.
+#define TEXT_STYLE_MAX 64
+
+struct Text_Draw_Command{
+    uint32_t texture;
+    int32_t first_instance;
+    int32_t instance_count;
+    int32_t first_style;
+    int32_t style_count;
+};
+
+struct Text_Draw_List{
+    Text_Instance *instances;
+    int32_t instance_count;
+    Text_Style *styles;
+    int32_t style_count;
+    Text_Draw_Command *commands;
+    int32_t command_count;
+};
+
+struct Text_Batch{
+    Text_Instance *instances;
+    int32_t instance_count;
+    int32_t instance_max;
+    Text_Style *styles;
+    // RGBA8 of every style, which is all a style depends on
+    uint32_t *style_keys;
+    int32_t style_count;
+    int32_t style_max;
+    Text_Draw_Command *commands;
+    int32_t command_count;
+    int32_t command_max;
+    
+    // The string being pushed
+    float atlas_w;
+    float atlas_h;
+    uint16_t style;
+    
+    int32_t string_count;
+    int32_t glyph_count;
+};
+
+void
+text_batch_free(Text_Batch *batch){
+    heap_free(batch->instances);
+    heap_free(batch->styles);
+    heap_free(batch->style_keys);
+    heap_free(batch->commands);
+    memset(batch, 0, sizeof(*batch));
+}
+
+// The arrays keep their size from frame to frame, so a steady frame never allocates.
+void
+text_batch_begin_frame(Text_Batch *batch){
+    batch->instance_count = 0;
+    batch->style_count = 0;
+    batch->command_count = 0;
+    batch->string_count = 0;
+    batch->glyph_count = 0;
+}
+
+void
+text_batch__begin_command(Text_Batch *batch, uint32_t texture){
+    if (batch->command_count + 1 > batch->command_max){
+        batch->command_max = 2*(batch->command_count + 1);
+        batch->commands = (Text_Draw_Command*)heap_realloc(batch->commands, sizeof(Text_Draw_Command)*batch->command_max);
+    }
+    Text_Draw_Command *command = &batch->commands[batch->command_count];
+    batch->command_count += 1;
+    command->texture = texture;
+    command->first_instance = batch->instance_count;
+    command->instance_count = 0;
+    command->first_style = batch->style_count;
+    command->style_count = 0;
+}
+
+// Strings on the same texture share a command, and strings of the same color share a style.
+void
+text_batch_begin_string_rgba8(Text_Batch *batch, uint32_t texture, int32_t atlas_w, int32_t atlas_h,
+                              uint8_t r, uint8_t g, uint8_t b, uint8_t a){
+    uint32_t key = ((uint32_t)r << 24)|((uint32_t)g << 16)|((uint32_t)b << 8)|a;
+    
+    Text_Draw_Command *command = 0;
+    if (batch->command_count > 0){
+        command = &batch->commands[batch->command_count - 1];
+        if (command->texture != texture){
+            command = 0;
+        }
+    }
+    
+    int32_t style_index = -1;
+    if (command != 0){
+        uint32_t *keys = batch->style_keys + command->first_style;
+        for (int32_t i = command->style_count - 1; i >= 0; i -= 1){
+            if (keys[i] == key){
+                style_index = i;
+                break;
+            }
+        }
+        if (style_index < 0 && command->style_count == TEXT_STYLE_MAX){
+            command = 0;
+        }
+    }
+    if (command == 0){
+        text_batch__begin_command(batch, texture);
+        command = &batch->commands[batch->command_count - 1];
+    }
+    if (style_index < 0){
+        if (batch->style_count + 1 > batch->style_max){
+            batch->style_max = 2*(batch->style_count + 1);
+            batch->styles = (Text_Style*)heap_realloc(batch->styles, sizeof(Text_Style)*batch->style_max);
+            batch->style_keys = (uint32_t*)heap_realloc(batch->style_keys, sizeof(uint32_t)*batch->style_max);
+        }
+        Text_Style *style = &batch->styles[batch->style_count];
+        memset(style, 0, sizeof(*style));
+        float M_value_table[7];
+        m_values_rgba8(r, g, b, a, M_value_table);
+        style->color[0] = m_value_alphas.a[r];
+        style->color[1] = m_value_alphas.a[g];
+        style->color[2] = m_value_alphas.a[b];
+        memcpy(style->M, M_value_table + 1, sizeof(style->M));
+        batch->style_keys[batch->style_count] = key;
+        batch->style_count += 1;
+        style_index = command->style_count;
+        command->style_count += 1;
+    }
+    
+    batch->atlas_w = (float)atlas_w;
+    batch->atlas_h = (float)atlas_h;
+    batch->style = (uint16_t)style_index;
+    batch->string_count += 1;
+}
+
+void
+text_batch_begin_string(Text_Batch *batch, uint32_t texture, int32_t atlas_w, int32_t atlas_h,
+                        float r, float g, float b, float a){
+    text_batch_begin_string_rgba8(batch, texture, atlas_w, atlas_h,
+                                  m_value_quantize(r), m_value_quantize(g), m_value_quantize(b), m_value_quantize(a));
+}
+
+////////////////////////////////
+
+// Instance Ranges
+// The fields of an instance are narrow and nothing upstream bounds them: a string can be drawn far
+// off screen and a glyph can be baked bigger than 255 texels. Every instance is made through these
+// so nothing wraps. A position saturates at the int16 limits, which is off any screen; a box is cut
+// down to 255 texels; a glyph in a slice or at an atlas position past the fields draws nothing.
+
+int16_t
+text__saturate_int16(int32_t v){
+    v = (v < INT16_MIN)?INT16_MIN:v;
+    v = (v > INT16_MAX)?INT16_MAX:v;
+    return((int16_t)v);
+}
+
+// Floats out of the int32 range would be undefined to convert, they are pinned first.
+int32_t
+text__whole_f32(float v, float min, float max){
+    v = (v < min)?min:v;
+    v = (v > max)?max:v;
+    return((int32_t)v);
+}
+
+// Every field but style from the glyph's metrics, with the pen at x, y in whole pixels
+void
+text__instance_from_metrics(Glyph_Metrics *metrics, float x, float y, float atlas_w, float atlas_h, Text_Instance *instance){
+    float atlas_x_f = metrics->uv_x*atlas_w + 0.5f;
+    float atlas_y_f = metrics->uv_y*atlas_h + 0.5f;
+    int32_t atlas_x = text__whole_f32(atlas_x_f, 0.f, 65536.f);
+    int32_t atlas_y = text__whole_f32(atlas_y_f, 0.f, 65536.f);
+    int32_t slice = text__whole_f32(metrics->uv_slice, 0.f, 256.f);
+    int32_t w = text__whole_f32(metrics->xy_w, 0.f, 255.f);
+    int32_t h = text__whole_f32(metrics->xy_h, 0.f, 255.f);
+    if (atlas_x_f < 0.f || atlas_y_f < 0.f || metrics->uv_slice < 0.f ||
+        atlas_x > UINT16_MAX || atlas_y > UINT16_MAX || slice > UINT8_MAX){
+        atlas_x = 0;
+        atlas_y = 0;
+        slice = 0;
+        w = 0;
+        h = 0;
+    }
+    memset(instance, 0, sizeof(*instance));
+    instance->x       = text__saturate_int16(text__whole_f32(x + metrics->off_x, -65536.f, 65536.f));
+    instance->y       = text__saturate_int16(text__whole_f32(y + metrics->off_y, -65536.f, 65536.f));
+    instance->atlas_x = (uint16_t)atlas_x;
+    instance->atlas_y = (uint16_t)atlas_y;
+    instance->w       = (uint8_t)w;
+    instance->h       = (uint8_t)h;
+    instance->slice   = (uint8_t)slice;
+}
+
+////////////////////////////////
+
+// Appends a glyph with the pen at layout_x, layout_y. Both are whole pixels.
+void
+text_batch_push_glyph(Text_Batch *batch, Glyph_Metrics *metrics, float layout_x, float layout_y){
+    if (batch->instance_count + 1 > batch->instance_max){
+        batch->instance_max = 2*(batch->instance_count + 1);
+        batch->instances = (Text_Instance*)heap_realloc(batch->instances, sizeof(Text_Instance)*batch->instance_max);
+    }
+    
+    Text_Instance *instance = &batch->instances[batch->instance_count];
+    text__instance_from_metrics(metrics, layout_x, layout_y, batch->atlas_w, batch->atlas_h, instance);
+    instance->style = batch->style;
+    
+    batch->instance_count += 1;
+    batch->commands[batch->command_count - 1].instance_count += 1;
+    batch->glyph_count += 1;
+}
+
+////////////////////////////////
+
+// Instance Generation
+// Every glyph keeps a template instance with its box relative to the pen and style zero. A string's
+// instances are then one template load and one add per glyph: the pen goes into x and y and the
+// style into its slot, every other field is carried over unchanged. The pen is pinned to int16 and
+// the add saturates, so a string past the int16 range lands at the limit instead of wrapping back
+// onto the screen.
+
+void
+text_instance_template(Glyph_Metrics *metrics, int32_t atlas_w, int32_t atlas_h, Text_Instance *instance){
+    text__instance_from_metrics(metrics, 0.f, 0.f, (float)atlas_w, (float)atlas_h, instance);
+}
+
+Text_Instance*
+text_alloc_instance_templates(Glyph_Metrics *metrics, int32_t glyph_count, int32_t atlas_w, int32_t atlas_h){
+    Text_Instance *templates = (Text_Instance*)heap_alloc(sizeof(Text_Instance)*glyph_count);
+    for (int32_t i = 0; i < glyph_count; i += 1){
+        text_instance_template(&metrics[i], atlas_w, atlas_h, &templates[i]);
+    }
+    return(templates);
+}
+
+// Reference for text_emit_instances. pen_x is the prefix sum of the advances: the pen position
+// of each glyph, in whole pixels.
+void
+text_emit_instances_scalar(Text_Instance *templates, uint16_t *glyphs, int32_t *pen_x, int32_t pen_y,
+                           uint16_t style, int32_t count, Text_Instance *out){
+    int16_t y = text__saturate_int16(pen_y);
+    for (int32_t i = 0; i < count; i += 1){
+        Text_Instance instance = templates[glyphs[i]];
+        instance.x = text__saturate_int16(instance.x + text__saturate_int16(pen_x[i]));
+        instance.y = text__saturate_int16(instance.y + y);
+        instance.style = style;
+        out[i] = instance;
+    }
+}
+
+void
+text_emit_instances(Text_Instance *templates, uint16_t *glyphs, int32_t *pen_x, int32_t pen_y,
+                    uint16_t style, int32_t count, Text_Instance *out){
+    int32_t i = 0;
+    // The saturating add leaves the lanes that add zero as they are, unsigned ones included, and a
+    // style is far below the signed limit.
+    assert(style < TEXT_STYLE_MAX);
+    int16_t y = text__saturate_int16(pen_y);
+#if defined(TEXT_BATCH_AVX2)
+    // Two instances per 256 bit add
+    for (; i + 2 <= count; i += 2){
+        __m128i t0 = _mm_loadu_si128((__m128i*)&templates[glyphs[i]]);
+        __m128i t1 = _mm_loadu_si128((__m128i*)&templates[glyphs[i + 1]]);
+        __m256i t = _mm256_inserti128_si256(_mm256_castsi128_si256(t0), t1, 1);
+        __m256i delta = _mm256_setr_epi16(text__saturate_int16(pen_x[i]), y, 0, 0, 0, 0, (int16_t)style, 0,
+                                          text__saturate_int16(pen_x[i + 1]), y, 0, 0, 0, 0, (int16_t)style, 0);
+        _mm256_storeu_si256((__m256i*)&out[i], _mm256_adds_epi16(t, delta));
+    }
+#endif
+#if defined(TEXT_BATCH_SSE2)
+    for (; i < count; i += 1){
+        __m128i t = _mm_loadu_si128((__m128i*)&templates[glyphs[i]]);
+        __m128i delta = _mm_setr_epi16(text__saturate_int16(pen_x[i]), y, 0, 0, 0, 0, (int16_t)style, 0);
+        _mm_storeu_si128((__m128i*)&out[i], _mm_adds_epi16(t, delta));
+    }
+#endif
+    text_emit_instances_scalar(templates, glyphs + i, pen_x + i, pen_y, style, count - i, out + i);
+}
+
+////////////////////////////////
+
+// Sparse Glyph Table
+// Whitespace and control glyphs have an advance and nothing to draw. The table keeps the advance of
+// every glyph and a template only for glyphs that draw, numbered densely, so layout can drop the
+// empty ones before any instance is made and runs index the templates by their dense number.
+// With more than one subpixel phase every glyph has phase_count variants, see example_subpixel.h.
+// Variant glyph*phase_count + phase is drawn with the pen in that phase and gets its own template.
+// Baked on demand, a variant the glyph cache evicts is released and keeps its dense index in case it
+// comes back. Once every dense index has been handed out, a new variant takes the index of a
+// released one, and runs laid out before that may point at the wrong template.
+
+// Draws nothing, only moves the pen
+#define TEXT_GLYPH_EMPTY 0xFFFF
+// Not baked yet, only seen with glyphs baked on demand
+#define TEXT_GLYPH_UNKNOWN 0xFFFE
+// Dense indices run from 0 up to the first of the markers
+#define TEXT_GLYPH_DENSE_MAX TEXT_GLYPH_UNKNOWN
+
+struct Text_Glyph_Table{
+    int32_t glyph_count;
+    int32_t phase_count;
+    // Per glyph: 26.6 advance
+    int32_t *advances;
+    // Per variant: the dense index or TEXT_GLYPH_EMPTY/TEXT_GLYPH_UNKNOWN
+    uint16_t *dense;
+    // Per drawable variant: the template and the variant it belongs to
+    Text_Instance *templates;
+    uint32_t *drawable_variants;
+    // Per dense index: set until its variant is released
+    uint8_t *drawable_live;
+    int32_t drawable_count;
+    int32_t drawable_max;
+    int32_t empty_count;
+    // Where the search for a released index goes on from
+    int32_t reuse_cursor;
+    // Dense indices taken from a released variant for another one
+    uint64_t reassignments;
+    // Drawable glyphs of a baked font past the last dense index, drawn as empty
+    int32_t dropped_count;
+};
+
+bool32
+text_glyph_is_empty(Glyph_Metrics *metrics){
+    return(metrics->xy_w <= 0.f || metrics->xy_h <= 0.f);
+}
+
+// With baked set every glyph's metrics are final and there is one phase. Otherwise every variant
+// starts out unknown and is filled in by text_glyph_table_set as it gets baked.
+Text_Glyph_Table
+text_glyph_table_alloc(Glyph_Metrics *metrics, int32_t glyph_count, int32_t phase_count, int32_t atlas_w, int32_t atlas_h, bool32 baked){
+    assert(1 <= phase_count && phase_count <= SUBPIXEL_PHASE_MAX);
+    assert(!baked || phase_count == 1);
+    int32_t variant_count = glyph_count*phase_count;
+    Text_Glyph_Table table = {0};
+    table.glyph_count = glyph_count;
+    table.phase_count = phase_count;
+    table.advances = (int32_t*)heap_alloc(sizeof(int32_t)*glyph_count);
+    table.dense = (uint16_t*)heap_alloc(sizeof(uint16_t)*variant_count);
+    for (int32_t i = 0; i < glyph_count; i += 1){
+        table.advances[i] = subpixel_from_pixels(metrics[i].advance);
+    }
+    for (int32_t i = 0; i < variant_count; i += 1){
+        table.dense[i] = TEXT_GLYPH_UNKNOWN;
+    }
+    if (baked){
+        // Only a font whose 65535 glyphs all draw runs out of dense indices, by one.
+        for (int32_t i = 0; i < glyph_count; i += 1){
+            if (text_glyph_is_empty(&metrics[i]) || table.drawable_count == TEXT_GLYPH_DENSE_MAX){
+                table.dropped_count += !text_glyph_is_empty(&metrics[i]);
+                table.dense[i] = TEXT_GLYPH_EMPTY;
+                table.empty_count += 1;
+            }
+            else{
+                table.dense[i] = (uint16_t)table.drawable_count;
+                table.drawable_count += 1;
+            }
+        }
+        table.drawable_max = table.drawable_count;
+        table.templates = (Text_Instance*)heap_alloc(sizeof(Text_Instance)*(table.drawable_max + 1));
+        table.drawable_variants = (uint32_t*)heap_alloc(sizeof(uint32_t)*(table.drawable_max + 1));
+        table.drawable_live = (uint8_t*)heap_alloc(table.drawable_max + 1);
+        memset(table.drawable_live, 1, table.drawable_max + 1);
+        for (int32_t i = 0; i < glyph_count; i += 1){
+            if (table.dense[i] != TEXT_GLYPH_EMPTY){
+                text_instance_template(&metrics[i], atlas_w, atlas_h, &table.templates[table.dense[i]]);
+                table.drawable_variants[table.dense[i]] = (uint32_t)i;
+            }
+        }
+    }
+    return(table);
+}
+
+void
+text_glyph_table_free(Text_Glyph_Table *table){
+    heap_free(table->advances);
+    heap_free(table->dense);
+    heap_free(table->templates);
+    heap_free(table->drawable_variants);
+    heap_free(table->drawable_live);
+    memset(table, 0, sizeof(*table));
+}
+
+// A fresh dense index while there are any left, then the next one whose variant was released. That
+// variant goes back to unknown. Returns TEXT_GLYPH_UNKNOWN when every variant with an index is live.
+uint16_t
+text_glyph_table__take_dense(Text_Glyph_Table *table){
+    if (table->drawable_count < TEXT_GLYPH_DENSE_MAX){
+        if (table->drawable_count + 1 > table->drawable_max){
+            int32_t drawable_max = 2*(table->drawable_count + 1);
+            table->drawable_max = (drawable_max < TEXT_GLYPH_DENSE_MAX)?drawable_max:TEXT_GLYPH_DENSE_MAX;
+            table->templates = (Text_Instance*)heap_realloc(table->templates, sizeof(Text_Instance)*table->drawable_max);
+            table->drawable_variants = (uint32_t*)heap_realloc(table->drawable_variants, sizeof(uint32_t)*table->drawable_max);
+            table->drawable_live = (uint8_t*)heap_realloc(table->drawable_live, table->drawable_max);
+        }
+        uint16_t dense = (uint16_t)table->drawable_count;
+        table->drawable_count += 1;
+        return(dense);
+    }
+    for (int32_t step = 0; step < table->drawable_count; step += 1){
+        int32_t dense = table->reuse_cursor;
+        table->reuse_cursor = (dense + 1)%table->drawable_count;
+        if (!table->drawable_live[dense]){
+            table->dense[table->drawable_variants[dense]] = TEXT_GLYPH_UNKNOWN;
+            table->reassignments += 1;
+            return((uint16_t)dense);
+        }
+    }
+    return(TEXT_GLYPH_UNKNOWN);
+}
+
+// Records a variant that was just baked. A variant keeps its dense index when it is baked again.
+// Returns false when no dense index is free, the variant stays unknown and draws nothing.
+bool32
+text_glyph_table_set(Text_Glyph_Table *table, int32_t variant, Glyph_Metrics *metrics, int32_t atlas_w, int32_t atlas_h){
+    uint16_t dense = table->dense[variant];
+    if (text_glyph_is_empty(metrics)){
+        if (dense == TEXT_GLYPH_UNKNOWN){
+            table->dense[variant] = TEXT_GLYPH_EMPTY;
+            table->empty_count += 1;
+        }
+        else if (dense != TEXT_GLYPH_EMPTY){
+            // Keeps its slot, a glyph cut down to nothing by its cell just draws an empty box.
+            text_instance_template(metrics, atlas_w, atlas_h, &table->templates[dense]);
+            table->drawable_live[dense] = 1;
+        }
+        return(true);
+    }
+    if (dense == TEXT_GLYPH_UNKNOWN || dense == TEXT_GLYPH_EMPTY){
+        uint16_t taken = text_glyph_table__take_dense(table);
+        if (taken == TEXT_GLYPH_UNKNOWN){
+            return(false);
+        }
+        if (dense == TEXT_GLYPH_EMPTY){
+            table->empty_count -= 1;
+        }
+        dense = taken;
+        table->dense[variant] = dense;
+        table->drawable_variants[dense] = (uint32_t)variant;
+    }
+    table->drawable_live[dense] = 1;
+    text_instance_template(metrics, atlas_w, atlas_h, &table->templates[dense]);
+    return(true);
+}
+
+// A variant left the glyph cache. It keeps its dense index until a new variant needs the index.
+void
+text_glyph_table_release(Text_Glyph_Table *table, int32_t variant){
+    uint16_t dense = table->dense[variant];
+    if (dense < TEXT_GLYPH_DENSE_MAX){
+        table->drawable_live[dense] = 0;
+    }
+}
+
+uint64_t
+text_glyph_table_memory(Text_Glyph_Table *table){
+    return((uint64_t)table->glyph_count*sizeof(int32_t) +
+           (uint64_t)table->glyph_count*table->phase_count*sizeof(uint16_t) +
+           (uint64_t)table->drawable_max*(sizeof(Text_Instance) + sizeof(uint32_t) + sizeof(uint8_t)));
+}
+
+// Dense indices and pen positions of the glyphs of a string that draw, with the pen starting at x.
+// dense may be glyphs itself, the writes never pass the reads. Returns how many glyphs draw.
+// Every glyph is written and only the ones that draw move the end along, which costs no branch on
+// the mix of empty and drawn glyphs. With a single phase the variant is the glyph and the snap is a
+// rounding shift; the general snap divides by the phase count.
+int32_t
+text_glyph_table_layout(Text_Glyph_Table *table, uint16_t *glyphs, int32_t count, int32_t x,
+                        uint16_t *dense, int32_t *pen_x){
+    int32_t phase_count = table->phase_count;
+    uint16_t *table_dense = table->dense;
+    int32_t *advances = table->advances;
+    int32_t visible_count = 0;
+    int32_t pen = subpixel_from_whole_pixels(x);
+    if (phase_count == 1){
+        for (int32_t i = 0; i < count; i += 1){
+            uint16_t glyph = glyphs[i];
+            int32_t phase = 0;
+            uint16_t index = table_dense[glyph];
+            dense[visible_count] = index;
+            pen_x[visible_count] = subpixel_snap(pen, 1, &phase);
+            visible_count += (index < TEXT_GLYPH_UNKNOWN);
+            pen += advances[glyph];
+        }
+    }
+    else{
+        for (int32_t i = 0; i < count; i += 1){
+            uint16_t glyph = glyphs[i];
+            int32_t phase = 0;
+            int32_t pixel_x = subpixel_snap(pen, phase_count, &phase);
+            uint16_t index = table_dense[glyph*phase_count + phase];
+            dense[visible_count] = index;
+            pen_x[visible_count] = pixel_x;
+            visible_count += (index < TEXT_GLYPH_UNKNOWN);
+            pen += advances[glyph];
+        }
+    }
+    return(visible_count);
+}
+
+// Appends a run of glyphs of the current string. pen_x holds the pen position of every glyph.
+void
+text_batch_push_run(Text_Batch *batch, Text_Instance *templates, uint16_t *glyphs, int32_t *pen_x, int32_t pen_y, int32_t count){
+    if (batch->instance_count + count > batch->instance_max){
+        batch->instance_max = 2*(batch->instance_count + count);
+        batch->instances = (Text_Instance*)heap_realloc(batch->instances, sizeof(Text_Instance)*batch->instance_max);
+    }
+    text_emit_instances(templates, glyphs, pen_x, pen_y, batch->style, count, batch->instances + batch->instance_count);
+    batch->instance_count += count;
+    batch->commands[batch->command_count - 1].instance_count += count;
+    batch->glyph_count += count;
+}
+
+Text_Draw_List
+text_batch_draw_list(Text_Batch *batch){
+    Text_Draw_List list = {0};
+    list.instances = batch->instances;
+    list.instance_count = batch->instance_count;
+    list.styles = batch->styles;
+    list.style_count = batch->style_count;
+    list.commands = batch->commands;
+    list.command_count = batch->command_count;
+    return(list);
+}
+
+#endif
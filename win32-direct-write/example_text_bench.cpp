@@ -0,0 +1,2506 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: benchmarks for the platform independent parts of the text pipeline
+// usage: text_bench [-data <dir>] <font.ttf>...
+// The text inputs are named relative to win32-direct-write and found from the executable's build
+// directory, -data points somewhere else. See example_data_path.h. The source code input is
+// test_data/source_file.txt, a frozen copy of example_rasterizer.cpp.
+// Checks of parts that need no font are their own programs, see example_*_test.cpp.
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+#include "example_truetype.h"
+#include "example_atlas_packer.h"
+#include "example_glyph_cache.h"
+#include "example_font_cache_file.h"
+#include "example_glyph_rasterizer.h"
+#include "example_software_rasterizer.h"
+#include "example_parallel_bake.h"
+#include "example_codepoint_map.h"
+#include "example_m_values.h"
+#include "example_utf8.h"
+#include "example_text_batch.h"
+#include "example_cpu_compositor.h"
+#include "example_software_font.h"
+#include "example_atlas_levels.h"
+#include "example_subpixel.h"
+#include "example_font_registry.h"
+#include "example_atlas_dirty.h"
+#include "example_render_commands.h"
+#include "example_bmp_file.h"
+#include "example_data_path.h"
+
+////////////////////////////////
+
+// What a bench prints about its results is checked in every build, not with assert. A failed check
+// is printed, the result it backs is printed as failed and the exit code is nonzero.
+static int32_t bench_failure_count = 0;
+
+bool32
+bench_verify(bool32 condition, char *what){
+    if (!condition){
+        bench_failure_count += 1;
+        printf("FAILED: %s\n", what);
+    }
+    return(condition);
+}
+
+uint64_t
+bench_now_ns(void){
+    uint64_t result = 0;
+#if defined(_WIN32)
+    LARGE_INTEGER counter = {0};
+    LARGE_INTEGER frequency = {0};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (uint64_t)((double)counter.QuadPart*1000000000.0/(double)frequency.QuadPart);
+#else
+    struct timespec t = {0};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (uint64_t)t.tv_sec*1000000000ull + (uint64_t)t.tv_nsec;
+#endif
+    return(result);
+}
+
+uint8_t*
+bench_read_file(char *file_name, int32_t *size_out){
+    uint8_t *result = 0;
+    FILE *file = fopen(file_name, "rb");
+    if (file != 0){
+        fseek(file, 0, SEEK_END);
+        int32_t size = (int32_t)ftell(file);
+        fseek(file, 0, SEEK_SET);
+        result = (uint8_t*)malloc(size + 1);
+        fread(result, 1, size, file);
+        result[size] = 0;
+        fclose(file);
+        *size_out = size;
+    }
+    return(result);
+}
+
+////////////////////////////////
+
+// Pixel box of a glyph the way the ClearType bake sees it: the outline box plus a column of filter
+// spill on each side.
+void
+bench_glyph_pixel_box(TTF_Font *font, int32_t glyph, float pixel_per_design_unit, int32_t *w, int32_t *h){
+    *w = 0;
+    *h = 0;
+    int32_t x0 = 0;
+    int32_t y0 = 0;
+    int32_t x1 = 0;
+    int32_t y1 = 0;
+    if (ttf_glyph_box(font, glyph, &x0, &y0, &x1, &y1)){
+        int32_t px0 = (int32_t)((float)x0*pixel_per_design_unit) - 2;
+        int32_t px1 = (int32_t)((float)x1*pixel_per_design_unit) + 2;
+        int32_t py0 = (int32_t)((float)y0*pixel_per_design_unit) - 1;
+        int32_t py1 = (int32_t)((float)y1*pixel_per_design_unit) + 1;
+        *w = px1 - px0;
+        *h = py1 - py0;
+    }
+}
+
+// Metrics the way the bake everything path would fill them, with boxes from the outline bounds.
+// Returns the number of atlas slices used.
+int32_t
+bench_build_metrics(TTF_Font *font, float point_size, Glyph_Metrics *metrics, int32_t *atlas_side_out){
+    float pixel_per_em = point_size*(1.f/72.f)*96.f;
+    float pixel_per_design_unit = pixel_per_em/(float)font->units_per_em;
+    int32_t atlas_side = atlas_packer_choose_slice_side((int32_t)((float)font->cap_height*pixel_per_design_unit));
+    Atlas_Packer packer = atlas_packer_init(atlas_side, atlas_side, 1);
+    for (int32_t glyph = 0; glyph < font->glyph_count; glyph += 1){
+        Glyph_Metrics *m = &metrics[glyph];
+        memset(m, 0, sizeof(*m));
+        m->advance = (float)(int32_t)((float)ttf_glyph_advance(font, glyph)*pixel_per_design_unit + 0.5f);
+        int32_t w = 0;
+        int32_t h = 0;
+        bench_glyph_pixel_box(font, glyph, pixel_per_design_unit, &w, &h);
+        Atlas_Slot slot = {0};
+        if (atlas_packer_pack(&packer, w, h, &slot) && w > 0){
+            int32_t x0 = 0;
+            int32_t y0 = 0;
+            int32_t x1 = 0;
+            int32_t y1 = 0;
+            ttf_glyph_box(font, glyph, &x0, &y0, &x1, &y1);
+            m->off_x    = (float)((int32_t)((float)x0*pixel_per_design_unit) - 2);
+            m->off_y    = (float)(-((int32_t)((float)y1*pixel_per_design_unit) + 1));
+            m->xy_w     = (float)w;
+            m->xy_h     = (float)h;
+            m->uv_w     = (float)w/(float)atlas_side;
+            m->uv_h     = (float)h/(float)atlas_side;
+            m->uv_x     = (float)slot.x/(float)atlas_side;
+            m->uv_y     = (float)slot.y/(float)atlas_side;
+            m->uv_slice = (float)slot.slice;
+        }
+    }
+    int32_t slice_count = packer.slice_count;
+    atlas_packer_free(&packer);
+    *atlas_side_out = atlas_side;
+    return(slice_count);
+}
+
+void
+bench_atlas_packer(char *font_name, TTF_Font *font, float point_size){
+    float dpi = 96.f;
+    float pixel_per_em = point_size*(1.f/72.f)*dpi;
+    float pixel_per_design_unit = pixel_per_em/((float)font->units_per_em);
+    int32_t cap_px = (int32_t)(((float)font->cap_height)*pixel_per_design_unit);
+    
+    // The old layout: four glyphs per slice, each slice sized from 4x the cap height.
+    int32_t old_w = 4*cap_px;
+    int32_t old_h = 4*cap_px;
+    int32_t pow2_w = 16;
+    int32_t pow2_h = 256;
+    for (; pow2_w < old_w; pow2_w *= 2);
+    for (; pow2_h < old_h; pow2_h *= 2);
+    old_w = pow2_w;
+    old_h = pow2_h;
+    int64_t old_bytes = (int64_t)old_w*old_h*3*((font->glyph_count + 3)/4);
+    
+    int32_t side = atlas_packer_choose_slice_side(cap_px);
+    Atlas_Packer packer = atlas_packer_init(side, side, 1);
+    uint64_t start = bench_now_ns();
+    for (int32_t glyph = 0; glyph < font->glyph_count; glyph += 1){
+        int32_t w = 0;
+        int32_t h = 0;
+        bench_glyph_pixel_box(font, glyph, pixel_per_design_unit, &w, &h);
+        Atlas_Slot slot = {0};
+        atlas_packer_pack(&packer, w, h, &slot);
+    }
+    uint64_t end = bench_now_ns();
+    int64_t new_bytes = (int64_t)side*side*3*packer.slice_count;
+    
+    printf("atlas_packer %s %.0fpt: %d glyphs, %d slices of %dx%d, efficiency %.1f%%, "
+           "%lld bytes vs %lld quadrant bytes (%lld saved), %.1f ns/glyph\n",
+           font_name, point_size, font->glyph_count, packer.slice_count, side, side,
+           100.f*atlas_packer_efficiency(&packer),
+           (long long)new_bytes, (long long)old_bytes, (long long)(old_bytes - new_bytes),
+           (double)(end - start)/(double)font->glyph_count);
+    
+    atlas_packer_free(&packer);
+}
+
+////////////////////////////////
+
+// Cold: rasterize and pack every glyph into a CPU side atlas, then save the cache file.
+// Warm: map the file, validate it and touch every atlas byte the way a texture upload would.
+void
+bench_font_cache_file(char *font_name, TTF_Font *font, float point_size){
+    char cache_name[DATA_PATH_MAX];
+    temp_path("text_bench_font.cache", cache_name, sizeof(cache_name));
+    float pixel_per_em = point_size*(1.f/72.f)*96.f;
+    float pixel_per_design_unit = pixel_per_em/((float)font->units_per_em);
+    int32_t side = atlas_packer_choose_slice_side((int32_t)(((float)font->cap_height)*pixel_per_design_unit));
+    
+    struct Bench_Metrics{
+        float v[10];
+    };
+    
+    Font_Cache_Key key = {0};
+    key.font_hash = font_cache_hash(font->data, font->size);
+    key.point_size = point_size;
+    key.dpi = 96.f;
+    key.gamma = 1.f;
+    
+    uint64_t cold_start = bench_now_ns();
+    Bench_Metrics *metrics = (Bench_Metrics*)malloc(sizeof(Bench_Metrics)*font->glyph_count);
+    memset(metrics, 0, sizeof(Bench_Metrics)*font->glyph_count);
+    int32_t slice_size = side*side*3;
+    int32_t atlas_c = 1;
+    uint8_t *atlas = (uint8_t*)malloc(slice_size);
+    memset(atlas, 0, slice_size);
+    Atlas_Packer packer = atlas_packer_init(side, side, 1);
+    Software_Rasterizer software_rasterizer = {0};
+    Glyph_Rasterizer rasterizer = software_rasterizer_init(&software_rasterizer, font, pixel_per_em);
+    for (int32_t glyph = 0; glyph < font->glyph_count; glyph += 1){
+        Glyph_Bitmap bitmap = {0};
+        rasterizer.rasterize_glyph(rasterizer.backend, (uint16_t)glyph, 0.f, &bitmap);
+        Atlas_Slot slot = {0};
+        atlas_packer_pack(&packer, bitmap.w, bitmap.h, &slot);
+        if (slot.slice >= atlas_c){
+            atlas = (uint8_t*)realloc(atlas, slice_size*(slot.slice + 1));
+            memset(atlas + slice_size*atlas_c, 0, slice_size*(slot.slice + 1 - atlas_c));
+            atlas_c = slot.slice + 1;
+        }
+        uint8_t *atlas_slice = atlas + slice_size*slot.slice + 3*slot.x + 3*side*slot.y;
+        glyph_bitmap_copy(&bitmap, bitmap.w, bitmap.h, atlas_slice, 3*side);
+        metrics[glyph].v[0] = (float)slot.x;
+        metrics[glyph].v[1] = (float)slot.y;
+        metrics[glyph].v[2] = (float)slot.slice;
+    }
+    bool32 written = font_cache_write(cache_name, &key, metrics, sizeof(Bench_Metrics), font->glyph_count,
+                                      atlas, side, side, atlas_c, 3);
+    uint64_t cold_end = bench_now_ns();
+    bench_verify(written, "font cache file written");
+    software_rasterizer_free(&software_rasterizer);
+    
+    // The touch reads a texel per cache line. Its sum is checked, so the reads cannot be dropped.
+    int32_t warm_runs = 20;
+    uint64_t touch_sum = 0;
+    int32_t warm_valid = 0;
+    uint64_t warm_start = bench_now_ns();
+    for (int32_t run = 0; run < warm_runs; run += 1){
+        Font_Cache_Map map = {0};
+        if (font_cache_map(cache_name, &map) &&
+            font_cache_validate(&map, &key, sizeof(Bench_Metrics))){
+            warm_valid += 1;
+            uint64_t atlas_size = (uint64_t)side*side*3*map.header->atlas_c;
+            for (uint64_t i = 0; i < atlas_size; i += 64){
+                touch_sum += map.atlas[i];
+            }
+        }
+        font_cache_unmap(&map);
+    }
+    uint64_t warm_end = bench_now_ns();
+    bench_verify(warm_valid == warm_runs, "font cache file maps and validates");
+    uint64_t expected_sum = 0;
+    for (uint64_t i = 0; i < (uint64_t)slice_size*atlas_c; i += 64){
+        expected_sum += atlas[i];
+    }
+    bench_verify(touch_sum == expected_sum*warm_valid, "font cache warm touch reads the baked atlas");
+    
+    // Both sides must agree on the atlas contents.
+    uint64_t file_size = 0;
+    Font_Cache_Map map = {0};
+    if (font_cache_map(cache_name, &map) &&
+        font_cache_validate(&map, &key, sizeof(Bench_Metrics))){
+        bench_verify(map.header->atlas_c == (uint32_t)atlas_c &&
+                     memcmp(map.atlas, atlas, slice_size*atlas_c) == 0, "font cache file atlas matches the bake");
+        bench_verify(memcmp(map.metrics, metrics, sizeof(Bench_Metrics)*font->glyph_count) == 0,
+                     "font cache file metrics match the bake");
+        file_size = map.size;
+    }
+    font_cache_unmap(&map);
+    remove(cache_name);
+    
+    printf("font_cache_file %s %.0fpt: %llu byte file, cold bake+save %.3f ms, warm map+touch %.3f ms (%.1fx)\n",
+           font_name, point_size, (unsigned long long)file_size,
+           (double)(cold_end - cold_start)/1000000.0,
+           (double)(warm_end - warm_start)/(1000000.0*warm_runs),
+           (double)(cold_end - cold_start)*warm_runs/(double)(warm_end - warm_start));
+    
+    atlas_packer_free(&packer);
+    free(atlas);
+    free(metrics);
+}
+
+////////////////////////////////
+
+void
+bench_software_rasterizer(char *font_name, TTF_Font *font){
+    float point_sizes[] = {9.f, 12.f, 24.f, 48.f};
+    for (int32_t i = 0; i < 4; i += 1){
+        float pixel_per_em = point_sizes[i]*(1.f/72.f)*96.f;
+        Software_Rasterizer software_rasterizer = {0};
+        Glyph_Rasterizer rasterizer = software_rasterizer_init(&software_rasterizer, font, pixel_per_em);
+        
+        int32_t drawn = 0;
+        int32_t failed = 0;
+        uint64_t texels = 0;
+        uint64_t start = bench_now_ns();
+        for (int32_t glyph = 0; glyph < font->glyph_count; glyph += 1){
+            Glyph_Bitmap bitmap = {0};
+            if (rasterizer.rasterize_glyph(rasterizer.backend, (uint16_t)glyph, 0.f, &bitmap)){
+                drawn += 1;
+                texels += (uint64_t)bitmap.w*bitmap.h;
+            }
+            else{
+                failed += 1;
+            }
+        }
+        uint64_t end = bench_now_ns();
+        double seconds = (double)(end - start)/1000000000.0;
+        
+        printf("software_rasterizer %s %.0fpt: %d glyphs (%d failed), %.0f glyphs/sec, %.1f Mtexel/sec\n",
+               font_name, point_sizes[i], drawn, failed,
+               (double)font->glyph_count/seconds, (double)texels/(seconds*1000000.0));
+        
+        software_rasterizer_free(&software_rasterizer);
+    }
+}
+
+////////////////////////////////
+
+void
+bench_record_slot(void *user, int32_t glyph_index, Glyph_Bitmap *, Atlas_Slot slot){
+    Atlas_Slot *slots = (Atlas_Slot*)user;
+    slots[glyph_index] = slot;
+}
+
+// Whole font bakes with 1, 2, 4... workers up to the core count. Every bake must match the single
+// worker bake byte for byte.
+void
+bench_parallel_bake(char *font_name, TTF_Font *font, float point_size){
+    float pixel_per_em = point_size*(1.f/72.f)*96.f;
+    float pixel_per_design_unit = pixel_per_em/(float)font->units_per_em;
+    int32_t atlas_side = atlas_packer_choose_slice_side((int32_t)((float)font->cap_height*pixel_per_design_unit));
+    int32_t core_count = bake_core_count();
+    int32_t max_workers = (core_count < 4)?4:core_count;
+    
+    Glyph_Rasterizer *rasterizers = (Glyph_Rasterizer*)malloc(sizeof(Glyph_Rasterizer)*max_workers);
+    Software_Rasterizer *software = (Software_Rasterizer*)malloc(sizeof(Software_Rasterizer)*max_workers);
+    memset(software, 0, sizeof(Software_Rasterizer)*max_workers);
+    for (int32_t i = 0; i < max_workers; i += 1){
+        rasterizers[i] = software_rasterizer_init(&software[i], font, pixel_per_em);
+    }
+    
+    Atlas_Slot *reference_slots = (Atlas_Slot*)malloc(sizeof(Atlas_Slot)*font->glyph_count);
+    Atlas_Slot *slots = (Atlas_Slot*)malloc(sizeof(Atlas_Slot)*font->glyph_count);
+    uint8_t *reference_atlas = 0;
+    int32_t reference_atlas_c = 0;
+    double single_seconds = 0.0;
+    
+    for (int32_t worker_count = 1; worker_count <= max_workers; worker_count *= 2){
+        memset(slots, 0, sizeof(Atlas_Slot)*font->glyph_count);
+        Atlas_Packer packer = atlas_packer_init(atlas_side, atlas_side, 1);
+        int32_t atlas_c = 0;
+        uint64_t start = bench_now_ns();
+        uint8_t *atlas = parallel_bake_atlas(rasterizers, worker_count, &packer, bench_record_slot, slots, &atlas_c);
+        uint64_t end = bench_now_ns();
+        double seconds = (double)(end - start)/1000000000.0;
+        atlas_packer_free(&packer);
+        
+        if (reference_atlas == 0){
+            reference_atlas = atlas;
+            reference_atlas_c = atlas_c;
+            single_seconds = seconds;
+            memcpy(reference_slots, slots, sizeof(Atlas_Slot)*font->glyph_count);
+        }
+        else{
+            assert(atlas_c == reference_atlas_c);
+            assert(memcmp(atlas, reference_atlas, (size_t)atlas_side*atlas_side*3*atlas_c) == 0);
+            assert(memcmp(slots, reference_slots, sizeof(Atlas_Slot)*font->glyph_count) == 0);
+            free(atlas);
+        }
+        
+        printf("parallel_bake %s %.0fpt: %2d workers (%d cores), %d slices, %.2f ms, %.0f glyphs/sec, %.2fx\n",
+               font_name, point_size, worker_count, core_count, atlas_c, seconds*1000.0,
+               (double)font->glyph_count/seconds, single_seconds/seconds);
+    }
+    
+    for (int32_t i = 0; i < max_workers; i += 1){
+        software_rasterizer_free(&software[i]);
+    }
+    free(reference_atlas);
+    free(slots);
+    free(reference_slots);
+    free(software);
+    free(rasterizers);
+}
+
+////////////////////////////////
+
+uint32_t
+bench_random(uint32_t *state){
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return(x);
+}
+
+// A CJK sized font drawn a frame at a time: a few hundred distinct glyphs per frame drawn from a
+// skewed distribution, with the screen's glyph set drifting as the text scrolls. What the cache
+// hands out is checked by example_glyph_cache_test.cpp.
+void
+bench_glyph_cache(void){
+    int32_t glyph_count = 20000;
+    int32_t cell_side = 20;
+    int32_t atlas_side = 512;
+    int32_t frame_count = 2000;
+    int32_t glyphs_per_frame = 2000;
+    
+    int32_t slice_counts[] = {1, 2, 4};
+    for (int32_t k = 0; k < 3; k += 1){
+        Glyph_Cache cache = glyph_cache_init(glyph_count, cell_side, cell_side, atlas_side, atlas_side, slice_counts[k]);
+        
+        uint32_t state = 0x1234567;
+        uint64_t start = bench_now_ns();
+        for (int32_t frame = 0; frame < frame_count; frame += 1){
+            glyph_cache_begin_frame(&cache);
+            int32_t scroll = frame*3;
+            for (int32_t i = 0; i < glyphs_per_frame; i += 1){
+                // Square of a uniform variable skews toward the common glyphs.
+                uint32_t r = bench_random(&state)%1024;
+                int32_t glyph = (int32_t)((r*r)>>10);
+                if ((bench_random(&state)&3) == 0){
+                    glyph = (glyph + scroll)%glyph_count;
+                }
+                Atlas_Slot slot = {0};
+                glyph_cache_lookup(&cache, glyph, &slot);
+            }
+        }
+        uint64_t end = bench_now_ns();
+        uint64_t lookups = (uint64_t)frame_count*glyphs_per_frame;
+        
+        printf("glyph_cache %d cells (%d slices of %dx%d): hit rate %.2f%%, %.2f bakes/frame, "
+               "%llu evictions, %llu full, %.1f ns/lookup, atlas %d bytes vs %d eager\n",
+               cache.cell_count, slice_counts[k], atlas_side, atlas_side,
+               100.0*(double)cache.hits/(double)lookups, (double)cache.misses/(double)frame_count,
+               (unsigned long long)cache.evictions, (unsigned long long)cache.failures,
+               (double)(end - start)/(double)lookups,
+               atlas_side*atlas_side*3*slice_counts[k], glyph_count*cell_side*cell_side*3);
+        
+        glyph_cache_free(&cache);
+    }
+}
+
+////////////////////////////////
+
+// Per character font query (the cmap binary search stands in for GetGlyphIndices) against the
+// codepoint map, on ASCII and on text mixing Latin, Greek, Cyrillic, Arabic and CJK.
+void
+bench_codepoint_map(char *font_name, TTF_Font *font){
+    int32_t count = 1 << 20;
+    uint32_t *codepoints = (uint32_t*)malloc(sizeof(uint32_t)*count);
+    uint16_t *expected = (uint16_t*)malloc(sizeof(uint16_t)*count);
+    uint16_t *glyphs = (uint16_t*)malloc(sizeof(uint16_t)*count);
+    
+    uint32_t ranges[][2] = {
+        {0x20, 0x7E},
+        {0xA0, 0x17F},
+        {0x391, 0x3C9},
+        {0x410, 0x44F},
+        {0x627, 0x64A},
+        {0x4E00, 0x4FFF},
+    };
+    int32_t range_count = sizeof(ranges)/sizeof(ranges[0]);
+    
+    for (int32_t mixed = 0; mixed < 2; mixed += 1){
+        uint32_t state = 0x9E3779B9u;
+        for (int32_t i = 0; i < count; i += 1){
+            uint32_t *range = ranges[0];
+            if (mixed){
+                range = ranges[bench_random(&state)%range_count];
+            }
+            codepoints[i] = range[0] + bench_random(&state)%(range[1] - range[0] + 1);
+        }
+        
+        uint64_t start = bench_now_ns();
+        for (int32_t i = 0; i < count; i += 1){
+            expected[i] = ttf_codepoint_glyph(font, codepoints[i]);
+        }
+        uint64_t end = bench_now_ns();
+        double query_ns = (double)(end - start)/(double)count;
+        
+        Codepoint_Map *map = codepoint_map_alloc(font, ttf_codepoint_glyphs);
+        start = bench_now_ns();
+        for (int32_t i = 0; i < count; i += 1){
+            glyphs[i] = codepoint_map_lookup(map, codepoints[i]);
+        }
+        end = bench_now_ns();
+        double cold_ns = (double)(end - start)/(double)count;
+        
+        start = bench_now_ns();
+        for (int32_t i = 0; i < count; i += 1){
+            glyphs[i] = codepoint_map_lookup(map, codepoints[i]);
+        }
+        end = bench_now_ns();
+        double warm_ns = (double)(end - start)/(double)count;
+        assert(memcmp(glyphs, expected, sizeof(uint16_t)*count) == 0);
+        
+        printf("codepoint_map %s %s: font query %.2f ns/char, map cold %.2f ns/char, warm %.2f ns/char (%.0f Mlookup/sec), %d pages, %llu bytes\n",
+               font_name, mixed?"mixed":"ascii", query_ns, cold_ns, warm_ns, 1000.0/warm_ns,
+               map->allocated_page_count, (unsigned long long)codepoint_map_memory(map));
+        codepoint_map_free(map);
+    }
+    
+    free(glyphs);
+    free(expected);
+    free(codepoints);
+}
+
+////////////////////////////////
+
+// Scalar against SIMD decoding on the ASCII test file and on mixed script text where about one
+// character in eight is multibyte. Malformed input and agreement on any bytes are checked by
+// example_utf8_test.cpp.
+void
+bench_utf8(char *ascii_file_name){
+    int32_t size = 1 << 22;
+    uint8_t *text[2];
+    int32_t text_size[2];
+    text[0] = (uint8_t*)malloc(size);
+    text[1] = (uint8_t*)malloc(size);
+    
+    // ASCII: the test file repeated
+    {
+        int32_t file_size = 0;
+        uint8_t *file = bench_read_file(ascii_file_name, &file_size);
+        if (file == 0 || file_size == 0){
+            printf("utf8: cannot read %s, using generated ASCII\n", ascii_file_name);
+            free(file);
+            file = (uint8_t*)"int32_t x = function_call(argument, 0x20);\n";
+            file_size = (int32_t)strlen((char*)file);
+            file = (uint8_t*)strdup((char*)file);
+        }
+        int32_t at = 0;
+        for (; at + file_size <= size; at += file_size){
+            memcpy(text[0] + at, file, file_size);
+        }
+        text_size[0] = at;
+        free(file);
+    }
+    
+    // Mixed
+    {
+        uint32_t ranges[][2] = {
+            {0xE0, 0x17F},
+            {0x391, 0x3C9},
+            {0x410, 0x44F},
+            {0x4E00, 0x4FFF},
+            {0x1F600, 0x1F64F},
+        };
+        int32_t range_count = sizeof(ranges)/sizeof(ranges[0]);
+        uint32_t state = 0x12345678u;
+        int32_t at = 0;
+        for (; at + 4 <= size;){
+            uint32_t r = bench_random(&state);
+            uint32_t codepoint = 0x20 + r%0x5F;
+            if ((r >> 8)%8 == 0){
+                uint32_t *range = ranges[(r >> 12)%range_count];
+                codepoint = range[0] + (r >> 16)%(range[1] - range[0] + 1);
+            }
+            at += utf8_encode_one(codepoint, text[1] + at);
+        }
+        text_size[1] = at;
+    }
+    
+    uint32_t *expected = (uint32_t*)malloc(sizeof(uint32_t)*size);
+    uint32_t *codepoints = (uint32_t*)malloc(sizeof(uint32_t)*size);
+    char *names[] = {"ascii", "mixed"};
+    for (int32_t t = 0; t < 2; t += 1){
+        int32_t repeat = 8;
+        int32_t expected_count = 0;
+        int32_t count = 0;
+        
+        uint64_t start = bench_now_ns();
+        for (int32_t i = 0; i < repeat; i += 1){
+            expected_count = utf8_decode_scalar(text[t], text_size[t], expected);
+        }
+        uint64_t end = bench_now_ns();
+        double scalar_seconds = (double)(end - start)/1000000000.0/repeat;
+        
+        start = bench_now_ns();
+        for (int32_t i = 0; i < repeat; i += 1){
+            count = utf8_decode(text[t], text_size[t], codepoints);
+        }
+        end = bench_now_ns();
+        double simd_seconds = (double)(end - start)/1000000000.0/repeat;
+        assert(count == expected_count);
+        
+        double megabytes = (double)text_size[t]/(1024.0*1024.0);
+        printf("utf8 %s: %d bytes, %d codepoints, scalar %.0f MB/s %.2f ns/char, simd %.0f MB/s %.2f ns/char, %.1fx\n",
+               names[t], text_size[t], count,
+               megabytes/scalar_seconds, scalar_seconds*1000000000.0/count,
+               megabytes/simd_seconds, simd_seconds*1000000000.0/count,
+               scalar_seconds/simd_seconds);
+    }
+    
+    free(codepoints);
+    free(expected);
+    free(text[1]);
+    free(text[0]);
+}
+
+////////////////////////////////
+
+// A syntax highlighting palette looked up over and over, recomputed against the tables. The tables
+// are checked against text_compute_M_values by example_m_values_test.cpp.
+void
+bench_m_values(void){
+    uint8_t palette[8][4] = {
+        {0x1e, 0x1e, 0x1e, 0xff}, {0x56, 0x9c, 0xd6, 0xff}, {0xce, 0x91, 0x78, 0xff}, {0x6a, 0x99, 0x55, 0xff},
+        {0xb5, 0xce, 0xa8, 0xff}, {0xc5, 0x86, 0xc0, 0xff}, {0xd4, 0xd4, 0xd4, 0x80}, {0x80, 0x80, 0x80, 0x40},
+    };
+    float palette_float[8][4];
+    for (int32_t i = 0; i < 8; i += 1){
+        for (int32_t c = 0; c < 4; c += 1){
+            palette_float[i][c] = palette[i][c]/255.f;
+        }
+    }
+    
+    int32_t lookup_count = 10000000;
+    float sink = 0.f;
+    uint64_t start = bench_now_ns();
+    for (int32_t i = 0; i < lookup_count; i += 1){
+        float *color = palette_float[i & 7];
+        float M[7];
+        text_compute_M_values(color[0], color[1], color[2], color[3], M);
+        sink += M[3];
+    }
+    uint64_t mid = bench_now_ns();
+    for (int32_t i = 0; i < lookup_count; i += 1){
+        uint8_t *color = palette[i & 7];
+        float M[7];
+        m_values_rgba8(color[0], color[1], color[2], color[3], M);
+        sink += M[3];
+    }
+    uint64_t opaque_start = bench_now_ns();
+    for (int32_t i = 0; i < lookup_count; i += 1){
+        uint8_t *color = palette[i%6];
+        float M[7];
+        m_values_rgba8(color[0], color[1], color[2], 255, M);
+        sink += M[3];
+    }
+    uint64_t end = bench_now_ns();
+    
+    printf("m_values: %d rows (%d bytes), recompute %.2f ns, table %.2f ns, table opaque %.2f ns (checksum %.0f)\n",
+           M_VALUE_KEY_COUNT, (int32_t)sizeof(m_value_rows),
+           (double)(mid - start)/lookup_count, (double)(opaque_start - mid)/lookup_count,
+           (double)(end - opaque_start)/lookup_count, sink);
+}
+
+////////////////////////////////
+
+struct Bench_String{
+    char *text;
+    float x;
+    float y;
+    float color[4];
+};
+
+// The busiest test scene (alpha steps of red, green and blue plus the labels) as one frame.
+int32_t
+bench_test_scene_strings(Bench_String *strings){
+    int32_t count = 0;
+    for (int32_t j = 1; j <= 6; j += 1){
+        float a = (j - 1)/5.f;
+        for (int32_t i = 0; i < 3; i += 1){
+            Bench_String *string = &strings[count++];
+            string->text = "DirectWrite rasterizer testing";
+            string->x = (float)(50 + 250*i);
+            string->y = (float)(j*80 + 40);
+            string->color[0] = (i == 0)?0.5f:0.f;
+            string->color[1] = (i == 1)?0.5f:0.f;
+            string->color[2] = (i == 2)?0.5f:0.f;
+            string->color[3] = a;
+        }
+    }
+    char *labels[] = {"Back = (0,.5,.5)", "Fore = Alpha Red Green Blue", "Press space to pause cycle"};
+    float label_x[] = {300.f, 550.f, 50.f};
+    for (int32_t i = 0; i < 3; i += 1){
+        Bench_String *string = &strings[count++];
+        string->text = labels[i];
+        string->x = label_x[i];
+        string->y = 60.f;
+        string->color[0] = 0.5f;
+        string->color[1] = 0.f;
+        string->color[2] = 0.f;
+        string->color[3] = 1.f;
+    }
+    return(count);
+}
+
+// Lays out one test scene frame into the batch, the same way draw_string does.
+void
+bench_push_test_scene(Text_Batch *batch, Codepoint_Map *map, Glyph_Metrics *metrics, int32_t atlas_side,
+                      Bench_String *strings, int32_t string_count, uint32_t *codepoints){
+    for (int32_t s = 0; s < string_count; s += 1){
+        Bench_String *string = &strings[s];
+        int32_t length = utf8_decode((uint8_t*)string->text, (int32_t)strlen(string->text), codepoints);
+        text_batch_begin_string(batch, 1, atlas_side, atlas_side, string->color[0], string->color[1], string->color[2], string->color[3]);
+        float layout_x = string->x;
+        for (int32_t i = 0; i < length; i += 1){
+            uint16_t glyph = codepoint_map_lookup(map, codepoints[i]);
+            text_batch_push_glyph(batch, &metrics[glyph], layout_x, string->y);
+            layout_x += metrics[glyph].advance;
+        }
+    }
+}
+
+// Everything draw_string touches, with the glyph cache filled by the software rasterizer.
+struct Bench_Frame_Font{
+    Codepoint_Map *map;
+    Glyph_Metrics *metrics;
+    Text_Instance *templates;
+    int32_t atlas_side;
+    Glyph_Cache cache;
+    Glyph_Rasterizer rasterizer;
+    uint8_t *cell_memory;
+};
+
+// draw_string without the upload. With no arena the scratch comes from the heap, as it used to.
+void
+bench_draw_string(Bench_Frame_Font *font, Text_Batch *batch, Arena *arena, Bench_String *string){
+    int32_t text_length = (int32_t)strlen(string->text);
+    Arena_Mark mark = {0};
+    uint32_t *codepoints = 0;
+    uint16_t *indices = 0;
+    int32_t *pen_x = 0;
+    if (arena != 0){
+        mark = arena_mark(arena);
+        codepoints = arena_push_array(arena, uint32_t, text_length);
+        indices = arena_push_array(arena, uint16_t, text_length);
+        pen_x = arena_push_array(arena, int32_t, text_length);
+        assert(codepoints != 0 && indices != 0 && pen_x != 0);
+    }
+    else{
+        codepoints = (uint32_t*)heap_alloc(sizeof(uint32_t)*text_length);
+        indices = (uint16_t*)heap_alloc(sizeof(uint16_t)*text_length);
+        pen_x = (int32_t*)heap_alloc(sizeof(int32_t)*text_length);
+    }
+    
+    int32_t length = utf8_decode((uint8_t*)string->text, text_length, codepoints);
+    for (int32_t i = 0; i < length; i += 1){
+        indices[i] = codepoint_map_lookup(font->map, codepoints[i]);
+    }
+    
+    int32_t visible_count = 0;
+    int32_t layout_x = (int32_t)string->x;
+    for (int32_t i = 0; i < length; i += 1){
+        uint16_t index = indices[i];
+        Glyph_Metrics *metrics = &font->metrics[index];
+        Atlas_Slot slot = {0};
+        Glyph_Cache_Result cache_result = glyph_cache_lookup(&font->cache, index, &slot);
+        if (cache_result == GlyphCache_Full){
+            layout_x += (int32_t)metrics->advance;
+            continue;
+        }
+        if (cache_result == GlyphCache_Miss){
+            Glyph_Bitmap bitmap = {0};
+            int32_t tex_w = 0;
+            int32_t tex_h = 0;
+            if (font->rasterizer.rasterize_glyph(font->rasterizer.backend, index, 0.f, &bitmap)){
+                tex_w = (bitmap.w < slot.w)?bitmap.w:slot.w;
+                tex_h = (bitmap.h < slot.h)?bitmap.h:slot.h;
+                glyph_bitmap_copy(&bitmap, tex_w, tex_h, font->cell_memory, tex_w*3);
+            }
+            metrics->xy_w = (float)tex_w;
+            metrics->xy_h = (float)tex_h;
+            metrics->uv_x = (float)slot.x/(float)font->atlas_side;
+            metrics->uv_y = (float)slot.y/(float)font->atlas_side;
+            metrics->uv_slice = (float)slot.slice;
+            text_instance_template(metrics, font->atlas_side, font->atlas_side, &font->templates[index]);
+        }
+        indices[visible_count] = index;
+        pen_x[visible_count] = layout_x;
+        visible_count += 1;
+        layout_x += (int32_t)metrics->advance;
+    }
+    
+    text_batch_begin_string(batch, 1, font->atlas_side, font->atlas_side,
+                            string->color[0], string->color[1], string->color[2], string->color[3]);
+    text_batch_push_run(batch, font->templates, indices, pen_x, (int32_t)string->y, visible_count);
+    
+    if (arena != 0){
+        arena_pop_to(arena, mark);
+    }
+    else{
+        heap_free(pen_x);
+        heap_free(indices);
+        heap_free(codepoints);
+    }
+}
+
+// Frames of the test scene with per-string heap scratch and with the frame arena. After the first
+// frame has warmed the caches and sized the batch, an arena frame must not touch the heap, both
+// with a glyph cache that holds the scene and with one so small it rasterizes glyphs every frame.
+// The arena and the counter themselves are checked by example_frame_arena_test.cpp.
+void
+bench_frame_arena(char *font_name, TTF_Font *font){
+    Bench_String strings[32];
+    int32_t string_count = bench_test_scene_strings(strings);
+    
+    struct Cache_Config{
+        char *name;
+        int32_t atlas_side;
+    };
+    Cache_Config configs[] = {
+        {"roomy cache", 512},
+        {"thrashing cache", 64},
+    };
+    for (int32_t k = 0; k < 2; k += 1){
+        Cache_Config *config = &configs[k];
+        int32_t cell_side = 32;
+        Bench_Frame_Font frame_font = {0};
+        frame_font.metrics = (Glyph_Metrics*)calloc(font->glyph_count, sizeof(Glyph_Metrics));
+        int32_t unused_side = 0;
+        bench_build_metrics(font, 12.f, frame_font.metrics, &unused_side);
+        frame_font.atlas_side = config->atlas_side;
+        frame_font.map = codepoint_map_alloc(font, ttf_codepoint_glyphs);
+        frame_font.templates = text_alloc_instance_templates(frame_font.metrics, font->glyph_count, config->atlas_side, config->atlas_side);
+        frame_font.cache = glyph_cache_init(font->glyph_count, cell_side, cell_side, config->atlas_side, config->atlas_side, 1);
+        frame_font.cell_memory = (uint8_t*)malloc(cell_side*cell_side*3);
+        Software_Rasterizer software = {0};
+        frame_font.rasterizer = software_rasterizer_init(&software, font, 12.f*(1.f/72.f)*96.f);
+        
+        Arena arena = arena_alloc(1 << 20);
+        Text_Batch batch = {0};
+        int32_t frame_count = 2000;
+        uint64_t heap_allocations = 0;
+        uint64_t arena_allocations = 0;
+        uint64_t elapsed[2] = {0};
+        uint64_t misses_before = 0;
+        for (int32_t use_arena = 0; use_arena < 2; use_arena += 1){
+            misses_before = frame_font.cache.misses;
+            for (int32_t frame = 0; frame < frame_count + 1; frame += 1){
+                uint64_t start = bench_now_ns();
+                arena_reset(&arena);
+                heap_frame_begin();
+                glyph_cache_begin_frame(&frame_font.cache);
+                text_batch_begin_frame(&batch);
+                // Rotating the order changes which glyphs reach a small cache first.
+                for (int32_t s = 0; s < string_count; s += 1){
+                    bench_draw_string(&frame_font, &batch, use_arena?&arena:0, &strings[(s + frame)%string_count]);
+                }
+                uint64_t allocations = heap_frame_end();
+                uint64_t end = bench_now_ns();
+                // The first frame is the warm up.
+                if (frame > 0){
+                    elapsed[use_arena] += end - start;
+                    if (use_arena){
+                        arena_allocations += allocations;
+                    }
+                    else{
+                        heap_allocations += allocations;
+                    }
+                }
+            }
+        }
+        
+        assert(arena_allocations == 0);
+        assert(arena.used == 0 && arena.failures == 0);
+        uint64_t glyphs = (uint64_t)frame_count*batch.glyph_count;
+        printf("frame_arena %s %s: %d strings/frame, %.1f glyph misses/frame, heap allocations/frame %.1f -> %llu, %.1f -> %.1f ns/glyph, arena high water %llu bytes\n",
+               font_name, config->name, string_count, (double)(frame_font.cache.misses - misses_before)/frame_count,
+               (double)heap_allocations/frame_count, (unsigned long long)(arena_allocations/frame_count),
+               (double)elapsed[0]/glyphs, (double)elapsed[1]/glyphs, (unsigned long long)arena.high_water);
+        
+        arena_free(&arena);
+        text_batch_free(&batch);
+        software_rasterizer_free(&software);
+        free(frame_font.cell_memory);
+        glyph_cache_free(&frame_font.cache);
+        heap_free(frame_font.templates);
+        codepoint_map_free(frame_font.map);
+        free(frame_font.metrics);
+    }
+}
+
+// One frame of the test scene through the batch. Checks that the frame becomes a single draw, that
+// every string's style reaches its glyphs, and that expanding the instances the way the vertex
+// shader does gives exactly the quads of the old six vertex per glyph format.
+void
+bench_text_batch(char *font_name, TTF_Font *font){
+    Glyph_Metrics *metrics = (Glyph_Metrics*)malloc(sizeof(Glyph_Metrics)*font->glyph_count);
+    int32_t atlas_side = 0;
+    bench_build_metrics(font, 12.f, metrics, &atlas_side);
+    Codepoint_Map *map = codepoint_map_alloc(font, ttf_codepoint_glyphs);
+    
+    Bench_String strings[32];
+    int32_t string_count = bench_test_scene_strings(strings);
+    uint32_t codepoints[256];
+    
+    Text_Batch batch = {0};
+    int32_t frame_count = 20000;
+    uint64_t start = bench_now_ns();
+    for (int32_t frame = 0; frame < frame_count; frame += 1){
+        text_batch_begin_frame(&batch);
+        bench_push_test_scene(&batch, map, metrics, atlas_side, strings, string_count, codepoints);
+    }
+    uint64_t end = bench_now_ns();
+    
+    Text_Draw_List list = text_batch_draw_list(&batch);
+    assert(sizeof(Text_Instance) == 16);
+    assert(list.command_count == 1);
+    assert(list.instance_count == batch.glyph_count);
+    int32_t instance_index = 0;
+    for (int32_t s = 0; s < string_count; s += 1){
+        float M_value_table[7];
+        Bench_String *string = &strings[s];
+        // Styles carry the color quantized to 8 bits, and the M values of that color.
+        float color[4];
+        for (int32_t c = 0; c < 4; c += 1){
+            color[c] = (float)m_value_quantize(string->color[c])/255.f;
+        }
+        text_compute_M_values(color[0], color[1], color[2], color[3], M_value_table);
+        int32_t length = utf8_decode((uint8_t*)string->text, (int32_t)strlen(string->text), codepoints);
+        float layout_x = string->x;
+        float layout_y = string->y;
+        for (int32_t i = 0; i < length; i += 1, instance_index += 1){
+            Text_Instance *instance = &list.instances[instance_index];
+            Text_Style *style = &list.styles[instance->style];
+            assert(memcmp(style->color, color, sizeof(style->color)) == 0);
+            for (int32_t m = 0; m < 6; m += 1){
+                assert(fabsf(style->M[m] - M_value_table[m + 1]) <= 1e-6f);
+            }
+            
+            Glyph_Metrics m = metrics[codepoint_map_lookup(map, codepoints[i])];
+            float g_x = layout_x + m.off_x;
+            float g_y = layout_y + m.off_y;
+            float expected[4][4] = {
+                {g_x,          g_y,          m.uv_x,          m.uv_y},
+                {g_x,          g_y + m.xy_h, m.uv_x,          m.uv_y + m.uv_h},
+                {g_x + m.xy_w, g_y,          m.uv_x + m.uv_w, m.uv_y},
+                {g_x + m.xy_w, g_y + m.xy_h, m.uv_x + m.uv_w, m.uv_y + m.uv_h},
+            };
+            for (int32_t corner = 0; corner < 4; corner += 1){
+                float cx = (float)(corner >> 1);
+                float cy = (float)(corner & 1);
+                float got[4] = {
+                    (float)instance->x + cx*(float)instance->w,
+                    (float)instance->y + cy*(float)instance->h,
+                    ((float)instance->atlas_x + cx*(float)instance->w)/(float)atlas_side,
+                    ((float)instance->atlas_y + cy*(float)instance->h)/(float)atlas_side,
+                };
+                assert(memcmp(got, expected[corner], sizeof(got)) == 0);
+            }
+            assert((float)instance->slice == m.uv_slice);
+            layout_x += m.advance;
+        }
+    }
+    
+    double ns_per_glyph = (double)(end - start)/((double)frame_count*batch.glyph_count);
+    printf("text_batch %s: %d strings, %d glyphs, %d styles per frame, %.1f ns/glyph, %.0f Mglyphs/sec, uploads %d -> 1, draws %d -> %d, %d bytes/glyph (was %d)\n",
+           font_name, batch.string_count, batch.glyph_count, list.style_count, ns_per_glyph, 1000.0/ns_per_glyph,
+           batch.string_count, batch.string_count, list.command_count,
+           (int32_t)sizeof(Text_Instance), (int32_t)(6*5*sizeof(float)));
+    
+    text_batch_free(&batch);
+    codepoint_map_free(map);
+    free(metrics);
+}
+
+////////////////////////////////
+
+// The test scene composited on the CPU: the scalar path against a per texel reference that uses
+// the sRGB formulas directly, and the AVX2 path against the scalar one, byte for byte.
+void
+bench_cpu_compositor(char *font_name, TTF_Font *font, float point_size){
+    Cpu_Compositor compositor = cpu_compositor_init();
+    Software_Font baked = software_font_bake(font, point_size, 1);
+    Cpu_Atlas atlas = {baked.atlas, baked.atlas_side, baked.atlas_side, baked.slice_count};
+    
+    Bench_String strings[32];
+    int32_t string_count = bench_test_scene_strings(strings);
+    uint32_t codepoints[256];
+    Text_Batch batch = {0};
+    bench_push_test_scene(&batch, baked.map, baked.metrics, baked.atlas_side, strings, string_count, codepoints);
+    Text_Draw_List list = text_batch_draw_list(&batch);
+    
+    Cpu_Framebuffer framebuffers[3];
+    for (int32_t i = 0; i < 3; i += 1){
+        framebuffers[i].w = 800;
+        framebuffers[i].h = 600;
+        framebuffers[i].pitch = 800;
+        framebuffers[i].pixels = (uint32_t*)malloc(sizeof(uint32_t)*800*600);
+        cpu_framebuffer_clear(&framebuffers[i], 0.f, 0.5f, 0.5f);
+    }
+    
+    // Reference, one texel at a time with no tables
+    Cpu_Framebuffer *reference = &framebuffers[0];
+    uint64_t covered_texels = 0;
+    for (int32_t k = 0; k < list.instance_count; k += 1){
+        Text_Instance *instance = &list.instances[k];
+        Text_Style *style = &list.styles[instance->style];
+        float M_value_table[7] = {0.f, style->M[0], style->M[1], style->M[2], style->M[3], style->M[4], style->M[5]};
+        uint8_t *slice = atlas.texels + (size_t)instance->slice*atlas.w*atlas.h*3;
+        for (int32_t y = 0; y < instance->h; y += 1){
+            for (int32_t x = 0; x < instance->w; x += 1){
+                int32_t px = instance->x + x;
+                int32_t py = instance->y + y;
+                if (px < 0 || py < 0 || px >= reference->w || py >= reference->h){
+                    continue;
+                }
+                uint8_t *texel = slice + ((size_t)(instance->atlas_y + y)*atlas.w + instance->atlas_x + x)*3;
+                uint32_t *pixel = &reference->pixels[py*reference->pitch + px];
+                uint32_t result = *pixel & 0xFF000000u;
+                covered_texels += ((texel[0] | texel[1] | texel[2]) != 0);
+                for (int32_t c = 0; c < 3; c += 1){
+                    float S = (float)texel[c]/255.f;
+                    float M = M_value_table[(int32_t)(S*6 + 0.1f)];
+                    float back = (float)cpu_srgb_decode_exact((double)((*pixel >> (8*c)) & 0xFF)/255.0);
+                    result |= (uint32_t)cpu_srgb_encode_reference(style->color[c]*M + back*(1.f - M)) << (8*c);
+                }
+                *pixel = result;
+            }
+        }
+    }
+    
+    // The first draw builds every style's blend table, later ones find them in the cache.
+    uint64_t cold_start = bench_now_ns();
+    cpu_composite_draw_list(&compositor, &framebuffers[1], &atlas, &list, false);
+    uint64_t cold_end = bench_now_ns();
+    bool32 exact = bench_verify(memcmp(framebuffers[0].pixels, framebuffers[1].pixels, sizeof(uint32_t)*800*600) == 0,
+                                "cpu_compositor: the scalar path differs from the sRGB reference");
+    bench_verify(compositor.table_builds == (uint64_t)list.style_count,
+                 "cpu_compositor: the first draw did not build one blend table per style");
+    int32_t variant_count = 1;
+    // Every instance goes through the AVX2 path while the results are checked.
+    int32_t default_min_width = cpu_simd_min_width;
+    cpu_simd_min_width = 0;
+#if CPU_COMPOSITOR_AVX2
+    cpu_composite_draw_list(&compositor, &framebuffers[2], &atlas, &list, true);
+    exact = bench_verify(memcmp(framebuffers[1].pixels, framebuffers[2].pixels, sizeof(uint32_t)*800*600) == 0,
+                         "cpu_compositor: the AVX2 path differs from the scalar one") && exact;
+    variant_count = 2;
+#endif
+    
+    // Clipping against every edge, both paths must agree on what survives.
+    for (int32_t v = 1; v <= variant_count; v += 1){
+        Cpu_Framebuffer small = {framebuffers[v].pixels, 97, 61, 800};
+        cpu_framebuffer_clear(&framebuffers[v], 0.f, 0.5f, 0.5f);
+        for (int32_t k = 0; k < list.instance_count; k += 1){
+            list.instances[k].x -= 60;
+            list.instances[k].y -= 40;
+        }
+        cpu_composite_draw_list(&compositor, &small, &atlas, &list, v == 2);
+        for (int32_t k = 0; k < list.instance_count; k += 1){
+            list.instances[k].x += 60;
+            list.instances[k].y += 40;
+        }
+    }
+#if CPU_COMPOSITOR_AVX2
+    exact = bench_verify(memcmp(framebuffers[1].pixels, framebuffers[2].pixels, sizeof(uint32_t)*800*600) == 0,
+                         "cpu_compositor: the paths clip differently") && exact;
+#endif
+    int32_t wide_count = 0;
+    for (int32_t k = 0; k < list.instance_count; k += 1){
+        wide_count += (list.instances[k].w >= default_min_width);
+    }
+    
+    // Best of several trials, the paths are close enough that one noisy trial would decide it. The
+    // AVX2 variants are every instance through the AVX2 path, then the default where narrow ones are
+    // left to the scalar path.
+    double ns_per_glyph[3] = {0};
+    int32_t repeat_count = 200;
+    for (int32_t trial = 0; trial < 10; trial += 1){
+        for (int32_t v = 0; v < 2*variant_count - 1; v += 1){
+            cpu_simd_min_width = (v == 1)?0:default_min_width;
+            uint64_t start = bench_now_ns();
+            for (int32_t i = 0; i < repeat_count; i += 1){
+                cpu_composite_draw_list(&compositor, &framebuffers[1], &atlas, &list, v != 0);
+            }
+            uint64_t end = bench_now_ns();
+            double ns = (double)(end - start)/((double)repeat_count*list.instance_count);
+            if (trial == 0 || ns < ns_per_glyph[v]){
+                ns_per_glyph[v] = ns;
+            }
+        }
+    }
+    
+    printf("cpu_compositor %s %.0fpt: %d glyphs, %llu covered texels, scalar %.1f ns/glyph (%.0f Mtexel/sec)",
+           font_name, point_size, list.instance_count, (unsigned long long)covered_texels, ns_per_glyph[0],
+           (double)covered_texels*1000.0/(ns_per_glyph[0]*list.instance_count));
+    if (variant_count > 1){
+        printf(", avx2 %.1f ns/glyph (%.0f Mtexel/sec, %.2fx), avx2 from %d texels wide on %d glyphs %.1f ns/glyph (%.2fx)",
+               ns_per_glyph[1], (double)covered_texels*1000.0/(ns_per_glyph[1]*list.instance_count),
+               ns_per_glyph[0]/ns_per_glyph[1], default_min_width, wide_count, ns_per_glyph[2],
+               ns_per_glyph[0]/ns_per_glyph[2]);
+    }
+    printf(", first draw %.1f us building %llu blend tables, %s\n",
+           (double)(cold_end - cold_start)/1000.0, (unsigned long long)compositor.table_builds,
+           exact?"bit exact against the sRGB reference":"NOT BIT EXACT");
+    
+    for (int32_t i = 0; i < 3; i += 1){
+        free(framebuffers[i].pixels);
+    }
+    cpu_compositor_free(&compositor);
+    text_batch_free(&batch);
+    software_font_free(&baked);
+}
+
+////////////////////////////////
+
+// The packed level atlas: every texel of a baked atlas keeping its levels through pack and unpack,
+// and the test scene composited from the unpacked atlas coming out byte for byte the same as from
+// the original. The kernels on their own are tested in example_atlas_levels_test.cpp.
+void
+bench_atlas_levels(char *font_name, TTF_Font *font, float point_size){
+    // A Baked Atlas
+    Software_Font baked = software_font_bake(font, point_size, 1);
+    int64_t texel_count = (int64_t)baked.atlas_side*baked.atlas_side*baked.slice_count;
+    uint16_t *packed = (uint16_t*)malloc(sizeof(uint16_t)*texel_count);
+    uint16_t *packed_scalar = (uint16_t*)malloc(sizeof(uint16_t)*texel_count);
+    uint8_t *unpacked = (uint8_t*)malloc(3*texel_count);
+    uint8_t *unpacked_scalar = (uint8_t*)malloc(3*texel_count);
+    
+    double mtexels_per_sec[4] = {0};
+    for (int32_t trial = 0; trial < 5; trial += 1){
+        for (int32_t k = 0; k < 4; k += 1){
+            uint64_t start = bench_now_ns();
+            switch (k){
+                case 0: atlas_levels_pack_scalar(baked.atlas, packed_scalar, texel_count); break;
+                case 1: atlas_levels_pack(baked.atlas, packed, texel_count); break;
+                case 2: atlas_levels_unpack_scalar(packed, unpacked_scalar, texel_count); break;
+                case 3: atlas_levels_unpack(packed, unpacked, texel_count); break;
+            }
+            uint64_t end = bench_now_ns();
+            double rate = (double)texel_count*1000.0/(double)(end - start);
+            if (rate > mtexels_per_sec[k]){
+                mtexels_per_sec[k] = rate;
+            }
+        }
+    }
+    bool32 lossless = bench_verify(memcmp(packed, packed_scalar, sizeof(uint16_t)*texel_count) == 0 &&
+                                   memcmp(unpacked, unpacked_scalar, 3*texel_count) == 0,
+                                   "atlas_levels: the SIMD kernels differ from the scalar ones");
+    int64_t changed_count = 0;
+    for (int64_t i = 0; i < 3*texel_count; i += 1){
+        changed_count += (atlas_level(baked.atlas[i]) != atlas_level(unpacked[i]));
+    }
+    lossless = bench_verify(changed_count == 0, "atlas_levels: texels lost their levels") && lossless;
+    
+    // Distinct level triples, the most an index into a palette would have to cover
+    static uint8_t seen[512];
+    memset(seen, 0, sizeof(seen));
+    int32_t distinct_count = 0;
+    for (int64_t i = 0; i < texel_count; i += 1){
+        distinct_count += (seen[packed[i]] == 0);
+        seen[packed[i]] = 1;
+    }
+    
+    // The Test Scene From Both Atlases
+    Bench_String strings[32];
+    int32_t string_count = bench_test_scene_strings(strings);
+    uint32_t codepoints[256];
+    Text_Batch batch = {0};
+    bench_push_test_scene(&batch, baked.map, baked.metrics, baked.atlas_side, strings, string_count, codepoints);
+    Text_Draw_List list = text_batch_draw_list(&batch);
+    Cpu_Compositor compositor = cpu_compositor_init();
+    Cpu_Framebuffer framebuffers[2];
+    for (int32_t i = 0; i < 2; i += 1){
+        Cpu_Atlas atlas = {(i == 0)?baked.atlas:unpacked, baked.atlas_side, baked.atlas_side, baked.slice_count};
+        framebuffers[i].w = 800;
+        framebuffers[i].h = 600;
+        framebuffers[i].pitch = 800;
+        framebuffers[i].pixels = (uint32_t*)malloc(sizeof(uint32_t)*800*600);
+        cpu_framebuffer_clear(&framebuffers[i], 0.f, 0.5f, 0.5f);
+        cpu_composite_draw_list(&compositor, &framebuffers[i], &atlas, &list, false);
+    }
+    lossless = bench_verify(memcmp(framebuffers[0].pixels, framebuffers[1].pixels, sizeof(uint32_t)*800*600) == 0,
+                            "atlas_levels: the test scene changed when drawn from the unpacked atlas") && lossless;
+    
+    printf("atlas_levels %s %.0fpt: %lld texels, %lld bytes as RGB, %lld packed (%.0f%% less), %d distinct level triples, "
+           "pack scalar %.0f simd %.0f Mtexel/sec, unpack scalar %.0f simd %.0f Mtexel/sec, %s\n",
+           font_name, point_size, (long long)texel_count, (long long)(3*texel_count), (long long)(2*texel_count),
+           100.0/3.0, distinct_count,
+           mtexels_per_sec[0], mtexels_per_sec[1], mtexels_per_sec[2], mtexels_per_sec[3],
+           lossless?"lossless":"NOT LOSSLESS");
+    
+    for (int32_t i = 0; i < 2; i += 1){
+        free(framebuffers[i].pixels);
+    }
+    cpu_compositor_free(&compositor);
+    text_batch_free(&batch);
+    free(unpacked_scalar);
+    free(unpacked);
+    free(packed_scalar);
+    free(packed);
+    software_font_free(&baked);
+}
+
+////////////////////////////////
+
+// Source text through the sparse glyph table against a template for every glyph of the font. The
+// instances of the glyphs that draw must come out the same, and the glyph cache must hand the cells
+// of glyphs that turn out empty to the next glyph. Reports what the whitespace no longer costs.
+void
+bench_sparse_glyphs(char *font_name, TTF_Font *font, char *text_file_name){
+    int32_t text_size = 0;
+    uint8_t *text = bench_read_file(text_file_name, &text_size);
+    if (text == 0){
+        printf("sparse_glyphs: cannot read %s\n", text_file_name);
+        return;
+    }
+    
+    Software_Font baked = software_font_bake(font, 12.f, 1);
+    Text_Glyph_Table *table = &baked.glyphs;
+    Text_Instance *full_templates = text_alloc_instance_templates(baked.metrics, baked.glyph_count, baked.atlas_side, baked.atlas_side);
+    
+    // Glyphs of every line, newlines dropped
+    uint32_t *codepoints = (uint32_t*)malloc(sizeof(uint32_t)*text_size);
+    uint16_t *glyphs = (uint16_t*)malloc(sizeof(uint16_t)*text_size);
+    int32_t *line_first = (int32_t*)malloc(sizeof(int32_t)*(text_size + 2));
+    int32_t line_count = 0;
+    int32_t glyph_count = 0;
+    {
+        int32_t codepoint_count = utf8_decode(text, text_size, codepoints);
+        line_first[0] = 0;
+        for (int32_t i = 0; i < codepoint_count; i += 1){
+            if (codepoints[i] == '\n'){
+                line_count += 1;
+                line_first[line_count] = glyph_count;
+                continue;
+            }
+            glyphs[glyph_count] = codepoint_map_lookup(baked.map, codepoints[i]);
+            glyph_count += 1;
+        }
+        line_count += 1;
+        line_first[line_count] = glyph_count;
+    }
+    
+    uint16_t *run_glyphs = (uint16_t*)malloc(sizeof(uint16_t)*(glyph_count + 1));
+    int32_t *pen_x = (int32_t*)malloc(sizeof(int32_t)*(glyph_count + 1));
+    Text_Batch batches[2] = {0};
+    // Stands in for the mapped text ring, a frame copies every instance it made into it.
+    Text_Instance *ring = (Text_Instance*)malloc(sizeof(Text_Instance)*(glyph_count + 1));
+    // Best of interleaved trials, the two are a few percent apart and one noisy pass would decide it.
+    double ns_per_glyph[2] = {0};
+    int32_t repeat = 20;
+    for (int32_t trial = 0; trial < 10*2; trial += 1){
+        int32_t method = trial%2;
+        Text_Batch *batch = &batches[method];
+        uint64_t start = bench_now_ns();
+        for (int32_t r = 0; r < repeat; r += 1){
+            text_batch_begin_frame(batch);
+            for (int32_t line = 0; line < line_count; line += 1){
+                int32_t first = line_first[line];
+                int32_t count = line_first[line + 1] - first;
+                int32_t pen_y = 20 + 16*(line%64);
+                text_batch_begin_string(batch, 1, baked.atlas_side, baked.atlas_side, 1.f, 1.f, 1.f, 1.f);
+                if (method == 0){
+                    int32_t pen = subpixel_from_whole_pixels(10);
+                    for (int32_t i = 0; i < count; i += 1){
+                        uint16_t glyph = glyphs[first + i];
+                        int32_t phase = 0;
+                        run_glyphs[i] = glyph;
+                        pen_x[i] = subpixel_snap(pen, 1, &phase);
+                        pen += table->advances[glyph];
+                    }
+                    text_batch_push_run(batch, full_templates, run_glyphs, pen_x, pen_y, count);
+                }
+                else{
+                    int32_t visible_count = text_glyph_table_layout(table, glyphs + first, count, 10, run_glyphs, pen_x);
+                    text_batch_push_run(batch, table->templates, run_glyphs, pen_x, pen_y, visible_count);
+                }
+            }
+            memcpy(ring, batch->instances, sizeof(Text_Instance)*batch->instance_count);
+        }
+        uint64_t end = bench_now_ns();
+        double ns = (double)(end - start)/((double)repeat*glyph_count);
+        if (trial < 2 || ns < ns_per_glyph[method]){
+            ns_per_glyph[method] = ns;
+        }
+    }
+    
+    // The full run with the empty instances taken out is the sparse run
+    int32_t empty_instance_count = 0;
+    {
+        Text_Instance *dense = batches[0].instances;
+        Text_Instance *sparse = batches[1].instances;
+        int32_t j = 0;
+        for (int32_t i = 0; i < glyph_count; i += 1){
+            if (text_glyph_is_empty(&baked.metrics[glyphs[i]])){
+                empty_instance_count += 1;
+                continue;
+            }
+            assert(j < batches[1].instance_count);
+            assert(memcmp(&dense[i], &sparse[j], sizeof(Text_Instance)) == 0);
+            j += 1;
+        }
+        assert(j == batches[1].instance_count);
+        assert(batches[0].instance_count == glyph_count);
+    }
+    
+    // On demand: the cache sees each glyph once, the empty ones give their cell straight back.
+    int32_t cell_side = (int32_t)ceilf((float)(font->ascent + font->descent)*(12.f*(96.f/72.f)/(float)font->units_per_em)) + 4;
+    Glyph_Cache cache = glyph_cache_init(baked.glyph_count, cell_side, cell_side, 1024, 1024, 1);
+    Text_Glyph_Table lazy = text_glyph_table_alloc(baked.metrics, baked.glyph_count, 1, baked.atlas_side, baked.atlas_side, false);
+    int32_t distinct_count = 0;
+    for (int32_t i = 0; i < glyph_count; i += 1){
+        uint16_t glyph = glyphs[i];
+        if (lazy.dense[glyph] != TEXT_GLYPH_UNKNOWN){
+            continue;
+        }
+        Atlas_Slot slot = {0};
+        Glyph_Cache_Result result = glyph_cache_lookup(&cache, glyph, &slot);
+        assert(result == GlyphCache_Miss);
+        text_glyph_table_set(&lazy, glyph, &baked.metrics[glyph], baked.atlas_side, baked.atlas_side);
+        if (lazy.dense[glyph] == TEXT_GLYPH_EMPTY){
+            glyph_cache_release(&cache, glyph);
+        }
+        distinct_count += 1;
+    }
+    int32_t resident_count = 0;
+    for (int32_t glyph = 0; glyph < baked.glyph_count; glyph += 1){
+        if (glyph_cache_is_resident(&cache, glyph)){
+            resident_count += 1;
+            assert(lazy.dense[glyph] < TEXT_GLYPH_UNKNOWN);
+        }
+    }
+    assert(resident_count == lazy.drawable_count);
+    assert((int32_t)cache.releases == lazy.empty_count);
+    assert(distinct_count == lazy.drawable_count + lazy.empty_count);
+    
+    uint64_t full_template_bytes = (uint64_t)baked.glyph_count*sizeof(Text_Instance);
+    uint64_t cell_bytes = (uint64_t)cell_side*cell_side*sizeof(uint16_t);
+    uint64_t sparse_template_bytes = (uint64_t)table->drawable_max*sizeof(Text_Instance);
+    printf("sparse_glyphs %s: %d of %d glyphs empty, templates %.1f KB -> %.1f KB\n",
+           font_name, table->empty_count, table->glyph_count, full_template_bytes/1024.0, sparse_template_bytes/1024.0);
+    // What a frame of this text sends through the instance ring, and how many vertices it runs
+    printf("sparse_glyphs %s: %d glyphs of text, %d empty (%.1f%%), instances %llu KB -> %llu KB and %d -> %d vertices a pass, "
+           "layout and ring copy %.2f -> %.2f ns/glyph\n",
+           text_file_name, glyph_count, empty_instance_count, 100.0*empty_instance_count/glyph_count,
+           (unsigned long long)(glyph_count*sizeof(Text_Instance)/1024),
+           (unsigned long long)((glyph_count - empty_instance_count)*sizeof(Text_Instance)/1024),
+           6*glyph_count, 6*(glyph_count - empty_instance_count), ns_per_glyph[0], ns_per_glyph[1]);
+    printf("sparse_glyphs %s: on demand %d distinct glyphs, %d cells released (%llu bytes of atlas cells)\n",
+           text_file_name, distinct_count, lazy.empty_count, (unsigned long long)(lazy.empty_count*cell_bytes));
+    
+    text_glyph_table_free(&lazy);
+    glyph_cache_free(&cache);
+    for (int32_t method = 0; method < 2; method += 1){
+        text_batch_free(&batches[method]);
+    }
+    free(ring);
+    free(pen_x);
+    free(run_glyphs);
+    free(line_first);
+    free(glyphs);
+    free(codepoints);
+    heap_free(full_templates);
+    software_font_free(&baked);
+    free(text);
+}
+
+////////////////////////////////
+
+// An editor drawing a source file: a line number and the text of every line in view, a cursor line
+// that is typed into every frame and a status line that changes with it. The view scrolls down a
+// line every few frames and sideways now and then. Every frame is drawn with and without the layout
+// cache and the two must make the same instances. The cache on its own is tested in
+// example_layout_cache_test.cpp.
+struct Bench_Editor_String{
+    char *text;
+    int32_t x;
+    int32_t y;
+};
+
+void
+bench_layout_cache(TTF_Font *font, char *source_file_name){
+    int32_t source_size = 0;
+    char *source = (char*)bench_read_file(source_file_name, &source_size);
+    if (source == 0){
+        printf("layout_cache: cannot read %s\n", source_file_name);
+        return;
+    }
+    
+    // Split into lines in place
+    char **lines = (char**)malloc(sizeof(char*)*(source_size + 1));
+    int32_t line_count = 0;
+    {
+        char *line = source;
+        for (int32_t i = 0; i <= source_size; i += 1){
+            if (i == source_size || source[i] == '\n'){
+                source[i] = 0;
+                if (i > 0 && source[i - 1] == '\r'){
+                    source[i - 1] = 0;
+                }
+                lines[line_count] = line;
+                line_count += 1;
+                line = source + i + 1;
+            }
+        }
+    }
+    
+    Software_Font baked = software_font_bake(font, 12.f, 1);
+    Software_Font cached = baked;
+    Layout_Cache cache = layout_cache_init(256, 256, 256);
+    cached.layout_cache = &cache;
+    
+    int32_t view_lines = 50;
+    int32_t frame_count = 1000;
+    int32_t cursor_row = 20;
+    Arena strings_arena = arena_alloc(1 << 20);
+    Arena arena = arena_alloc(1 << 20);
+    Text_Batch batches[2] = {0};
+    uint64_t ns[2] = {0};
+    uint64_t glyph_total = 0;
+    uint64_t frame_allocations[2] = {0};
+    int32_t mismatch_frames = 0;
+    Bench_Editor_String *strings = (Bench_Editor_String*)malloc(sizeof(Bench_Editor_String)*(2*view_lines + 1));
+    for (int32_t frame = 0; frame < frame_count; frame += 1){
+        // The strings of the frame
+        arena_reset(&strings_arena);
+        int32_t top = (frame/4)%(line_count - view_lines);
+        int32_t scroll_x = ((frame/100)%2 == 0)?0:-48;
+        int32_t string_count = 0;
+        for (int32_t row = 0; row < view_lines; row += 1){
+            int32_t line = top + row;
+            char *number = arena_push_array(&strings_arena, char, 16);
+            snprintf(number, 16, "%5d", line + 1);
+            strings[string_count].text = number;
+            strings[string_count].x = 4;
+            strings[string_count].y = 16 + 16*row;
+            string_count += 1;
+            
+            char *text = lines[line];
+            if (row == cursor_row){
+                // Typed into: the line grows by one letter a frame
+                int32_t length = (int32_t)strlen(lines[line]);
+                int32_t typed = 1 + frame%24;
+                text = arena_push_array(&strings_arena, char, length + typed + 1);
+                memcpy(text, lines[line], length);
+                for (int32_t i = 0; i < typed; i += 1){
+                    text[length + i] = (char)('a' + i);
+                }
+                text[length + typed] = 0;
+            }
+            strings[string_count].text = text;
+            strings[string_count].x = 60 + scroll_x;
+            strings[string_count].y = 16 + 16*row;
+            string_count += 1;
+        }
+        char *status = arena_push_array(&strings_arena, char, 64);
+        snprintf(status, 64, "Ln %d, Col %d  %s", top + cursor_row + 1, 1 + frame%24, source_file_name);
+        strings[string_count].text = status;
+        strings[string_count].x = 4;
+        strings[string_count].y = 16 + 16*view_lines;
+        string_count += 1;
+        
+        for (int32_t method = 0; method < 2; method += 1){
+            Software_Font *draw_font = (method == 0)?&baked:&cached;
+            Text_Batch *batch = &batches[method];
+            arena_reset(&arena);
+            heap_frame_begin();
+            uint64_t start = bench_now_ns();
+            text_batch_begin_frame(batch);
+            for (int32_t i = 0; i < string_count; i += 1){
+                software_font_draw_string(draw_font, batch, &arena, strings[i].text, strings[i].x, strings[i].y, 1.f, 1.f, 1.f, 1.f);
+            }
+            uint64_t end = bench_now_ns();
+            uint64_t allocations = heap_frame_end();
+            if (frame > 0){
+                ns[method] += end - start;
+                frame_allocations[method] += allocations;
+            }
+        }
+        
+        if (batches[0].instance_count != batches[1].instance_count ||
+            memcmp(batches[0].instances, batches[1].instances, sizeof(Text_Instance)*batches[0].instance_count) != 0){
+            mismatch_frames += 1;
+        }
+        if (frame > 0){
+            glyph_total += batches[0].instance_count;
+        }
+    }
+    bench_verify(mismatch_frames == 0, "layout_cache: frames drawn through the cache differ from ones laid out");
+    // Only the batches grow, the cache never allocates after init.
+    bench_verify(frame_allocations[1] == frame_allocations[0], "layout_cache: the cache allocated after init");
+    
+    uint64_t lookups = cache.hits + cache.misses;
+    printf("layout_cache %s: %d frames of %d strings, %.1f us/frame -> %.1f us/frame (%.1fx), %.2f -> %.2f ns/glyph\n",
+           source_file_name, frame_count, 2*view_lines + 1,
+           (double)ns[0]/(1000.0*(frame_count - 1)), (double)ns[1]/(1000.0*(frame_count - 1)), (double)ns[0]/(double)ns[1],
+           (double)ns[0]/(double)glyph_total, (double)ns[1]/(double)glyph_total);
+    printf("layout_cache %s: %.1f%% hits, %llu moved, %llu misses, %llu evictions, %llu too long, %llu KB\n",
+           source_file_name, 100.0*(double)cache.hits/(double)lookups, (unsigned long long)cache.moves,
+           (unsigned long long)cache.misses, (unsigned long long)cache.evictions, (unsigned long long)cache.bypasses,
+           (unsigned long long)(layout_cache_memory(&cache)/1024));
+    
+    free(strings);
+    for (int32_t method = 0; method < 2; method += 1){
+        text_batch_free(&batches[method]);
+    }
+    arena_free(&arena);
+    arena_free(&strings_arena);
+    layout_cache_free(&cache);
+    software_font_free(&baked);
+    free(lines);
+    free(source);
+}
+
+////////////////////////////////
+
+// Center of a glyph's coverage along x, in pixels from the pen.
+double
+bench_coverage_center_x(Glyph_Bitmap *bitmap){
+    double sum = 0.0;
+    double moment = 0.0;
+    for (int32_t y = 0; y < bitmap->h; y += 1){
+        uint8_t *line = bitmap->rgb + y*bitmap->pitch;
+        for (int32_t s = 0; s < 3*bitmap->w; s += 1){
+            sum += line[s];
+            moment += line[s]*((s + 0.5)/3.0);
+        }
+    }
+    return(bitmap->off_x + ((sum > 0.0)?moment/sum:0.0));
+}
+
+// draw_string's on demand layout: variants are looked up in a glyph cache keyed by variant and
+// rasterized shifted by their phase on a miss. Returns how many glyphs draw.
+int32_t
+bench_subpixel_layout(Text_Glyph_Table *table, Glyph_Cache *cache, Glyph_Rasterizer *rasterizer, Glyph_Metrics *metrics,
+                      int32_t atlas_side, uint16_t *glyphs, int32_t count, int32_t x,
+                      uint16_t *dense_out, int32_t *pen_x, uint64_t *tight_bytes){
+    int32_t phase_count = table->phase_count;
+    int32_t visible_count = 0;
+    int32_t pen = subpixel_from_whole_pixels(x);
+    for (int32_t i = 0; i < count; i += 1){
+        uint16_t glyph = glyphs[i];
+        int32_t phase = 0;
+        int32_t pixel_x = subpixel_snap(pen, phase_count, &phase);
+        int32_t variant = glyph*phase_count + phase;
+        pen += table->advances[glyph];
+        if (table->dense[variant] == TEXT_GLYPH_EMPTY){
+            continue;
+        }
+        Atlas_Slot slot = {0};
+        Glyph_Cache_Result result = glyph_cache_lookup(cache, variant, &slot);
+        assert(result != GlyphCache_Full);
+        if (result == GlyphCache_Miss){
+            if (cache->last_evicted >= 0){
+                text_glyph_table_release(table, cache->last_evicted);
+            }
+            Glyph_Metrics m = metrics[glyph];
+            Glyph_Bitmap bitmap = {0};
+            m.xy_w = 0.f;
+            m.xy_h = 0.f;
+            if (rasterizer->rasterize_glyph(rasterizer->backend, glyph, subpixel_phase_shift(phase, phase_count), &bitmap) &&
+                bitmap.w > 0 && bitmap.h > 0){
+                m.off_x = (float)bitmap.off_x;
+                m.off_y = (float)bitmap.off_y;
+                m.xy_w = (float)((bitmap.w < slot.w)?bitmap.w:slot.w);
+                m.xy_h = (float)((bitmap.h < slot.h)?bitmap.h:slot.h);
+                m.uv_x = (float)slot.x/(float)atlas_side;
+                m.uv_y = (float)slot.y/(float)atlas_side;
+                m.uv_slice = (float)slot.slice;
+                *tight_bytes += (uint64_t)bitmap.w*bitmap.h*sizeof(uint16_t);
+            }
+            text_glyph_table_set(table, variant, &m, atlas_side, atlas_side);
+            if (table->dense[variant] == TEXT_GLYPH_EMPTY){
+                glyph_cache_release(cache, variant);
+            }
+        }
+        uint16_t dense = table->dense[variant];
+        if (dense < TEXT_GLYPH_DENSE_MAX){
+            dense_out[visible_count] = dense;
+            pen_x[visible_count] = pixel_x;
+            visible_count += 1;
+        }
+    }
+    return(visible_count);
+}
+
+// How far whole pixel advances drift from the font's widths over the lines of a source file, that a
+// shifted variant really moves by its phase, and the atlas each phase count needs for the file's
+// glyphs. The 26.6 math on its own is tested in example_subpixel_test.cpp.
+void
+bench_subpixel(TTF_Font *font, char *source_file_name){
+    int32_t source_size = 0;
+    uint8_t *source = bench_read_file(source_file_name, &source_size);
+    if (source == 0){
+        printf("subpixel: cannot read %s\n", source_file_name);
+        return;
+    }
+    
+    float point_size = 12.f;
+    float pixel_per_em = point_size*(1.f/72.f)*96.f;
+    float pixel_per_design_unit = pixel_per_em/(float)font->units_per_em;
+    Glyph_Metrics *metrics = (Glyph_Metrics*)malloc(sizeof(Glyph_Metrics)*font->glyph_count);
+    memset(metrics, 0, sizeof(Glyph_Metrics)*font->glyph_count);
+    for (int32_t glyph = 0; glyph < font->glyph_count; glyph += 1){
+        metrics[glyph].advance = (float)ttf_glyph_advance(font, glyph)*pixel_per_design_unit;
+    }
+    Codepoint_Map *map = codepoint_map_alloc(font, ttf_codepoint_glyphs);
+    
+    // Glyphs of every line
+    uint32_t *codepoints = (uint32_t*)malloc(sizeof(uint32_t)*source_size);
+    uint16_t *glyphs = (uint16_t*)malloc(sizeof(uint16_t)*(source_size + 1));
+    int32_t *line_first = (int32_t*)malloc(sizeof(int32_t)*(source_size + 2));
+    int32_t line_count = 0;
+    int32_t glyph_count = 0;
+    {
+        int32_t codepoint_count = utf8_decode(source, source_size, codepoints);
+        line_first[0] = 0;
+        for (int32_t i = 0; i < codepoint_count; i += 1){
+            if (codepoints[i] == '\n'){
+                line_count += 1;
+                line_first[line_count] = glyph_count;
+                continue;
+            }
+            glyphs[glyph_count] = codepoint_map_lookup(map, codepoints[i]);
+            glyph_count += 1;
+        }
+        line_count += 1;
+        line_first[line_count] = glyph_count;
+    }
+    
+    // Drift at the end of each line against the exact sum of the advances
+    {
+        int32_t *advances = (int32_t*)malloc(sizeof(int32_t)*font->glyph_count);
+        for (int32_t glyph = 0; glyph < font->glyph_count; glyph += 1){
+            advances[glyph] = subpixel_from_pixels(metrics[glyph].advance);
+        }
+        double ceil_max = 0.0;
+        double ceil_sum = 0.0;
+        double fixed_max = 0.0;
+        double fixed_sum = 0.0;
+        double bound_use_max = 0.0;
+        int32_t past_bound_count = 0;
+        for (int32_t line = 0; line < line_count; line += 1){
+            double exact = 0.0;
+            int32_t ceil_pen = 0;
+            int32_t fixed_pen = 0;
+            for (int32_t i = line_first[line]; i < line_first[line + 1]; i += 1){
+                exact += (double)ttf_glyph_advance(font, glyphs[i])*pixel_per_design_unit;
+                ceil_pen += (int32_t)ceilf(metrics[glyphs[i]].advance);
+                fixed_pen += advances[glyphs[i]];
+            }
+            double ceil_error = fabs((double)ceil_pen - exact);
+            double fixed_error = fabs((double)fixed_pen/SUBPIXEL_ONE - exact);
+            ceil_max = (ceil_error > ceil_max)?ceil_error:ceil_max;
+            fixed_max = (fixed_error > fixed_max)?fixed_error:fixed_max;
+            ceil_sum += ceil_error;
+            fixed_sum += fixed_error;
+            
+            // Each advance rounds by at most half a 64th, so the drift of a line is bounded by its
+            // glyph count. Snapping the last pen can add one more step.
+            int32_t count = line_first[line + 1] - line_first[line];
+            double bound = (double)count*0.5/SUBPIXEL_ONE + 1.0/SUBPIXEL_ONE;
+            past_bound_count += (fixed_error > bound);
+            double bound_use = fixed_error/bound;
+            bound_use_max = (bound_use > bound_use_max)?bound_use:bound_use_max;
+        }
+        printf("subpixel %s: line end drift over %d lines, whole pixel advances %.2f px mean %.2f px max, 26.6 %.3f px mean %.3f px max (%.0f%% of the rounding bound)\n",
+               source_file_name, line_count, ceil_sum/line_count, ceil_max, fixed_sum/line_count, fixed_max,
+               100.0*bound_use_max);
+        bench_verify(past_bound_count == 0, "subpixel: 26.6 lines drifted past the rounding bound");
+        free(advances);
+    }
+    
+    Software_Rasterizer software = {0};
+    Glyph_Rasterizer rasterizer = software_rasterizer_init(&software, font, pixel_per_em);
+    
+    // A variant moves by its phase
+    {
+        char sample[] = "lHoWm";
+        double max_error = 0.0;
+        for (int32_t k = 0; sample[k] != 0; k += 1){
+            uint16_t glyph = codepoint_map_lookup(map, (uint32_t)sample[k]);
+            Glyph_Bitmap bitmap = {0};
+            rasterizer.rasterize_glyph(rasterizer.backend, glyph, 0.f, &bitmap);
+            double base = bench_coverage_center_x(&bitmap);
+            for (int32_t phase = 1; phase < SUBPIXEL_PHASE_MAX; phase += 1){
+                float shift_x = subpixel_phase_shift(phase, SUBPIXEL_PHASE_MAX);
+                rasterizer.rasterize_glyph(rasterizer.backend, glyph, shift_x, &bitmap);
+                double error = fabs(bench_coverage_center_x(&bitmap) - base - shift_x);
+                max_error = (error > max_error)?error:max_error;
+            }
+        }
+        bench_verify(max_error < 0.05, "subpixel: a shifted variant does not move by its phase");
+    }
+    
+    // Atlas per phase count: the file laid out twice through a glyph cache big enough for all of it
+    int32_t cell_side = (int32_t)ceilf((float)(font->ascent + font->descent)*pixel_per_design_unit) + 4;
+    int32_t atlas_side = 1024;
+    uint16_t *dense = (uint16_t*)malloc(sizeof(uint16_t)*(glyph_count + 1));
+    uint16_t *dense_check = (uint16_t*)malloc(sizeof(uint16_t)*(glyph_count + 1));
+    int32_t *pen_x = (int32_t*)malloc(sizeof(int32_t)*(glyph_count + 1));
+    int32_t *pen_x_check = (int32_t*)malloc(sizeof(int32_t)*(glyph_count + 1));
+    uint64_t one_phase_bytes = 0;
+    for (int32_t phase_count = 1; phase_count <= SUBPIXEL_PHASE_MAX; phase_count += 1){
+        Text_Glyph_Table table = text_glyph_table_alloc(metrics, font->glyph_count, phase_count, atlas_side, atlas_side, false);
+        Glyph_Cache cache = glyph_cache_init(font->glyph_count*phase_count, cell_side, cell_side, atlas_side, atlas_side, 4);
+        uint64_t tight_bytes = 0;
+        uint64_t layout_ns = 0;
+        int32_t mismatch_lines = 0;
+        for (int32_t pass = 0; pass < 2; pass += 1){
+            glyph_cache_begin_frame(&cache);
+            uint64_t start = bench_now_ns();
+            for (int32_t line = 0; line < line_count; line += 1){
+                int32_t first = line_first[line];
+                int32_t count = line_first[line + 1] - first;
+                int32_t visible_count = bench_subpixel_layout(&table, &cache, &rasterizer, metrics, atlas_side,
+                                                              glyphs + first, count, 10, dense, pen_x, &tight_bytes);
+                if (pass == 1){
+                    // Once everything is baked the plain table layout agrees
+                    int32_t check_count = text_glyph_table_layout(&table, glyphs + first, count, 10, dense_check, pen_x_check);
+                    if (check_count != visible_count ||
+                        memcmp(dense, dense_check, sizeof(uint16_t)*visible_count) != 0 ||
+                        memcmp(pen_x, pen_x_check, sizeof(int32_t)*visible_count) != 0){
+                        mismatch_lines += 1;
+                    }
+                }
+            }
+            uint64_t end = bench_now_ns();
+            if (pass == 1){
+                layout_ns = end - start;
+            }
+        }
+        bench_verify(mismatch_lines == 0, "subpixel: the table layout differs from the baking one");
+        bench_verify(cache.evictions == 0, "subpixel: the glyph cache evicted with room for every variant");
+        
+        uint64_t cell_bytes = (uint64_t)table.drawable_count*cell_side*cell_side*sizeof(uint16_t);
+        if (phase_count == 1){
+            one_phase_bytes = cell_bytes;
+        }
+        printf("subpixel %s: %d phase(s), %d variants drawn, atlas %llu KB in cells (%.2fx), %llu KB packed tight, table %llu KB, layout %.2f ns/glyph\n",
+               source_file_name, phase_count, table.drawable_count,
+               (unsigned long long)(cell_bytes/1024), (double)cell_bytes/(double)one_phase_bytes,
+               (unsigned long long)(tight_bytes/1024), (unsigned long long)(text_glyph_table_memory(&table)/1024),
+               (double)layout_ns/(double)glyph_count);
+        
+        glyph_cache_free(&cache);
+        text_glyph_table_free(&table);
+    }
+    
+    free(pen_x_check);
+    free(pen_x);
+    free(dense_check);
+    free(dense);
+    software_rasterizer_free(&software);
+    free(line_first);
+    free(glyphs);
+    free(codepoints);
+    codepoint_map_free(map);
+    free(metrics);
+    free(source);
+}
+
+////////////////////////////////
+
+// Zooming in and out through a registry of four sizes: how long a frame waits on a size it has not
+// seen and on one already resident, what each size holds and that a size baked in the background is
+// the same bake as one made directly. A registry of one size checks that the font on screen is
+// never evicted to make room for the next.
+void
+bench_font_registry(char *font_name, TTF_Font *font){
+    int32_t worker_count = 2;
+    Font_Registry registry = font_registry_init(font, 4, worker_count, 0);
+    
+    // Same bake either way, with the face shared or not
+    {
+        Software_Font *from_registry = font_registry_get_wait(&registry, 12.f, 96.f);
+        Software_Font direct = software_font_bake(font, 12.f, worker_count);
+        assert(from_registry != 0 && from_registry->shared_face && !direct.shared_face);
+        assert(from_registry->face == &registry.face && from_registry->map == registry.face.map);
+        assert(from_registry->slice_count == direct.slice_count && from_registry->atlas_side == direct.atlas_side);
+        assert(memcmp(from_registry->metrics, direct.metrics, sizeof(Glyph_Metrics)*direct.glyph_count) == 0);
+        assert(memcmp(from_registry->atlas, direct.atlas, (size_t)direct.atlas_side*direct.atlas_side*direct.slice_count*3) == 0);
+        // 9pt at 128 dpi is 12pt at 96 dpi
+        assert(font_registry_get(&registry, 9.f, 128.f) == from_registry);
+        software_font_free(&direct);
+    }
+    
+    // Zoom steps. A new size does not hold up the frame that asks for it, the wait after that stands
+    // in for the frames drawn at the old size until the bake is in.
+    float zoom_sizes[] = {12.f, 14.f, 16.f, 18.f, 16.f, 14.f, 12.f, 10.f, 12.f, 14.f, 24.f, 14.f};
+    int32_t zoom_count = (int32_t)(sizeof(zoom_sizes)/sizeof(zoom_sizes[0]));
+    uint64_t request_ns = 0;
+    uint64_t baked_ns = 0;
+    uint64_t resident_ns = 0;
+    int32_t baked_count = 0;
+    int32_t resident_count = 0;
+    for (int32_t i = 0; i < zoom_count; i += 1){
+        uint64_t start = bench_now_ns();
+        Software_Font *zoomed = font_registry_get(&registry, zoom_sizes[i], 96.f);
+        uint64_t end = bench_now_ns();
+        if (zoomed == 0){
+            zoomed = font_registry_get_wait(&registry, zoom_sizes[i], 96.f);
+            request_ns += end - start;
+            baked_ns += bench_now_ns() - start;
+            baked_count += 1;
+        }
+        else{
+            resident_ns += end - start;
+            resident_count += 1;
+        }
+        assert(zoomed != 0 && zoomed->face == &registry.face);
+    }
+    assert(baked_count > 0 && resident_count > 0);
+    
+    {
+        Font_Registry single = font_registry_init(font, 1, 1, 0);
+        Software_Font *current = font_registry_get_wait(&single, 12.f, 96.f);
+        float current_pixel_per_em = current->pixel_per_em;
+        assert(font_registry_get_or_keep(&single, 14.f, 96.f, current) == current);
+        assert(current->pixel_per_em == current_pixel_per_em && single.evictions == 0 && single.stalls == 1);
+        assert(font_registry_get_or_keep(&single, 14.f, 96.f, 0) == 0 && single.evictions == 1);
+        assert(font_registry_get_wait(&single, 14.f, 96.f) != 0);
+        font_registry_free(&single);
+    }
+    
+    uint64_t shared_bytes = 0;
+    uint64_t size_bytes = font_registry_memory(&registry, &shared_bytes);
+    printf("font_registry %s: %d zooms, %d new sizes (request %.1f us, baked in %.2f ms), %d resident %.0f ns each, %llu evictions\n",
+           font_name, zoom_count, baked_count, (double)request_ns/(1000.0*baked_count), (double)baked_ns/(1000000.0*baked_count),
+           resident_count, (double)resident_ns/resident_count, (unsigned long long)registry.evictions);
+    for (int32_t i = 0; i < registry.size_max; i += 1){
+        Font_Registry_Size *size = &registry.sizes[i];
+        if (size->state == FontSize_Ready){
+            printf("font_registry %s: %.1fpt resident, %llu KB (atlas %dx%dx%d)\n",
+                   font_name, size->pixel_per_em*72.f/96.f, (unsigned long long)(software_font_memory(&size->font)/1024),
+                   size->font.atlas_side, size->font.atlas_side, size->font.slice_count);
+        }
+    }
+    printf("font_registry %s: %llu KB in sizes, %llu KB shared by all of them\n",
+           font_name, (unsigned long long)(size_bytes/1024), (unsigned long long)(shared_bytes/1024));
+    
+    font_registry_free(&registry);
+}
+
+////////////////////////////////
+
+// Stands in for the atlas texture: the uploads are copied into it so it can be compared with the
+// CPU copy after every flush.
+struct Bench_Atlas_GPU{
+    int32_t atlas_w;
+    int32_t atlas_h;
+    uint16_t *texels;
+};
+
+void
+bench_atlas_upload(void *backend, int32_t slice, Atlas_Dirty_Rect rect, uint16_t *texels, int32_t pitch){
+    Bench_Atlas_GPU *gpu = (Bench_Atlas_GPU*)backend;
+    uint16_t *dst = gpu->texels + ((size_t)slice*gpu->atlas_h + rect.y0)*gpu->atlas_w + rect.x0;
+    for (int32_t y = rect.y0; y < rect.y1; y += 1){
+        memcpy(dst, texels, sizeof(uint16_t)*(rect.x1 - rect.x0));
+        dst += gpu->atlas_w;
+        texels += pitch;
+    }
+}
+
+// Scrolling through a source file with glyphs baked on demand the way the GL window does it: 40
+// lines on screen, 8 new lines a frame, three subpixel phases in a 512x512x2 glyph cache. The
+// texels each frame bakes reach the atlas as one upload per glyph, as the whole atlas, or as dirty
+// rectangles coalesced with a few merge_slack settings. The uploads are checked against the CPU copy
+// after every frame. The coalescing on its own is tested in example_atlas_dirty_test.cpp.
+void
+bench_atlas_dirty(TTF_Font *font, char *source_file_name){
+    int32_t source_size = 0;
+    uint8_t *source = bench_read_file(source_file_name, &source_size);
+    if (source == 0){
+        printf("atlas_dirty: cannot read %s\n", source_file_name);
+        return;
+    }
+    
+    float pixel_per_em = 12.f*(1.f/72.f)*96.f;
+    float pixel_per_design_unit = pixel_per_em/(float)font->units_per_em;
+    Codepoint_Map *map = codepoint_map_alloc(font, ttf_codepoint_glyphs);
+    int32_t *advances = (int32_t*)malloc(sizeof(int32_t)*font->glyph_count);
+    for (int32_t glyph = 0; glyph < font->glyph_count; glyph += 1){
+        advances[glyph] = subpixel_from_pixels((float)ttf_glyph_advance(font, glyph)*pixel_per_design_unit);
+    }
+    
+    // Glyphs of every line
+    uint32_t *codepoints = (uint32_t*)malloc(sizeof(uint32_t)*source_size);
+    uint16_t *glyphs = (uint16_t*)malloc(sizeof(uint16_t)*(source_size + 1));
+    int32_t *line_first = (int32_t*)malloc(sizeof(int32_t)*(source_size + 2));
+    int32_t line_count = 0;
+    int32_t glyph_count = 0;
+    {
+        int32_t codepoint_count = utf8_decode(source, source_size, codepoints);
+        line_first[0] = 0;
+        for (int32_t i = 0; i < codepoint_count; i += 1){
+            if (codepoints[i] == '\n'){
+                line_count += 1;
+                line_first[line_count] = glyph_count;
+                continue;
+            }
+            glyphs[glyph_count] = codepoint_map_lookup(map, codepoints[i]);
+            glyph_count += 1;
+        }
+        line_count += 1;
+        line_first[line_count] = glyph_count;
+    }
+    
+    int32_t phase_count = 3;
+    int32_t atlas_side = 512;
+    int32_t slice_count = 2;
+    int32_t cell_side = (int32_t)ceilf((float)(font->ascent + font->descent)*pixel_per_design_unit) + 4;
+    int32_t lines_on_screen = 40;
+    int32_t lines_per_frame = 8;
+    uint16_t *cell = (uint16_t*)malloc(sizeof(uint16_t)*cell_side*cell_side);
+    uint64_t atlas_texels = (uint64_t)atlas_side*atlas_side*slice_count;
+    
+    Bench_Atlas_GPU gpu = {0};
+    gpu.atlas_w = atlas_side;
+    gpu.atlas_h = atlas_side;
+    gpu.texels = (uint16_t*)malloc(sizeof(uint16_t)*atlas_texels);
+    
+    int32_t slacks[] = {0, 256, 1024, 4096};
+    for (int32_t k = 0; k < 4; k += 1){
+        Glyph_Cache cache = glyph_cache_init(font->glyph_count*phase_count, cell_side, cell_side, atlas_side, atlas_side, slice_count);
+        Atlas_Dirty dirty = atlas_dirty_init(atlas_side, atlas_side, slice_count, slacks[k]);
+        memset(gpu.texels, 0, sizeof(uint16_t)*atlas_texels);
+        
+        int32_t frame_count = 0;
+        int32_t baking_frames = 0;
+        int32_t stale_frames = 0;
+        uint64_t write_ns = 0;
+        uint64_t flush_ns = 0;
+        for (int32_t top = 0; top < line_count; top += lines_per_frame){
+            glyph_cache_begin_frame(&cache);
+            uint64_t glyphs_before = dirty.stats.glyphs;
+            int32_t bottom = (top + lines_on_screen < line_count)?(top + lines_on_screen):line_count;
+            for (int32_t line = top; line < bottom; line += 1){
+                int32_t pen = subpixel_from_whole_pixels(10);
+                for (int32_t i = line_first[line]; i < line_first[line + 1]; i += 1){
+                    uint16_t glyph = glyphs[i];
+                    int32_t phase = 0;
+                    subpixel_snap(pen, phase_count, &phase);
+                    pen += advances[glyph];
+                    int32_t w = 0;
+                    int32_t h = 0;
+                    bench_glyph_pixel_box(font, glyph, pixel_per_design_unit, &w, &h);
+                    if (w <= 0 || h <= 0){
+                        continue;
+                    }
+                    int32_t variant = glyph*phase_count + phase;
+                    Atlas_Slot slot = {0};
+                    Glyph_Cache_Result result = glyph_cache_lookup(&cache, variant, &slot);
+                    assert(result != GlyphCache_Full);
+                    if (result == GlyphCache_Miss){
+                        // Texels only the variant would write, so a lost or misplaced upload shows.
+                        w = (w < slot.w)?w:slot.w;
+                        h = (h < slot.h)?h:slot.h;
+                        for (int32_t t = 0; t < w*h; t += 1){
+                            cell[t] = (uint16_t)((variant*7 + t) & 0x1FF);
+                        }
+                        uint64_t start = bench_now_ns();
+                        atlas_dirty_write(&dirty, slot.slice, slot.x, slot.y, w, h, cell, w);
+                        write_ns += bench_now_ns() - start;
+                    }
+                }
+            }
+            
+            uint64_t start = bench_now_ns();
+            atlas_dirty_flush(&dirty, bench_atlas_upload, &gpu);
+            flush_ns += bench_now_ns() - start;
+            stale_frames += (memcmp(gpu.texels, dirty.texels, sizeof(uint16_t)*atlas_texels) != 0);
+            frame_count += 1;
+            if (dirty.stats.glyphs != glyphs_before){
+                baking_frames += 1;
+            }
+        }
+        
+        bench_verify(stale_frames == 0, "atlas_dirty: the uploads left the texture behind the CPU copy");
+        Atlas_Dirty_Stats *stats = &dirty.stats;
+        double glyph_total = (double)stats->glyphs;
+        if (k == 0){
+            printf("atlas_dirty %s: %d frames, %d of them baked %llu glyphs, %llu evictions\n",
+                   source_file_name, frame_count, baking_frames, (unsigned long long)stats->glyphs,
+                   (unsigned long long)cache.evictions);
+            printf("atlas_dirty %s: whole atlas %.0f bytes/glyph in %d uploads, per glyph %.0f bytes/glyph in %llu uploads\n",
+                   source_file_name, (double)(atlas_texels*sizeof(uint16_t)*baking_frames)/glyph_total, baking_frames*slice_count,
+                   (double)(stats->written*sizeof(uint16_t))/glyph_total, (unsigned long long)stats->glyphs);
+        }
+        printf("atlas_dirty %s: slack %4d, %.0f bytes/glyph in %llu uploads (%.1f per baking frame), %.1f%% extra, %.0f ns/glyph to mark, %.0f ns/glyph to flush\n",
+               source_file_name, slacks[k], (double)(stats->uploaded*sizeof(uint16_t))/glyph_total,
+               (unsigned long long)stats->uploads, (double)stats->uploads/baking_frames,
+               100.0*(double)(stats->uploaded - stats->written)/(double)stats->written,
+               (double)write_ns/glyph_total, (double)flush_ns/glyph_total);
+        
+        atlas_dirty_free(&dirty);
+        glyph_cache_free(&cache);
+    }
+    
+    free(gpu.texels);
+    free(cell);
+    free(line_first);
+    free(glyphs);
+    free(codepoints);
+    free(advances);
+    codepoint_map_free(map);
+    free(source);
+}
+
+////////////////////////////////
+
+// The test scene as a render command stream: executing it on the CPU gives the same pixels as
+// compositing the draw list directly, a blit lands clipped where it should, and a capture of many
+// frames reads back byte for byte while damaged frames are turned away. Reports what recording,
+// writing, reading and replaying a frame cost.
+void
+bench_render_commands(char *font_name, TTF_Font *font){
+    Cpu_Compositor compositor = cpu_compositor_init();
+    Software_Font baked = software_font_bake(font, 12.f, 1);
+    Cpu_Atlas atlas = {baked.atlas, baked.atlas_side, baked.atlas_side, baked.slice_count};
+    
+    Bench_String strings[32];
+    int32_t string_count = bench_test_scene_strings(strings);
+    uint32_t codepoints[256];
+    Text_Batch batch = {0};
+    
+    Cpu_Framebuffer framebuffers[3];
+    for (int32_t i = 0; i < 3; i += 1){
+        framebuffers[i].w = 800;
+        framebuffers[i].h = 600;
+        framebuffers[i].pitch = 800;
+        framebuffers[i].pixels = (uint32_t*)malloc(sizeof(uint32_t)*800*600);
+        memset(framebuffers[i].pixels, 0, sizeof(uint32_t)*800*600);
+    }
+    Cpu_Framebuffer *direct = &framebuffers[0];
+    Cpu_Render_Target target = {0};
+    target.compositor = &compositor;
+    target.framebuffer = &framebuffers[1];
+    target.atlas = &atlas;
+    target.window = &framebuffers[2];
+    Render_Executor executor = cpu_render_executor(&target);
+    
+    // The draw list straight into the compositor
+    bench_push_test_scene(&batch, baked.map, baked.metrics, baked.atlas_side, strings, string_count, codepoints);
+    Text_Draw_List list = text_batch_draw_list(&batch);
+    cpu_framebuffer_clear(direct, 0.f, 0.5f, 0.5f);
+    cpu_composite_draw_list(&compositor, direct, &atlas, &list, false);
+    
+    // The same frame recorded and executed
+    Render_Stream stream = {0};
+    render_stream_begin_frame(&stream);
+    render_clear(&stream, 0.f, 0.5f, 0.5f);
+    uint64_t record_start = bench_now_ns();
+    render_text_batch(&stream, &batch);
+    uint64_t record_end = bench_now_ns();
+    render_blit(&stream, 0, 0, 800, 600, 0, 0);
+    bench_verify(batch.instance_count == 0, "render_commands: recording left the batch full");
+    Render_Atlas_Bounds bounds = {atlas.w, atlas.h, atlas.slice_count};
+    bench_verify(render_stream_validate(&stream, &bounds), "render_commands: the recorded frame does not validate");
+    render_stream_execute(&stream, &executor);
+    bench_verify(memcmp(direct->pixels, framebuffers[1].pixels, sizeof(uint32_t)*800*600) == 0,
+                 "render_commands: the executed frame differs from the direct composite");
+    bench_verify(memcmp(direct->pixels, framebuffers[2].pixels, sizeof(uint32_t)*800*600) == 0,
+                 "render_commands: the blit differs from the frame");
+    uint64_t frame_bytes = stream.size;
+    int32_t frame_commands = stream.command_count;
+    
+    // A blit hanging off the top left of both framebuffers
+    {
+        Render_Stream blit_stream = {0};
+        render_blit(&blit_stream, -10, 20, 300, 200, 30, -40);
+        memset(framebuffers[2].pixels, 0, sizeof(uint32_t)*800*600);
+        render_stream_execute(&blit_stream, &executor);
+        int32_t wrong_pixels = 0;
+        for (int32_t y = 0; y < 600; y += 1){
+            for (int32_t x = 0; x < 800; x += 1){
+                int32_t src_x = x - 30 - 10;
+                int32_t src_y = y + 40 + 20;
+                bool32 inside = (x >= 40 && x < 40 + 290 && y < 200 - 40);
+                uint32_t expected = inside?framebuffers[1].pixels[src_y*800 + src_x]:0;
+                wrong_pixels += (framebuffers[2].pixels[y*800 + x] != expected);
+            }
+        }
+        bench_verify(wrong_pixels == 0, "render_commands: the clipped blit is wrong");
+        render_stream_free(&blit_stream);
+    }
+    
+    // A capture of many frames, written, read back and replayed
+    int32_t capture_frames = 200;
+    FILE *file = tmpfile();
+    if (file == 0){
+        printf("render_commands: no temporary file for the capture\n");
+    }
+    else{
+        uint64_t write_start = bench_now_ns();
+        bool32 written = render_capture_begin(file);
+        for (int32_t i = 0; i < capture_frames; i += 1){
+            written = written && render_capture_write_frame(file, &stream);
+        }
+        fflush(file);
+        uint64_t write_end = bench_now_ns();
+        bench_verify(written, "render_commands: the capture was not written");
+        
+        rewind(file);
+        Render_Stream replay = {0};
+        uint64_t read_ns = 0;
+        uint64_t replay_ns = 0;
+        bench_verify(render_capture_check(file), "render_commands: the capture header does not check");
+        int32_t read_count = 0;
+        int32_t changed_frames = 0;
+        for (;;){
+            uint64_t start = bench_now_ns();
+            bool32 read = render_capture_read_frame(file, &replay, &bounds);
+            uint64_t mid = bench_now_ns();
+            if (!read){
+                break;
+            }
+            changed_frames += (replay.size != stream.size || replay.command_count != stream.command_count ||
+                               memcmp(replay.memory, stream.memory, (size_t)stream.size) != 0);
+            render_stream_execute(&replay, &executor);
+            uint64_t end = bench_now_ns();
+            read_ns += mid - start;
+            replay_ns += end - mid;
+            read_count += 1;
+        }
+        bench_verify(read_count == capture_frames && changed_frames == 0,
+                     "render_commands: the capture did not read back frame for frame");
+        bench_verify(memcmp(direct->pixels, framebuffers[1].pixels, sizeof(uint32_t)*800*600) == 0,
+                     "render_commands: the replayed frame differs from the direct composite");
+        
+        double capture_bytes = (double)frame_bytes*capture_frames;
+        printf("render_commands %s: %d commands, %llu bytes a frame (%d glyphs), record %.2f us, write %.0f MB/s, read %.0f MB/s, replay %.3f ms/frame\n",
+               font_name, frame_commands, (unsigned long long)frame_bytes, list.instance_count,
+               (double)(record_end - record_start)/1000.0,
+               capture_bytes*1000.0/(double)(write_end - write_start), capture_bytes*1000.0/(double)read_ns,
+               (double)replay_ns/(1000000.0*capture_frames));
+        render_stream_free(&replay);
+        fclose(file);
+    }
+    
+    render_stream_free(&stream);
+    for (int32_t i = 0; i < 3; i += 1){
+        free(framebuffers[i].pixels);
+    }
+    text_batch_free(&batch);
+    software_font_free(&baked);
+    cpu_compositor_free(&compositor);
+}
+
+////////////////////////////////
+
+// Instances for every line of a text file three ways: text_batch_push_glyph per glyph (the path
+// draw_string used to take), the scalar template kernel and the SIMD template kernel. All three
+// must produce the same bytes.
+void
+bench_instance_kernel(char *font_name, TTF_Font *font, char *text_file_name){
+    int32_t text_size = 0;
+    uint8_t *text = bench_read_file(text_file_name, &text_size);
+    if (text == 0){
+        printf("instance_kernel: cannot read %s\n", text_file_name);
+        return;
+    }
+    
+    Glyph_Metrics *metrics = (Glyph_Metrics*)malloc(sizeof(Glyph_Metrics)*font->glyph_count);
+    int32_t atlas_side = 0;
+    bench_build_metrics(font, 12.f, metrics, &atlas_side);
+    Text_Instance *templates = text_alloc_instance_templates(metrics, font->glyph_count, atlas_side, atlas_side);
+    Codepoint_Map *map = codepoint_map_alloc(font, ttf_codepoint_glyphs);
+    
+    // Glyphs and pen positions of every line
+    uint32_t *codepoints = (uint32_t*)malloc(sizeof(uint32_t)*text_size);
+    uint16_t *glyphs = (uint16_t*)malloc(sizeof(uint16_t)*text_size);
+    int32_t *pen_x = (int32_t*)malloc(sizeof(int32_t)*text_size);
+    int32_t *line_first = (int32_t*)malloc(sizeof(int32_t)*(text_size + 2));
+    int32_t line_count = 0;
+    int32_t glyph_count = 0;
+    {
+        int32_t codepoint_count = utf8_decode(text, text_size, codepoints);
+        int32_t layout_x = 0;
+        line_first[0] = 0;
+        for (int32_t i = 0; i < codepoint_count; i += 1){
+            if (codepoints[i] == '\n'){
+                line_count += 1;
+                line_first[line_count] = glyph_count;
+                layout_x = 0;
+                continue;
+            }
+            uint16_t glyph = codepoint_map_lookup(map, codepoints[i]);
+            glyphs[glyph_count] = glyph;
+            pen_x[glyph_count] = 10 + layout_x;
+            glyph_count += 1;
+            layout_x += (int32_t)metrics[glyph].advance;
+        }
+        line_count += 1;
+        line_first[line_count] = glyph_count;
+    }
+    
+    Text_Batch batches[3] = {0};
+    double ns_per_glyph[3] = {0};
+    int32_t repeat = 200;
+    for (int32_t method = 0; method < 3; method += 1){
+        Text_Batch *batch = &batches[method];
+        uint64_t start = bench_now_ns();
+        for (int32_t r = 0; r < repeat; r += 1){
+            text_batch_begin_frame(batch);
+            for (int32_t line = 0; line < line_count; line += 1){
+                int32_t first = line_first[line];
+                int32_t count = line_first[line + 1] - first;
+                int32_t pen_y = 20 + 16*(line%64);
+                text_batch_begin_string(batch, 1, atlas_side, atlas_side, 1.f, 1.f, 1.f, 1.f);
+                if (method == 0){
+                    for (int32_t i = 0; i < count; i += 1){
+                        text_batch_push_glyph(batch, &metrics[glyphs[first + i]], (float)pen_x[first + i], (float)pen_y);
+                    }
+                }
+                else if (method == 1){
+                    if (batch->instance_count + count > batch->instance_max){
+                        batch->instance_max = 2*(batch->instance_count + count);
+                        batch->instances = (Text_Instance*)realloc(batch->instances, sizeof(Text_Instance)*batch->instance_max);
+                    }
+                    text_emit_instances_scalar(templates, glyphs + first, pen_x + first, pen_y, batch->style, count,
+                                               batch->instances + batch->instance_count);
+                    batch->instance_count += count;
+                    batch->commands[batch->command_count - 1].instance_count += count;
+                    batch->glyph_count += count;
+                }
+                else{
+                    text_batch_push_run(batch, templates, glyphs + first, pen_x + first, pen_y, count);
+                }
+            }
+        }
+        uint64_t end = bench_now_ns();
+        ns_per_glyph[method] = (double)(end - start)/((double)repeat*glyph_count);
+    }
+    
+    assert(batches[0].instance_count == glyph_count);
+    for (int32_t method = 1; method < 3; method += 1){
+        assert(batches[method].instance_count == glyph_count);
+        assert(memcmp(batches[method].instances, batches[0].instances, sizeof(Text_Instance)*glyph_count) == 0);
+    }
+    
+    printf("instance_kernel %s: %d lines, %d glyphs, push_glyph %.2f ns/glyph, scalar kernel %.2f ns/glyph, simd kernel %.2f ns/glyph (%.1fx)\n",
+           font_name, line_count, glyph_count, ns_per_glyph[0], ns_per_glyph[1], ns_per_glyph[2],
+           ns_per_glyph[0]/ns_per_glyph[2]);
+    
+    for (int32_t method = 0; method < 3; method += 1){
+        text_batch_free(&batches[method]);
+    }
+    free(line_first);
+    free(pen_x);
+    free(glyphs);
+    free(codepoints);
+    codepoint_map_free(map);
+    free(templates);
+    free(metrics);
+    free(text);
+}
+
+////////////////////////////////
+
+// Saving a B, G, R, X image the way example_texture_extraction did: the whole file built in one
+// buffer and written with a single fwrite.
+bool32
+bench_bmp_write_buffered(char *file_name, uint8_t *pixels, int32_t width, int32_t height, int32_t pitch){
+    int32_t out_pitch = bmp_pitch(width);
+    uint64_t file_size = sizeof(Bmp_Header) + sizeof(Bmp_Info_Header) + (uint64_t)out_pitch*height;
+    uint8_t *memory = (uint8_t*)malloc((size_t)file_size);
+    memset(memory, 0, (size_t)file_size);
+    Bmp_Header *header = (Bmp_Header*)memory;
+    Bmp_Info_Header *info_header = (Bmp_Info_Header*)(header + 1);
+    uint8_t *out_data = (uint8_t*)(info_header + 1);
+    header->sig[0] = 'B';
+    header->sig[1] = 'M';
+    header->file_size = (uint32_t)file_size;
+    header->data_offset = (uint32_t)(out_data - memory);
+    info_header->size = sizeof(*info_header);
+    info_header->width = width;
+    info_header->height = height;
+    info_header->planes = 1;
+    info_header->bits_per_pixel = 24;
+    for (int32_t y = 0; y < height; y += 1){
+        uint8_t *in_pixel = pixels + (size_t)y*pitch;
+        uint8_t *out_pixel = out_data + (size_t)out_pitch*(height - 1 - y);
+        for (int32_t x = 0; x < width; x += 1){
+            out_pixel[0] = in_pixel[0];
+            out_pixel[1] = in_pixel[1];
+            out_pixel[2] = in_pixel[2];
+            in_pixel += 4;
+            out_pixel += 3;
+        }
+    }
+    
+    bool32 result = false;
+    FILE *out = fopen(file_name, "wb");
+    if (out != 0){
+        result = (fwrite(memory, 1, (size_t)file_size, out) == file_size);
+        result = (fclose(out) == 0) && result;
+    }
+    free(memory);
+    return(result);
+}
+
+// The per row stdio writer bmp_write_rgbx used before it streamed.
+bool32
+bench_bmp_write_rows(char *file_name, uint8_t *pixels, int32_t width, int32_t height, int32_t pitch){
+    FILE *out = fopen(file_name, "wb");
+    if (out == 0){
+        return(false);
+    }
+    int32_t out_pitch = bmp_pitch(width);
+    Bmp_Header header = {0};
+    Bmp_Info_Header info_header = {0};
+    header.sig[0] = 'B';
+    header.sig[1] = 'M';
+    header.data_offset = sizeof(header) + sizeof(info_header);
+    header.file_size = header.data_offset + (uint32_t)out_pitch*height;
+    info_header.size = sizeof(info_header);
+    info_header.width = width;
+    info_header.height = height;
+    info_header.planes = 1;
+    info_header.bits_per_pixel = 24;
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(&info_header, sizeof(info_header), 1, out);
+    
+    uint8_t *row = (uint8_t*)malloc(out_pitch);
+    memset(row, 0, out_pitch);
+    for (int32_t y = height - 1; y >= 0; y -= 1){
+        uint8_t *in_pixel = pixels + (size_t)y*pitch;
+        uint8_t *out_pixel = row;
+        for (int32_t x = 0; x < width; x += 1){
+            out_pixel[0] = in_pixel[0];
+            out_pixel[1] = in_pixel[1];
+            out_pixel[2] = in_pixel[2];
+            in_pixel += 4;
+            out_pixel += 3;
+        }
+        fwrite(row, 1, out_pitch, out);
+    }
+    free(row);
+    
+    bool32 result = (ferror(out) == 0);
+    result = (fclose(out) == 0) && result;
+    return(result);
+}
+
+// Writes images from the example's 200 by 200 target up to 4K through the whole file buffer, the
+// per row fwrite and the streaming writer. All three files have to come out the same.
+void
+bench_bmp_write(void){
+    int32_t sizes[][2] = {
+        {200, 200}, {601, 580}, {1920, 1080}, {3840, 2160},
+    };
+    char *method_names[] = {"buffered", "rows", "streamed"};
+    char *file_names[] = {"bench_bmp_0.bmp", "bench_bmp_1.bmp", "bench_bmp_2.bmp"};
+    
+    int32_t size_count = sizeof(sizes)/sizeof(sizes[0]);
+    for (int32_t s = 0; s < size_count; s += 1){
+        int32_t width = sizes[s][0];
+        int32_t height = sizes[s][1];
+        // A DIB pitch, with a few bytes past the row so the readers must honor it
+        int32_t pitch = width*4 + 16;
+        uint8_t *pixels = (uint8_t*)malloc((size_t)pitch*height);
+        uint32_t state = 0x1234567u + s;
+        for (int32_t i = 0; i < pitch*height; i += 1){
+            pixels[i] = (uint8_t)bench_random(&state);
+        }
+        
+        int32_t out_pitch = bmp_pitch(width);
+        uint64_t file_size = sizeof(Bmp_Header) + sizeof(Bmp_Info_Header) + (uint64_t)out_pitch*height;
+        int32_t chunk_rows = BMP_WRITE_CHUNK_SIZE/out_pitch;
+        chunk_rows = (chunk_rows < 1)?1:chunk_rows;
+        chunk_rows = (chunk_rows > height)?height:chunk_rows;
+        uint64_t scratch_bytes[3] = {file_size, (uint64_t)out_pitch, (uint64_t)out_pitch*chunk_rows};
+        int32_t repeat = (int32_t)((64ull << 20)/file_size);
+        repeat = (repeat < 2)?2:repeat;
+        
+        double mb_per_second[3] = {0};
+        for (int32_t method = 0; method < 3; method += 1){
+            uint64_t start = bench_now_ns();
+            for (int32_t r = 0; r < repeat; r += 1){
+                bool32 written = false;
+                switch (method){
+                    case 0:
+                    {
+                        written = bench_bmp_write_buffered(file_names[method], pixels, width, height, pitch);
+                    }break;
+                    
+                    case 1:
+                    {
+                        written = bench_bmp_write_rows(file_names[method], pixels, width, height, pitch);
+                    }break;
+                    
+                    case 2:
+                    {
+                        written = bmp_write_pixels(file_names[method], pixels, width, height, pitch, BmpPixels_BGRX);
+                    }break;
+                }
+                bench_verify(written, "bmp_write: a writer failed");
+            }
+            uint64_t end = bench_now_ns();
+            mb_per_second[method] = ((double)file_size*repeat/(1024.0*1024.0))/((double)(end - start)/1000000000.0);
+        }
+        
+        int32_t first_size = 0;
+        uint8_t *first = bench_read_file(file_names[0], &first_size);
+        bool32 same = (first != 0 && (uint64_t)first_size == file_size);
+        for (int32_t method = 1; method < 3 && same; method += 1){
+            int32_t other_size = 0;
+            uint8_t *other = bench_read_file(file_names[method], &other_size);
+            same = (other != 0 && other_size == first_size && memcmp(first, other, first_size) == 0);
+            free(other);
+        }
+        bench_verify(same, "bmp_write: the three writers' files differ");
+        free(first);
+        for (int32_t method = 0; method < 3; method += 1){
+            remove(file_names[method]);
+        }
+        
+        printf("bmp_write %dx%d: %.1f MB file", width, height, (double)file_size/(1024.0*1024.0));
+        for (int32_t method = 0; method < 3; method += 1){
+            printf(", %s %.0f MB/s (%llu KB scratch)", method_names[method], mb_per_second[method],
+                   (unsigned long long)(scratch_bytes[method] + 1023)/1024);
+        }
+        printf(same?", same bytes\n":", FILES DIFFER\n");
+        free(pixels);
+    }
+}
+
+////////////////////////////////
+
+int
+main(int argc, char **argv){
+    char data_root[DATA_PATH_MAX];
+    data_root_from_executable(data_root, sizeof(data_root));
+    int32_t first_font = 1;
+    if (argc > 2 && strcmp(argv[1], "-data") == 0){
+        snprintf(data_root, sizeof(data_root), "%s", argv[2]);
+        first_font = 3;
+    }
+    char text_file_name[DATA_PATH_MAX];
+    char source_file_name[DATA_PATH_MAX];
+    data_path(data_root, "../win32-file-handles/test_data/text_file.txt", text_file_name, sizeof(text_file_name));
+    data_path(data_root, "test_data/source_file.txt", source_file_name, sizeof(source_file_name));
+    
+    bench_glyph_cache();
+    bench_m_values();
+    bench_utf8(text_file_name);
+    bench_bmp_write();
+    
+    for (int32_t i = first_font; i < argc; i += 1){
+        char *font_name = argv[i];
+        int32_t size = 0;
+        uint8_t *data = bench_read_file(font_name, &size);
+        TTF_Font font = {0};
+        if (data == 0 || !ttf_init(&font, data, size)){
+            printf("%s: not a TrueType font\n", font_name);
+            free(data);
+            continue;
+        }
+        
+        bench_codepoint_map(font_name, &font);
+        bench_text_batch(font_name, &font);
+        bench_frame_arena(font_name, &font);
+        bench_cpu_compositor(font_name, &font, 12.f);
+        bench_cpu_compositor(font_name, &font, 36.f);
+        bench_atlas_levels(font_name, &font, 12.f);
+        bench_atlas_levels(font_name, &font, 36.f);
+        bench_instance_kernel(font_name, &font, text_file_name);
+        bench_sparse_glyphs(font_name, &font, text_file_name);
+        bench_sparse_glyphs(font_name, &font, source_file_name);
+        bench_layout_cache(&font, source_file_name);
+        bench_subpixel(&font, source_file_name);
+        bench_font_registry(font_name, &font);
+        bench_atlas_dirty(&font, source_file_name);
+        bench_render_commands(font_name, &font);
+        bench_software_rasterizer(font_name, &font);
+        bench_parallel_bake(font_name, &font, 24.f);
+        
+        float point_sizes[] = {12.f, 24.f};
+        for (int32_t j = 0; j < 2; j += 1){
+            bench_atlas_packer(font_name, &font, point_sizes[j]);
+            bench_font_cache_file(font_name, &font, point_sizes[j]);
+        }
+        
+        free(data);
+    }
+    
+    return((bench_failure_count == 0)?0:1);
+}
@@ -0,0 +1,146 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the glyph instance ranges
+// usage: text_instance_test [seed]
+// Makes templates from random metrics, most in range and some far past what the narrow fields of
+// an instance hold, then emits them at random pens from well inside the int16 range to far past it.
+// In range every field must come out exact; out of range a position saturates, a box is cut down to
+// 255 texels and a glyph that cannot be addressed draws nothing. The SIMD emitter must match the
+// scalar one everywhere.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_text_batch.h"
+#include "example_test.h"
+
+static int32_t test_round_count = 2000;
+static int32_t test_glyph_count = 64;
+
+int32_t
+test_expect_saturated(int64_t v){
+    v = (v < INT16_MIN)?INT16_MIN:v;
+    v = (v > INT16_MAX)?INT16_MAX:v;
+    return((int32_t)v);
+}
+
+// Mostly in range, one in eight anywhere
+float
+test_random_field(uint32_t *state, int32_t min, int32_t max, int32_t far){
+    float v = 0.f;
+    if (test_random_range(state, 0, 7) == 0){
+        v = (float)test_random_range(state, -far, far);
+    }
+    else{
+        v = (float)test_random_range(state, min, max);
+    }
+    return(v + (float)test_random_range(state, 0, 3)*0.25f);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x51E7A9u);
+    uint32_t state = seed;
+    
+    int32_t atlas_side = 1024;
+    Glyph_Metrics *metrics = (Glyph_Metrics*)malloc(sizeof(Glyph_Metrics)*test_glyph_count);
+    Text_Instance *templates = (Text_Instance*)malloc(sizeof(Text_Instance)*test_glyph_count);
+    uint16_t *glyphs = (uint16_t*)malloc(sizeof(uint16_t)*test_glyph_count);
+    int32_t *pen_x = (int32_t*)malloc(sizeof(int32_t)*test_glyph_count);
+    Text_Instance *simd = (Text_Instance*)malloc(sizeof(Text_Instance)*test_glyph_count);
+    Text_Instance *scalar = (Text_Instance*)malloc(sizeof(Text_Instance)*test_glyph_count);
+    
+    int64_t rejected_total = 0;
+    int64_t saturated_total = 0;
+    for (int32_t round = 0; round < test_round_count; round += 1){
+        int64_t failures_before = test_state.failures;
+        
+        // Templates
+        for (int32_t i = 0; i < test_glyph_count; i += 1){
+            Glyph_Metrics *m = &metrics[i];
+            memset(m, 0, sizeof(*m));
+            m->off_x = test_random_field(&state, -8, 8, 100000);
+            m->off_y = test_random_field(&state, -40, 8, 100000);
+            m->xy_w = test_random_field(&state, 0, 64, 1000);
+            m->xy_h = test_random_field(&state, 0, 64, 1000);
+            m->uv_x = test_random_field(&state, 0, atlas_side - 64, 200000)/(float)atlas_side;
+            m->uv_y = test_random_field(&state, 0, atlas_side - 64, 200000)/(float)atlas_side;
+            m->uv_slice = (float)test_random_range(&state, 0, 300);
+            text_instance_template(m, atlas_side, atlas_side, &templates[i]);
+            
+            Text_Instance *t = &templates[i];
+            float atlas_x = m->uv_x*atlas_side + 0.5f;
+            float atlas_y = m->uv_y*atlas_side + 0.5f;
+            bool32 addressable = (atlas_x >= 0.f && atlas_x < 65536.f && atlas_y >= 0.f && atlas_y < 65536.f &&
+                                  m->uv_slice < 256.f);
+            TEST_CHECK(t->x == test_expect_saturated((int64_t)m->off_x));
+            TEST_CHECK(t->y == test_expect_saturated((int64_t)m->off_y));
+            TEST_CHECK(t->style == 0 && t->flags == 0 && t->reserved == 0);
+            if (addressable){
+                int32_t w = (m->xy_w < 0.f)?0:(m->xy_w > 255.f)?255:(int32_t)m->xy_w;
+                int32_t h = (m->xy_h < 0.f)?0:(m->xy_h > 255.f)?255:(int32_t)m->xy_h;
+                TEST_CHECK(t->atlas_x == (int32_t)atlas_x && t->atlas_y == (int32_t)atlas_y);
+                TEST_CHECK(t->slice == (int32_t)m->uv_slice);
+                TEST_CHECK(t->w == w && t->h == h);
+            }
+            else{
+                TEST_CHECK(t->w == 0 && t->h == 0);
+                rejected_total += 1;
+            }
+        }
+        
+        // A run, the pens of most rounds stay in range
+        int32_t count = test_random_range(&state, 0, test_glyph_count);
+        int32_t far = (round%4 == 0)?1000000:20000;
+        int32_t pen_y = test_random_range(&state, -far, far);
+        uint16_t style = (uint16_t)test_random_range(&state, 0, TEXT_STYLE_MAX - 1);
+        for (int32_t i = 0; i < count; i += 1){
+            glyphs[i] = (uint16_t)test_random_range(&state, 0, test_glyph_count - 1);
+            pen_x[i] = test_random_range(&state, -far, far);
+        }
+        text_emit_instances(templates, glyphs, pen_x, pen_y, style, count, simd);
+        text_emit_instances_scalar(templates, glyphs, pen_x, pen_y, style, count, scalar);
+        for (int32_t i = 0; i < count; i += 1){
+            Text_Instance *t = &templates[glyphs[i]];
+            Text_Instance *o = &simd[i];
+            TEST_CHECK(memcmp(o, &scalar[i], sizeof(*o)) == 0);
+            int64_t x = (int64_t)t->x + test_expect_saturated(pen_x[i]);
+            int64_t y = (int64_t)t->y + test_expect_saturated(pen_y);
+            TEST_CHECK(o->x == test_expect_saturated(x));
+            TEST_CHECK(o->y == test_expect_saturated(y));
+            TEST_CHECK(o->atlas_x == t->atlas_x && o->atlas_y == t->atlas_y);
+            TEST_CHECK(o->w == t->w && o->h == t->h && o->slice == t->slice && o->flags == t->flags);
+            TEST_CHECK(o->style == style && o->reserved == 0);
+            saturated_total += (o->x != x || o->y != y);
+        }
+        if (test_state.failures != failures_before){
+            printf("    round %d: %d glyphs, pen_y %d, style %d\n", round, count, pen_y, style);
+        }
+    }
+    
+    free(scalar);
+    free(simd);
+    free(pen_x);
+    free(glyphs);
+    free(templates);
+    free(metrics);
+    
+    printf("text_instance_test: %d rounds, %lld templates rejected, %lld instances saturated\n",
+           test_round_count, (long long)rejected_total, (long long)saturated_total);
+    return(test_finish("text_instance_test", seed));
+}
@@ -13,55 +13,31 @@
 */
 
 // DirectWrite texture extraction example
+// Rasterizes one glyph through the Glyph_Rasterizer interface and saves it at the pen position of a
+// black image. use_software_rasterizer picks the backend, the same two the GL example bakes with.
 
 #include <windows.h>
 #include <dwrite.h>
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
 
-// Bitmap structs
-#pragma pack(push, 1)
-struct Header{
-    char sig[2];
-    uint32_t file_size;
-    uint32_t reserved;
-    uint32_t data_offset;
-};
-
-struct Info_Header{
-    uint32_t size;
-    uint32_t width;
-    uint32_t height;
-    uint16_t planes;
-    uint16_t bits_per_pixel;
-    uint32_t compression;
-    uint32_t image_size;
-    uint32_t x_pixels_per_meter;
-    uint32_t y_pixels_per_meter;
-    uint32_t colors_used;
-    uint32_t important_colors;
-};
-
-struct Color_Table{
-    uint8_t R;
-    uint8_t G;
-    uint8_t B;
-    uint8_t A;
-};
-#pragma pack(pop)
+#include "example_bmp_file.h"
+#include "example_glyph_rasterizer.h"
+#include "example_dwrite_rasterizer.h"
+#include "example_software_rasterizer.h"
 
 int main(){
-    COLORREF back_color = RGB(0,0,0);
-    COLORREF fore_color = RGB(255,0,0);
     int32_t raster_target_w = 200;
     int32_t raster_target_h = 200;
-    float raster_target_x = 100.f;
-    float raster_target_y = 100.f;
     wchar_t font_path[] = L"C:\\Windows\\Fonts\\arial.ttf";
     float point_size = 12.f;
     uint32_t codepoint = '?';
     char *test_output_file_name = "test.bmp";
+    bool32 use_software_rasterizer = false;
     
     HRESULT error = 0;
     
@@ -106,21 +82,33 @@ int main(){
     error = dwrite_factory->GetGdiInterop(&dwrite_gdi_interop);
     assert(error == S_OK);
     
-    // DWrite Bitmap Render Target
-    IDWriteBitmapRenderTarget *render_target = 0;
-    error = dwrite_gdi_interop->CreateBitmapRenderTarget(0, raster_target_w, raster_target_h, &render_target);
-    assert(error == S_OK);
+    // Size
+    float pixel_per_em = point_size*96.f/72.f;
+    DWRITE_FONT_METRICS font_metrics = {0};
+    font_face->GetMetrics(&font_metrics);
+    float pixel_per_design_unit = pixel_per_em/((float)font_metrics.designUnitsPerEm);
     
-    // Clear the Render Target
-    HDC dc = render_target->GetMemoryDC();
-    
-    {
-        HGDIOBJ original = SelectObject(dc, GetStockObject(DC_PEN));
-        SetDCPenColor(dc, back_color);
-        SelectObject(dc, GetStockObject(DC_BRUSH));
-        SetDCBrushColor(dc, back_color);
-        Rectangle(dc, 0, 0, raster_target_w, raster_target_h);
-        SelectObject(dc, original);
+    // Rasterizer
+    Glyph_Rasterizer rasterizer = {0};
+    DWrite_Glyph_Baker baker = {0};
+    TTF_Font ttf_font = {0};
+    Software_Rasterizer software_rasterizer = {0};
+    if (use_software_rasterizer){
+        int32_t font_file_size = 0;
+        uint8_t *font_file_data = map_font_file(font_path, &font_file_size);
+        bool32 loaded = (font_file_data != 0 && ttf_init(&ttf_font, font_file_data, font_file_size));
+        assert(loaded);
+        rasterizer = software_rasterizer_init(&software_rasterizer, &ttf_font, pixel_per_em);
+    }
+    else{
+        bool32 created = dwrite_glyph_baker_init(&baker, dwrite_gdi_interop, font_face, rendering_params,
+                                                 raster_target_w, raster_target_h, pixel_per_em, pixel_per_design_unit);
+        assert(created);
+        rasterizer.backend = &baker;
+        rasterizer.rasterize_glyph = dwrite_rasterize_glyph;
+        rasterizer.glyph_advances = dwrite_glyph_advances;
+        rasterizer.glyph_count = font_face->GetGlyphCount();
+        rasterizer.pixel_per_em = pixel_per_em;
     }
     
     // Find the glyph index for the codepoint we want to render
@@ -129,80 +117,41 @@ int main(){
     assert(error == S_OK);
     
     // Render the glyph
-    DWRITE_GLYPH_RUN glyph_run = {0};
-    glyph_run.fontFace = font_face;
-    glyph_run.fontEmSize = point_size*96.f/72.f;
-    glyph_run.glyphCount = 1;
-    glyph_run.glyphIndices = &index;
-    RECT bounding_box = {0};
-    error = render_target->DrawGlyphRun(raster_target_x, raster_target_y, DWRITE_MEASURING_MODE_NATURAL, &glyph_run, rendering_params, fore_color, &bounding_box);
-    assert(error == S_OK);
+    Glyph_Bitmap bitmap = {0};
+    bool32 rasterized = rasterizer.rasterize_glyph(rasterizer.backend, index, 0.f, &bitmap);
+    assert(rasterized);
     
-    // Get the Bitmap
-    HBITMAP bitmap = (HBITMAP)GetCurrentObject(dc, OBJ_BITMAP);
-    DIBSECTION dib = {0};
-    GetObject(bitmap, sizeof(dib), &dib);
-    
-    // Save the Bitmap
-    {
-        uint8_t *in_data = (uint8_t*)dib.dsBm.bmBits;
-        int32_t in_pitch = dib.dsBm.bmWidthBytes;
-        int32_t width = raster_target_w;
-        int32_t height = raster_target_h;
-        char *file_name = test_output_file_name;
-        
-        void *memory = (void*)malloc(1 << 20);
-        assert(memory != 0);
-        void *ptr = memory;
-        int32_t out_pitch = (width*3) + 3;
-        out_pitch = out_pitch - (out_pitch%4);
-        
-        Header *header = (Header*)ptr;
-        ptr = header + 1;
-        Info_Header *info_header = (Info_Header*)ptr;
-        ptr = info_header + 1;
-        uint8_t *out_data = (uint8_t*)ptr;
-        ptr = out_data + out_pitch*height;
-        
-        header->sig[0] = 'B';
-        header->sig[1] = 'M';
-        header->file_size = (uint8_t*)ptr - (uint8_t*)memory;
-        header->reserved = 0;
-        header->data_offset = out_data - (uint8_t*)memory;
-        info_header->size = sizeof(*info_header);
-        info_header->width = width;
-        info_header->height = height;
-        info_header->planes = 1;
-        info_header->bits_per_pixel = 24;
-        info_header->compression = 0;
-        info_header->image_size = 0;
-        info_header->x_pixels_per_meter = 0;
-        info_header->y_pixels_per_meter = 0;
-        info_header->colors_used = 0;
-        info_header->important_colors = 0;
-        
-        uint8_t *in_line = (uint8_t*)in_data;
-        uint8_t *out_line = out_data + out_pitch*(height - 1);
-        for (int32_t y = 0; y < height; y += 1){
-            uint8_t *in_pixel = in_line;
-            uint8_t *out_pixel = out_line;
-            for (int32_t x = 0; x < width; x += 1){
-                out_pixel[0] = in_pixel[0];
-                out_pixel[1] = in_pixel[1];
-                out_pixel[2] = in_pixel[2];
-                in_pixel += 4;
-                out_pixel += 3;
+    // Place the Box at the Pen
+    // The pen is in the middle of the image, on the baseline.
+    uint32_t *pixels = (uint32_t*)calloc((size_t)raster_target_w*raster_target_h, sizeof(uint32_t));
+    int32_t pen_x = raster_target_w/2;
+    int32_t pen_y = raster_target_h/2;
+    for (int32_t y = 0; y < bitmap.h; y += 1){
+        int32_t py = pen_y + bitmap.off_y + y;
+        if (py < 0 || py >= raster_target_h){
+            continue;
+        }
+        uint8_t *in = bitmap.rgb + y*bitmap.pitch;
+        for (int32_t x = 0; x < bitmap.w; x += 1, in += 3){
+            int32_t px = pen_x + bitmap.off_x + x;
+            if (px < 0 || px >= raster_target_w){
+                continue;
             }
-            in_line += in_pitch;
-            out_line -= out_pitch;
+            pixels[py*raster_target_w + px] = in[0] | (in[1] << 8) | (in[2] << 16);
         }
-        
-        FILE *out = fopen(file_name, "wb");
-        assert(out != 0);
-        fwrite(memory, 1, header->file_size, out);
-        fclose(out);
+    }
+    
+    // Save the Bitmap
+    bool32 saved = bmp_write_rgbx(test_output_file_name, pixels, raster_target_w, raster_target_h, raster_target_w);
+    assert(saved);
+    
+    free(pixels);
+    if (use_software_rasterizer){
+        software_rasterizer_free(&software_rasterizer);
+    }
+    else{
+        dwrite_glyph_baker_free(&baker);
     }
     
     return(0);
 }
-
@@ -0,0 +1,348 @@
+// DirectWrite rasterization example: scoped timers for the phases of startup and of a frame
+// TRACE_SCOPE("name") times the rest of the enclosing block. When the block ends, one event with
+// the name, start and end goes into a ring owned by the calling thread. Nothing is locked and
+// nothing is allocated after a thread's first event. A full ring overwrites its oldest events, so a
+// program that runs forever keeps its latest TRACE_RING_SIZE events per ring. A thread that exits
+// hands its ring, events and all, to the next thread that starts tracing, so threads started over
+// and over for bakes do not use up the TRACE_THREAD_MAX rings.
+// trace_write_json writes every ring as Chrome trace events, which chrome://tracing and
+// ui.perfetto.dev both open. trace_write_summary prints count, total, mean, min and max per name.
+// A phase's total includes the phases nested inside it.
+// Tracing is off unless TRACE_ENABLED is defined to 1. When it is off the macros expand to nothing
+// and none of this is compiled, so callers put their dumps inside #if TRACE_ENABLED.
+// Events are read without synchronization. Dump after the threads that trace are joined or idle.
+
+#if !defined(EXAMPLE_TRACE_H)
+#define EXAMPLE_TRACE_H
+
+#if !defined(TRACE_ENABLED)
+#define TRACE_ENABLED 0
+#endif
+
+#if TRACE_ENABLED
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+// Events per ring, a power of two
+#define TRACE_RING_SIZE (1 << 16)
+// Rings, the most threads that trace at the same time
+#define TRACE_THREAD_MAX 64
+// Distinct names the summary can tell apart
+#define TRACE_SUMMARY_MAX 128
+
+// Names are string literals, only the pointer is kept.
+struct Trace_Event{
+    char *name;
+    uint64_t start;
+    uint64_t end;
+    int32_t thread_id;
+};
+
+struct Trace_Ring{
+    Trace_Event *events;
+    // Events ever written, the ring holds the last TRACE_RING_SIZE of them
+    uint64_t write;
+    // Set while a thread owns the ring
+    volatile int32_t in_use;
+    // Of the thread that owns it now or owned it last
+    int32_t thread_id;
+    char *thread_name;
+};
+
+// Gives the ring back when its thread exits.
+struct Trace_Thread{
+    Trace_Ring *ring;
+    int32_t thread_id;
+    ~Trace_Thread();
+};
+
+static Trace_Ring *trace_rings[TRACE_THREAD_MAX];
+static volatile int32_t trace_ring_count = 0;
+// Threads that ever traced, thread ids count up from zero
+static volatile int32_t trace_thread_count = 0;
+// Threads that started tracing while every ring was taken
+static volatile int32_t trace_threads_refused = 0;
+static thread_local Trace_Thread trace_thread = {0};
+
+////////////////////////////////
+
+// Timer
+
+// Raw counter ticks, converted to time only when the trace is written.
+uint64_t
+trace_ticks(void){
+    uint64_t result = 0;
+#if defined(_WIN32)
+    LARGE_INTEGER counter = {0};
+    QueryPerformanceCounter(&counter);
+    result = (uint64_t)counter.QuadPart;
+#else
+    struct timespec t = {0};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (uint64_t)t.tv_sec*1000000000ull + (uint64_t)t.tv_nsec;
+#endif
+    return(result);
+}
+
+double
+trace_ticks_per_second(void){
+    double result = 1000000000.0;
+#if defined(_WIN32)
+    LARGE_INTEGER frequency = {0};
+    QueryPerformanceFrequency(&frequency);
+    result = (double)frequency.QuadPart;
+#endif
+    return(result);
+}
+
+int32_t
+trace__atomic_add(volatile int32_t *x, int32_t v){
+#if defined(_WIN32)
+    return((int32_t)InterlockedExchangeAdd((volatile LONG*)x, v));
+#else
+    return(__atomic_fetch_add(x, v, __ATOMIC_SEQ_CST));
+#endif
+}
+
+// True if *x was expected and is now desired.
+bool32
+trace__atomic_swap_if(volatile int32_t *x, int32_t expected, int32_t desired){
+#if defined(_WIN32)
+    return(InterlockedCompareExchange((volatile LONG*)x, desired, expected) == expected);
+#else
+    return(__atomic_compare_exchange_n(x, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+#endif
+}
+
+////////////////////////////////
+
+// Recording
+
+Trace_Thread::~Trace_Thread(){
+    if (ring != 0){
+        trace__atomic_swap_if(&ring->in_use, 1, 0);
+        ring = 0;
+    }
+}
+
+// The calling thread's ring, taken on its first event: one a thread that exited gave back, otherwise
+// a new one. Zero while all TRACE_THREAD_MAX rings are taken.
+Trace_Ring*
+trace__thread_ring(void){
+    Trace_Ring *ring = trace_thread.ring;
+    if (ring == 0){
+        for (int32_t i = 0; i < TRACE_THREAD_MAX && ring == 0; i += 1){
+            Trace_Ring *candidate = trace_rings[i];
+            if (candidate != 0 && trace__atomic_swap_if(&candidate->in_use, 0, 1)){
+                ring = candidate;
+            }
+        }
+        if (ring == 0){
+            int32_t index = trace__atomic_add(&trace_ring_count, 1);
+            if (index >= TRACE_THREAD_MAX){
+                trace__atomic_add(&trace_ring_count, -1);
+                trace__atomic_add(&trace_threads_refused, 1);
+                return(0);
+            }
+            // Outside heap_alloc, so a thread's first event does not show up as a frame allocation.
+            ring = (Trace_Ring*)malloc(sizeof(Trace_Ring));
+            memset(ring, 0, sizeof(*ring));
+            ring->events = (Trace_Event*)malloc(sizeof(Trace_Event)*TRACE_RING_SIZE);
+            ring->in_use = 1;
+            trace_rings[index] = ring;
+        }
+        ring->thread_id = trace__atomic_add(&trace_thread_count, 1);
+        ring->thread_name = 0;
+        trace_thread.ring = ring;
+        trace_thread.thread_id = ring->thread_id;
+    }
+    return(ring);
+}
+
+void
+trace_record(char *name, uint64_t start, uint64_t end){
+    Trace_Ring *ring = trace__thread_ring();
+    if (ring != 0){
+        Trace_Event *event = &ring->events[ring->write & (TRACE_RING_SIZE - 1)];
+        event->name = name;
+        event->start = start;
+        event->end = end;
+        event->thread_id = trace_thread.thread_id;
+        ring->write += 1;
+    }
+}
+
+// Shows up as the thread's name in the trace viewer.
+void
+trace_thread_name(char *name){
+    Trace_Ring *ring = trace__thread_ring();
+    if (ring != 0){
+        ring->thread_name = name;
+    }
+}
+
+struct Trace_Scope{
+    char *name;
+    uint64_t start;
+    Trace_Scope(char *scope_name){
+        name = scope_name;
+        start = trace_ticks();
+    }
+    ~Trace_Scope(){
+        trace_record(name, start, trace_ticks());
+    }
+};
+
+#define TRACE__JOIN2(a,b) a##b
+#define TRACE__JOIN(a,b) TRACE__JOIN2(a,b)
+#define TRACE_SCOPE(name) Trace_Scope TRACE__JOIN(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) trace_thread_name(name)
+
+////////////////////////////////
+
+// Output
+
+// Index of the oldest event a ring still holds.
+uint64_t
+trace__first(Trace_Ring *ring){
+    return((ring->write > TRACE_RING_SIZE)?(ring->write - TRACE_RING_SIZE):0);
+}
+
+// Earliest start of any event held, the zero of the trace's timeline.
+uint64_t
+trace__origin(void){
+    uint64_t origin = 0;
+    bool32 found = false;
+    for (int32_t i = 0; i < trace_ring_count; i += 1){
+        Trace_Ring *ring = trace_rings[i];
+        for (uint64_t k = trace__first(ring); k < ring->write; k += 1){
+            Trace_Event *event = &ring->events[k & (TRACE_RING_SIZE - 1)];
+            if (!found || event->start < origin){
+                origin = event->start;
+                found = true;
+            }
+        }
+    }
+    return(origin);
+}
+
+// Chrome trace event format, complete events with times in microseconds. Returns false if the file
+// could not be written.
+bool32
+trace_write_json(char *file_name){
+    FILE *file = fopen(file_name, "wb");
+    if (file == 0){
+        return(false);
+    }
+    double us_per_tick = 1000000.0/trace_ticks_per_second();
+    uint64_t origin = trace__origin();
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    char *separator = "";
+    for (int32_t i = 0; i < trace_ring_count; i += 1){
+        Trace_Ring *ring = trace_rings[i];
+        if (ring->thread_name != 0){
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    separator, ring->thread_id, ring->thread_name);
+            separator = ",\n";
+        }
+        for (uint64_t k = trace__first(ring); k < ring->write; k += 1){
+            Trace_Event *event = &ring->events[k & (TRACE_RING_SIZE - 1)];
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    separator, event->name, event->thread_id,
+                    (double)(event->start - origin)*us_per_tick, (double)(event->end - event->start)*us_per_tick);
+            separator = ",\n";
+        }
+    }
+    fprintf(file, "\n]}\n");
+    bool32 result = (ferror(file) == 0);
+    fclose(file);
+    return(result);
+}
+
+struct Trace_Summary_Row{
+    char *name;
+    uint64_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+};
+
+int
+trace__compare_rows(const void *a, const void *b){
+    uint64_t x = ((Trace_Summary_Row*)a)->total;
+    uint64_t y = ((Trace_Summary_Row*)b)->total;
+    return((x > y)?-1:(x < y)?1:0);
+}
+
+// One row per name over every thread, the longest total first.
+void
+trace_write_summary(FILE *file){
+    Trace_Summary_Row *rows = (Trace_Summary_Row*)malloc(sizeof(Trace_Summary_Row)*TRACE_SUMMARY_MAX);
+    int32_t row_count = 0;
+    uint64_t overwritten = 0;
+    for (int32_t i = 0; i < trace_ring_count; i += 1){
+        Trace_Ring *ring = trace_rings[i];
+        uint64_t first = trace__first(ring);
+        overwritten += first;
+        for (uint64_t k = first; k < ring->write; k += 1){
+            Trace_Event *event = &ring->events[k & (TRACE_RING_SIZE - 1)];
+            uint64_t duration = event->end - event->start;
+            Trace_Summary_Row *row = 0;
+            for (int32_t j = 0; j < row_count; j += 1){
+                if (rows[j].name == event->name || strcmp(rows[j].name, event->name) == 0){
+                    row = &rows[j];
+                    break;
+                }
+            }
+            if (row == 0){
+                if (row_count == TRACE_SUMMARY_MAX){
+                    continue;
+                }
+                row = &rows[row_count];
+                row_count += 1;
+                memset(row, 0, sizeof(*row));
+                row->name = event->name;
+                row->min = duration;
+            }
+            row->count += 1;
+            row->total += duration;
+            row->min = (duration < row->min)?duration:row->min;
+            row->max = (duration > row->max)?duration:row->max;
+        }
+    }
+    qsort(rows, row_count, sizeof(Trace_Summary_Row), trace__compare_rows);
+    
+    double us_per_tick = 1000000.0/trace_ticks_per_second();
+    fprintf(file, "%-24s %10s %12s %12s %12s %12s\n", "phase", "count", "total ms", "mean us", "min us", "max us");
+    for (int32_t i = 0; i < row_count; i += 1){
+        Trace_Summary_Row *row = &rows[i];
+        fprintf(file, "%-24s %10llu %12.3f %12.3f %12.3f %12.3f\n", row->name, (unsigned long long)row->count,
+                (double)row->total*us_per_tick/1000.0, (double)row->total*us_per_tick/(double)row->count,
+                (double)row->min*us_per_tick, (double)row->max*us_per_tick);
+    }
+    fprintf(file, "%d thread(s) in %d ring(s), %llu events overwritten", (int32_t)trace_thread_count,
+            (int32_t)trace_ring_count, (unsigned long long)overwritten);
+    if (trace_threads_refused > 0){
+        fprintf(file, ", %d thread(s) not traced with every ring taken", (int32_t)trace_threads_refused);
+    }
+    fprintf(file, "\n");
+    free(rows);
+}
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_THREAD_NAME(name)
+
+#endif
+
+#endif
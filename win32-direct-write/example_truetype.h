@@ -0,0 +1,568 @@
+// DirectWrite rasterization example: minimal TrueType table reader
+// Just enough of the sfnt format to get per glyph boxes, metrics and outlines without DirectWrite.
+// Font files come from outside, so no read goes past the table it belongs to: ttf_init checks the
+// tables against the file and the fixed size parts of them it reads, the cmap subtable and each
+// glyph's outline are checked as they are read. A damaged font fails to load or reads as glyphs
+// with no outline, it never reads out of bounds.
+
+#if !defined(EXAMPLE_TRUETYPE_H)
+#define EXAMPLE_TRUETYPE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_arena.h"
+
+struct TTF_Font{
+    uint8_t *data;
+    int32_t size;
+    
+    int32_t glyph_count;
+    int32_t units_per_em;
+    int32_t index_to_loc_format;
+    int32_t hmetric_count;
+    int32_t ascent;
+    int32_t descent;
+    int32_t cap_height;
+    
+    uint32_t loca;
+    uint32_t glyf;
+    uint32_t glyf_length;
+    uint32_t hmtx;
+    // Unicode subtable of cmap, format 4 or 12, zero when the font has neither
+    uint32_t cmap_subtable;
+    uint32_t cmap_subtable_length;
+    int32_t cmap_format;
+};
+
+uint16_t
+ttf_u16(uint8_t *p){
+    return((uint16_t)((p[0] << 8) | p[1]));
+}
+
+int16_t
+ttf_i16(uint8_t *p){
+    return((int16_t)ttf_u16(p));
+}
+
+uint32_t
+ttf_u32(uint8_t *p){
+    return(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+}
+
+// Offset of a table, zero when the font has no such table or the table does not fit in the file.
+uint32_t
+ttf_find_table(TTF_Font *font, char *tag, uint32_t *length_out){
+    uint32_t result = 0;
+    *length_out = 0;
+    int32_t table_count = ttf_u16(font->data + 4);
+    if (12 + 16*table_count > font->size){
+        return(0);
+    }
+    for (int32_t i = 0; i < table_count; i += 1){
+        uint8_t *record = font->data + 12 + 16*i;
+        if (memcmp(record, tag, 4) == 0){
+            uint32_t offset = ttf_u32(record + 8);
+            uint32_t length = ttf_u32(record + 12);
+            if (offset > 0 && offset <= (uint32_t)font->size && length <= (uint32_t)font->size - offset){
+                result = offset;
+                *length_out = length;
+            }
+            break;
+        }
+    }
+    return(result);
+}
+
+// Checks a cmap subtable's header and arrays against the subtable's own length and the cmap.
+bool32
+ttf__cmap_subtable_valid(TTF_Font *font, uint32_t subtable, uint32_t available, int32_t format, uint32_t *length_out){
+    uint8_t *sub = font->data + subtable;
+    uint32_t length = 0;
+    bool32 result = false;
+    if (format == 4 && available >= 14){
+        // The 16 bit length wraps in some big fonts, the subtable is taken to run to the end of cmap.
+        length = available;
+        uint32_t seg_count = ttf_u16(sub + 6)/2;
+        result = (16 + 8*seg_count <= length);
+    }
+    else if (format == 12 && available >= 16){
+        length = ttf_u32(sub + 4);
+        uint32_t group_count = ttf_u32(sub + 12);
+        result = (16 <= length && length <= available && group_count <= (length - 16)/12);
+    }
+    *length_out = length;
+    return(result);
+}
+
+bool32
+ttf_init(TTF_Font *font, uint8_t *data, int32_t size){
+    memset(font, 0, sizeof(*font));
+    font->data = data;
+    font->size = size;
+    if (size < 12){
+        return(false);
+    }
+    
+    // Only plain TrueType outlines, no collections and no CFF.
+    uint32_t version = ttf_u32(data);
+    if (version != 0x00010000 && version != 0x74727565){
+        return(false);
+    }
+    
+    // Each table has to hold the fields read from it.
+    uint32_t head_length = 0;
+    uint32_t maxp_length = 0;
+    uint32_t hhea_length = 0;
+    uint32_t loca_length = 0;
+    uint32_t hmtx_length = 0;
+    uint32_t head = ttf_find_table(font, "head", &head_length);
+    uint32_t maxp = ttf_find_table(font, "maxp", &maxp_length);
+    uint32_t hhea = ttf_find_table(font, "hhea", &hhea_length);
+    font->loca = ttf_find_table(font, "loca", &loca_length);
+    font->glyf = ttf_find_table(font, "glyf", &font->glyf_length);
+    font->hmtx = ttf_find_table(font, "hmtx", &hmtx_length);
+    if (head == 0 || maxp == 0 || hhea == 0 || font->loca == 0 || font->glyf == 0 || font->hmtx == 0 ||
+        head_length < 54 || maxp_length < 6 || hhea_length < 36){
+        return(false);
+    }
+    
+    font->units_per_em        = ttf_u16(data + head + 18);
+    font->index_to_loc_format = ttf_i16(data + head + 50);
+    font->glyph_count         = ttf_u16(data + maxp + 4);
+    font->ascent              = ttf_i16(data + hhea + 4);
+    font->descent             = ttf_i16(data + hhea + 6);
+    font->hmetric_count       = ttf_u16(data + hhea + 34);
+    
+    // loca has an offset past the last glyph, and every glyph past the long metrics shares the last.
+    uint32_t loca_entry_size = (font->index_to_loc_format == 0)?2:4;
+    if (font->units_per_em == 0 || (font->index_to_loc_format != 0 && font->index_to_loc_format != 1) ||
+        loca_length < loca_entry_size*(font->glyph_count + 1) ||
+        font->hmetric_count == 0 || hmtx_length < 4*(uint32_t)font->hmetric_count){
+        return(false);
+    }
+    
+    uint32_t os2_length = 0;
+    uint32_t os2 = ttf_find_table(font, "OS/2", &os2_length);
+    if (os2 != 0 && os2_length >= 90 && ttf_u16(data + os2) >= 2){
+        font->cap_height = ttf_i16(data + os2 + 88);
+    }
+    if (font->cap_height <= 0){
+        font->cap_height = (font->ascent*7)/10;
+    }
+    
+    // Prefer the full repertoire format 12 subtable over the BMP only format 4 one.
+    // A subtable that does not fit is passed over like one of another format.
+    uint32_t cmap_length = 0;
+    uint32_t cmap = ttf_find_table(font, "cmap", &cmap_length);
+    if (cmap != 0 && cmap_length >= 4){
+        uint32_t subtable_count = ttf_u16(data + cmap + 2);
+        subtable_count = (subtable_count > (cmap_length - 4)/8)?(cmap_length - 4)/8:subtable_count;
+        for (uint32_t i = 0; i < subtable_count; i += 1){
+            uint8_t *record = data + cmap + 4 + 8*i;
+            int32_t platform = ttf_u16(record);
+            int32_t encoding = ttf_u16(record + 2);
+            uint32_t subtable_offset = ttf_u32(record + 4);
+            if (subtable_offset > cmap_length - 2){
+                continue;
+            }
+            uint32_t subtable = cmap + subtable_offset;
+            int32_t format = ttf_u16(data + subtable);
+            bool32 unicode = (platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10)));
+            uint32_t subtable_length = 0;
+            if (unicode && (format == 12 || (format == 4 && font->cmap_format != 12)) &&
+                ttf__cmap_subtable_valid(font, subtable, cmap_length - subtable_offset, format, &subtable_length)){
+                font->cmap_subtable = subtable;
+                font->cmap_subtable_length = subtable_length;
+                font->cmap_format = format;
+            }
+        }
+    }
+    
+    return(true);
+}
+
+// Byte range of a glyph's outline inside glyf, empty for glyphs with no outline.
+bool32
+ttf_glyph_range(TTF_Font *font, int32_t glyph, uint32_t *first, uint32_t *one_past_last){
+    if (glyph < 0 || glyph >= font->glyph_count){
+        return(false);
+    }
+    uint32_t a = 0;
+    uint32_t b = 0;
+    if (font->index_to_loc_format == 0){
+        a = 2*(uint32_t)ttf_u16(font->data + font->loca + 2*glyph);
+        b = 2*(uint32_t)ttf_u16(font->data + font->loca + 2*glyph + 2);
+    }
+    else{
+        a = ttf_u32(font->data + font->loca + 4*glyph);
+        b = ttf_u32(font->data + font->loca + 4*glyph + 4);
+    }
+    // A range that runs out of glyf is taken as no outline, like one that runs backwards.
+    if (b > font->glyf_length){
+        return(false);
+    }
+    *first = font->glyf + a;
+    *one_past_last = font->glyf + b;
+    return(b > a);
+}
+
+// Design unit bounding box of a glyph, false for glyphs with no outline.
+bool32
+ttf_glyph_box(TTF_Font *font, int32_t glyph, int32_t *x0, int32_t *y0, int32_t *x1, int32_t *y1){
+    uint32_t first = 0;
+    uint32_t one_past_last = 0;
+    if (!ttf_glyph_range(font, glyph, &first, &one_past_last) || one_past_last - first < 10){
+        return(false);
+    }
+    uint8_t *header = font->data + first;
+    *x0 = ttf_i16(header + 2);
+    *y0 = ttf_i16(header + 4);
+    *x1 = ttf_i16(header + 6);
+    *y1 = ttf_i16(header + 8);
+    return(true);
+}
+
+// Glyph for a Unicode codepoint, zero when the font does not cover it.
+uint16_t
+ttf_codepoint_glyph(TTF_Font *font, uint32_t codepoint){
+    uint16_t result = 0;
+    uint8_t *sub = font->data + font->cmap_subtable;
+    if (font->cmap_format == 4){
+        if (codepoint > 0xFFFF){
+            return(0);
+        }
+        int32_t seg_count = ttf_u16(sub + 6)/2;
+        uint8_t *end_codes = sub + 14;
+        uint8_t *start_codes = end_codes + 2*seg_count + 2;
+        uint8_t *deltas = start_codes + 2*seg_count;
+        uint8_t *range_offsets = deltas + 2*seg_count;
+        
+        // First segment whose end is at or past the codepoint
+        int32_t lo = 0;
+        int32_t hi = seg_count;
+        for (; lo < hi;){
+            int32_t mid = (lo + hi)/2;
+            if (ttf_u16(end_codes + 2*mid) < codepoint){
+                lo = mid + 1;
+            }
+            else{
+                hi = mid;
+            }
+        }
+        if (lo < seg_count && ttf_u16(start_codes + 2*lo) <= codepoint){
+            uint32_t start = ttf_u16(start_codes + 2*lo);
+            uint16_t delta = ttf_u16(deltas + 2*lo);
+            uint16_t range_offset = ttf_u16(range_offsets + 2*lo);
+            if (range_offset == 0){
+                result = (uint16_t)(codepoint + delta);
+            }
+            else{
+                // The glyph array follows the offsets, the offset can point anywhere past them.
+                uint32_t glyph_at = (uint32_t)(range_offsets - sub) + 2*lo + range_offset + 2*(codepoint - start);
+                if (glyph_at + 2 <= font->cmap_subtable_length){
+                    uint16_t glyph = ttf_u16(sub + glyph_at);
+                    if (glyph != 0){
+                        result = (uint16_t)(glyph + delta);
+                    }
+                }
+            }
+        }
+    }
+    else if (font->cmap_format == 12){
+        uint32_t group_count = ttf_u32(sub + 12);
+        uint8_t *groups = sub + 16;
+        uint32_t lo = 0;
+        uint32_t hi = group_count;
+        for (; lo < hi;){
+            uint32_t mid = (lo + hi)/2;
+            uint8_t *group = groups + 12*mid;
+            if (ttf_u32(group + 4) < codepoint){
+                lo = mid + 1;
+            }
+            else{
+                hi = mid;
+            }
+        }
+        if (lo < group_count){
+            uint8_t *group = groups + 12*lo;
+            uint32_t start = ttf_u32(group);
+            if (start <= codepoint){
+                result = (uint16_t)(ttf_u32(group + 8) + (codepoint - start));
+            }
+        }
+    }
+    if (result >= font->glyph_count){
+        result = 0;
+    }
+    return(result);
+}
+
+// Codepoint lookup in the shape of Codepoint_Glyphs_Function, backend is the TTF_Font.
+void
+ttf_codepoint_glyphs(void *backend, uint32_t *codepoints, uint16_t *glyphs, int32_t count){
+    TTF_Font *font = (TTF_Font*)backend;
+    for (int32_t i = 0; i < count; i += 1){
+        glyphs[i] = ttf_codepoint_glyph(font, codepoints[i]);
+    }
+}
+
+int32_t
+ttf_glyph_advance(TTF_Font *font, int32_t glyph){
+    int32_t metric = glyph;
+    if (metric >= font->hmetric_count){
+        metric = font->hmetric_count - 1;
+    }
+    return(ttf_u16(font->data + font->hmtx + 4*metric));
+}
+
+////////////////////////////////
+
+// Outlines
+
+struct TTF_Point{
+    float x;
+    float y;
+    bool32 on_curve;
+};
+
+// Every contour is a closed loop of points. contour_ends[i] is one past the last point of contour i.
+struct TTF_Outline{
+    TTF_Point *points;
+    int32_t point_count;
+    int32_t point_max;
+    int32_t *contour_ends;
+    int32_t contour_count;
+    int32_t contour_max;
+    // Scratch for the flags of the simple glyph being read, kept to avoid an allocation per glyph
+    uint8_t *flags;
+    int32_t flag_max;
+};
+
+void
+ttf_outline_free(TTF_Outline *outline){
+    heap_free(outline->points);
+    heap_free(outline->contour_ends);
+    heap_free(outline->flags);
+    memset(outline, 0, sizeof(*outline));
+}
+
+void
+ttf_outline__reserve(TTF_Outline *outline, int32_t point_count, int32_t contour_count){
+    if (outline->point_count + point_count > outline->point_max){
+        outline->point_max = 2*(outline->point_count + point_count);
+        outline->points = (TTF_Point*)heap_realloc(outline->points, sizeof(TTF_Point)*outline->point_max);
+    }
+    if (outline->contour_count + contour_count > outline->contour_max){
+        outline->contour_max = 2*(outline->contour_count + contour_count);
+        outline->contour_ends = (int32_t*)heap_realloc(outline->contour_ends, sizeof(int32_t)*outline->contour_max);
+    }
+    if (point_count + 1 > outline->flag_max){
+        outline->flag_max = 2*(point_count + 1);
+        outline->flags = (uint8_t*)heap_realloc(outline->flags, outline->flag_max);
+    }
+}
+
+// Transform applied to composite glyph components: x' = a*x + c*y + e, y' = b*x + d*y + f
+struct TTF_Transform{
+    float a;
+    float b;
+    float c;
+    float d;
+    float e;
+    float f;
+};
+
+bool32
+ttf__append_glyph_outline(TTF_Font *font, int32_t glyph, TTF_Transform transform, TTF_Outline *outline, int32_t depth){
+    uint32_t first = 0;
+    uint32_t one_past_last = 0;
+    if (!ttf_glyph_range(font, glyph, &first, &one_past_last)){
+        return(true);
+    }
+    if (depth > 8 || one_past_last - first < 10){
+        return(false);
+    }
+    
+    uint8_t *data = font->data;
+    uint8_t *end = data + one_past_last;
+    int32_t contour_count = ttf_i16(data + first);
+    
+    if (contour_count >= 0){
+        // Simple glyph
+        uint8_t *ptr = data + first + 10;
+        if (end - ptr < 2*contour_count + 2){
+            return(false);
+        }
+        int32_t point_count = 0;
+        if (contour_count > 0){
+            point_count = ttf_u16(ptr + 2*(contour_count - 1)) + 1;
+        }
+        ttf_outline__reserve(outline, point_count, contour_count);
+        int32_t base = outline->point_count;
+        for (int32_t i = 0; i < contour_count; i += 1){
+            int32_t contour_end = base + ttf_u16(ptr + 2*i) + 1;
+            if (contour_end > base + point_count){
+                return(false);
+            }
+            outline->contour_ends[outline->contour_count + i] = contour_end;
+        }
+        ptr += 2*contour_count;
+        int32_t instruction_length = ttf_u16(ptr);
+        ptr += 2;
+        if (end - ptr < instruction_length){
+            return(false);
+        }
+        ptr += instruction_length;
+        
+        // Flags, with repeats expanded. The on curve bit is kept in the point until the coordinates are read.
+        TTF_Point *points = outline->points + base;
+        uint8_t *flags = outline->flags;
+        for (int32_t i = 0; i < point_count;){
+            if (ptr >= end){
+                return(false);
+            }
+            uint8_t flag = *ptr++;
+            int32_t repeat = 1;
+            if (flag & 8){
+                if (ptr >= end){
+                    return(false);
+                }
+                repeat += *ptr++;
+            }
+            for (; repeat > 0 && i < point_count; repeat -= 1, i += 1){
+                flags[i] = flag;
+            }
+        }
+        
+        // Each coordinate is one byte, two or none, checked before it is read.
+        int32_t value = 0;
+        for (int32_t i = 0; i < point_count; i += 1){
+            uint8_t flag = flags[i];
+            int32_t size = (flag & 2)?1:(flag & 16)?0:2;
+            if (end - ptr < size){
+                return(false);
+            }
+            if (flag & 2){
+                int32_t delta = *ptr++;
+                value += (flag & 16)?delta:-delta;
+            }
+            else if (!(flag & 16)){
+                value += ttf_i16(ptr);
+                ptr += 2;
+            }
+            points[i].x = (float)value;
+        }
+        value = 0;
+        for (int32_t i = 0; i < point_count; i += 1){
+            uint8_t flag = flags[i];
+            int32_t size = (flag & 4)?1:(flag & 32)?0:2;
+            if (end - ptr < size){
+                return(false);
+            }
+            if (flag & 4){
+                int32_t delta = *ptr++;
+                value += (flag & 32)?delta:-delta;
+            }
+            else if (!(flag & 32)){
+                value += ttf_i16(ptr);
+                ptr += 2;
+            }
+            points[i].y = (float)value;
+            points[i].on_curve = (flag & 1);
+        }
+        
+        for (int32_t i = 0; i < point_count; i += 1){
+            float x = points[i].x;
+            float y = points[i].y;
+            points[i].x = transform.a*x + transform.c*y + transform.e;
+            points[i].y = transform.b*x + transform.d*y + transform.f;
+        }
+        outline->point_count += point_count;
+        outline->contour_count += contour_count;
+    }
+    else{
+        // Composite glyph
+        uint8_t *ptr = data + first + 10;
+        for (;;){
+            if (ptr + 4 > end){
+                return(false);
+            }
+            uint16_t flags = ttf_u16(ptr);
+            int32_t component = ttf_u16(ptr + 2);
+            ptr += 4;
+            // The offsets, then the scale: one value, separate x and y, or a two by two matrix
+            int32_t argument_size = (flags & 1)?4:2;
+            int32_t scale_size = (flags & 8)?2:(flags & 64)?4:(flags & 128)?8:0;
+            if (end - ptr < argument_size + scale_size){
+                return(false);
+            }
+            
+            float dx = 0.f;
+            float dy = 0.f;
+            if (flags & 1){
+                dx = (float)ttf_i16(ptr);
+                dy = (float)ttf_i16(ptr + 2);
+                ptr += 4;
+            }
+            else{
+                dx = (float)(int8_t)ptr[0];
+                dy = (float)(int8_t)ptr[1];
+                ptr += 2;
+            }
+            // Point matching placement is not supported, those components go at the origin.
+            if (!(flags & 2)){
+                dx = 0.f;
+                dy = 0.f;
+            }
+            
+            TTF_Transform local = {1.f, 0.f, 0.f, 1.f, dx, dy};
+            if (flags & 8){
+                local.a = local.d = (float)ttf_i16(ptr)/16384.f;
+                ptr += 2;
+            }
+            else if (flags & 64){
+                local.a = (float)ttf_i16(ptr)/16384.f;
+                local.d = (float)ttf_i16(ptr + 2)/16384.f;
+                ptr += 4;
+            }
+            else if (flags & 128){
+                local.a = (float)ttf_i16(ptr)/16384.f;
+                local.b = (float)ttf_i16(ptr + 2)/16384.f;
+                local.c = (float)ttf_i16(ptr + 4)/16384.f;
+                local.d = (float)ttf_i16(ptr + 6)/16384.f;
+                ptr += 8;
+            }
+            
+            TTF_Transform combined = {0};
+            combined.a = transform.a*local.a + transform.c*local.b;
+            combined.b = transform.b*local.a + transform.d*local.b;
+            combined.c = transform.a*local.c + transform.c*local.d;
+            combined.d = transform.b*local.c + transform.d*local.d;
+            combined.e = transform.a*local.e + transform.c*local.f + transform.e;
+            combined.f = transform.b*local.e + transform.d*local.f + transform.f;
+            if (!ttf__append_glyph_outline(font, component, combined, outline, depth + 1)){
+                return(false);
+            }
+            
+            if (!(flags & 32)){
+                break;
+            }
+        }
+    }
+    
+    return(true);
+}
+
+// Decodes a glyph's outline in design units, y up. The outline's arrays are reused between calls.
+bool32
+ttf_glyph_outline(TTF_Font *font, int32_t glyph, TTF_Outline *outline){
+    outline->point_count = 0;
+    outline->contour_count = 0;
+    TTF_Transform identity = {1.f, 0.f, 0.f, 1.f, 0.f, 0.f};
+    return(ttf__append_glyph_outline(font, glyph, identity, outline, 0));
+}
+
+#endif
@@ -0,0 +1,461 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the TrueType table reader on damaged fonts
+// usage: truetype_test [seed]
+// A small font is built in memory: a square, two contours with repeated flags and byte and word
+// coordinates, a composite of the two with an offset and a scale, a format 4 or a format 12 cmap.
+// It has to read back exactly. Then every glyph is cut short at every length, which must fail rather
+// than read the next glyph; fields that point out of their table must keep the font from loading;
+// every prefix of the file and random damage anywhere must load or fail without a read past the end.
+// Each damaged font sits in an allocation of its own size, so a build with a memory checker sees
+// any read out of bounds.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_truetype.h"
+#include "example_test.h"
+
+static int32_t test_damage_count = 20000;
+
+#define TEST_FONT_MAX 4096
+
+struct Test_Font_Builder{
+    uint8_t data[TEST_FONT_MAX];
+    int32_t size;
+};
+
+void
+test_put8(Test_Font_Builder *b, int32_t x){
+    b->data[b->size] = (uint8_t)x;
+    b->size += 1;
+}
+
+void
+test_put16(Test_Font_Builder *b, int32_t x){
+    test_put8(b, x >> 8);
+    test_put8(b, x);
+}
+
+void
+test_put32(Test_Font_Builder *b, uint32_t x){
+    test_put16(b, (int32_t)(x >> 16));
+    test_put16(b, (int32_t)x);
+}
+
+void
+test_set16(uint8_t *at, int32_t x){
+    at[0] = (uint8_t)(x >> 8);
+    at[1] = (uint8_t)x;
+}
+
+void
+test_set32(uint8_t *at, uint32_t x){
+    test_set16(at, (int32_t)(x >> 16));
+    test_set16(at + 2, (int32_t)x);
+}
+
+void
+test_pad(Test_Font_Builder *b, int32_t size){
+    for (int32_t i = 0; i < size; i += 1){
+        test_put8(b, 0);
+    }
+}
+
+// Where the tables of the built font are, to damage them on purpose
+struct Test_Font_Layout{
+    char tags[9][5];
+    uint32_t offsets[9];
+    uint32_t lengths[9];
+    int32_t table_count;
+    // Start of each glyph inside glyf, and one past the last
+    uint32_t glyph_starts[5];
+};
+
+#define TEST_GLYPH_COUNT 4
+
+// The font: glyph 0 has no outline, 1 is a square, 2 is two contours and 3 is 1 and 2 put together.
+void
+test_build_font(Test_Font_Builder *b, Test_Font_Layout *layout, int32_t cmap_format){
+    memset(b, 0, sizeof(*b));
+    memset(layout, 0, sizeof(*layout));
+    char *tags[] = {"OS/2", "cmap", "glyf", "head", "hhea", "hmtx", "loca", "maxp"};
+    int32_t table_count = 8;
+    layout->table_count = table_count;
+    test_put32(b, 0x00010000);
+    test_put16(b, table_count);
+    test_pad(b, 6);
+    int32_t directory = b->size;
+    test_pad(b, 16*table_count);
+    
+    for (int32_t t = 0; t < table_count; t += 1){
+        int32_t start = b->size;
+        char *tag = tags[t];
+        if (strcmp(tag, "OS/2") == 0){
+            test_put16(b, 2);
+            test_pad(b, 86);
+            test_put16(b, 700);
+            test_pad(b, 6);
+        }
+        else if (strcmp(tag, "cmap") == 0){
+            test_put16(b, 0);
+            test_put16(b, 1);
+            test_put16(b, 3);
+            test_put16(b, (cmap_format == 12)?10:1);
+            test_put32(b, 12);
+            if (cmap_format == 4){
+                // A..C by delta, a..c through the glyph array, then the closing segment
+                int32_t sub = b->size;
+                test_put16(b, 4);
+                test_put16(b, 0);
+                test_put16(b, 0);
+                test_put16(b, 6);
+                test_pad(b, 6);
+                test_put16(b, 'C'); test_put16(b, 'c'); test_put16(b, 0xFFFF);
+                test_put16(b, 0);
+                test_put16(b, 'A'); test_put16(b, 'a'); test_put16(b, 0xFFFF);
+                test_put16(b, 1 - 'A'); test_put16(b, 0); test_put16(b, 1);
+                test_put16(b, 0); test_put16(b, 4); test_put16(b, 0);
+                test_put16(b, 3); test_put16(b, 2); test_put16(b, 0);
+                test_set16(b->data + sub + 2, b->size - sub);
+            }
+            else{
+                test_put16(b, 12);
+                test_put16(b, 0);
+                test_put32(b, 16 + 2*12);
+                test_put32(b, 0);
+                test_put32(b, 2);
+                test_put32(b, 'A'); test_put32(b, 'C'); test_put32(b, 1);
+                test_put32(b, 0x1F600); test_put32(b, 0x1F600); test_put32(b, 2);
+            }
+        }
+        else if (strcmp(tag, "glyf") == 0){
+            layout->glyph_starts[0] = 0;
+            layout->glyph_starts[1] = 0;
+            
+            // Square: a byte x, then words, with x or y kept the same
+            test_put16(b, 1);
+            test_put16(b, 100); test_put16(b, 0); test_put16(b, 500); test_put16(b, 400);
+            test_put16(b, 3);
+            test_put16(b, 0);
+            test_put8(b, 0x33); test_put8(b, 0x21); test_put8(b, 0x11); test_put8(b, 0x21);
+            test_put8(b, 100); test_put16(b, 400); test_put16(b, -400);
+            test_put16(b, 400);
+            layout->glyph_starts[2] = b->size - start;
+            
+            // Three off curve points from one repeated flag, two on curve ones stepping left by bytes
+            test_put16(b, 2);
+            test_put16(b, 0); test_put16(b, 0); test_put16(b, 600); test_put16(b, 600);
+            test_put16(b, 2); test_put16(b, 4);
+            test_put16(b, 2);
+            test_put8(b, 0); test_put8(b, 0);
+            test_put8(b, 0x08); test_put8(b, 2);
+            test_put8(b, 0x2B); test_put8(b, 1);
+            test_put16(b, 0); test_put16(b, 300); test_put16(b, 300);
+            test_put8(b, 50); test_put8(b, 50);
+            test_put16(b, 0); test_put16(b, 600); test_put16(b, -600);
+            layout->glyph_starts[3] = b->size - start;
+            
+            // Glyph 1 moved by words, then glyph 2 moved by bytes and scaled by half
+            test_put16(b, -1);
+            test_put16(b, 0); test_put16(b, -20); test_put16(b, 510); test_put16(b, 380);
+            test_put16(b, 0x23); test_put16(b, 1); test_put16(b, 10); test_put16(b, -20);
+            test_put16(b, 0x0A); test_put16(b, 2); test_put8(b, 5); test_put8(b, 6); test_put16(b, 8192);
+            layout->glyph_starts[4] = b->size - start;
+        }
+        else if (strcmp(tag, "head") == 0){
+            test_pad(b, 18);
+            test_put16(b, 1000);
+            test_pad(b, 30);
+            test_put16(b, 1);
+            test_put16(b, 0);
+        }
+        else if (strcmp(tag, "hhea") == 0){
+            test_put32(b, 0x00010000);
+            test_put16(b, 800);
+            test_put16(b, -200);
+            test_pad(b, 26);
+            test_put16(b, 3);
+        }
+        else if (strcmp(tag, "hmtx") == 0){
+            test_put16(b, 500); test_put16(b, 0);
+            test_put16(b, 600); test_put16(b, 100);
+            test_put16(b, 700); test_put16(b, 0);
+            test_put16(b, 0);
+        }
+        else if (strcmp(tag, "loca") == 0){
+            // glyf comes before loca, its glyphs are already laid out.
+            for (int32_t g = 0; g <= TEST_GLYPH_COUNT; g += 1){
+                test_put32(b, layout->glyph_starts[g]);
+            }
+        }
+        else if (strcmp(tag, "maxp") == 0){
+            test_put32(b, 0x00005000);
+            test_put16(b, TEST_GLYPH_COUNT);
+        }
+        
+        uint8_t *record = b->data + directory + 16*t;
+        memcpy(record, tag, 4);
+        test_set32(record + 8, (uint32_t)start);
+        test_set32(record + 12, (uint32_t)(b->size - start));
+        memcpy(layout->tags[t], tag, 5);
+        layout->offsets[t] = (uint32_t)start;
+        layout->lengths[t] = (uint32_t)(b->size - start);
+        test_pad(b, (4 - (b->size & 3)) & 3);
+    }
+}
+
+int32_t
+test_table(Test_Font_Layout *layout, char *tag){
+    for (int32_t t = 0; t < layout->table_count; t += 1){
+        if (strcmp(layout->tags[t], tag) == 0){
+            return(t);
+        }
+    }
+    return(-1);
+}
+
+// Every entry point on a font that may be damaged. Only what has to hold for any font is checked.
+void
+test_use_font(uint8_t *bytes, int32_t size, TTF_Outline *outline){
+    // The font gets an allocation of exactly its size.
+    uint8_t *data = (uint8_t*)malloc((size > 0)?size:1);
+    memcpy(data, bytes, size);
+    TTF_Font font = {0};
+    if (ttf_init(&font, data, size)){
+        uint32_t codepoints[] = {0, 'A', 'B', 'C', 'a', 'b', 'c', 'z', 0xFFFF, 0x1F600, 0x10FFFF};
+        for (int32_t i = 0; i < (int32_t)(sizeof(codepoints)/sizeof(codepoints[0])); i += 1){
+            uint16_t glyph = ttf_codepoint_glyph(&font, codepoints[i]);
+            TEST_CHECK(glyph == 0 || glyph < font.glyph_count);
+        }
+        for (int32_t g = 0; g < font.glyph_count; g += 1){
+            int32_t x0, y0, x1, y1;
+            ttf_glyph_box(&font, g, &x0, &y0, &x1, &y1);
+            ttf_glyph_advance(&font, g);
+            if (ttf_glyph_outline(&font, g, outline)){
+                TEST_CHECK(outline->point_count >= 0 && outline->contour_count >= 0);
+                for (int32_t c = 0; c < outline->contour_count; c += 1){
+                    TEST_CHECK(0 < outline->contour_ends[c] && outline->contour_ends[c] <= outline->point_count);
+                }
+            }
+        }
+    }
+    free(data);
+}
+
+bool32
+test_point(TTF_Outline *outline, int32_t i, float x, float y, bool32 on_curve){
+    TTF_Point *p = &outline->points[i];
+    return(p->x == x && p->y == y && (p->on_curve != 0) == (on_curve != 0));
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x77F0u);
+    uint32_t state = seed;
+    TTF_Outline outline = {0};
+    Test_Font_Builder *builder = (Test_Font_Builder*)malloc(sizeof(Test_Font_Builder));
+    Test_Font_Layout layout = {0};
+    uint64_t damaged_loads = 0;
+    
+    // The intact font, with each kind of cmap
+    int32_t cmap_formats[] = {4, 12};
+    for (int32_t f = 0; f < 2; f += 1){
+        int64_t failures_before = test_state.failures;
+        test_build_font(builder, &layout, cmap_formats[f]);
+        TTF_Font font = {0};
+        if (!TEST_CHECK(ttf_init(&font, builder->data, builder->size))){
+            continue;
+        }
+        TEST_CHECK(font.glyph_count == TEST_GLYPH_COUNT && font.units_per_em == 1000);
+        TEST_CHECK(font.ascent == 800 && font.descent == -200 && font.cap_height == 700);
+        TEST_CHECK(font.cmap_format == cmap_formats[f]);
+        TEST_CHECK(ttf_glyph_advance(&font, 1) == 600 && ttf_glyph_advance(&font, 3) == 700);
+        
+        TEST_CHECK(ttf_codepoint_glyph(&font, 'A') == 1);
+        TEST_CHECK(ttf_codepoint_glyph(&font, 'C') == 3);
+        TEST_CHECK(ttf_codepoint_glyph(&font, 'z') == 0);
+        if (cmap_formats[f] == 4){
+            TEST_CHECK(ttf_codepoint_glyph(&font, 'a') == 3);
+            TEST_CHECK(ttf_codepoint_glyph(&font, 'b') == 2);
+            TEST_CHECK(ttf_codepoint_glyph(&font, 'c') == 0);
+            TEST_CHECK(ttf_codepoint_glyph(&font, 0x1F600) == 0);
+        }
+        else{
+            TEST_CHECK(ttf_codepoint_glyph(&font, 'a') == 0);
+            TEST_CHECK(ttf_codepoint_glyph(&font, 0x1F600) == 2);
+        }
+        
+        int32_t x0, y0, x1, y1;
+        TEST_CHECK(!ttf_glyph_box(&font, 0, &x0, &y0, &x1, &y1));
+        TEST_CHECK(ttf_glyph_box(&font, 1, &x0, &y0, &x1, &y1) && x0 == 100 && y0 == 0 && x1 == 500 && y1 == 400);
+        TEST_CHECK(ttf_glyph_outline(&font, 0, &outline) && outline.point_count == 0);
+        
+        TEST_CHECK(ttf_glyph_outline(&font, 1, &outline));
+        TEST_CHECK(outline.point_count == 4 && outline.contour_count == 1 && outline.contour_ends[0] == 4);
+        TEST_CHECK(test_point(&outline, 0, 100, 0, true) && test_point(&outline, 1, 500, 0, true) &&
+                   test_point(&outline, 2, 500, 400, true) && test_point(&outline, 3, 100, 400, true));
+        
+        TEST_CHECK(ttf_glyph_outline(&font, 2, &outline));
+        TEST_CHECK(outline.point_count == 5 && outline.contour_count == 2);
+        TEST_CHECK(outline.contour_ends[0] == 3 && outline.contour_ends[1] == 5);
+        TEST_CHECK(test_point(&outline, 0, 0, 0, false) && test_point(&outline, 1, 300, 600, false) &&
+                   test_point(&outline, 2, 600, 0, false) && test_point(&outline, 3, 550, 0, true) &&
+                   test_point(&outline, 4, 500, 0, true));
+        
+        TEST_CHECK(ttf_glyph_outline(&font, 3, &outline));
+        TEST_CHECK(outline.point_count == 9 && outline.contour_count == 3);
+        TEST_CHECK(outline.contour_ends[0] == 4 && outline.contour_ends[1] == 7 && outline.contour_ends[2] == 9);
+        TEST_CHECK(test_point(&outline, 0, 110, -20, true) && test_point(&outline, 2, 510, 380, true));
+        TEST_CHECK(test_point(&outline, 4, 5, 6, false) && test_point(&outline, 5, 155, 306, false) &&
+                   test_point(&outline, 8, 255, 6, true));
+        if (test_state.failures != failures_before){
+            printf("    the intact font with a format %d cmap\n", cmap_formats[f]);
+        }
+    }
+    
+    // Glyphs cut short
+    test_build_font(builder, &layout, 4);
+    uint8_t *loca = builder->data + layout.offsets[test_table(&layout, "loca")];
+    for (int32_t g = 1; g < TEST_GLYPH_COUNT; g += 1){
+        int32_t length = (int32_t)(layout.glyph_starts[g + 1] - layout.glyph_starts[g]);
+        for (int32_t cut = 0; cut < length; cut += 1){
+            int64_t failures_before = test_state.failures;
+            test_set32(loca + 4*(g + 1), layout.glyph_starts[g] + cut);
+            TTF_Font font = {0};
+            TEST_CHECK(ttf_init(&font, builder->data, builder->size));
+            int32_t x0, y0, x1, y1;
+            TEST_CHECK(ttf_glyph_box(&font, g, &x0, &y0, &x1, &y1) == (cut >= 10));
+            TEST_CHECK(ttf_glyph_outline(&font, g, &outline) == (cut == 0));
+            if (test_state.failures != failures_before){
+                printf("    glyph %d cut to %d of %d bytes\n", g, cut, length);
+            }
+            test_use_font(builder->data, builder->size, &outline);
+        }
+        test_set32(loca + 4*(g + 1), layout.glyph_starts[g + 1]);
+    }
+    // An end past glyf, an end before the start
+    test_set32(loca + 4*TEST_GLYPH_COUNT, layout.lengths[test_table(&layout, "glyf")] + 1);
+    {
+        TTF_Font font = {0};
+        int32_t x0, y0, x1, y1;
+        TEST_CHECK(ttf_init(&font, builder->data, builder->size));
+        TEST_CHECK(!ttf_glyph_box(&font, 3, &x0, &y0, &x1, &y1));
+        TEST_CHECK(ttf_glyph_outline(&font, 3, &outline) && outline.point_count == 0);
+    }
+    test_set32(loca + 4*TEST_GLYPH_COUNT, layout.glyph_starts[TEST_GLYPH_COUNT]);
+    test_set32(loca + 4*3, layout.glyph_starts[2] - 1);
+    {
+        TTF_Font font = {0};
+        TEST_CHECK(ttf_init(&font, builder->data, builder->size));
+        TEST_CHECK(ttf_glyph_outline(&font, 2, &outline) && outline.point_count == 0);
+    }
+    
+    // Fields pointing out of their tables keep the font from loading.
+    struct Test_Damage{
+        char *name;
+        char *tag;
+        // Zero for the table's directory entry, otherwise one past the field's offset in the table
+        int32_t field;
+        int32_t field_size;
+        uint32_t value;
+    };
+    Test_Damage damages[] = {
+        {"head too short", "head", 0, 4, 53},
+        {"hhea too short", "hhea", 0, 4, 35},
+        {"maxp past the end", "maxp", -1, 4, 0x7FFFFFF0},
+        {"glyf past the end", "glyf", 0, 4, 0x10000},
+        {"more glyphs than loca has", "maxp", 4 + 1, 2, TEST_GLYPH_COUNT + 1},
+        {"more long metrics than hmtx has", "hhea", 34 + 1, 2, 4},
+        {"no long metrics", "hhea", 34 + 1, 2, 0},
+        {"unknown loca format", "head", 50 + 1, 2, 2},
+    };
+    for (int32_t d = 0; d < (int32_t)(sizeof(damages)/sizeof(damages[0])); d += 1){
+        Test_Damage *damage = &damages[d];
+        test_build_font(builder, &layout, 4);
+        int32_t t = test_table(&layout, damage->tag);
+        uint8_t *at = builder->data + layout.offsets[t] + damage->field - 1;
+        if (damage->field == 0){
+            at = builder->data + 12 + 16*t + 12;
+        }
+        else if (damage->field < 0){
+            at = builder->data + 12 + 16*t + 8;
+        }
+        if (damage->field_size == 2){
+            test_set16(at, (int32_t)damage->value);
+        }
+        else{
+            test_set32(at, damage->value);
+        }
+        TTF_Font font = {0};
+        if (!TEST_CHECK(!ttf_init(&font, builder->data, builder->size))){
+            printf("    %s loaded\n", damage->name);
+        }
+    }
+    {
+        // A table count past the end of the file
+        test_build_font(builder, &layout, 4);
+        test_set16(builder->data + 4, 0xFFFF);
+        TTF_Font font = {0};
+        TEST_CHECK(!ttf_init(&font, builder->data, builder->size));
+    }
+    {
+        // A cmap subtable that runs past cmap, the font loads with no cmap.
+        test_build_font(builder, &layout, 4);
+        uint8_t *cmap = builder->data + layout.offsets[test_table(&layout, "cmap")];
+        test_set16(cmap + 12 + 6, 2*1000);
+        TTF_Font font = {0};
+        TEST_CHECK(ttf_init(&font, builder->data, builder->size) && font.cmap_format == 0);
+        TEST_CHECK(ttf_codepoint_glyph(&font, 'A') == 0);
+        test_set16(cmap + 12 + 6, 6);
+        test_set32(cmap + 8, 0x7FFFFFFF);
+        TEST_CHECK(ttf_init(&font, builder->data, builder->size) && font.cmap_format == 0);
+        // A glyph array offset past the subtable reads as no glyph.
+        test_set32(cmap + 8, 12);
+        test_set16(cmap + 12 + 36, 0x7FF0);
+        TEST_CHECK(ttf_init(&font, builder->data, builder->size) && font.cmap_format == 4);
+        TEST_CHECK(ttf_codepoint_glyph(&font, 'a') == 0 && ttf_codepoint_glyph(&font, 'A') == 1);
+    }
+    
+    // Every prefix of the file, then random damage
+    for (int32_t f = 0; f < 2; f += 1){
+        test_build_font(builder, &layout, cmap_formats[f]);
+        for (int32_t size = 0; size <= builder->size; size += 1){
+            test_use_font(builder->data, size, &outline);
+        }
+    }
+    uint8_t *damaged = (uint8_t*)malloc(TEST_FONT_MAX);
+    for (int32_t i = 0; i < test_damage_count; i += 1){
+        test_build_font(builder, &layout, cmap_formats[i%2]);
+        memcpy(damaged, builder->data, builder->size);
+        int32_t flips = test_random_range(&state, 1, 8);
+        for (int32_t k = 0; k < flips; k += 1){
+            int32_t at = test_random_range(&state, 0, builder->size - 1);
+            damaged[at] = (test_random_range(&state, 0, 1) == 0)?(uint8_t)test_random(&state):(uint8_t)(damaged[at] ^ 0xFF);
+        }
+        TTF_Font font = {0};
+        damaged_loads += ttf_init(&font, damaged, builder->size);
+        test_use_font(damaged, builder->size, &outline);
+    }
+    free(damaged);
+    
+    free(builder);
+    ttf_outline_free(&outline);
+    printf("truetype_test: %d damaged fonts, %llu of them loaded\n", test_damage_count, (unsigned long long)damaged_loads);
+    return(test_finish("truetype_test", seed));
+}
@@ -0,0 +1,196 @@
+// DirectWrite rasterization example: UTF-8 decoding for draw_string
+// Runs of ASCII are widened 16 bytes at a time with SSE2 (32 with AVX2 when the compiler targets it),
+// multibyte sequences go through the scalar decoder. Malformed sequences decode to U+FFFD.
+
+#if !defined(EXAMPLE_UTF8_H)
+#define EXAMPLE_UTF8_H
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define UTF8_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <stdint.h>
+typedef int32_t bool32;
+
+#define UTF8_REPLACEMENT 0xFFFD
+
+// Decodes the sequence at the start of text. Always consumes at least one byte.
+uint32_t
+utf8_decode_one(uint8_t *text, int32_t length, int32_t *advance){
+    uint32_t b0 = text[0];
+    if (b0 < 0x80){
+        *advance = 1;
+        return(b0);
+    }
+    
+    int32_t need = 0;
+    uint32_t codepoint = 0;
+    uint32_t min = 0;
+    if ((b0 & 0xE0) == 0xC0){
+        need = 1;
+        codepoint = b0 & 0x1F;
+        min = 0x80;
+    }
+    else if ((b0 & 0xF0) == 0xE0){
+        need = 2;
+        codepoint = b0 & 0x0F;
+        min = 0x800;
+    }
+    else if ((b0 & 0xF8) == 0xF0){
+        need = 3;
+        codepoint = b0 & 0x07;
+        min = 0x10000;
+    }
+    else{
+        *advance = 1;
+        return(UTF8_REPLACEMENT);
+    }
+    
+    // A truncated sequence consumes only the bytes that belong to it.
+    for (int32_t k = 1; k <= need; k += 1){
+        if (k >= length || (text[k] & 0xC0) != 0x80){
+            *advance = k;
+            return(UTF8_REPLACEMENT);
+        }
+        codepoint = (codepoint << 6) | (text[k] & 0x3F);
+    }
+    *advance = need + 1;
+    
+    // Overlong forms, surrogates and values past the Unicode range
+    if (codepoint < min || codepoint > 0x10FFFF || (0xD800 <= codepoint && codepoint <= 0xDFFF)){
+        codepoint = UTF8_REPLACEMENT;
+    }
+    return(codepoint);
+}
+
+// Writes the 1 to 4 byte sequence of a codepoint and returns its length. Used to build test text.
+int32_t
+utf8_encode_one(uint32_t codepoint, uint8_t *out){
+    int32_t length = 0;
+    if (codepoint < 0x80){
+        out[0] = (uint8_t)codepoint;
+        length = 1;
+    }
+    else if (codepoint < 0x800){
+        out[0] = (uint8_t)(0xC0 | (codepoint >> 6));
+        out[1] = (uint8_t)(0x80 | (codepoint & 0x3F));
+        length = 2;
+    }
+    else if (codepoint < 0x10000){
+        out[0] = (uint8_t)(0xE0 | (codepoint >> 12));
+        out[1] = (uint8_t)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (uint8_t)(0x80 | (codepoint & 0x3F));
+        length = 3;
+    }
+    else{
+        out[0] = (uint8_t)(0xF0 | (codepoint >> 18));
+        out[1] = (uint8_t)(0x80 | ((codepoint >> 12) & 0x3F));
+        out[2] = (uint8_t)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[3] = (uint8_t)(0x80 | (codepoint & 0x3F));
+        length = 4;
+    }
+    return(length);
+}
+
+// Reference decoder, one sequence at a time. codepoints needs room for length entries.
+int32_t
+utf8_decode_scalar(uint8_t *text, int32_t length, uint32_t *codepoints){
+    int32_t count = 0;
+    for (int32_t i = 0; i < length;){
+        int32_t advance = 1;
+        codepoints[count] = utf8_decode_one(text + i, length - i, &advance);
+        count += 1;
+        i += advance;
+    }
+    return(count);
+}
+
+int32_t
+utf8__count_trailing_zeros(uint32_t x){
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, x);
+    return((int32_t)index);
+#else
+    return(__builtin_ctz(x));
+#endif
+}
+
+// Same output as utf8_decode_scalar. codepoints needs room for length entries.
+// A block is always widened whole. Only its leading ASCII run is kept, the next sequence is
+// decoded scalar and the block after it starts right behind it, so short multibyte runs in mostly
+// ASCII text do not knock the loop off the fast path.
+int32_t
+utf8_decode(uint8_t *text, int32_t length, uint32_t *codepoints){
+    int32_t count = 0;
+    int32_t i = 0;
+#if defined(UTF8_AVX2)
+    for (; i + 32 <= length;){
+        __m256i bytes = _mm256_loadu_si256((__m256i*)(text + i));
+        uint32_t non_ascii = (uint32_t)_mm256_movemask_epi8(bytes);
+        uint32_t *out = codepoints + count;
+        _mm256_storeu_si256((__m256i*)(out +  0), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(text + i +  0))));
+        _mm256_storeu_si256((__m256i*)(out +  8), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(text + i +  8))));
+        _mm256_storeu_si256((__m256i*)(out + 16), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(text + i + 16))));
+        _mm256_storeu_si256((__m256i*)(out + 24), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(text + i + 24))));
+        if (non_ascii == 0){
+            count += 32;
+            i += 32;
+        }
+        else{
+            int32_t ascii_run = utf8__count_trailing_zeros(non_ascii);
+            count += ascii_run;
+            i += ascii_run;
+            int32_t advance = 1;
+            codepoints[count] = utf8_decode_one(text + i, length - i, &advance);
+            count += 1;
+            i += advance;
+        }
+    }
+#endif
+#if defined(UTF8_SSE2)
+    for (; i + 16 <= length;){
+        __m128i bytes = _mm_loadu_si128((__m128i*)(text + i));
+        uint32_t non_ascii = (uint32_t)_mm_movemask_epi8(bytes);
+        __m128i zero = _mm_setzero_si128();
+        __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+        uint32_t *out = codepoints + count;
+        _mm_storeu_si128((__m128i*)(out +  0), _mm_unpacklo_epi16(lo16, zero));
+        _mm_storeu_si128((__m128i*)(out +  4), _mm_unpackhi_epi16(lo16, zero));
+        _mm_storeu_si128((__m128i*)(out +  8), _mm_unpacklo_epi16(hi16, zero));
+        _mm_storeu_si128((__m128i*)(out + 12), _mm_unpackhi_epi16(hi16, zero));
+        if (non_ascii == 0){
+            count += 16;
+            i += 16;
+        }
+        else{
+            int32_t ascii_run = utf8__count_trailing_zeros(non_ascii);
+            count += ascii_run;
+            i += ascii_run;
+            int32_t advance = 1;
+            codepoints[count] = utf8_decode_one(text + i, length - i, &advance);
+            count += 1;
+            i += advance;
+        }
+    }
+#endif
+    
+    // Tail
+    for (; i < length;){
+        int32_t advance = 1;
+        codepoints[count] = utf8_decode_one(text + i, length - i, &advance);
+        count += 1;
+        i += advance;
+    }
+    return(count);
+}
+
+#endif
@@ -0,0 +1,146 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the UTF-8 decoder
+// usage: utf8_test [seed]
+// Malformed sequences must each decode to U+FFFD and consume only their own bytes. Random valid
+// text must decode back to the codepoints it was encoded from. Random bytes, mostly ASCII so the
+// SIMD blocks are taken and left at every offset, must decode the same with the SIMD decoder as
+// with the scalar reference.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_utf8.h"
+#include "example_test.h"
+
+static int32_t test_text_count = 20000;
+static int32_t test_text_max = 300;
+
+void
+test_decode_expect(char *text, uint32_t *expected, int32_t expected_count){
+    uint32_t codepoints[64];
+    int32_t length = (int32_t)strlen(text);
+    int32_t count = utf8_decode((uint8_t*)text, length, codepoints);
+    if (TEST_CHECK(count == expected_count)){
+        TEST_CHECK(memcmp(codepoints, expected, sizeof(uint32_t)*count) == 0);
+    }
+    count = utf8_decode_scalar((uint8_t*)text, length, codepoints);
+    if (TEST_CHECK(count == expected_count)){
+        TEST_CHECK(memcmp(codepoints, expected, sizeof(uint32_t)*count) == 0);
+    }
+}
+
+// Any scalar value but the surrogates, mostly from the two byte and CJK ranges
+uint32_t
+test_random_codepoint(uint32_t *state){
+    uint32_t codepoint = 0;
+    switch (test_random_range(state, 0, 3)){
+        case 0: codepoint = (uint32_t)test_random_range(state, 0x80, 0x7FF); break;
+        case 1: codepoint = (uint32_t)test_random_range(state, 0x4E00, 0x9FFF); break;
+        case 2: codepoint = (uint32_t)test_random_range(state, 0x10000, 0x10FFFF); break;
+        default: codepoint = (uint32_t)test_random_range(state, 0x800, 0xFFFF); break;
+    }
+    if (0xD800 <= codepoint && codepoint <= 0xDFFF){
+        codepoint = 0xFFFD;
+    }
+    return(codepoint);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x0C7F8u);
+    uint32_t state = seed;
+    
+    // Malformed input
+    {
+        uint32_t truncated[] = {'a', UTF8_REPLACEMENT, 'b'};
+        test_decode_expect("a\xE2\x82" "b", truncated, 3);
+        uint32_t overlong[] = {UTF8_REPLACEMENT, 'x'};
+        test_decode_expect("\xC0\xAFx", overlong, 2);
+        uint32_t surrogate[] = {UTF8_REPLACEMENT};
+        test_decode_expect("\xED\xA0\x80", surrogate, 1);
+        uint32_t past_unicode[] = {UTF8_REPLACEMENT, 'y'};
+        test_decode_expect("\xF4\x90\x80\x80y", past_unicode, 2);
+        uint32_t stray[] = {UTF8_REPLACEMENT, UTF8_REPLACEMENT, 'z'};
+        test_decode_expect("\x80\xFFz", stray, 3);
+        uint32_t mixed[] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e',0x20AC,0x1F600,'!'};
+        test_decode_expect("0123456789abcde\xE2\x82\xAC\xF0\x9F\x98\x80!", mixed, 18);
+    }
+    
+    // Room for the widest text plus the blocks the SIMD loops store whole
+    int32_t byte_max = 4*test_text_max;
+    uint8_t *text = (uint8_t*)malloc(byte_max);
+    uint32_t *source = (uint32_t*)malloc(sizeof(uint32_t)*test_text_max);
+    uint32_t *expected = (uint32_t*)malloc(sizeof(uint32_t)*(byte_max + 32));
+    uint32_t *codepoints = (uint32_t*)malloc(sizeof(uint32_t)*(byte_max + 32));
+    
+    // Valid text decodes back to where it came from.
+    int64_t codepoint_total = 0;
+    for (int32_t t = 0; t < test_text_count; t += 1){
+        int32_t source_count = test_random_range(&state, 0, test_text_max);
+        int32_t multibyte_in_8 = test_random_range(&state, 0, 8);
+        int32_t length = 0;
+        for (int32_t i = 0; i < source_count; i += 1){
+            uint32_t codepoint = (uint32_t)test_random_range(&state, 0x20, 0x7E);
+            if (test_random_range(&state, 0, 7) < multibyte_in_8){
+                codepoint = test_random_codepoint(&state);
+            }
+            source[i] = codepoint;
+            length += utf8_encode_one(codepoint, text + length);
+        }
+        int32_t count = utf8_decode(text, length, codepoints);
+        if (TEST_CHECK(count == source_count)){
+            TEST_CHECK(memcmp(codepoints, source, sizeof(uint32_t)*count) == 0);
+        }
+        codepoint_total += count;
+    }
+    
+    // Any bytes decode the same through the SIMD loops as through the reference.
+    int64_t replacement_total = 0;
+    for (int32_t t = 0; t < test_text_count; t += 1){
+        int32_t length = test_random_range(&state, 0, byte_max);
+        int32_t non_ascii_in_64 = test_random_range(&state, 0, 64);
+        for (int32_t i = 0; i < length; i += 1){
+            uint8_t byte = (uint8_t)test_random_range(&state, 0, 0x7F);
+            if (test_random_range(&state, 0, 63) < non_ascii_in_64){
+                byte = (uint8_t)test_random_range(&state, 0x80, 0xFF);
+            }
+            text[i] = byte;
+        }
+        int32_t expected_count = utf8_decode_scalar(text, length, expected);
+        int32_t count = utf8_decode(text, length, codepoints);
+        TEST_CHECK(expected_count <= length);
+        if (TEST_CHECK(count == expected_count)){
+            TEST_CHECK(memcmp(codepoints, expected, sizeof(uint32_t)*count) == 0);
+        }
+        for (int32_t i = 0; i < expected_count; i += 1){
+            uint32_t codepoint = expected[i];
+            TEST_CHECK(codepoint <= 0x10FFFF && !(0xD800 <= codepoint && codepoint <= 0xDFFF));
+            replacement_total += (codepoint == UTF8_REPLACEMENT);
+        }
+    }
+    
+    free(codepoints);
+    free(expected);
+    free(source);
+    free(text);
+    
+    printf("utf8_test: %d valid texts (%lld codepoints), %d random byte texts (%lld replacements)\n",
+           test_text_count, (long long)codepoint_total, test_text_count, (long long)replacement_total);
+    return(test_finish("utf8_test", seed));
+}
@@ -0,0 +1,238 @@
+// DirectWrite rasterization example: streaming vertex ring
+// One buffer is allocated once and written front to back with a cursor. At the end of each frame
+// a fence covers what the frame wrote. Before the cursor runs over a region the GPU may still read,
+// the region's fence is polled: if it has passed the region is reused in place, if not the buffer
+// is orphaned instead of waiting. Orphaning is the only thing that hands the driver new storage,
+// and it only happens on a wrap that would otherwise stall.
+// The buffer itself sits behind a small backend so the bookkeeping can be checked without a GPU.
+
+#if !defined(EXAMPLE_VERTEX_RING_H)
+#define EXAMPLE_VERTEX_RING_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+typedef int32_t bool32;
+
+// Copies size bytes to offset in the current storage.
+typedef void Vertex_Ring_Write_Function(void *backend, uint64_t offset, void *data, uint64_t size);
+// Fence after every draw submitted so far, zero is never a valid fence.
+typedef uint64_t Vertex_Ring_Fence_Function(void *backend);
+// True once the GPU is past the fence. With block set it waits for that.
+typedef bool32 Vertex_Ring_Wait_Function(void *backend, uint64_t fence, bool32 block);
+typedef void Vertex_Ring_Release_Function(void *backend, uint64_t fence);
+// Replaces the storage with new storage of the given size; draws in flight keep the old one.
+typedef void Vertex_Ring_Orphan_Function(void *backend, uint64_t size);
+
+struct Vertex_Ring_Backend{
+    void *backend;
+    Vertex_Ring_Write_Function *write;
+    Vertex_Ring_Fence_Function *fence;
+    Vertex_Ring_Wait_Function *wait;
+    Vertex_Ring_Release_Function *release;
+    Vertex_Ring_Orphan_Function *orphan;
+};
+
+struct Vertex_Ring_Stats{
+    uint64_t bytes;
+    uint64_t allocations;
+    uint64_t wraps;
+    // Wraps where the fence had passed and the front of the buffer was reused in place
+    uint64_t reuses;
+    // Wraps where the GPU was still reading, each one a stall avoided by orphaning
+    uint64_t orphans;
+    // Blocking waits, only when more frames are in flight than the ring tracks
+    uint64_t waits;
+    // Allocations too big for the ring, which grows to fit them
+    uint64_t resizes;
+};
+
+// Region of the current storage the GPU may still be reading
+struct Vertex_Ring_Region{
+    uint64_t fence;
+    uint64_t begin;
+    uint64_t end;
+};
+
+#define VERTEX_RING_MAX_REGIONS 16
+
+struct Vertex_Ring{
+    Vertex_Ring_Backend backend;
+    uint64_t size;
+    uint64_t cursor;
+    // Start of what the current frame has written, not yet covered by a fence
+    uint64_t frame_begin;
+    
+    // Oldest first
+    Vertex_Ring_Region regions[VERTEX_RING_MAX_REGIONS];
+    int32_t region_first;
+    int32_t region_count;
+    
+    Vertex_Ring_Stats frame;
+    Vertex_Ring_Stats last_frame;
+    Vertex_Ring_Stats total;
+};
+
+Vertex_Ring
+vertex_ring_init(Vertex_Ring_Backend backend, uint64_t size){
+    Vertex_Ring ring = {0};
+    ring.backend = backend;
+    ring.size = size;
+    backend.orphan(backend.backend, size);
+    return(ring);
+}
+
+void
+vertex_ring__drop_regions(Vertex_Ring *ring){
+    for (int32_t i = 0; i < ring->region_count; i += 1){
+        Vertex_Ring_Region *region = &ring->regions[(ring->region_first + i)%VERTEX_RING_MAX_REGIONS];
+        ring->backend.release(ring->backend.backend, region->fence);
+    }
+    ring->region_first = 0;
+    ring->region_count = 0;
+}
+
+void
+vertex_ring__retire_oldest(Vertex_Ring *ring){
+    Vertex_Ring_Region *region = &ring->regions[ring->region_first];
+    ring->backend.release(ring->backend.backend, region->fence);
+    ring->region_first = (ring->region_first + 1)%VERTEX_RING_MAX_REGIONS;
+    ring->region_count -= 1;
+}
+
+// Fences what has been written since the last fence.
+void
+vertex_ring__close_region(Vertex_Ring *ring){
+    if (ring->cursor == ring->frame_begin){
+        return;
+    }
+    if (ring->region_count == VERTEX_RING_MAX_REGIONS){
+        Vertex_Ring_Region *oldest = &ring->regions[ring->region_first];
+        ring->backend.wait(ring->backend.backend, oldest->fence, true);
+        ring->frame.waits += 1;
+        vertex_ring__retire_oldest(ring);
+    }
+    Vertex_Ring_Region *region = &ring->regions[(ring->region_first + ring->region_count)%VERTEX_RING_MAX_REGIONS];
+    region->fence = ring->backend.fence(ring->backend.backend);
+    region->begin = ring->frame_begin;
+    region->end = ring->cursor;
+    ring->region_count += 1;
+    ring->frame_begin = ring->cursor;
+}
+
+void
+vertex_ring__orphan(Vertex_Ring *ring, uint64_t size){
+    vertex_ring__drop_regions(ring);
+    ring->backend.orphan(ring->backend.backend, size);
+    ring->size = size;
+    ring->cursor = 0;
+    ring->frame_begin = 0;
+}
+
+// Fences pass in order, so once the newest region under [begin, end) is done every older one is
+// too. Returns false if that region is still in use.
+bool32
+vertex_ring__make_room(Vertex_Ring *ring, uint64_t begin, uint64_t end){
+    int32_t newest = -1;
+    for (int32_t i = 0; i < ring->region_count; i += 1){
+        Vertex_Ring_Region *region = &ring->regions[(ring->region_first + i)%VERTEX_RING_MAX_REGIONS];
+        if (region->begin < end && begin < region->end){
+            newest = i;
+        }
+    }
+    if (newest < 0){
+        return(true);
+    }
+    Vertex_Ring_Region *region = &ring->regions[(ring->region_first + newest)%VERTEX_RING_MAX_REGIONS];
+    if (!ring->backend.wait(ring->backend.backend, region->fence, false)){
+        return(false);
+    }
+    for (int32_t i = 0; i <= newest; i += 1){
+        vertex_ring__retire_oldest(ring);
+    }
+    return(true);
+}
+
+// Reserves size bytes and returns their offset in the buffer. Draws that read them must be
+// submitted before vertex_ring_end_frame.
+uint64_t
+vertex_ring_alloc(Vertex_Ring *ring, uint64_t size){
+    size = (size + 15) & ~(uint64_t)15;
+    
+    if (size > ring->size){
+        // Draws already submitted this frame keep the old storage.
+        uint64_t new_size = ring->size;
+        for (; new_size < size; new_size *= 2);
+        vertex_ring__orphan(ring, new_size);
+        ring->frame.resizes += 1;
+    }
+    
+    bool32 wrapped = false;
+    if (ring->cursor + size > ring->size){
+        // What this frame wrote before the wrap gets a fence of its own, the frame may reach it again.
+        vertex_ring__close_region(ring);
+        ring->cursor = 0;
+        ring->frame_begin = 0;
+        ring->frame.wraps += 1;
+        wrapped = true;
+    }
+    
+    if (!vertex_ring__make_room(ring, ring->cursor, ring->cursor + size)){
+        vertex_ring__orphan(ring, ring->size);
+        ring->frame.orphans += 1;
+    }
+    else if (wrapped){
+        ring->frame.reuses += 1;
+    }
+    
+    uint64_t offset = ring->cursor;
+    ring->cursor += size;
+    ring->frame.bytes += size;
+    ring->frame.allocations += 1;
+    return(offset);
+}
+
+uint64_t
+vertex_ring_push(Vertex_Ring *ring, void *data, uint64_t size){
+    uint64_t offset = vertex_ring_alloc(ring, size);
+    ring->backend.write(ring->backend.backend, offset, data, size);
+    return(offset);
+}
+
+void
+vertex_ring__add_stats(Vertex_Ring_Stats *total, Vertex_Ring_Stats *frame){
+    total->bytes       += frame->bytes;
+    total->allocations += frame->allocations;
+    total->wraps       += frame->wraps;
+    total->reuses      += frame->reuses;
+    total->orphans     += frame->orphans;
+    total->waits       += frame->waits;
+    total->resizes     += frame->resizes;
+}
+
+// Call after the frame's draws are submitted.
+void
+vertex_ring_end_frame(Vertex_Ring *ring){
+    vertex_ring__close_region(ring);
+    
+    // Retire whatever the GPU has finished without waiting.
+    for (; ring->region_count > 0;){
+        Vertex_Ring_Region *oldest = &ring->regions[ring->region_first];
+        if (!ring->backend.wait(ring->backend.backend, oldest->fence, false)){
+            break;
+        }
+        vertex_ring__retire_oldest(ring);
+    }
+    
+    vertex_ring__add_stats(&ring->total, &ring->frame);
+    ring->last_frame = ring->frame;
+    memset(&ring->frame, 0, sizeof(ring->frame));
+}
+
+void
+vertex_ring_free(Vertex_Ring *ring){
+    vertex_ring__drop_regions(ring);
+    memset(ring, 0, sizeof(*ring));
+}
+
+#endif
@@ -0,0 +1,270 @@
+/*
+** Win32 Direct Write Example Program
+**  v1.0.0 - June 16th 2021
+**  by Allen Webster allenwebster@4coder.net
+**
+** public domain example program
+** NO WARRANTY IMPLIED; USE AT YOUR OWN RISK
+**
+** *WARNING* this example has not yet been curated and refined to save
+**  your time if you are trying to use it for learning. It lacks detailed
+**  commentary and is probably sloppy in places.
+**
+*/
+
+// DirectWrite rasterization example: test of the streaming vertex ring
+// usage: vertex_ring_test [seed]
+// Streams frames through the ring into a mock GPU that finishes each frame a few frames after it is
+// submitted. No write may land on bytes a draw in flight still reads from the same storage, every
+// fence handed out is released exactly once, and a few fixed scenarios must reuse, orphan or grow
+// the ring as they are built to. Random scenarios then vary the ring size, latency and uploads.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+typedef int32_t bool32;
+
+#include "example_vertex_ring.h"
+#include "example_test.h"
+
+static int32_t test_scenario_frame_count = 4000;
+static int32_t test_random_scenario_count = 100;
+static int32_t test_random_frame_count = 400;
+
+// Stands in for the GPU behind a vertex ring. Fences are sequential ids and the GPU finishes a
+// frame's fences a fixed number of frames after it is submitted. Every draw remembers the bytes it
+// reads, and a write into bytes an unfinished draw still reads from the same storage is a bug.
+struct Test_Mock_Draw{
+    uint32_t generation;
+    uint64_t fence;
+    uint64_t begin;
+    uint64_t end;
+};
+
+#define TEST_MOCK_MAX_DRAWS 256
+#define TEST_MOCK_MAX_FRAMES 64
+
+struct Test_Mock_GPU{
+    uint8_t *storage;
+    uint64_t storage_size;
+    uint32_t generation;
+    uint64_t issued_fence;
+    uint64_t completed_fence;
+    int32_t latency;
+    uint64_t frame_fences[TEST_MOCK_MAX_FRAMES];
+    Test_Mock_Draw draws[TEST_MOCK_MAX_DRAWS];
+    int32_t draw_count;
+    uint64_t storage_allocations;
+    // One byte per fence ever issued, set while the fence is live
+    uint8_t *fence_live;
+    uint64_t fence_max;
+    uint64_t live_fences;
+};
+
+void
+test_mock_write(void *backend, uint64_t offset, void *data, uint64_t size){
+    Test_Mock_GPU *gpu = (Test_Mock_GPU*)backend;
+    if (!TEST_CHECK(offset + size <= gpu->storage_size)){
+        return;
+    }
+    for (int32_t i = 0; i < gpu->draw_count; i += 1){
+        Test_Mock_Draw *draw = &gpu->draws[i];
+        bool32 in_flight = (draw->generation == gpu->generation && draw->fence > gpu->completed_fence);
+        TEST_CHECK(!(in_flight && draw->begin < offset + size && offset < draw->end));
+    }
+    memcpy(gpu->storage + offset, data, (size_t)size);
+}
+
+uint64_t
+test_mock_fence(void *backend){
+    Test_Mock_GPU *gpu = (Test_Mock_GPU*)backend;
+    gpu->issued_fence += 1;
+    if (gpu->issued_fence >= gpu->fence_max){
+        gpu->fence_max = 2*gpu->issued_fence;
+        gpu->fence_live = (uint8_t*)realloc(gpu->fence_live, (size_t)gpu->fence_max);
+    }
+    gpu->fence_live[gpu->issued_fence] = 1;
+    gpu->live_fences += 1;
+    return(gpu->issued_fence);
+}
+
+bool32
+test_mock_wait(void *backend, uint64_t fence, bool32 block){
+    Test_Mock_GPU *gpu = (Test_Mock_GPU*)backend;
+    TEST_CHECK(fence != 0 && fence <= gpu->issued_fence && gpu->fence_live[fence]);
+    if (block && gpu->completed_fence < fence){
+        gpu->completed_fence = fence;
+    }
+    return(fence <= gpu->completed_fence);
+}
+
+void
+test_mock_release(void *backend, uint64_t fence){
+    Test_Mock_GPU *gpu = (Test_Mock_GPU*)backend;
+    if (TEST_CHECK(fence != 0 && fence <= gpu->issued_fence && gpu->fence_live[fence])){
+        gpu->fence_live[fence] = 0;
+        gpu->live_fences -= 1;
+    }
+}
+
+void
+test_mock_orphan(void *backend, uint64_t size){
+    Test_Mock_GPU *gpu = (Test_Mock_GPU*)backend;
+    // Draws in flight keep the old storage, they are no longer checked against new writes.
+    free(gpu->storage);
+    gpu->storage = (uint8_t*)malloc((size_t)size);
+    gpu->storage_size = size;
+    gpu->generation += 1;
+    gpu->storage_allocations += 1;
+}
+
+void
+test_mock_draw(Test_Mock_GPU *gpu, uint64_t offset, uint64_t size){
+    // Finished draws can never be hit again, drop them before recording the new one.
+    int32_t kept = 0;
+    for (int32_t i = 0; i < gpu->draw_count; i += 1){
+        if (gpu->draws[i].fence > gpu->completed_fence && gpu->draws[i].generation == gpu->generation){
+            gpu->draws[kept] = gpu->draws[i];
+            kept += 1;
+        }
+    }
+    gpu->draw_count = kept;
+    if (!TEST_CHECK(gpu->draw_count < TEST_MOCK_MAX_DRAWS)){
+        return;
+    }
+    Test_Mock_Draw *draw = &gpu->draws[gpu->draw_count];
+    draw->generation = gpu->generation;
+    // Covered by the next fence the ring asks for
+    draw->fence = gpu->issued_fence + 1;
+    draw->begin = offset;
+    draw->end = offset + size;
+    gpu->draw_count += 1;
+}
+
+void
+test_mock_end_frame(Test_Mock_GPU *gpu, int32_t frame){
+    gpu->frame_fences[frame%TEST_MOCK_MAX_FRAMES] = gpu->issued_fence;
+    if (frame >= gpu->latency){
+        uint64_t done = gpu->frame_fences[(frame - gpu->latency)%TEST_MOCK_MAX_FRAMES];
+        if (gpu->completed_fence < done){
+            gpu->completed_fence = done;
+        }
+    }
+}
+
+struct Test_Scenario{
+    char *name;
+    uint64_t ring_size;
+    int32_t latency;
+    int32_t pushes_per_frame;
+    uint64_t min_push;
+    uint64_t max_push;
+};
+
+// Runs the frames and checks what holds for any scenario. The totals are left in stats.
+void
+test_run_scenario(Test_Scenario *scenario, int32_t frame_count, uint32_t *state, uint8_t *data,
+                  Vertex_Ring_Stats *stats, uint64_t *storage_allocations){
+    Test_Mock_GPU *gpu = (Test_Mock_GPU*)calloc(1, sizeof(Test_Mock_GPU));
+    gpu->latency = scenario->latency;
+    
+    Vertex_Ring_Backend backend = {0};
+    backend.backend = gpu;
+    backend.write = test_mock_write;
+    backend.fence = test_mock_fence;
+    backend.wait = test_mock_wait;
+    backend.release = test_mock_release;
+    backend.orphan = test_mock_orphan;
+    Vertex_Ring ring = vertex_ring_init(backend, scenario->ring_size);
+    
+    for (int32_t frame = 0; frame < frame_count; frame += 1){
+        for (int32_t p = 0; p < scenario->pushes_per_frame; p += 1){
+            uint64_t size = scenario->min_push;
+            if (scenario->max_push > scenario->min_push){
+                size += test_random(state)%(scenario->max_push - scenario->min_push);
+            }
+            uint64_t offset = vertex_ring_push(&ring, data, size);
+            TEST_CHECK(offset%16 == 0 && offset + size <= ring.size);
+            test_mock_draw(gpu, offset, size);
+        }
+        vertex_ring_end_frame(&ring);
+        test_mock_end_frame(gpu, frame);
+        TEST_CHECK(ring.region_count <= VERTEX_RING_MAX_REGIONS);
+    }
+    
+    *stats = ring.total;
+    *storage_allocations = gpu->storage_allocations;
+    TEST_CHECK(stats->allocations == (uint64_t)frame_count*scenario->pushes_per_frame);
+    TEST_CHECK(stats->reuses <= stats->wraps);
+    vertex_ring_free(&ring);
+    TEST_CHECK(gpu->live_fences == 0);
+    free(gpu->fence_live);
+    free(gpu->storage);
+    free(gpu);
+}
+
+int
+main(int argc, char **argv){
+    uint32_t seed = test_seed(argc, argv, 0x7E27E1u);
+    uint32_t state = seed;
+    
+    uint64_t max_push = 300 << 10;
+    uint8_t *data = (uint8_t*)malloc((size_t)max_push);
+    memset(data, 0x5a, (size_t)max_push);
+    
+    // Scenarios built to take each path of the ring
+    Test_Scenario scenarios[] = {
+        // A frame of text well inside the ring, the GPU two frames behind
+        {"steady",   1 << 20, 2, 1, 48 << 10, 48 << 10},
+        // Three frames in flight cover more than the ring
+        {"tight",    128 << 10, 3, 1, 48 << 10, 48 << 10},
+        // Several uploads per frame of varying size, frames wrap part way through
+        {"bursty",   256 << 10, 2, 4, 1 << 10, 40 << 10},
+        // A single frame bigger than the ring
+        {"oversize", 64 << 10, 2, 1, 16 << 10, 300 << 10},
+    };
+    for (int32_t k = 0; k < (int32_t)(sizeof(scenarios)/sizeof(scenarios[0])); k += 1){
+        Test_Scenario *scenario = &scenarios[k];
+        Vertex_Ring_Stats total = {0};
+        uint64_t storage_allocations = 0;
+        test_run_scenario(scenario, test_scenario_frame_count, &state, data, &total, &storage_allocations);
+        if (k == 0){
+            TEST_CHECK(total.orphans == 0 && total.reuses > 0 && total.resizes == 0);
+        }
+        if (k == 1){
+            TEST_CHECK(total.orphans > 0);
+        }
+        if (k == 3){
+            TEST_CHECK(total.resizes > 0);
+        }
+        printf("vertex_ring_test %s: ring %llu KiB, latency %d, %.3f wraps/frame, %.3f reused/frame, "
+               "%.3f stalls avoided/frame, %.3f waits/frame, %llu storage allocations in %d frames\n",
+               scenario->name, (unsigned long long)(scenario->ring_size >> 10), scenario->latency,
+               (double)total.wraps/test_scenario_frame_count, (double)total.reuses/test_scenario_frame_count,
+               (double)total.orphans/test_scenario_frame_count, (double)total.waits/test_scenario_frame_count,
+               (unsigned long long)storage_allocations, test_scenario_frame_count);
+    }
+    
+    for (int32_t k = 0; k < test_random_scenario_count; k += 1){
+        int64_t failures_before = test_state.failures;
+        Test_Scenario scenario = {0};
+        scenario.name = "random";
+        scenario.ring_size = (uint64_t)16 << test_random_range(&state, 10, 16);
+        scenario.latency = test_random_range(&state, 0, 6);
+        scenario.pushes_per_frame = test_random_range(&state, 1, 8);
+        scenario.min_push = (uint64_t)test_random_range(&state, 1, 64 << 10);
+        scenario.max_push = scenario.min_push + (uint64_t)test_random_range(&state, 0, (int32_t)(max_push - scenario.min_push));
+        Vertex_Ring_Stats total = {0};
+        uint64_t storage_allocations = 0;
+        test_run_scenario(&scenario, test_random_frame_count, &state, data, &total, &storage_allocations);
+        if (test_state.failures != failures_before){
+            printf("    random scenario %d: ring %llu, latency %d, %d pushes of %llu to %llu bytes\n",
+                   k, (unsigned long long)scenario.ring_size, scenario.latency, scenario.pushes_per_frame,
+                   (unsigned long long)scenario.min_push, (unsigned long long)scenario.max_push);
+        }
+    }
+    free(data);
+    
+    return(test_finish("vertex_ring_test", seed));
+}